@@ -16,6 +16,8 @@ folly::StringPiece congestionControlTypeToString(CongestionControlType type) {
       return kCongestionControlCubicStr;
     case CongestionControlType::BBR:
       return kCongestionControlBbrStr;
+    case CongestionControlType::BBR2:
+      return kCongestionControlBbr2Str;
     case CongestionControlType::Copa:
       return kCongestionControlCopaStr;
     case CongestionControlType::Copa2:
@@ -39,6 +41,8 @@ folly::Optional<CongestionControlType> congestionControlStrToType(
     return quic::CongestionControlType::Cubic;
   } else if (str == kCongestionControlBbrStr) {
     return quic::CongestionControlType::BBR;
+  } else if (str == kCongestionControlBbr2Str) {
+    return quic::CongestionControlType::BBR2;
   } else if (str == kCongestionControlCopaStr) {
     return quic::CongestionControlType::Copa;
   } else if (str == kCongestionControlCopa2Str) {
@@ -328,18 +328,28 @@ constexpr uint64_t kDefaultMinBurstPackets = 5;
 // but the notifications can get delayed if the event loop is busy
 // this is subject to testing but I would suggest a value >= 200usec
 constexpr std::chrono::microseconds kDefaultPacingTimerTickInterval{1000};
+// Packets a connection writes per turn of the worker's fair pacing, and
+// packets the worker writes at most per pass over its connections.
+constexpr uint64_t kDefaultFairPacingQuantumInPackets = 2;
+constexpr uint64_t kDefaultFairPacingPacketsPerPass = 64;
 // Fraction of RTT that is used to limit how long a write function can loop
 constexpr DurationRep kDefaultWriteLimitRttFraction = 25;
 
 // Congestion control:
 constexpr folly::StringPiece kCongestionControlCubicStr = "cubic";
 constexpr folly::StringPiece kCongestionControlBbrStr = "bbr";
+constexpr folly::StringPiece kCongestionControlBbr2Str = "bbr2";
 constexpr folly::StringPiece kCongestionControlCopaStr = "copa";
 constexpr folly::StringPiece kCongestionControlCopa2Str = "copa2";
 constexpr folly::StringPiece kCongestionControlNewRenoStr = "newreno";
 constexpr folly::StringPiece kCongestionControlNoneStr = "none";
 constexpr folly::StringPiece kCongestionControlCcpStr = "ccp";
 
+// Fall back to the datapath's own congestion control when the in-process CCP
+// hasn't answered a report for that long.
+constexpr std::chrono::microseconds kDefaultInProcessCcpFallbackTimeout =
+    std::chrono::seconds(1);
+
 constexpr DurationRep kPersistentCongestionThreshold = 3;
 enum class CongestionControlType : uint8_t {
   Cubic,
@@ -349,6 +359,9 @@ enum class CongestionControlType : uint8_t {
   BBR,
   CCP,
   None,
+  // Added after None so that the values of the existing types, which can be
+  // set through transport knobs, don't change.
+  BBR2,
   // NOTE: MAX should always be at the end
   MAX
 };
@@ -386,6 +399,21 @@ constexpr std::chrono::microseconds kDelayIncreaseUpperBound(8);
 // Hystart's lower bound for DelayIncrease
 constexpr std::chrono::microseconds kDelayIncreaseLowerBound(2);
 
+/* HyStart++ (RFC 9406): */
+// Bounds of the RTT increase over the last round which ends slow start
+constexpr std::chrono::microseconds kHystartPlusPlusMinRttThresh(4000);
+constexpr std::chrono::microseconds kHystartPlusPlusMaxRttThresh(16000);
+// The RTT increase threshold is the last round's min RTT over this, bounded
+constexpr uint8_t kHystartPlusPlusMinRttDivisor = 8;
+// RTT samples needed in a round before comparing it to the last one
+constexpr uint8_t kHystartPlusPlusRttSamples = 8;
+// Conservative slow start grows cwnd this many times slower than slow start
+constexpr uint8_t kHystartPlusPlusCssGrowthDivisor = 4;
+// Rounds of conservative slow start before moving to congestion avoidance
+constexpr uint8_t kHystartPlusPlusCssRounds = 5;
+// Max cwnd increase per ack in MSS when the connection isn't paced
+constexpr uint64_t kHystartPlusPlusUnpacedLimitInMss = 8;
+
 /* Cubic */
 // Default cwnd reduction factor:
 constexpr double kDefaultCubicReductionFactor = 0.8;
@@ -73,6 +73,7 @@ bool IOBufQuicBatch::flushInternal() {
   if (batchWriter_->empty()) {
     return true;
   }
+  QUIC_TRACE_SCOPE(SOCKET_WRITE);
 
   bool written = false;
   folly::Optional<int> firstSocketErrno;
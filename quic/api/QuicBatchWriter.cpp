@@ -60,14 +60,16 @@ class ThreadLocalBatchWriterCache : public folly::AsyncTimeout {
 
   void timeoutExpired() noexcept override {
     timerActive_ = false;
-    auto& instance = getThreadLocalInstance();
-    if (instance.socket_ && instance.batchWriter_ &&
-        !instance.batchWriter_->empty()) {
+    getThreadLocalInstance().flush();
+    decRef();
+  }
+
+  void flush() {
+    if (socket_ && batchWriter_ && !batchWriter_->empty()) {
       // pass a default address - it is not being used by the writer
-      instance.batchWriter_->write(*socket_.get(), folly::SocketAddress());
-      instance.batchWriter_->reset();
+      batchWriter_->write(*socket_.get(), folly::SocketAddress());
+      batchWriter_->reset();
     }
-    decRef();
   }
 
   void enable(bool val) {
@@ -516,6 +518,12 @@ void BatchWriterDeleter::operator()(BatchWriter* batchWriter) {
 }
 
 // BatchWriterFactory
+void BatchWriterFactory::flushThreadLocalBatchWriter() {
+#if USE_THREAD_LOCAL_BATCH_WRITER
+  ThreadLocalBatchWriterCache::getThreadLocalInstance().flush();
+#endif
+}
+
 BatchWriterPtr BatchWriterFactory::makeBatchWriter(
     folly::AsyncUDPSocket& sock,
     const quic::QuicBatchingMode& batchingMode,
@@ -261,6 +261,12 @@ class BatchWriterFactory {
       const std::chrono::microseconds& threadLocalDelay,
       DataPathType dataPathType,
       QuicConnectionStateBase& conn);
+
+  /**
+   * Writes out what the thread local batch writer holds, without waiting for
+   * its timeout.
+   */
+  static void flushThreadLocalBatchWriter();
 };
 
 } // namespace quic
@@ -168,6 +168,11 @@ class QuicSocket {
     uint32_t totalPTOCount{0};
     folly::Optional<PacketNum> largestPacketAckedByPeer;
     folly::Optional<PacketNum> largestPacketSent;
+    // Number of paced bursts queued for the worker's fair pacing, and the
+    // time they waited for their first turn.
+    uint64_t fairPacingBursts{0};
+    std::chrono::microseconds fairPacingTotalQueueingDelay{0us};
+    std::chrono::microseconds fairPacingMaxQueueingDelay{0us};
   };
 
   /**
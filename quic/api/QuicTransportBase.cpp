@@ -18,6 +18,7 @@
 #include <quic/d6d/QuicD6DStateFunctions.h>
 #include <quic/logging/QLoggerConstants.h>
 #include <quic/loss/QuicLossFunctions.h>
+#include <quic/state/AckHandlers.h>
 #include <quic/state/QuicPacingFunctions.h>
 #include <quic/state/QuicStateFunctions.h>
 #include <quic/state/QuicStreamFunctions.h>
@@ -52,10 +53,11 @@ QuicTransportBase::QuicTransportBase(
       writeLooper_(new FunctionLooper(
           evb,
           [this](bool fromTimer) { pacedWriteDataToSocket(fromTimer); },
-          LooperType::WriteLooper)) {
+          LooperType::WriteLooper)),
+      fairPacingFlow_(this) {
   writeLooper_->setPacingFunction([this]() -> auto {
     if (isConnectionPaced(*conn_)) {
-      return conn_->pacer->getTimeUntilNextWrite();
+      return conn_->pacer->getTimeUntilNextWrite(Clock::now());
     }
     return 0us;
   });
@@ -68,6 +70,19 @@ void QuicTransportBase::setPacingTimer(
   }
 }
 
+void QuicTransportBase::setPacingWheel(
+    PacingWheel::SharedPtr pacingWheel) noexcept {
+  if (pacingWheel) {
+    writeLooper_->setPacingWheel(std::move(pacingWheel));
+  }
+}
+
+void QuicTransportBase::setFairPacingScheduler(
+    FairPacingScheduler::SharedPtr fairPacingScheduler) noexcept {
+  fairPacingFlow_.dequeueFlow();
+  fairPacingScheduler_ = std::move(fairPacingScheduler);
+}
+
 void QuicTransportBase::setCongestionControllerFactory(
     std::shared_ptr<CongestionControllerFactory> ccFactory) {
   CHECK(ccFactory);
@@ -364,6 +379,7 @@ void QuicTransportBase::closeImpl(
   readLooper_->stop();
   peekLooper_->stop();
   writeLooper_->stop();
+  fairPacingFlow_.dequeueFlow();
 
   // TODO: invoke connection close callbacks.
   cancelAllAppCallbacks(cancelCode);
@@ -536,7 +552,7 @@ QuicSocket::TransportInfo QuicTransportBase::getTransportInfo() const {
     congestionWindow = conn_->congestionController->getCongestionWindow();
     if (isConnectionPaced(*conn_)) {
       burstSize = conn_->pacer->getCachedWriteBatchSize();
-      pacingInterval = conn_->pacer->getTimeUntilNextWrite();
+      pacingInterval = conn_->pacer->getTimeUntilNextWrite(Clock::now());
     }
   }
   TransportInfo transportInfo;
@@ -580,6 +596,11 @@ QuicSocket::TransportInfo QuicTransportBase::getTransportInfo() const {
   transportInfo.largestPacketAckedByPeer =
       conn_->ackStates.appDataAckState.largestAckedByPeer;
   transportInfo.largestPacketSent = conn_->lossState.largestSent;
+  const auto& fairPacingStats = fairPacingFlow_.getFlowStats();
+  transportInfo.fairPacingBursts = fairPacingStats.numEnqueued;
+  transportInfo.fairPacingTotalQueueingDelay =
+      fairPacingStats.totalQueueingDelay;
+  transportInfo.fairPacingMaxQueueingDelay = fairPacingStats.maxQueueingDelay;
   return transportInfo;
 }
 
@@ -1633,6 +1654,7 @@ void QuicTransportBase::onNetworkData(
     updatePeekLooper();
     updateWriteLooper(true);
   };
+  QUIC_TRACE_LOOP(conn_->statsCallback, READ_LOOP);
   try {
     conn_->lossState.totalBytesRecvd += networkData.totalData;
     auto originalAckVersion = currentAckStateVersion(*conn_);
@@ -1641,6 +1663,8 @@ void QuicTransportBase::onNetworkData(
           peer,
           NetworkDataSingle(std::move(packet), networkData.receiveTimePoint));
     }
+    // The ACK frames of the batch update the congestion controller at once.
+    processPendingAckEvents(*conn_);
     processCallbacksAfterNetworkData();
     if (closeState_ != CloseState::CLOSED) {
       if (currentAckStateVersion(*conn_) != originalAckVersion) {
@@ -2760,6 +2784,9 @@ QuicTransportBase::readDatagrams(size_t atMost) {
 
 void QuicTransportBase::writeSocketData() {
   if (socket_) {
+    QUIC_TRACE_LOOP(conn_->statsCallback, WRITE_LOOP);
+    // The congestion controller must know of all the acks read so far.
+    processPendingAckEvents(*conn_);
     // record this invocation of a new write to the socket
     ++(conn_->writeCount);
     auto packetsBefore = conn_->outstandings.numOutstanding();
@@ -2898,9 +2925,9 @@ void QuicTransportBase::setTransportSettings(
       conn_->transportSettings.defaultCongestionController);
   if (conn_->transportSettings.pacingEnabled) {
     if (writeLooper_->hasPacingTimer()) {
-      bool usingBbr =
-          (conn_->transportSettings.defaultCongestionController ==
-           CongestionControlType::BBR);
+      auto ccType = conn_->transportSettings.defaultCongestionController;
+      bool usingBbr = ccType == CongestionControlType::BBR ||
+          ccType == CongestionControlType::BBR2;
       auto minCwnd = usingBbr ? kMinCwndInMssForBbr
                               : conn_->transportSettings.minCwndInMss;
       conn_->pacer = std::make_unique<TokenlessPacer>(*conn_, minCwnd);
@@ -2998,7 +3025,8 @@ folly::Expected<Priority, LocalErrorCode> QuicTransportBase::getStreamPriority(
 void QuicTransportBase::validateCongestionAndPacing(
     CongestionControlType& type) {
   // Fallback to Cubic if Pacing isn't enabled with BBR together
-  if (type == CongestionControlType::BBR &&
+  if ((type == CongestionControlType::BBR ||
+       type == CongestionControlType::BBR2) &&
       (!conn_->transportSettings.pacingEnabled ||
        !writeLooper_->hasPacingTimer())) {
     LOG(ERROR) << "Unpaced BBR isn't supported";
@@ -3100,7 +3128,7 @@ void QuicTransportBase::runOnEvbAsync(
       true);
 }
 
-void QuicTransportBase::pacedWriteDataToSocket(bool /* fromTimer */) {
+void QuicTransportBase::pacedWriteDataToSocket(bool fromTimer) {
   FOLLY_MAYBE_UNUSED auto self = sharedGuard();
 
   if (!isConnectionPaced(*conn_)) {
@@ -3113,18 +3141,51 @@ void QuicTransportBase::pacedWriteDataToSocket(bool /* fromTimer */) {
   }
 
   // We are in the middle of a pacing interval. Leave it be.
-  if (writeLooper_->isScheduled()) {
+  if (writeLooper_->isScheduled() || writeLooper_->isPacingScheduled()) {
     // The next burst is already scheduled. Since the burst size doesn't depend
     // on much data we currently have in buffer at all, no need to change
     // anything.
     return;
   }
 
+  if (fairPacingScheduler_) {
+    if (!fromTimer &&
+        conn_->pacer->getTimeUntilNextWrite(Clock::now()) != 0us) {
+      // The last burst was written too recently, e.g. by the scheduler, which
+      // restarted the looper after. Wait for the pacing interval.
+      writeLooper_->run();
+      return;
+    }
+    // The scheduler writes the burst in turn with the other transports, and
+    // restarts the looper if there is more to write after it.
+    writeLooper_->stop();
+    if (!fairPacingFlow_.isFlowQueued()) {
+      // The burst starts now, however many turns it takes to write it.
+      fairPacingScheduler_->enqueue(
+          &fairPacingFlow_,
+          conn_->pacer->updateAndGetWriteBatchSize(Clock::now()));
+    }
+    return;
+  }
+
   // Do a burst write before waiting for an interval. This will also call
   // updateWriteLooper, but inside FunctionLooper we will ignore that.
   writeSocketDataAndCatch();
 }
 
+uint64_t QuicTransportBase::fairPacingWriteDataToSocket(
+    uint64_t maxPackets) noexcept {
+  FOLLY_MAYBE_UNUSED auto self = sharedGuard();
+  if (closeState_ == CloseState::CLOSED) {
+    return 0;
+  }
+  auto packetsBefore = conn_->lossState.totalPacketsSent;
+  conn_->writePacketsBudget = maxPackets;
+  writeSocketDataAndCatch();
+  conn_->writePacketsBudget = folly::none;
+  return conn_->lossState.totalPacketsSent - packetsBefore;
+}
+
 folly::Expected<QuicSocket::StreamTransportInfo, LocalErrorCode>
 QuicTransportBase::getStreamTransportInfo(StreamId id) const {
   if (!conn_->streamManager->streamExists(id)) {
@@ -11,7 +11,9 @@
 #include <quic/QuicConstants.h>
 #include <quic/QuicException.h>
 #include <quic/api/QuicSocket.h>
+#include <quic/common/FairPacingScheduler.h>
 #include <quic/common/FunctionLooper.h>
+#include <quic/common/PacingWheel.h>
 #include <quic/common/Timers.h>
 #include <quic/congestion_control/CongestionControllerFactory.h>
 #include <quic/congestion_control/Copa.h>
@@ -45,6 +47,19 @@ class QuicTransportBase : public QuicSocket {
 
   void setPacingTimer(TimerHighRes::SharedPtr pacingTimer) noexcept;
 
+  /**
+   * Paces writes through a wheel shared with other transports on the same
+   * evb, instead of the pacing timer.
+   */
+  void setPacingWheel(PacingWheel::SharedPtr pacingWheel) noexcept;
+
+  /**
+   * Leaves the paced bursts to a scheduler shared with other transports on
+   * the same evb, which writes them in turn with the ones of the others.
+   */
+  void setFairPacingScheduler(
+      FairPacingScheduler::SharedPtr fairPacingScheduler) noexcept;
+
   folly::EventBase* getEventBase() const override;
 
   folly::Optional<ConnectionId> getClientConnectionId() const override;
@@ -574,6 +589,21 @@ class QuicTransportBase : public QuicSocket {
     QuicTransportBase* transport_;
   };
 
+  class FairPacingFlow : public FairPacingScheduler::Flow {
+   public:
+    ~FairPacingFlow() override = default;
+
+    explicit FairPacingFlow(QuicTransportBase* transport)
+        : transport_(transport) {}
+
+    uint64_t fairPacingWrite(uint64_t maxPackets) noexcept override {
+      return transport_->fairPacingWriteDataToSocket(maxPackets);
+    }
+
+   private:
+    QuicTransportBase* transport_;
+  };
+
   void scheduleLossTimeout(std::chrono::milliseconds timeout);
   void cancelLossTimeout();
   bool isLossTimeoutScheduled() const;
@@ -719,6 +749,12 @@ class QuicTransportBase : public QuicSocket {
    */
   void pacedWriteDataToSocket(bool fromTimer);
 
+  /**
+   * Writes at most maxPackets of the burst queued on the fair pacing
+   * scheduler, and returns the number of packets written.
+   */
+  uint64_t fairPacingWriteDataToSocket(uint64_t maxPackets) noexcept;
+
   uint64_t maxWritableOnStream(const QuicStreamState&);
   uint64_t maxWritableOnConn();
 
@@ -836,6 +872,8 @@ class QuicTransportBase : public QuicSocket {
   FunctionLooper::Ptr readLooper_;
   FunctionLooper::Ptr peekLooper_;
   FunctionLooper::Ptr writeLooper_;
+  FairPacingScheduler::SharedPtr fairPacingScheduler_;
+  FairPacingFlow fairPacingFlow_;
 
   // TODO: This is silly. We need a better solution.
   // Uninitialied local address as a fallback answer when socket isn't bound.
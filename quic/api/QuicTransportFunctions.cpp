@@ -214,8 +214,11 @@ DataPathResult continuousMemoryBuildScheduleEncrypt(
       getAckState(connection, pnSpace).largestAckedByPeer.value_or(0));
   pktBuilder.accountForCipherOverhead(cipherOverhead);
   CHECK(scheduler.hasData());
-  auto result =
-      scheduler.scheduleFramesForPacket(std::move(pktBuilder), writableBytes);
+  auto result = [&] {
+    QUIC_TRACE_SCOPE(SCHEDULE);
+    return scheduler.scheduleFramesForPacket(
+        std::move(pktBuilder), writableBytes);
+  }();
   CHECK(connection.bufAccessor->ownsBuffer());
   auto& packet = result.packet;
   if (!packet || packet->packet.frames.empty()) {
@@ -248,8 +251,11 @@ DataPathResult continuousMemoryBuildScheduleEncrypt(
   // buf's data starts from the body part of buf.
   buf->trimStart(prevSize + headerLen);
   // buf and packetBuf is actually the same.
-  auto packetBuf =
-      aead.inplaceEncrypt(std::move(buf), packet->header.get(), packetNum);
+  auto packetBuf = [&] {
+    QUIC_TRACE_SCOPE(ENCRYPT);
+    return aead.inplaceEncrypt(
+        std::move(buf), packet->header.get(), packetNum);
+  }();
   CHECK(packetBuf->headroom() == headerLen + prevSize);
   // Include header back.
   packetBuf->prepend(headerLen);
@@ -305,8 +311,11 @@ DataPathResult iobufChainBasedBuildScheduleEncrypt(
       getAckState(connection, pnSpace).largestAckedByPeer.value_or(0));
   // It's the scheduler's job to invoke encode header
   pktBuilder.accountForCipherOverhead(cipherOverhead);
-  auto result =
-      scheduler.scheduleFramesForPacket(std::move(pktBuilder), writableBytes);
+  auto result = [&] {
+    QUIC_TRACE_SCOPE(SCHEDULE);
+    return scheduler.scheduleFramesForPacket(
+        std::move(pktBuilder), writableBytes);
+  }();
   auto& packet = result.packet;
   if (!packet || packet->packet.frames.empty()) {
     ioBufBatch.flush();
@@ -332,8 +341,11 @@ DataPathResult iobufChainBasedBuildScheduleEncrypt(
   bodyCursor.pull(unencrypted->writableData() + headerLen, bodyLen);
   unencrypted->advance(headerLen);
   unencrypted->append(bodyLen);
-  auto packetBuf = aead.inplaceEncrypt(
-      std::move(unencrypted), packet->header.get(), packetNum);
+  auto packetBuf = [&] {
+    QUIC_TRACE_SCOPE(ENCRYPT);
+    return aead.inplaceEncrypt(
+        std::move(unencrypted), packet->header.get(), packetNum);
+  }();
   DCHECK(packetBuf->headroom() == headerLen);
   packetBuf->clear();
   auto headerCursor = folly::io::Cursor(packet->header.get());
@@ -1267,6 +1279,7 @@ void encryptPacketHeader(
     const uint8_t* encryptedBody,
     size_t bodyLen,
     const PacketNumberCipher& headerCipher) {
+  QUIC_TRACE_SCOPE(ENCRYPT);
   // Header encryption.
   auto packetNumberLength = parsePacketNumberLength(*header);
   Sample sample;
@@ -1405,6 +1418,10 @@ uint64_t writeConnectionDataToSocket(
     CHECK(buf->length() == 0 && buf->headroom() == 0);
     connection.bufAccessor->release(std::move(buf));
   }
+  if (ioBufBatch.getPktSent() > 0) {
+    QUIC_STATS(
+        connection.statsCallback, onWriteBurst, ioBufBatch.getPktSent());
+  }
   return ioBufBatch.getPktSent();
 }
 
@@ -1602,6 +1619,11 @@ WriteDataReason hasNonAckDataToWrite(const QuicConnectionStateBase& conn) {
 }
 
 void maybeSendStreamLimitUpdates(QuicConnectionStateBase& conn) {
+  if (conn.memoryBudget && conn.memoryBudget->underPressure()) {
+    // The peer can't open more streams until the pressure goes down, the
+    // updates stay pending until then.
+    return;
+  }
   auto update = conn.streamManager->remoteBidirectionalStreamLimitUpdate();
   if (update) {
     sendSimpleFrame(conn, (MaxStreamsFrame(*update, true)));
@@ -232,10 +232,21 @@ class MockQuicTransport : public QuicServerTransport {
 
   GMOCK_METHOD0_(, , , accept, void());
 
+  MOCK_METHOD0(handoff, std::unique_ptr<folly::IOBuf>());
+
   GMOCK_METHOD1_(, , , setTransportSettings, void(TransportSettings));
 
   GMOCK_METHOD1_(, noexcept, , setPacingTimer, void(TimerHighRes::SharedPtr));
 
+  GMOCK_METHOD1_(, noexcept, , setPacingWheel, void(PacingWheel::SharedPtr));
+
+  GMOCK_METHOD1_(
+      ,
+      noexcept,
+      ,
+      setFairPacingScheduler,
+      void(FairPacingScheduler::SharedPtr));
+
   void onNetworkData(
       const folly::SocketAddress& peer,
       NetworkData&& networkData) noexcept override {
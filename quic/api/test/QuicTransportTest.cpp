@@ -3174,7 +3174,7 @@ TEST_F(QuicTransportTest, AlreadyScheduledPacingNoWrite) {
   EXPECT_CALL(*socket_, write(_, _)).WillOnce(Return(0));
   EXPECT_CALL(*rawPacer, updateAndGetWriteBatchSize(_))
       .WillRepeatedly(Return(1));
-  EXPECT_CALL(*rawPacer, getTimeUntilNextWrite())
+  EXPECT_CALL(*rawPacer, getTimeUntilNextWrite(_))
       .WillRepeatedly(Return(3600000ms));
   // This will write out 100 bytes, leave 100 bytes behind. FunctionLooper will
   // schedule a pacing timeout.
@@ -3214,6 +3214,102 @@ TEST_F(QuicTransportTest, NoScheduleIfNoNewData) {
   EXPECT_FALSE(transport_->isPacingScheduled());
 }
 
+TEST_F(QuicTransportTest, FairPacingWritesBurstInTurns) {
+  transport_->setPacingTimer(TimerHighRes::newTimer(&evb_, 1ms));
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb_, 1, 64));
+  transport_->setFairPacingScheduler(scheduler);
+  auto& conn = transport_->getConnectionState();
+  conn.udpSendPacketLen = 100;
+  auto mockCongestionController =
+      std::make_unique<NiceMock<MockCongestionController>>();
+  auto rawCongestionController = mockCongestionController.get();
+  conn.congestionController = std::move(mockCongestionController);
+  conn.transportSettings.pacingEnabled = true;
+  conn.canBePaced = true;
+  auto mockPacer = std::make_unique<NiceMock<MockPacer>>();
+  auto rawPacer = mockPacer.get();
+  conn.pacer = std::move(mockPacer);
+  EXPECT_CALL(*rawCongestionController, getWritableBytes())
+      .WillRepeatedly(Return(10000));
+  EXPECT_CALL(*rawPacer, updateAndGetWriteBatchSize(_))
+      .WillRepeatedly(Return(5));
+  EXPECT_CALL(*rawPacer, getCachedWriteBatchSize()).WillRepeatedly(Return(5));
+  EXPECT_CALL(*rawPacer, getTimeUntilNextWrite(_))
+      .WillRepeatedly(Return(3600000ms));
+
+  auto buf = buildRandomInputData(2000);
+  auto streamId = transport_->createBidirectionalStream().value();
+  transport_->writeChain(streamId, buf->clone(), false);
+  // The burst is queued, nothing is written until the scheduler's pass.
+  EXPECT_CALL(*socket_, write(_, _)).Times(0);
+  transport_->pacedWrite(true);
+  EXPECT_EQ(1, scheduler->count());
+  EXPECT_FALSE(transport_->isPacingScheduled());
+
+  // Then it goes out a packet per turn.
+  EXPECT_CALL(*socket_, write(_, _)).Times(5).WillRepeatedly(Return(0));
+  loopForWrites();
+  EXPECT_EQ(0, scheduler->count());
+  EXPECT_EQ(5, conn.lossState.totalPacketsSent);
+  EXPECT_FALSE(conn.writePacketsBudget.has_value());
+  EXPECT_EQ(1, transport_->getTransportInfo().fairPacingBursts);
+
+  // The looper is back to waiting for the pacing interval.
+  EXPECT_CALL(*socket_, write(_, _)).Times(0);
+  loopForWrites();
+  ASSERT_NE(WriteDataReason::NO_WRITE, shouldWriteData(conn));
+  EXPECT_TRUE(transport_->isPacingScheduled());
+  EXPECT_EQ(0, scheduler->count());
+}
+
+TEST_F(QuicTransportTest, FairPacingUpdatesPacerOncePerBurst) {
+  transport_->setPacingTimer(TimerHighRes::newTimer(&evb_, 1ms));
+  // Three packets per pass, the burst of five takes two passes.
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb_, 1, 3));
+  transport_->setFairPacingScheduler(scheduler);
+  auto& conn = transport_->getConnectionState();
+  conn.udpSendPacketLen = 100;
+  auto mockCongestionController =
+      std::make_unique<NiceMock<MockCongestionController>>();
+  auto rawCongestionController = mockCongestionController.get();
+  conn.congestionController = std::move(mockCongestionController);
+  conn.transportSettings.pacingEnabled = true;
+  conn.canBePaced = true;
+  auto mockPacer = std::make_unique<NiceMock<MockPacer>>();
+  auto rawPacer = mockPacer.get();
+  conn.pacer = std::move(mockPacer);
+  EXPECT_CALL(*rawCongestionController, getWritableBytes())
+      .WillRepeatedly(Return(10000));
+  EXPECT_CALL(*rawPacer, getCachedWriteBatchSize()).WillRepeatedly(Return(5));
+  EXPECT_CALL(*rawPacer, getTimeUntilNextWrite(_))
+      .WillRepeatedly(Return(3600000ms));
+
+  auto buf = buildRandomInputData(2000);
+  auto streamId = transport_->createBidirectionalStream().value();
+  transport_->writeChain(streamId, buf->clone(), false);
+  // The pacer is updated when the burst is queued, and not by its turns.
+  EXPECT_CALL(*rawPacer, updateAndGetWriteBatchSize(_)).WillOnce(Return(5));
+  EXPECT_CALL(*socket_, write(_, _)).Times(0);
+  transport_->pacedWrite(true);
+  EXPECT_EQ(1, scheduler->count());
+
+  EXPECT_CALL(*rawPacer, updateAndGetWriteBatchSize(_)).Times(0);
+  EXPECT_CALL(*socket_, write(_, _)).Times(3).WillRepeatedly(Return(0));
+  loopForWrites();
+  EXPECT_EQ(1, scheduler->numPasses());
+  EXPECT_EQ(3, conn.lossState.totalPacketsSent);
+  EXPECT_EQ(1, scheduler->count());
+
+  EXPECT_CALL(*socket_, write(_, _)).Times(2).WillRepeatedly(Return(0));
+  loopForWrites();
+  EXPECT_EQ(2, scheduler->numPasses());
+  EXPECT_EQ(5, conn.lossState.totalPacketsSent);
+  EXPECT_EQ(0, scheduler->count());
+  EXPECT_EQ(1, transport_->getTransportInfo().fairPacingBursts);
+}
+
 TEST_F(QuicTransportTest, SaneCwndSettings) {
   TransportSettings transportSettings;
   transportSettings.minCwndInMss = 1;
@@ -58,7 +58,7 @@ class TestQuicTransport
   }
 
   bool isPacingScheduled() {
-    return writeLooper_->isScheduled();
+    return writeLooper_->isScheduled() || writeLooper_->isPacingScheduled();
   }
 
   void onReadData(
@@ -69,6 +69,7 @@ class TestQuicTransport
     if (closed) {
       return;
     }
+    uint64_t packetLimit = getWriteDataPacketsLimit(*conn_);
     writeQuicDataToSocket(
         *socket_,
         *conn_,
@@ -77,9 +78,7 @@ class TestQuicTransport
         *aead,
         *headerCipher,
         getVersion(),
-        (isConnectionPaced(*conn_)
-             ? conn_->pacer->updateAndGetWriteBatchSize(Clock::now())
-             : conn_->transportSettings.writeConnectionDataPacketsLimit));
+        packetLimit);
   }
 
   void closeTransport() override {
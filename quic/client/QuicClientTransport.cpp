@@ -851,10 +851,7 @@ void QuicClientTransport::writeData() {
     return;
   }
 
-  uint64_t packetLimit =
-      (isConnectionPaced(*conn_)
-           ? conn_->pacer->updateAndGetWriteBatchSize(Clock::now())
-           : conn_->transportSettings.writeConnectionDataPacketsLimit);
+  uint64_t packetLimit = getWriteDataPacketsLimit(*conn_);
   // At the end of this function, clear out any probe packets credit we didn't
   // use.
   SCOPE_EXIT {
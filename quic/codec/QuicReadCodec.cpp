@@ -12,6 +12,7 @@
 #include <folly/io/Cursor.h>
 #include <quic/codec/Decode.h>
 #include <quic/codec/PacketNumber.h>
+#include <quic/common/HotPathTrace.h>
 
 namespace {
 quic::ConnectionId zeroConnId() {
@@ -216,8 +217,11 @@ CodecResult QuicReadCodec::parseLongHeaderPacket(
   }
 
   Buf decrypted;
-  auto decryptAttempt = cipher->tryDecrypt(
-      std::move(encryptedData), headerData.get(), packetNum.first);
+  auto decryptAttempt = [&] {
+    QUIC_TRACE_SCOPE(DECRYPT);
+    return cipher->tryDecrypt(
+        std::move(encryptedData), headerData.get(), packetNum.first);
+  }();
   if (!decryptAttempt) {
     VLOG(4) << "Unable to decrypt packet=" << packetNum.first
             << " packetNumLen=" << parsePacketNumberLength(initialByte)
@@ -232,6 +236,7 @@ CodecResult QuicReadCodec::parseLongHeaderPacket(
     decrypted = folly::IOBuf::create(0);
   }
 
+  QUIC_TRACE_SCOPE(FRAME_PARSE);
   return decodeRegularPacket(
       std::move(longHeader), params_, std::move(decrypted));
 }
@@ -288,8 +293,11 @@ CodecResult QuicReadCodec::tryParseShortHeaderPacket(
   data->trimStart(aadLen);
 
   Buf decrypted;
-  auto decryptAttempt = oneRttReadCipher_->tryDecrypt(
-      std::move(data), &headerData, packetNum.first);
+  auto decryptAttempt = [&] {
+    QUIC_TRACE_SCOPE(DECRYPT);
+    return oneRttReadCipher_->tryDecrypt(
+        std::move(data), &headerData, packetNum.first);
+  }();
   if (!decryptAttempt) {
     auto protectionType = shortHeader->getProtectionType();
     VLOG(10) << "Unable to decrypt packet=" << packetNum.first
@@ -303,6 +311,7 @@ CodecResult QuicReadCodec::tryParseShortHeaderPacket(
     decrypted = folly::IOBuf::create(0);
   }
 
+  QUIC_TRACE_SCOPE(FRAME_PARSE);
   return decodeRegularPacket(
       std::move(*shortHeader), params_, std::move(decrypted));
 }
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/FairPacingScheduler.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+FairPacingScheduler::Flow::~Flow() {
+  dequeueFlow();
+}
+
+bool FairPacingScheduler::Flow::isFlowQueued() const noexcept {
+  return scheduler_ != nullptr;
+}
+
+void FairPacingScheduler::Flow::dequeueFlow() noexcept {
+  if (scheduler_) {
+    scheduler_->dequeue(*this);
+  }
+}
+
+const FairPacingScheduler::FlowStats& FairPacingScheduler::Flow::getFlowStats()
+    const noexcept {
+  return stats_;
+}
+
+FairPacingScheduler::UniquePtr FairPacingScheduler::newScheduler(
+    folly::EventBase* evb,
+    uint64_t quantumInPackets,
+    uint64_t packetsPerPass) {
+  return UniquePtr(
+      new FairPacingScheduler(evb, quantumInPackets, packetsPerPass));
+}
+
+FairPacingScheduler::FairPacingScheduler(
+    folly::EventBase* evb,
+    uint64_t quantumInPackets,
+    uint64_t packetsPerPass)
+    : evb_(evb), quantum_(quantumInPackets), packetsPerPass_(packetsPerPass) {
+  CHECK(evb_);
+  CHECK_GT(quantum_, 0);
+  CHECK_GT(packetsPerPass_, 0);
+}
+
+FairPacingScheduler::~FairPacingScheduler() {
+  DCHECK(!currentFlow_);
+  while (!flows_.empty()) {
+    dequeue(flows_.front());
+  }
+}
+
+void FairPacingScheduler::enqueue(Flow* flow, uint64_t packets) noexcept {
+  DCHECK(flow);
+  if (packets == 0) {
+    return;
+  }
+  if (flow->scheduler_ == this) {
+    flow->backlog_ = std::max(flow->backlog_, packets);
+    return;
+  }
+  flow->dequeueFlow();
+  flow->scheduler_ = this;
+  flow->backlog_ = packets;
+  flow->deficit_ = 0;
+  flow->enqueueTime_ = std::chrono::steady_clock::now();
+  flow->stats_.numEnqueued++;
+  flows_.push_back(*flow);
+  count_++;
+  if (!isLoopCallbackScheduled()) {
+    evb_->runInLoop(this);
+  }
+}
+
+void FairPacingScheduler::dequeue(Flow& flow) noexcept {
+  DCHECK_EQ(flow.scheduler_, this);
+  if (&flow == currentFlow_) {
+    currentFlow_ = nullptr;
+  } else {
+    flow.hook_.unlink();
+  }
+  flow.scheduler_ = nullptr;
+  flow.backlog_ = 0;
+  flow.deficit_ = 0;
+  flow.enqueueTime_ = folly::none;
+  count_--;
+}
+
+void FairPacingScheduler::runLoopCallback() noexcept {
+  folly::DelayedDestruction::DestructorGuard dg(this);
+  numPasses_++;
+  uint64_t budget = packetsPerPass_;
+  while (budget > 0 && !flows_.empty()) {
+    auto& flow = flows_.front();
+    flows_.pop_front();
+    currentFlow_ = &flow;
+    if (flow.enqueueTime_) {
+      auto queueingDelay =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - *flow.enqueueTime_);
+      flow.stats_.totalQueueingDelay += queueingDelay;
+      flow.stats_.maxQueueingDelay =
+          std::max(flow.stats_.maxQueueingDelay, queueingDelay);
+      flow.enqueueTime_ = folly::none;
+    }
+    flow.deficit_ += quantum_;
+    auto maxPackets = std::min({flow.deficit_, flow.backlog_, budget});
+    auto written = flow.fairPacingWrite(maxPackets);
+    budget -= std::min(written, budget);
+    if (currentFlow_ != &flow) {
+      // The flow was dequeued, or even destroyed, while writing.
+      continue;
+    }
+    currentFlow_ = nullptr;
+    flow.stats_.packetsWritten += written;
+    flow.deficit_ -= std::min(written, flow.deficit_);
+    flow.backlog_ = written < maxPackets ? 0 : flow.backlog_ - written;
+    if (flow.backlog_ == 0) {
+      flow.scheduler_ = nullptr;
+      flow.deficit_ = 0;
+      count_--;
+    } else {
+      flows_.push_back(flow);
+    }
+  }
+  if (drainCallback_) {
+    drainCallback_();
+  }
+  if (!flows_.empty() && !isLoopCallbackScheduled()) {
+    evb_->runInLoop(this);
+  }
+}
+
+void FairPacingScheduler::setDrainCallback(
+    folly::Function<void()> drainCallback) {
+  drainCallback_ = std::move(drainCallback);
+}
+
+size_t FairPacingScheduler::count() const noexcept {
+  return count_;
+}
+
+uint64_t FairPacingScheduler::numPasses() const noexcept {
+  return numPasses_;
+}
+
+} // namespace quic
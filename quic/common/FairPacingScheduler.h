@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/IntrusiveList.h>
+#include <folly/Optional.h>
+#include <folly/io/async/DelayedDestruction.h>
+#include <folly/io/async/EventBase.h>
+
+#include <chrono>
+
+namespace quic {
+
+/**
+ * Deficit round robin over the paced writes of the connections sharing an
+ * evb. A connection due to write a pacing burst enqueues itself as a flow
+ * with the number of packets it wants to write, instead of writing right
+ * away. At the end of the loop iteration, the scheduler goes over the flows
+ * in turn: each turn adds the quantum to the flow's deficit, and the flow
+ * writes up to its deficit. A flow with nothing left to write leaves the
+ * queue and loses its deficit, the others go back to the end of it.
+ *
+ * The bursts of the connections due together then interleave a quantum at a
+ * time, e.g. into the same sendmmsg or GSO batch, instead of going out back
+ * to back. A pass writes at most packetsPerPass packets, the flows left over
+ * wait for the next loop iteration. The drain callback runs after each pass.
+ */
+class FairPacingScheduler : public folly::DelayedDestruction,
+                            private folly::EventBase::LoopCallback {
+ public:
+  struct FlowStats {
+    // Number of times the flow was enqueued.
+    uint64_t numEnqueued{0};
+    uint64_t packetsWritten{0};
+    // Time from being enqueued to the first turn.
+    std::chrono::microseconds totalQueueingDelay{0};
+    std::chrono::microseconds maxQueueingDelay{0};
+  };
+
+  class Flow {
+   public:
+    virtual ~Flow();
+
+    /**
+     * Writes at most maxPackets, and returns the number of packets written.
+     * Writing fewer means the flow has nothing more to write for now.
+     */
+    virtual uint64_t fairPacingWrite(uint64_t maxPackets) noexcept = 0;
+
+    bool isFlowQueued() const noexcept;
+
+    void dequeueFlow() noexcept;
+
+    const FlowStats& getFlowStats() const noexcept;
+
+   private:
+    friend class FairPacingScheduler;
+
+    FairPacingScheduler* scheduler_{nullptr};
+    // Packets left to write, and packets the flow may write before its next
+    // quantum.
+    uint64_t backlog_{0};
+    uint64_t deficit_{0};
+    folly::Optional<std::chrono::steady_clock::time_point> enqueueTime_;
+    FlowStats stats_;
+    folly::IntrusiveListHook hook_;
+  };
+
+  using UniquePtr = std::unique_ptr<FairPacingScheduler, Destructor>;
+  using SharedPtr = std::shared_ptr<FairPacingScheduler>;
+
+  static UniquePtr newScheduler(
+      folly::EventBase* evb,
+      uint64_t quantumInPackets,
+      uint64_t packetsPerPass);
+
+  /**
+   * Queues the flow to write packets in the next pass. If it is already
+   * queued, it keeps its place and writes at least packets.
+   */
+  void enqueue(Flow* flow, uint64_t packets) noexcept;
+
+  /**
+   * Runs after each pass, once the flows wrote their share.
+   */
+  void setDrainCallback(folly::Function<void()> drainCallback);
+
+  // Number of flows queued.
+  size_t count() const noexcept;
+
+  // Number of passes over the queued flows.
+  uint64_t numPasses() const noexcept;
+
+ private:
+  using FlowList = folly::IntrusiveList<Flow, &Flow::hook_>;
+
+  FairPacingScheduler(
+      folly::EventBase* evb,
+      uint64_t quantumInPackets,
+      uint64_t packetsPerPass);
+  ~FairPacingScheduler() override;
+
+  void runLoopCallback() noexcept override;
+
+  void dequeue(Flow& flow) noexcept;
+
+  folly::EventBase* evb_;
+  uint64_t quantum_;
+  uint64_t packetsPerPass_;
+  FlowList flows_;
+  // The flow whose turn it is, out of flows_ while it writes.
+  Flow* currentFlow_{nullptr};
+  size_t count_{0};
+  uint64_t numPasses_{0};
+  folly::Function<void()> drainCallback_;
+};
+
+} // namespace quic
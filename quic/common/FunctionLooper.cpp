@@ -24,8 +24,13 @@ void FunctionLooper::setPacingTimer(
   pacingTimer_ = std::move(pacingTimer);
 }
 
+void FunctionLooper::setPacingWheel(
+    PacingWheel::SharedPtr pacingWheel) noexcept {
+  pacingWheel_ = std::move(pacingWheel);
+}
+
 bool FunctionLooper::hasPacingTimer() const noexcept {
-  return pacingTimer_ != nullptr;
+  return pacingTimer_ != nullptr || pacingWheel_ != nullptr;
 }
 
 void FunctionLooper::setPacingFunction(
@@ -53,10 +58,15 @@ void FunctionLooper::commonLoopBody(bool fromTimer) noexcept {
 }
 
 bool FunctionLooper::schedulePacingTimeout(bool /* fromTimer */) noexcept {
-  if (pacingFunc_ && pacingTimer_ && !isScheduled()) {
+  if (pacingFunc_ && hasPacingTimer() && !isScheduled() &&
+      !isPacingScheduled()) {
     auto nextPacingTime = (*pacingFunc_)();
     if (nextPacingTime != 0us) {
-      pacingTimer_->scheduleTimeout(this, nextPacingTime);
+      if (pacingWheel_) {
+        pacingWheel_->scheduleTimeout(this, nextPacingTime);
+      } else {
+        pacingTimer_->scheduleTimeout(this, nextPacingTime);
+      }
       return true;
     }
   }
@@ -73,12 +83,12 @@ void FunctionLooper::run(bool thisIteration) noexcept {
   running_ = true;
   // Caller can call run() in func_. But if we are in pacing mode, we should
   // prevent such loop.
-  if (pacingTimer_ && inLoopBody_) {
+  if (hasPacingTimer() && inLoopBody_) {
     VLOG(4) << __func__ << ": " << type_
             << " in loop body and using pacing - not rescheduling";
     return;
   }
-  if (isLoopCallbackScheduled() || isScheduled()) {
+  if (isLoopCallbackScheduled() || isScheduled() || isPacingScheduled()) {
     VLOG(10) << __func__ << ": " << type_ << " already scheduled";
     return;
   }
@@ -90,6 +100,7 @@ void FunctionLooper::stop() noexcept {
   running_ = false;
   cancelLoopCallback();
   cancelTimeout();
+  cancelPacing();
 }
 
 bool FunctionLooper::isRunning() const {
@@ -120,8 +131,16 @@ void FunctionLooper::callbackCanceled() noexcept {
   return;
 }
 
+void FunctionLooper::pacingWheelExpired() noexcept {
+  folly::DelayedDestruction::DestructorGuard dg(this);
+  commonLoopBody(true);
+}
+
 folly::Optional<std::chrono::microseconds>
 FunctionLooper::getTimerTickInterval() noexcept {
+  if (pacingWheel_) {
+    return pacingWheel_->getTickInterval();
+  }
   if (pacingTimer_) {
     return pacingTimer_->getTickInterval();
   }
@@ -11,6 +11,7 @@
 
 #include <folly/Function.h>
 #include <folly/io/async/EventBase.h>
+#include <quic/common/PacingWheel.h>
 #include <quic/common/Timers.h>
 
 namespace quic {
@@ -29,7 +30,8 @@ std::ostream& operator<<(std::ostream& /* out */, const LooperType& /*rhs*/);
  */
 class FunctionLooper : public folly::EventBase::LoopCallback,
                        public folly::DelayedDestruction,
-                       public TimerHighRes::Callback {
+                       public TimerHighRes::Callback,
+                       public PacingWheel::Callback {
  public:
   using Ptr =
       std::unique_ptr<FunctionLooper, folly::DelayedDestruction::Destructor>;
@@ -41,6 +43,15 @@ class FunctionLooper : public folly::EventBase::LoopCallback,
 
   void setPacingTimer(TimerHighRes::SharedPtr pacingTimer) noexcept;
 
+  /**
+   * Paces through a wheel shared with other loopers instead of a timeout of
+   * its own on the pacing timer. Takes precedence over the pacing timer.
+   */
+  void setPacingWheel(PacingWheel::SharedPtr pacingWheel) noexcept;
+
+  /**
+   * Whether there is a pacing timer or a pacing wheel.
+   */
   bool hasPacingTimer() const noexcept;
 
   void runLoopCallback() noexcept override;
@@ -81,6 +92,8 @@ class FunctionLooper : public folly::EventBase::LoopCallback,
 
   void callbackCanceled() noexcept override;
 
+  void pacingWheelExpired() noexcept override;
+
   folly::Optional<std::chrono::microseconds> getTimerTickInterval() noexcept;
 
  private:
@@ -92,6 +105,7 @@ class FunctionLooper : public folly::EventBase::LoopCallback,
   folly::Function<void(bool)> func_;
   folly::Optional<folly::Function<std::chrono::microseconds()>> pacingFunc_;
   TimerHighRes::SharedPtr pacingTimer_;
+  PacingWheel::SharedPtr pacingWheel_;
   bool running_{false};
   bool inLoopBody_{false};
   const LooperType type_;
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Preprocessor.h>
+#include <folly/lang/Assume.h>
+#include <quic/common/EnumArray.h>
+#include <chrono>
+
+#ifdef QUIC_HOT_PATH_TRACING
+#include <folly/tracing/StaticTracepoint.h>
+#include <glog/logging.h>
+#endif
+
+namespace quic {
+
+/**
+ * Phases of the read and write loops that can be timed when the build is
+ * configured with QUIC_ENABLE_HOT_PATH_TRACING. READ_LOOP and WRITE_LOOP
+ * cover a whole loop iteration, the other phases are nested inside them.
+ */
+enum class HotPathPhase : uint8_t {
+  READ_LOOP,
+  DECRYPT,
+  FRAME_PARSE,
+  ACK_PROCESSING,
+  WRITE_LOOP,
+  SCHEDULE,
+  ENCRYPT,
+  SOCKET_WRITE,
+  // NOTE: MAX should always be at the end
+  MAX
+};
+
+inline const char* toString(HotPathPhase phase) {
+  switch (phase) {
+    case HotPathPhase::READ_LOOP:
+      return "READ_LOOP";
+    case HotPathPhase::DECRYPT:
+      return "DECRYPT";
+    case HotPathPhase::FRAME_PARSE:
+      return "FRAME_PARSE";
+    case HotPathPhase::ACK_PROCESSING:
+      return "ACK_PROCESSING";
+    case HotPathPhase::WRITE_LOOP:
+      return "WRITE_LOOP";
+    case HotPathPhase::SCHEDULE:
+      return "SCHEDULE";
+    case HotPathPhase::ENCRYPT:
+      return "ENCRYPT";
+    case HotPathPhase::SOCKET_WRITE:
+      return "SOCKET_WRITE";
+    case HotPathPhase::MAX:
+      return "MAX";
+  }
+  folly::assume_unreachable();
+}
+
+#ifdef QUIC_HOT_PATH_TRACING
+
+/**
+ * Per thread stack of the loop iterations being timed, each accumulating the
+ * time spent in each phase while it is the innermost one. Scoped timers add
+ * to the innermost loop, and each loop scope hands its own totals to the stats
+ * callback when it ends, so a write loop run from within a read loop reports
+ * its phases separately. Phases timed outside of any loop are dropped rather
+ * than attributed to whichever loop runs next. Keeping this thread local lets
+ * code without access to the connection (e.g. the codec) be timed.
+ */
+class HotPathTrace {
+ public:
+  class Loop {
+   public:
+    template <typename Fn>
+    void flush(Fn&& fn) {
+      for (auto phase : accumulated_.keys()) {
+        if (accumulated_[phase].count() != 0) {
+          fn(phase, accumulated_[phase]);
+          accumulated_[phase] = std::chrono::nanoseconds::zero();
+        }
+      }
+    }
+
+   private:
+    friend class HotPathTrace;
+
+    EnumArray<HotPathPhase, std::chrono::nanoseconds> accumulated_{};
+    Loop* parent_{nullptr};
+  };
+
+  static HotPathTrace& get() noexcept {
+    static thread_local HotPathTrace trace;
+    return trace;
+  }
+
+  void push(Loop& loop) noexcept {
+    loop.parent_ = current_;
+    current_ = &loop;
+  }
+
+  void pop(Loop& loop) noexcept {
+    DCHECK_EQ(current_, &loop);
+    current_ = loop.parent_;
+    loop.parent_ = nullptr;
+  }
+
+  void record(HotPathPhase phase, std::chrono::nanoseconds duration) noexcept {
+    if (current_) {
+      current_->accumulated_[phase] += duration;
+    }
+  }
+
+ private:
+  Loop* current_{nullptr};
+};
+
+class ScopedHotPathTimer {
+ public:
+  explicit ScopedHotPathTimer(HotPathPhase phase) noexcept
+      : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedHotPathTimer() {
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_);
+    FOLLY_SDT(
+        quic,
+        hot_path_phase,
+        static_cast<uint8_t>(phase_),
+        static_cast<uint64_t>(duration.count()));
+    HotPathTrace::get().record(phase_, duration);
+  }
+
+ private:
+  HotPathPhase phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Times a whole loop iteration and, once done, reports every phase that was
+ * accumulated during it to the stats callback. The callback pointer is read
+ * at the end of the scope since the transport may drop it while processing.
+ */
+template <typename StatsCallback>
+class ScopedHotPathLoop {
+ public:
+  ScopedHotPathLoop(StatsCallback*& statsCallback, HotPathPhase phase) noexcept
+      : statsCallback_(statsCallback),
+        phase_(phase),
+        start_(std::chrono::steady_clock::now()) {
+    HotPathTrace::get().push(loop_);
+  }
+
+  ~ScopedHotPathLoop() {
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_);
+    FOLLY_SDT(
+        quic,
+        hot_path_phase,
+        static_cast<uint8_t>(phase_),
+        static_cast<uint64_t>(duration.count()));
+    auto& trace = HotPathTrace::get();
+    trace.record(phase_, duration);
+    trace.pop(loop_);
+    auto statsCallback = statsCallback_;
+    loop_.flush([statsCallback](auto phase, auto phaseDuration) {
+      if (statsCallback) {
+        statsCallback->onHotPathLatency(phase, phaseDuration);
+      }
+    });
+  }
+
+ private:
+  StatsCallback*& statsCallback_;
+  HotPathPhase phase_;
+  std::chrono::steady_clock::time_point start_;
+  HotPathTrace::Loop loop_;
+};
+
+#define QUIC_TRACE_SCOPE(phase)                     \
+  ::quic::ScopedHotPathTimer FB_ANONYMOUS_VARIABLE( \
+      quicHotPathTimer)(::quic::HotPathPhase::phase)
+
+#define QUIC_TRACE_LOOP(statsCallback, phase)      \
+  ::quic::ScopedHotPathLoop FB_ANONYMOUS_VARIABLE( \
+      quicHotPathLoop)(statsCallback, ::quic::HotPathPhase::phase)
+
+#else
+
+#define QUIC_TRACE_SCOPE(phase)
+#define QUIC_TRACE_LOOP(statsCallback, phase)
+
+#endif
+
+} // namespace quic
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace quic {
+
+/**
+ * Fixed size log-linear histogram over uint64_t values.
+ *
+ * Values below kSubBuckets each get their own bucket. Every power of two range
+ * [2^k, 2^(k+1)) above that is split into kSubBuckets equally sized buckets,
+ * which bounds the relative error of any reported value by 1 / kSubBuckets
+ * while keeping the whole value range in a few KB.
+ *
+ * addValue() is meant to be called from a single writer thread (e.g. the
+ * worker that owns the histogram). It only does relaxed loads and stores, so
+ * there is no lock prefix or fence on the hot path. snapshot() can be called
+ * from any thread concurrently with the writer; the result may lag the writer
+ * by a few samples but is never torn per bucket.
+ */
+class LogLinearHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 3;
+  static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+  static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  struct Snapshot {
+    std::array<uint64_t, kNumBuckets> buckets{};
+    uint64_t count{0};
+    uint64_t sum{0};
+    uint64_t max{0};
+
+    void merge(const Snapshot& other) noexcept {
+      for (size_t i = 0; i < kNumBuckets; ++i) {
+        buckets[i] += other.buckets[i];
+      }
+      count += other.count;
+      sum += other.sum;
+      max = std::max(max, other.max);
+    }
+
+    uint64_t mean() const noexcept {
+      return count ? sum / count : 0;
+    }
+
+    /**
+     * Returns the upper bound of the bucket holding the given percentile,
+     * clamped to the largest value seen. pct is in [0, 100].
+     */
+    uint64_t percentile(double pct) const noexcept {
+      if (count == 0) {
+        return 0;
+      }
+      auto target = static_cast<uint64_t>(pct / 100.0 * count);
+      if (target == 0) {
+        target = 1;
+      }
+      uint64_t seen = 0;
+      for (size_t i = 0; i < kNumBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= target) {
+          return std::min(bucketUpperBound(i), max);
+        }
+      }
+      return max;
+    }
+  };
+
+  static size_t bucketIndex(uint64_t value) noexcept {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    // findLastSet is 1-based, so this is the index of the highest set bit.
+    size_t msb = folly::findLastSet(value) - 1;
+    size_t shift = msb - kSubBucketBits;
+    size_t sub = (value >> shift) & (kSubBuckets - 1);
+    return (shift + 1) * kSubBuckets + sub;
+  }
+
+  static uint64_t bucketLowerBound(size_t index) noexcept {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    size_t shift = index / kSubBuckets - 1;
+    size_t sub = index % kSubBuckets;
+    return static_cast<uint64_t>(kSubBuckets + sub) << shift;
+  }
+
+  static uint64_t bucketUpperBound(size_t index) noexcept {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    size_t shift = index / kSubBuckets - 1;
+    return bucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+  }
+
+  void addValue(uint64_t value) noexcept {
+    bump(buckets_[bucketIndex(value)], 1);
+    bump(count_, 1);
+    bump(sum_, value);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  Snapshot snapshot() const noexcept {
+    Snapshot snap;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    snap.count = count_.load(std::memory_order_relaxed);
+    snap.sum = sum_.load(std::memory_order_relaxed);
+    snap.max = max_.load(std::memory_order_relaxed);
+    return snap;
+  }
+
+ private:
+  // Single writer, so a plain load + store is enough and avoids the locked
+  // read-modify-write a fetch_add would cost.
+  static void bump(std::atomic<uint64_t>& val, uint64_t delta) noexcept {
+    val.store(
+        val.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+} // namespace quic
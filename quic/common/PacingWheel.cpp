@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/PacingWheel.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+PacingWheel::Callback::~Callback() {
+  cancelPacing();
+}
+
+bool PacingWheel::Callback::isPacingScheduled() const noexcept {
+  return wheel_ != nullptr;
+}
+
+void PacingWheel::Callback::cancelPacing() noexcept {
+  if (wheel_) {
+    wheel_->cancel(*this);
+  }
+}
+
+PacingWheel::UniquePtr PacingWheel::newWheel(
+    TimerHighRes::SharedPtr timer,
+    size_t numSlots) {
+  return UniquePtr(new PacingWheel(std::move(timer), numSlots));
+}
+
+PacingWheel::PacingWheel(TimerHighRes::SharedPtr timer, size_t numSlots)
+    : timer_(std::move(timer)),
+      start_(std::chrono::steady_clock::now()),
+      slots_(numSlots) {
+  CHECK(timer_);
+  CHECK_GT(numSlots, 0);
+  tickInterval_ = timer_->getTickInterval();
+  CHECK_GT(tickInterval_.count(), 0);
+}
+
+PacingWheel::~PacingWheel() {
+  for (auto& slot : slots_) {
+    while (!slot.empty()) {
+      auto& callback = slot.front();
+      slot.pop_front();
+      callback.wheel_ = nullptr;
+    }
+  }
+}
+
+uint64_t PacingWheel::tickOf(
+    std::chrono::steady_clock::time_point time,
+    bool roundUp) const noexcept {
+  if (time <= start_) {
+    return 0;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      time - start_);
+  auto tick = elapsed / tickInterval_;
+  if (roundUp && elapsed % tickInterval_ != std::chrono::microseconds::zero()) {
+    tick++;
+  }
+  return tick;
+}
+
+void PacingWheel::scheduleTimeout(
+    Callback* callback,
+    std::chrono::microseconds timeout) noexcept {
+  DCHECK(callback);
+  callback->cancelPacing();
+  auto now = std::chrono::steady_clock::now();
+  auto dueTick =
+      std::max(tickOf(now + timeout, true /* roundUp */), lastDrainedTick_ + 1);
+  callback->wheel_ = this;
+  callback->dueTick_ = dueTick;
+  slots_[dueTick % slots_.size()].push_back(*callback);
+  count_++;
+  // The end of the pass looks for the next wake up anyway.
+  if (!draining_ && (!wakeUpTick_ || dueTick < *wakeUpTick_)) {
+    scheduleWakeUp(dueTick, now);
+  }
+}
+
+void PacingWheel::cancel(Callback& callback) noexcept {
+  DCHECK_EQ(callback.wheel_, this);
+  callback.hook_.unlink();
+  callback.wheel_ = nullptr;
+  count_--;
+  // A wake up for nothing is cheaper than looking for the next one here.
+}
+
+void PacingWheel::scheduleWakeUp(
+    uint64_t tick,
+    std::chrono::steady_clock::time_point now) noexcept {
+  wakeUpTick_ = tick;
+  auto wakeUpTime = start_ + tickInterval_ * static_cast<int64_t>(tick);
+  auto timeout = wakeUpTime > now
+      ? std::chrono::duration_cast<std::chrono::microseconds>(wakeUpTime - now)
+      : std::chrono::microseconds::zero();
+  if (isScheduled()) {
+    cancelTimeout();
+  }
+  timer_->scheduleTimeout(this, timeout);
+}
+
+void PacingWheel::scheduleNextWakeUp(
+    std::chrono::steady_clock::time_point now) noexcept {
+  wakeUpTick_ = folly::none;
+  if (isScheduled()) {
+    cancelTimeout();
+  }
+  if (count_ == 0) {
+    return;
+  }
+  // A callback due more than a turn away sits in a slot scanned first, the
+  // wheel then wakes up early for it and looks again.
+  for (size_t i = 1; i <= slots_.size(); i++) {
+    auto tick = lastDrainedTick_ + i;
+    if (!slots_[tick % slots_.size()].empty()) {
+      scheduleWakeUp(tick, now);
+      return;
+    }
+  }
+}
+
+void PacingWheel::timeoutExpired() noexcept {
+  folly::DelayedDestruction::DestructorGuard dg(this);
+  auto now = std::chrono::steady_clock::now();
+  // The timer may fire a bit ahead of the tick it was scheduled for.
+  auto nowTick =
+      std::max(tickOf(now, false /* roundUp */), wakeUpTick_.value_or(0));
+  wakeUpTick_ = folly::none;
+  numPasses_++;
+
+  // Take the due callbacks out first, so that the ones scheduling themselves
+  // again while running land in a later slot.
+  CallbackList due;
+  auto numTicks = std::min<uint64_t>(nowTick - lastDrainedTick_, slots_.size());
+  for (uint64_t i = 1; i <= numTicks; i++) {
+    auto& slot = slots_[(lastDrainedTick_ + i) % slots_.size()];
+    for (auto it = slot.begin(); it != slot.end();) {
+      auto& callback = *it++;
+      if (callback.dueTick_ <= nowTick) {
+        callback.hook_.unlink();
+        due.push_back(callback);
+      }
+    }
+  }
+  lastDrainedTick_ = nowTick;
+
+  draining_ = true;
+  while (!due.empty()) {
+    auto& callback = due.front();
+    due.pop_front();
+    callback.wheel_ = nullptr;
+    count_--;
+    callback.pacingWheelExpired();
+  }
+  if (drainCallback_) {
+    drainCallback_();
+  }
+  draining_ = false;
+  scheduleNextWakeUp(std::chrono::steady_clock::now());
+}
+
+std::chrono::microseconds PacingWheel::getTickInterval() const noexcept {
+  return tickInterval_;
+}
+
+void PacingWheel::setDrainCallback(folly::Function<void()> drainCallback) {
+  drainCallback_ = std::move(drainCallback);
+}
+
+size_t PacingWheel::count() const noexcept {
+  return count_;
+}
+
+uint64_t PacingWheel::numPasses() const noexcept {
+  return numPasses_;
+}
+
+} // namespace quic
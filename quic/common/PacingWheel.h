@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/IntrusiveList.h>
+#include <folly/Optional.h>
+#include <quic/common/Timers.h>
+
+#include <chrono>
+#include <vector>
+
+namespace quic {
+
+// With the default 1ms pacing tick, the wheel spans about a second. Callbacks
+// due further away stay in their slot for more than one turn.
+constexpr size_t kDefaultPacingWheelSlots = 1024;
+
+/**
+ * A calendar of paced writes, shared by the connections of a worker. Time is
+ * cut into slots of the timer's tick interval, and each callback sits in the
+ * slot of the tick it is due at. The wheel keeps a single timeout on the
+ * timer, for the earliest non-empty slot, and runs every callback due by
+ * then in one pass. Connections due on the same tick then write back to back
+ * instead of each waking up on its own, and the drain callback runs once
+ * after each pass, e.g. to flush a batch writer they share.
+ *
+ * A callback never runs before the tick it is due at, but may run up to one
+ * tick later than the timeout it was scheduled with, as with the timer.
+ */
+class PacingWheel : public folly::DelayedDestruction,
+                    private TimerHighRes::Callback {
+ public:
+  class Callback {
+   public:
+    virtual ~Callback();
+
+    virtual void pacingWheelExpired() noexcept = 0;
+
+    bool isPacingScheduled() const noexcept;
+
+    void cancelPacing() noexcept;
+
+   private:
+    friend class PacingWheel;
+
+    PacingWheel* wheel_{nullptr};
+    uint64_t dueTick_{0};
+    folly::IntrusiveListHook hook_;
+  };
+
+  using UniquePtr = std::unique_ptr<PacingWheel, Destructor>;
+  using SharedPtr = std::shared_ptr<PacingWheel>;
+
+  static UniquePtr newWheel(
+      TimerHighRes::SharedPtr timer,
+      size_t numSlots = kDefaultPacingWheelSlots);
+
+  /**
+   * Schedules the callback to run timeout from now, rescheduling it if it was
+   * already scheduled.
+   */
+  void scheduleTimeout(
+      Callback* callback,
+      std::chrono::microseconds timeout) noexcept;
+
+  std::chrono::microseconds getTickInterval() const noexcept;
+
+  /**
+   * Runs after each pass, once all the callbacks due in it ran.
+   */
+  void setDrainCallback(folly::Function<void()> drainCallback);
+
+  // Number of callbacks scheduled.
+  size_t count() const noexcept;
+
+  // Number of times the wheel woke up and ran its due callbacks.
+  uint64_t numPasses() const noexcept;
+
+ private:
+  using CallbackList = folly::IntrusiveList<Callback, &Callback::hook_>;
+
+  PacingWheel(TimerHighRes::SharedPtr timer, size_t numSlots);
+  ~PacingWheel() override;
+
+  void timeoutExpired() noexcept override;
+  void callbackCanceled() noexcept override {}
+
+  uint64_t tickOf(
+      std::chrono::steady_clock::time_point time,
+      bool roundUp) const noexcept;
+  void cancel(Callback& callback) noexcept;
+  void scheduleWakeUp(
+      uint64_t tick,
+      std::chrono::steady_clock::time_point now) noexcept;
+  // Wakes up at the earliest non-empty slot, if there is any.
+  void scheduleNextWakeUp(std::chrono::steady_clock::time_point now) noexcept;
+
+  TimerHighRes::SharedPtr timer_;
+  std::chrono::microseconds tickInterval_;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<CallbackList> slots_;
+  // Slots up to and including this tick have been drained.
+  uint64_t lastDrainedTick_{0};
+  folly::Optional<uint64_t> wakeUpTick_;
+  size_t count_{0};
+  uint64_t numPasses_{0};
+  bool draining_{false};
+  folly::Function<void()> drainCallback_;
+};
+
+} // namespace quic
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/FairPacingScheduler.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace std;
+using namespace folly;
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+using Turn = std::pair<int, uint64_t>;
+
+class TestFlow : public FairPacingScheduler::Flow {
+ public:
+  TestFlow(int id, uint64_t packets, std::vector<Turn>& turns)
+      : id_(id), packets_(packets), turns_(turns) {}
+
+  uint64_t fairPacingWrite(uint64_t maxPackets) noexcept override {
+    auto written = std::min(maxPackets, packets_);
+    packets_ -= written;
+    turns_.emplace_back(id_, written);
+    if (onWrite) {
+      onWrite();
+    }
+    return written;
+  }
+
+  folly::Function<void()> onWrite;
+
+ private:
+  int id_;
+  uint64_t packets_;
+  std::vector<Turn>& turns_;
+};
+
+TEST(FairPacingSchedulerTest, RoundRobin) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 2, 64));
+  size_t drains = 0;
+  scheduler->setDrainCallback([&]() { drains++; });
+  std::vector<Turn> turns;
+  TestFlow flow0(0, 6, turns), flow1(1, 6, turns), flow2(2, 6, turns);
+  scheduler->enqueue(&flow0, 6);
+  scheduler->enqueue(&flow1, 6);
+  scheduler->enqueue(&flow2, 6);
+  EXPECT_TRUE(flow0.isFlowQueued());
+  EXPECT_EQ(3, scheduler->count());
+  evb.loop();
+  std::vector<Turn> expected;
+  for (int round = 0; round < 3; round++) {
+    for (int id = 0; id < 3; id++) {
+      expected.emplace_back(id, 2);
+    }
+  }
+  EXPECT_EQ(expected, turns);
+  EXPECT_FALSE(flow0.isFlowQueued());
+  EXPECT_EQ(0, scheduler->count());
+  EXPECT_EQ(1, scheduler->numPasses());
+  EXPECT_EQ(1, drains);
+  EXPECT_EQ(1, flow0.getFlowStats().numEnqueued);
+  EXPECT_EQ(6, flow0.getFlowStats().packetsWritten);
+}
+
+TEST(FairPacingSchedulerTest, ShortFlowLeavesEarly) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 2, 64));
+  std::vector<Turn> turns;
+  TestFlow longFlow(0, 7, turns), shortFlow(1, 3, turns);
+  scheduler->enqueue(&longFlow, 7);
+  scheduler->enqueue(&shortFlow, 3);
+  evb.loop();
+  std::vector<Turn> expected{{0, 2}, {1, 2}, {0, 2}, {1, 1}, {0, 2}, {0, 1}};
+  EXPECT_EQ(expected, turns);
+}
+
+TEST(FairPacingSchedulerTest, FlowWritesLess) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 4, 64));
+  std::vector<Turn> turns;
+  // Wants 10 packets, but only has 1 to write once it gets its turn.
+  TestFlow flow(0, 1, turns);
+  scheduler->enqueue(&flow, 10);
+  evb.loop();
+  std::vector<Turn> expected{{0, 1}};
+  EXPECT_EQ(expected, turns);
+  EXPECT_FALSE(flow.isFlowQueued());
+}
+
+TEST(FairPacingSchedulerTest, PacketsPerPass) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 2, 5));
+  std::vector<Turn> turns;
+  TestFlow flow0(0, 6, turns), flow1(1, 6, turns);
+  scheduler->enqueue(&flow0, 6);
+  scheduler->enqueue(&flow1, 6);
+  evb.loopOnce();
+  std::vector<Turn> expected{{0, 2}, {1, 2}, {0, 1}};
+  EXPECT_EQ(expected, turns);
+  EXPECT_EQ(2, scheduler->count());
+  evb.loop();
+  // flow0 kept the deficit it had no budget for.
+  expected.insert(expected.end(), {{1, 2}, {0, 3}, {1, 2}});
+  EXPECT_EQ(expected, turns);
+  EXPECT_EQ(2, scheduler->numPasses());
+  EXPECT_EQ(0, scheduler->count());
+}
+
+TEST(FairPacingSchedulerTest, EnqueueTwice) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 2, 64));
+  std::vector<Turn> turns;
+  TestFlow flow0(0, 4, turns), flow1(1, 2, turns);
+  scheduler->enqueue(&flow0, 2);
+  scheduler->enqueue(&flow1, 2);
+  scheduler->enqueue(&flow0, 4);
+  scheduler->enqueue(&flow0, 0);
+  EXPECT_EQ(2, scheduler->count());
+  EXPECT_EQ(1, flow0.getFlowStats().numEnqueued);
+  evb.loop();
+  std::vector<Turn> expected{{0, 2}, {1, 2}, {0, 2}};
+  EXPECT_EQ(expected, turns);
+}
+
+TEST(FairPacingSchedulerTest, DequeueDuringPass) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 2, 64));
+  std::vector<Turn> turns;
+  TestFlow flow0(0, 4, turns);
+  auto flow1 = std::make_unique<TestFlow>(1, 4, turns);
+  auto flow2 = std::make_unique<TestFlow>(2, 4, turns);
+  // flow1 goes away in the turn of flow0, flow2 leaves in its own turn.
+  flow0.onWrite = [&]() { flow1.reset(); };
+  flow2->onWrite = [&]() { flow2->dequeueFlow(); };
+  scheduler->enqueue(&flow0, 4);
+  scheduler->enqueue(flow1.get(), 4);
+  scheduler->enqueue(flow2.get(), 4);
+  evb.loop();
+  std::vector<Turn> expected{{0, 2}, {2, 2}, {0, 2}};
+  EXPECT_EQ(expected, turns);
+  EXPECT_FALSE(flow2->isFlowQueued());
+  EXPECT_EQ(0, scheduler->count());
+}
+
+TEST(FairPacingSchedulerTest, DestroyScheduler) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 2, 64));
+  std::vector<Turn> turns;
+  TestFlow flow(0, 4, turns);
+  scheduler->enqueue(&flow, 4);
+  scheduler.reset();
+  EXPECT_FALSE(flow.isFlowQueued());
+  evb.loop();
+  EXPECT_TRUE(turns.empty());
+}
+
+TEST(FairPacingSchedulerTest, QueueingDelay) {
+  EventBase evb;
+  FairPacingScheduler::SharedPtr scheduler(
+      FairPacingScheduler::newScheduler(&evb, 2, 64));
+  std::vector<Turn> turns;
+  TestFlow flow(0, 4, turns);
+  scheduler->enqueue(&flow, 2);
+  std::this_thread::sleep_for(2ms);
+  evb.loop();
+  scheduler->enqueue(&flow, 2);
+  evb.loop();
+  const auto& stats = flow.getFlowStats();
+  EXPECT_EQ(2, stats.numEnqueued);
+  EXPECT_EQ(4, stats.packetsWritten);
+  EXPECT_GE(stats.maxQueueingDelay, 2ms);
+  EXPECT_GE(stats.totalQueueingDelay, stats.maxQueueingDelay);
+}
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/HotPathTrace.h>
+
+#include <folly/portability/GTest.h>
+#include <vector>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+TEST(HotPathTraceTest, PhaseNames) {
+  EXPECT_STREQ("READ_LOOP", toString(HotPathPhase::READ_LOOP));
+  EXPECT_STREQ("SOCKET_WRITE", toString(HotPathPhase::SOCKET_WRITE));
+}
+
+#ifdef QUIC_HOT_PATH_TRACING
+namespace {
+struct FakeStats {
+  void onHotPathLatency(HotPathPhase phase, std::chrono::nanoseconds) {
+    phases.push_back(phase);
+  }
+  std::vector<HotPathPhase> phases;
+};
+} // namespace
+
+TEST(HotPathTraceTest, LoopFlushesNestedPhases) {
+  FakeStats stats;
+  FakeStats* statsPtr = &stats;
+  {
+    QUIC_TRACE_LOOP(statsPtr, READ_LOOP);
+    {
+      QUIC_TRACE_SCOPE(DECRYPT);
+    }
+    {
+      QUIC_TRACE_SCOPE(FRAME_PARSE);
+    }
+    {
+      QUIC_TRACE_SCOPE(DECRYPT);
+    }
+  }
+  // One report per phase per loop iteration, in enum order.
+  std::vector<HotPathPhase> expected = {
+      HotPathPhase::READ_LOOP, HotPathPhase::DECRYPT, HotPathPhase::FRAME_PARSE};
+  EXPECT_EQ(expected, stats.phases);
+
+  stats.phases.clear();
+  {
+    QUIC_TRACE_LOOP(statsPtr, WRITE_LOOP);
+  }
+  EXPECT_EQ(std::vector<HotPathPhase>{HotPathPhase::WRITE_LOOP}, stats.phases);
+}
+
+TEST(HotPathTraceTest, NestedLoopsReportSeparately) {
+  FakeStats readStats;
+  FakeStats* readStatsPtr = &readStats;
+  FakeStats writeStats;
+  FakeStats* writeStatsPtr = &writeStats;
+  {
+    QUIC_TRACE_LOOP(readStatsPtr, READ_LOOP);
+    {
+      QUIC_TRACE_SCOPE(DECRYPT);
+    }
+    {
+      QUIC_TRACE_LOOP(writeStatsPtr, WRITE_LOOP);
+      {
+        QUIC_TRACE_SCOPE(ENCRYPT);
+      }
+    }
+    // The write loop's flush didn't take the read loop's phases with it.
+    EXPECT_TRUE(readStats.phases.empty());
+    {
+      QUIC_TRACE_SCOPE(FRAME_PARSE);
+    }
+  }
+  std::vector<HotPathPhase> expectedWrite = {
+      HotPathPhase::WRITE_LOOP, HotPathPhase::ENCRYPT};
+  EXPECT_EQ(expectedWrite, writeStats.phases);
+  std::vector<HotPathPhase> expectedRead = {
+      HotPathPhase::READ_LOOP,
+      HotPathPhase::DECRYPT,
+      HotPathPhase::FRAME_PARSE};
+  EXPECT_EQ(expectedRead, readStats.phases);
+}
+
+TEST(HotPathTraceTest, PhaseOutsideLoopDropped) {
+  FakeStats stats;
+  FakeStats* statsPtr = &stats;
+  {
+    QUIC_TRACE_SCOPE(SOCKET_WRITE);
+  }
+  {
+    QUIC_TRACE_LOOP(statsPtr, WRITE_LOOP);
+  }
+  EXPECT_EQ(std::vector<HotPathPhase>{HotPathPhase::WRITE_LOOP}, stats.phases);
+}
+#endif
+
+} // namespace test
+} // namespace quic
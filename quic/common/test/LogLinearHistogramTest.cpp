@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/LogLinearHistogram.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+TEST(LogLinearHistogramTest, SmallValuesHaveTheirOwnBucket) {
+  for (uint64_t v = 0; v < LogLinearHistogram::kSubBuckets; ++v) {
+    EXPECT_EQ(v, LogLinearHistogram::bucketIndex(v));
+    EXPECT_EQ(v, LogLinearHistogram::bucketLowerBound(v));
+    EXPECT_EQ(v, LogLinearHistogram::bucketUpperBound(v));
+  }
+}
+
+TEST(LogLinearHistogramTest, BucketBoundsContainValue) {
+  std::vector<uint64_t> values = {
+      8, 9, 15, 16, 17, 100, 1000, 12345, 1ULL << 40, (1ULL << 40) + 7};
+  values.push_back(std::numeric_limits<uint64_t>::max());
+  for (auto v : values) {
+    auto index = LogLinearHistogram::bucketIndex(v);
+    EXPECT_LT(index, LogLinearHistogram::kNumBuckets);
+    EXPECT_LE(LogLinearHistogram::bucketLowerBound(index), v);
+    EXPECT_GE(LogLinearHistogram::bucketUpperBound(index), v);
+  }
+}
+
+TEST(LogLinearHistogramTest, BucketsAreMonotonic) {
+  for (size_t i = 1; i < LogLinearHistogram::kNumBuckets; ++i) {
+    EXPECT_EQ(
+        LogLinearHistogram::bucketUpperBound(i - 1) + 1,
+        LogLinearHistogram::bucketLowerBound(i));
+  }
+}
+
+TEST(LogLinearHistogramTest, SnapshotAndPercentiles) {
+  LogLinearHistogram histogram;
+  for (uint64_t v = 1; v <= 1000; ++v) {
+    histogram.addValue(v);
+  }
+  auto snap = histogram.snapshot();
+  EXPECT_EQ(1000, snap.count);
+  EXPECT_EQ(500500, snap.sum);
+  EXPECT_EQ(1000, snap.max);
+  EXPECT_EQ(500, snap.mean());
+  // Relative error is bounded by the sub bucket resolution.
+  auto p50 = snap.percentile(50);
+  EXPECT_GE(p50, 500);
+  EXPECT_LE(p50, 500 + 500 / LogLinearHistogram::kSubBuckets);
+  EXPECT_EQ(1000, snap.percentile(100));
+}
+
+TEST(LogLinearHistogramTest, Merge) {
+  LogLinearHistogram h1, h2;
+  h1.addValue(10);
+  h2.addValue(20);
+  h2.addValue(30);
+  auto snap = h1.snapshot();
+  snap.merge(h2.snapshot());
+  EXPECT_EQ(3, snap.count);
+  EXPECT_EQ(60, snap.sum);
+  EXPECT_EQ(30, snap.max);
+  EXPECT_EQ(0, LogLinearHistogram::Snapshot().percentile(99));
+}
+
+} // namespace test
+} // namespace quic
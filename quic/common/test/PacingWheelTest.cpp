@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/common/PacingWheel.h>
+
+#include <gtest/gtest.h>
+#include <quic/common/FunctionLooper.h>
+
+using namespace std;
+using namespace folly;
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+class TestPacingCallback : public PacingWheel::Callback {
+ public:
+  explicit TestPacingCallback(folly::Function<void()> func = nullptr)
+      : func_(std::move(func)) {}
+
+  void pacingWheelExpired() noexcept override {
+    runTimes.push_back(std::chrono::steady_clock::now());
+    if (func_) {
+      func_();
+    }
+  }
+
+  std::vector<std::chrono::steady_clock::time_point> runTimes;
+
+ private:
+  folly::Function<void()> func_;
+};
+
+TEST(PacingWheelTest, SameTickInOnePass) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  size_t drains = 0;
+  wheel->setDrainCallback([&]() { drains++; });
+  EXPECT_EQ(1ms, wheel->getTickInterval());
+
+  std::vector<TestPacingCallback> callbacks(3);
+  for (auto& callback : callbacks) {
+    wheel->scheduleTimeout(&callback, 3ms);
+    EXPECT_TRUE(callback.isPacingScheduled());
+  }
+  EXPECT_EQ(3, wheel->count());
+  evb.loop();
+  for (auto& callback : callbacks) {
+    EXPECT_EQ(1, callback.runTimes.size());
+    EXPECT_FALSE(callback.isPacingScheduled());
+  }
+  EXPECT_EQ(0, wheel->count());
+  // They were all due within the same tick, or the one after at worst.
+  EXPECT_LE(wheel->numPasses(), 2);
+  EXPECT_EQ(wheel->numPasses(), drains);
+}
+
+TEST(PacingWheelTest, NotBeforeDue) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  TestPacingCallback early, late;
+  auto start = std::chrono::steady_clock::now();
+  wheel->scheduleTimeout(&late, 20ms);
+  wheel->scheduleTimeout(&early, 2ms);
+  evb.loop();
+  ASSERT_EQ(1, early.runTimes.size());
+  ASSERT_EQ(1, late.runTimes.size());
+  EXPECT_LT(early.runTimes.front(), late.runTimes.front());
+  // The timer may fire a bit ahead, but never a whole tick.
+  EXPECT_GE(early.runTimes.front() - start, 1ms);
+  EXPECT_GE(late.runTimes.front() - start, 19ms);
+  EXPECT_EQ(2, wheel->numPasses());
+}
+
+TEST(PacingWheelTest, Cancel) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  TestPacingCallback canceled, kept;
+  wheel->scheduleTimeout(&canceled, 2ms);
+  wheel->scheduleTimeout(&kept, 5ms);
+  canceled.cancelPacing();
+  EXPECT_FALSE(canceled.isPacingScheduled());
+  EXPECT_EQ(1, wheel->count());
+  evb.loop();
+  EXPECT_TRUE(canceled.runTimes.empty());
+  EXPECT_EQ(1, kept.runTimes.size());
+}
+
+TEST(PacingWheelTest, Reschedule) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  TestPacingCallback callback;
+  wheel->scheduleTimeout(&callback, 2ms);
+  wheel->scheduleTimeout(&callback, 4ms);
+  EXPECT_EQ(1, wheel->count());
+  evb.loop();
+  EXPECT_EQ(1, callback.runTimes.size());
+}
+
+TEST(PacingWheelTest, ScheduleFromCallback) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  TestPacingCallback* self = nullptr;
+  size_t runs = 0;
+  TestPacingCallback callback([&]() {
+    if (++runs < 5) {
+      // Even a zero timeout goes to the next tick rather than this pass.
+      wheel->scheduleTimeout(self, 0us);
+    }
+  });
+  self = &callback;
+  wheel->scheduleTimeout(&callback, 1ms);
+  evb.loop();
+  EXPECT_EQ(5, runs);
+  EXPECT_EQ(5, wheel->numPasses());
+  EXPECT_EQ(0, wheel->count());
+}
+
+TEST(PacingWheelTest, DestroyCallback) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  TestPacingCallback kept;
+  wheel->scheduleTimeout(&kept, 3ms);
+  {
+    TestPacingCallback destroyed;
+    wheel->scheduleTimeout(&destroyed, 2ms);
+    EXPECT_EQ(2, wheel->count());
+  }
+  EXPECT_EQ(1, wheel->count());
+  evb.loop();
+  EXPECT_EQ(1, kept.runTimes.size());
+}
+
+TEST(PacingWheelTest, DestroyWheel) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  TestPacingCallback callback;
+  wheel->scheduleTimeout(&callback, 2ms);
+  wheel.reset();
+  EXPECT_FALSE(callback.isPacingScheduled());
+  evb.loop();
+  EXPECT_TRUE(callback.runTimes.empty());
+}
+
+TEST(PacingWheelTest, PacedLoopers) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  size_t drains = 0;
+  wheel->setDrainCallback([&]() { drains++; });
+  std::vector<FunctionLooper::Ptr> loopers;
+  std::vector<std::vector<bool>> fromTimerVecs(4);
+  std::vector<bool> paced(4, false);
+  for (size_t i = 0; i < 4; i++) {
+    auto func = [&, i](bool fromTimer) {
+      fromTimerVecs[i].push_back(fromTimer);
+      if (fromTimer) {
+        loopers[i]->stop();
+      }
+    };
+    auto pacingFunc = [&, i]() -> auto {
+      if (!paced[i]) {
+        paced[i] = true;
+        return 5ms;
+      }
+      return std::chrono::milliseconds::zero();
+    };
+    loopers.emplace_back(
+        new FunctionLooper(&evb, std::move(func), LooperType::WriteLooper));
+    loopers.back()->setPacingWheel(wheel);
+    loopers.back()->setPacingFunction(std::move(pacingFunc));
+    EXPECT_TRUE(loopers.back()->hasPacingTimer());
+    EXPECT_EQ(1ms, *loopers.back()->getTimerTickInterval());
+    loopers.back()->run();
+  }
+  evb.loop();
+  for (size_t i = 0; i < 4; i++) {
+    ASSERT_EQ(2, fromTimerVecs[i].size());
+    EXPECT_FALSE(fromTimerVecs[i].front());
+    EXPECT_TRUE(fromTimerVecs[i].back());
+    EXPECT_FALSE(loopers[i]->isPacingScheduled());
+  }
+  EXPECT_EQ(wheel->numPasses(), drains);
+  EXPECT_LE(wheel->numPasses(), 2);
+}
+
+TEST(PacingWheelTest, StopLooper) {
+  EventBase evb;
+  TimerHighRes::SharedPtr timer(TimerHighRes::newTimer(&evb, 1ms));
+  PacingWheel::SharedPtr wheel(PacingWheel::newWheel(timer));
+  size_t calls = 0;
+  auto func = [&](bool) { calls++; };
+  auto pacingFunc = [&]() -> auto { return 3600000ms; };
+  FunctionLooper::Ptr looper(
+      new FunctionLooper(&evb, std::move(func), LooperType::WriteLooper));
+  looper->setPacingWheel(wheel);
+  looper->setPacingFunction(std::move(pacingFunc));
+  looper->run();
+  evb.loopOnce();
+  EXPECT_EQ(1, calls);
+  EXPECT_TRUE(looper->isPacingScheduled());
+  EXPECT_EQ(1, wheel->count());
+  looper->stop();
+  EXPECT_FALSE(looper->isPacingScheduled());
+  EXPECT_EQ(0, wheel->count());
+}
+
+} // namespace test
+} // namespace quic
@@ -48,7 +48,7 @@ bool BbrCongestionController::updateRoundTripCounter(
     TimePoint largestAckedSentTime) noexcept {
   if (largestAckedSentTime > endOfRoundTrip_) {
     roundTripCounter_++;
-    endOfRoundTrip_ = Clock::now();
+    endOfRoundTrip_ = latestSentTime_;
     return true;
   }
   return false;
@@ -67,7 +67,7 @@ void BbrCongestionController::setBandwidthSampler(
 void BbrCongestionController::onPacketLoss(
     const LossEvent& loss,
     uint64_t ackedBytes) {
-  endOfRecovery_ = Clock::now();
+  endOfRecovery_ = loss.lossTime;
 
   if (!inRecovery()) {
     recoveryState_ = BbrCongestionController::RecoveryState::CONSERVATIVE;
@@ -80,7 +80,7 @@ void BbrCongestionController::onPacketLoss(
 
     // We need to make sure CONSERVATIVE can last for a round trip, so update
     // endOfRoundTrip_ to the latest sent packet.
-    endOfRoundTrip_ = Clock::now();
+    endOfRoundTrip_ = latestSentTime_;
 
     // TODO: maybe set appLimited in recovery based on config
   }
@@ -109,6 +109,7 @@ void BbrCongestionController::onPacketSent(const OutstandingPacket& packet) {
   }
   addAndCheckOverflow(
       conn_.lossState.inflightBytes, packet.metadata.encodedSize);
+  latestSentTime_ = std::max(latestSentTime_, packet.metadata.time);
   if (!ackAggregationStartTime_) {
     ackAggregationStartTime_ = packet.metadata.time;
   }
@@ -143,6 +144,12 @@ uint64_t BbrCongestionController::updateAckAggregation(const AckEvent& ack) {
 void BbrCongestionController::onPacketAckOrLoss(
     folly::Optional<AckEvent> ackEvent,
     folly::Optional<LossEvent> lossEvent) {
+  onPacketAckOrLossInPlace(ackEvent.get_pointer(), lossEvent.get_pointer());
+}
+
+void BbrCongestionController::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ackEvent,
+    const LossEvent* FOLLY_NULLABLE lossEvent) {
   auto prevInflightBytes = conn_.lossState.inflightBytes;
   if (ackEvent) {
     subtractAndCheckUnderflow(
@@ -160,7 +167,7 @@ void BbrCongestionController::onPacketAckOrLoss(
   }
   if (ackEvent && ackEvent->largestAckedPacket.has_value()) {
     CHECK(!ackEvent->ackedPackets.empty());
-    onPacketAcked(*ackEvent, prevInflightBytes, lossEvent.has_value());
+    onPacketAcked(*ackEvent, prevInflightBytes, lossEvent != nullptr);
   }
 }
 
@@ -545,6 +552,7 @@ bool BbrCongestionController::isAppLimited() const noexcept {
 
 void BbrCongestionController::getStats(CongestionControllerStats& stats) const {
   stats.bbrStats.state = static_cast<uint8_t>(state_);
+  stats.bbrStats.bandwidth = bandwidth().normalize();
 }
 
 uint64_t BbrCongestionController::getCongestionWindow() const noexcept {
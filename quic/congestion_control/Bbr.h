@@ -117,6 +117,9 @@ class BbrCongestionController : public CongestionController {
   void onPacketAckOrLoss(
       folly::Optional<AckEvent> ackEvent,
       folly::Optional<LossEvent> lossEvent) override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE ackEvent,
+      const LossEvent* FOLLY_NULLABLE lossEvent) override;
   uint64_t getWritableBytes() const noexcept override;
 
   uint64_t getCongestionWindow() const noexcept override;
@@ -201,6 +204,10 @@ class BbrCongestionController : public CongestionController {
   // When a packet with send time later than endOfRoundTrip_ is acked, the
   // current round strip is ended.
   TimePoint endOfRoundTrip_;
+  // Send time of the latest packet sent. Round trips and recovery are tracked
+  // with packet and event times rather than Clock::now() so that the
+  // controller can be driven by a simulated clock.
+  TimePoint latestSentTime_;
   // When a packet with send time later than endOfRecovery_ is acked, the
   // connection is no longer in recovery
   folly::Optional<TimePoint> endOfRecovery_;
@@ -0,0 +1,660 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/Bbr2.h>
+
+#include <folly/Random.h>
+#include <quic/QuicConstants.h>
+#include <quic/congestion_control/CongestionControlFunctions.h>
+#include <quic/logging/QLoggerConstants.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+quic::Bandwidth kLowPacingRateForSendQuantum{1200 * 1000, 1s};
+quic::Bandwidth kHighPacingRateForSendQuantum{24, 1us};
+// See BBRInflight(gain) function in
+// https://tools.ietf.org/html/draft-cardwell-iccrg-bbr-congestion-control-00#section-4.2.3.2
+uint64_t kQuantaFactor = 3;
+// Cap of the exponent of inflight_hi growth in ProbeBwUp.
+uint8_t kMaxProbeUpRounds = 30;
+} // namespace
+
+namespace quic {
+
+Bbr2CongestionController::Bbr2CongestionController(
+    QuicConnectionStateBase& conn)
+    : conn_(conn),
+      cwnd_(conn.udpSendPacketLen * conn.transportSettings.initCwndInMss),
+      initialCwnd_(
+          conn.udpSendPacketLen * conn.transportSettings.initCwndInMss),
+      pacingWindow_(
+          conn.udpSendPacketLen * conn.transportSettings.initCwndInMss),
+      maxAckHeightFilter_(kBandwidthWindowLength, 0, 0) {}
+
+CongestionControlType Bbr2CongestionController::type() const noexcept {
+  return CongestionControlType::BBR2;
+}
+
+void Bbr2CongestionController::setRttSampler(
+    std::unique_ptr<BbrCongestionController::MinRttSampler> sampler) noexcept {
+  minRttSampler_ = std::move(sampler);
+}
+
+void Bbr2CongestionController::setBandwidthSampler(
+    std::unique_ptr<BbrCongestionController::BandwidthSampler>
+        sampler) noexcept {
+  bandwidthSampler_ = std::move(sampler);
+}
+
+bool Bbr2CongestionController::updateRoundTripCounter(
+    TimePoint largestAckedSentTime) noexcept {
+  if (largestAckedSentTime > endOfRoundTrip_) {
+    roundTripCounter_++;
+    endOfRoundTrip_ = latestSentTime_;
+    return true;
+  }
+  return false;
+}
+
+void Bbr2CongestionController::startRound() noexcept {
+  endOfRoundTrip_ = latestSentTime_;
+}
+
+void Bbr2CongestionController::onRoundEnd() noexcept {
+  inflightLatest_ = bytesAckedInRound_;
+  if (bytesLostInRound_ > 0 && !isProbingBw()) {
+    // Back off to what the path delivered in the round, but no faster than
+    // kBbr2Beta per round trip.
+    inflightLo_ = std::max<uint64_t>(
+        inflightLatest_, inflightLo_.value_or(cwnd_) * kBbr2Beta);
+  }
+  if (state_ != State::Startup && state_ != State::Drain &&
+      state_ != State::ProbeRtt) {
+    roundsSinceProbeBw_++;
+  }
+  bytesAckedInRound_ = 0;
+  bytesLostInRound_ = 0;
+  packetsLostInRound_ = 0;
+}
+
+void Bbr2CongestionController::onPacketSent(const OutstandingPacket& packet) {
+  if (!conn_.lossState.inflightBytes && isAppLimited()) {
+    exitingQuiescene_ = true;
+  }
+  addAndCheckOverflow(
+      conn_.lossState.inflightBytes, packet.metadata.encodedSize);
+  latestSentTime_ = std::max(latestSentTime_, packet.metadata.time);
+  if (!ackAggregationStartTime_) {
+    ackAggregationStartTime_ = packet.metadata.time;
+  }
+}
+
+void Bbr2CongestionController::onPacketAckOrLoss(
+    folly::Optional<AckEvent> ackEvent,
+    folly::Optional<LossEvent> lossEvent) {
+  onPacketAckOrLossInPlace(ackEvent.get_pointer(), lossEvent.get_pointer());
+}
+
+void Bbr2CongestionController::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ackEvent,
+    const LossEvent* FOLLY_NULLABLE lossEvent) {
+  auto prevInflightBytes = conn_.lossState.inflightBytes;
+  if (ackEvent) {
+    subtractAndCheckUnderflow(
+        conn_.lossState.inflightBytes, ackEvent->ackedBytes);
+  }
+  if (lossEvent) {
+    subtractAndCheckUnderflow(
+        conn_.lossState.inflightBytes, lossEvent->lostBytes);
+  }
+  // Close the round trip before accounting the loss, so that the loss counts
+  // against the round trip it is detected in.
+  bool newRoundTrip = false;
+  if (ackEvent && ackEvent->largestAckedPacket.has_value() &&
+      !ackEvent->implicit) {
+    newRoundTrip =
+        updateRoundTripCounter(ackEvent->largestAckedPacketSentTime);
+    if (newRoundTrip) {
+      onRoundEnd();
+    }
+  }
+  if (lossEvent) {
+    onPacketLoss(*lossEvent, prevInflightBytes);
+    if (conn_.pacer) {
+      conn_.pacer->onPacketsLoss();
+    }
+  }
+  if (ackEvent && ackEvent->largestAckedPacket.has_value()) {
+    CHECK(!ackEvent->ackedPackets.empty());
+    onPacketAcked(*ackEvent, prevInflightBytes, newRoundTrip);
+  }
+}
+
+void Bbr2CongestionController::onPacketLoss(
+    const LossEvent& loss,
+    uint64_t prevInflightBytes) {
+  bytesLostInRound_ += loss.lostBytes;
+  packetsLostInRound_ += loss.lostPackets;
+  if (loss.persistentCongestion) {
+    cwnd_ = minCwnd();
+    if (conn_.qLogger) {
+      conn_.qLogger->addCongestionMetricUpdate(
+          conn_.lossState.inflightBytes,
+          getCongestionWindow(),
+          kPersistentCongestion,
+          bbr2StateToString(state_));
+    }
+  }
+  if (isInflightTooHigh(prevInflightBytes)) {
+    handleInflightTooHigh(prevInflightBytes, loss.lossTime);
+  }
+}
+
+bool Bbr2CongestionController::isInflightTooHigh(
+    uint64_t inflightBytes) const noexcept {
+  return bytesLostInRound_ > inflightBytes * kBbr2LossThreshold;
+}
+
+void Bbr2CongestionController::handleInflightTooHigh(
+    uint64_t inflightBytes,
+    TimePoint eventTime) {
+  if (state_ == State::Startup) {
+    // A few scattered losses can be from anything, a lot of them mean the
+    // bottleneck queue is overflowing.
+    if (packetsLostInRound_ >= kBbr2StartupFullLossCount) {
+      btlbwFound_ = true;
+      inflightHi_ = std::max(calculateTargetCwnd(1.0), inflightLatest_);
+    }
+    return;
+  }
+  if (state_ == State::ProbeBwRefill || state_ == State::ProbeBwUp) {
+    // The probe found the limit of the path, remember it. Refill keeps
+    // refilling the pipe under the new bound, Up stops probing.
+    inflightHi_ = std::max<uint64_t>(
+        inflightBytes, calculateTargetCwnd(1.0) * kBbr2Beta);
+    if (state_ == State::ProbeBwUp) {
+      transitToProbeBwDown(eventTime);
+    }
+  }
+}
+
+void Bbr2CongestionController::onPacketAcked(
+    const AckEvent& ack,
+    uint64_t prevInflightBytes,
+    bool newRoundTrip) {
+  SCOPE_EXIT {
+    if (conn_.qLogger) {
+      conn_.qLogger->addCongestionMetricUpdate(
+          conn_.lossState.inflightBytes,
+          getCongestionWindow(),
+          kCongestionPacketAck,
+          bbr2StateToString(state_));
+    }
+  };
+  if (ack.implicit) {
+    // This is an implicit ACK during the handshake, we can't trust very
+    // much about it except the fact that it does ACK some bytes.
+    updateCwnd(ack.ackedBytes, 0);
+    return;
+  }
+  if (ack.mrttSample && minRttSampler_) {
+    minRttSampler_->newRttSample(ack.mrttSample.value(), ack.ackTime);
+  }
+  bytesAckedInRound_ += ack.ackedBytes;
+  if (bandwidthSampler_) {
+    bandwidthSampler_->onPacketAcked(ack, roundTripCounter_);
+  }
+  auto excessiveBytes = updateAckAggregation(ack);
+
+  // Same as BBRv1, the ProbeBw phases need to be handled before we may
+  // transit into ProbeBw from Drain.
+  if (state_ == State::ProbeBwDown || state_ == State::ProbeBwCruise ||
+      state_ == State::ProbeBwRefill || state_ == State::ProbeBwUp) {
+    handleAckInProbeBw(ack, prevInflightBytes, newRoundTrip);
+  }
+
+  if (newRoundTrip && !ack.largestAckedPacketAppLimited) {
+    detectBottleneckBandwidth(ack.largestAckedPacketAppLimited);
+  }
+
+  if (state_ == State::Startup && btlbwFound_) {
+    transitToDrain();
+  }
+
+  if (state_ == State::Drain &&
+      conn_.lossState.inflightBytes <= calculateTargetCwnd(1.0)) {
+    transitToProbeBwDown(ack.ackTime);
+  }
+
+  if (shouldProbeRtt()) {
+    transitToProbeRtt();
+  }
+  exitingQuiescene_ = false;
+
+  if (state_ == State::ProbeRtt && minRttSampler_) {
+    handleAckInProbeRtt(newRoundTrip, ack.ackTime);
+  }
+
+  updateCwnd(ack.ackedBytes, excessiveBytes);
+  updatePacing();
+}
+
+void Bbr2CongestionController::handleAckInProbeBw(
+    const AckEvent& ack,
+    uint64_t prevInflightBytes,
+    bool newRoundTrip) {
+  switch (state_) {
+    case State::ProbeBwDown:
+      if (isTimeToProbeBw(ack.ackTime)) {
+        transitToProbeBwRefill();
+        return;
+      }
+      // Done draining the queue the last probe may have built.
+      if (conn_.lossState.inflightBytes <= inflightWithHeadroom() &&
+          conn_.lossState.inflightBytes <= calculateTargetCwnd(1.0)) {
+        transitToProbeBwCruise();
+      }
+      return;
+    case State::ProbeBwCruise:
+      if (isTimeToProbeBw(ack.ackTime)) {
+        transitToProbeBwRefill();
+      }
+      return;
+    case State::ProbeBwRefill:
+      // Refill spends one round trip at the estimated bandwidth with the
+      // lower bounds reset, so that the pipe is full but the queue is still
+      // empty when Up starts.
+      if (newRoundTrip) {
+        transitToProbeBwUp(ack.ackTime);
+      }
+      return;
+    case State::ProbeBwUp:
+      if (newRoundTrip && inflightHi_ &&
+          prevInflightBytes + conn_.udpSendPacketLen >= cwnd_) {
+        // We are using all of inflight_hi without too much loss, raise it
+        // exponentially with the number of rounds spent probing.
+        *inflightHi_ += conn_.udpSendPacketLen << probeUpRounds_;
+        probeUpRounds_ =
+            std::min<uint8_t>(probeUpRounds_ + 1, kMaxProbeUpRounds);
+      }
+      if (ack.ackTime - cycleStart_ > minRtt() &&
+          prevInflightBytes >= calculateTargetCwnd(kBbr2ProbeBwUpPacingGain)) {
+        transitToProbeBwDown(ack.ackTime);
+      }
+      return;
+    default:
+      return;
+  }
+}
+
+bool Bbr2CongestionController::isTimeToProbeBw(
+    TimePoint eventTime) const noexcept {
+  if (eventTime - cycleStart_ >= probeBwWait_) {
+    return true;
+  }
+  uint64_t bdpInPackets = calculateTargetCwnd(1.0) / conn_.udpSendPacketLen;
+  return roundsSinceProbeBw_ >= std::min(bdpInPackets, kBbr2ProbeBwMaxRounds);
+}
+
+bool Bbr2CongestionController::isProbingBw() const noexcept {
+  return state_ == State::Startup || state_ == State::ProbeBwRefill ||
+      state_ == State::ProbeBwUp;
+}
+
+bool Bbr2CongestionController::shouldProbeRtt() noexcept {
+  return state_ != State::ProbeRtt && minRttSampler_ && !exitingQuiescene_ &&
+      minRttSampler_->minRttExpired();
+}
+
+void Bbr2CongestionController::handleAckInProbeRtt(
+    bool newRoundTrip,
+    TimePoint ackTime) noexcept {
+  DCHECK(state_ == State::ProbeRtt);
+  CHECK(minRttSampler_);
+
+  if (bandwidthSampler_) {
+    bandwidthSampler_->onAppLimited();
+  }
+  if (!earliestTimeToExitProbeRtt_ &&
+      conn_.lossState.inflightBytes <= probeRttCwnd()) {
+    earliestTimeToExitProbeRtt_ = ackTime + kProbeRttDuration;
+    probeRttRound_ = folly::none;
+    return;
+  }
+  if (earliestTimeToExitProbeRtt_) {
+    if (!probeRttRound_ && newRoundTrip) {
+      probeRttRound_ = roundTripCounter_;
+    }
+    if (probeRttRound_ && *earliestTimeToExitProbeRtt_ <= ackTime) {
+      minRttSampler_->timestampMinRtt(ackTime);
+      inflightLo_ = folly::none;
+      if (btlbwFound_) {
+        transitToProbeBwDown(ackTime);
+        transitToProbeBwCruise();
+      } else {
+        transitToStartup();
+      }
+    }
+  }
+}
+
+void Bbr2CongestionController::transitToStartup() noexcept {
+  state_ = State::Startup;
+  pacingGain_ = kBbr2StartupPacingGain;
+  cwndGain_ = kBbr2StartupCwndGain;
+}
+
+void Bbr2CongestionController::transitToDrain() noexcept {
+  state_ = State::Drain;
+  pacingGain_ = kBbr2DrainPacingGain;
+  cwndGain_ = kBbr2StartupCwndGain;
+}
+
+void Bbr2CongestionController::transitToProbeBwDown(TimePoint eventTime) {
+  state_ = State::ProbeBwDown;
+  pacingGain_ = kBbr2ProbeBwDownPacingGain;
+  cwndGain_ = kProbeBwGain;
+  cycleStart_ = eventTime;
+  roundsSinceProbeBw_ = 0;
+  probeBwWait_ = kBbr2ProbeBwMinWait +
+      std::chrono::milliseconds(
+                     folly::Random::rand32(kBbr2ProbeBwRandWait.count()));
+  startRound();
+}
+
+void Bbr2CongestionController::transitToProbeBwCruise() noexcept {
+  state_ = State::ProbeBwCruise;
+  pacingGain_ = 1.0f;
+}
+
+void Bbr2CongestionController::transitToProbeBwRefill() noexcept {
+  state_ = State::ProbeBwRefill;
+  pacingGain_ = 1.0f;
+  inflightLo_ = folly::none;
+  probeUpRounds_ = 0;
+  startRound();
+}
+
+void Bbr2CongestionController::transitToProbeBwUp(
+    TimePoint eventTime) noexcept {
+  state_ = State::ProbeBwUp;
+  pacingGain_ = kBbr2ProbeBwUpPacingGain;
+  cycleStart_ = eventTime;
+  startRound();
+}
+
+void Bbr2CongestionController::transitToProbeRtt() noexcept {
+  state_ = State::ProbeRtt;
+  pacingGain_ = 1.0f;
+  earliestTimeToExitProbeRtt_ = folly::none;
+  probeRttRound_ = folly::none;
+  if (bandwidthSampler_) {
+    bandwidthSampler_->onAppLimited();
+  }
+}
+
+uint64_t Bbr2CongestionController::updateAckAggregation(const AckEvent& ack) {
+  if (!ackAggregationStartTime_) {
+    // See BbrCongestionController::updateAckAggregation, we may get an ack
+    // before ever seeing a packet sent if the controller is swapped in the
+    // middle of a connection.
+    return 0;
+  }
+  uint64_t expectedAckBytes = bandwidth() *
+      std::chrono::duration_cast<std::chrono::microseconds>(
+                                  ack.ackTime - *ackAggregationStartTime_);
+  if (aggregatedAckBytes_ <= expectedAckBytes) {
+    aggregatedAckBytes_ = ack.ackedBytes;
+    ackAggregationStartTime_ = ack.ackTime;
+    return 0;
+  }
+  aggregatedAckBytes_ += ack.ackedBytes;
+  maxAckHeightFilter_.Update(
+      aggregatedAckBytes_ - expectedAckBytes, roundTripCounter_);
+  return aggregatedAckBytes_ - expectedAckBytes;
+}
+
+void Bbr2CongestionController::detectBottleneckBandwidth(
+    bool appLimitedSample) {
+  if (btlbwFound_ || appLimitedSample) {
+    return;
+  }
+  auto bandwidthTarget = previousStartupBandwidth_ * kExpectedStartupGrowth;
+  auto realBandwidth = bandwidth();
+  if (realBandwidth >= bandwidthTarget) {
+    previousStartupBandwidth_ = realBandwidth;
+    slowStartupRoundCounter_ = 0;
+    return;
+  }
+  if (++slowStartupRoundCounter_ >= kStartupSlowGrowRoundLimit) {
+    btlbwFound_ = true;
+  }
+}
+
+uint64_t Bbr2CongestionController::calculateTargetCwnd(
+    float gain) const noexcept {
+  auto bandwidthEst = bandwidth();
+  auto minRttEst = minRtt();
+  if (!bandwidthEst || minRttEst == 0us) {
+    return gain * initialCwnd_;
+  }
+  uint64_t bdp = bandwidthEst * minRttEst;
+  return bdp * gain + kQuantaFactor * sendQuantum_;
+}
+
+uint64_t Bbr2CongestionController::inflightWithHeadroom() const noexcept {
+  if (!inflightHi_) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  uint64_t headroom = std::max<uint64_t>(
+      conn_.udpSendPacketLen, *inflightHi_ * kBbr2Headroom);
+  return *inflightHi_ > headroom + minCwnd() ? *inflightHi_ - headroom
+                                             : minCwnd();
+}
+
+uint64_t Bbr2CongestionController::probeRttCwnd() const noexcept {
+  return boundedCwnd(
+      calculateTargetCwnd(kBbr2ProbeRttCwndGain),
+      conn_.udpSendPacketLen,
+      conn_.transportSettings.maxCwndInMss,
+      kMinCwndInMssForBbr);
+}
+
+uint64_t Bbr2CongestionController::minCwnd() const noexcept {
+  return conn_.udpSendPacketLen * kMinCwndInMssForBbr;
+}
+
+void Bbr2CongestionController::updateCwnd(
+    uint64_t ackedBytes,
+    uint64_t excessiveBytes) noexcept {
+  if (state_ == State::ProbeRtt) {
+    return;
+  }
+
+  auto pacingRate = bandwidth() * pacingGain_;
+  if (pacingRate < kLowPacingRateForSendQuantum) {
+    sendQuantum_ = conn_.udpSendPacketLen;
+  } else if (pacingRate < kHighPacingRateForSendQuantum) {
+    sendQuantum_ = conn_.udpSendPacketLen * 2;
+  } else {
+    sendQuantum_ = std::min(pacingRate * 1000us, k64K);
+  }
+  auto targetCwnd = calculateTargetCwnd(cwndGain_);
+  if (btlbwFound_) {
+    targetCwnd += maxAckHeightFilter_.GetBest();
+  } else if (conn_.transportSettings.bbrConfig.enableAckAggregationInStartup) {
+    targetCwnd += excessiveBytes;
+  }
+
+  if (btlbwFound_) {
+    cwnd_ = std::min(targetCwnd, cwnd_ + ackedBytes);
+  } else if (
+      cwnd_ < targetCwnd || conn_.lossState.totalBytesAcked < initialCwnd_) {
+    cwnd_ += ackedBytes;
+  }
+  boundCwndForModel();
+
+  cwnd_ = boundedCwnd(
+      cwnd_,
+      conn_.udpSendPacketLen,
+      conn_.transportSettings.maxCwndInMss,
+      kMinCwndInMssForBbr);
+}
+
+void Bbr2CongestionController::boundCwndForModel() noexcept {
+  uint64_t cap = std::numeric_limits<uint64_t>::max();
+  if (state_ == State::ProbeBwCruise || state_ == State::ProbeRtt) {
+    cap = inflightWithHeadroom();
+  } else if (
+      state_ == State::ProbeBwDown || state_ == State::ProbeBwRefill ||
+      state_ == State::ProbeBwUp) {
+    cap = inflightHi_.value_or(cap);
+  }
+  if (inflightLo_) {
+    cap = std::min(cap, *inflightLo_);
+  }
+  cwnd_ = std::min(cwnd_, std::max(cap, minCwnd()));
+}
+
+void Bbr2CongestionController::updatePacing() noexcept {
+  if (!conn_.pacer) {
+    return;
+  }
+  if (conn_.lossState.totalBytesSent < initialCwnd_) {
+    return;
+  }
+  auto bandwidthEstimate = bandwidth();
+  if (!bandwidthEstimate) {
+    return;
+  }
+  auto mrtt = minRtt();
+  uint64_t targetPacingWindow = bandwidthEstimate * pacingGain_ * mrtt;
+  if (btlbwFound_) {
+    pacingWindow_ = targetPacingWindow;
+  } else {
+    pacingWindow_ = std::max(pacingWindow_, targetPacingWindow);
+  }
+  if (state_ == State::Startup) {
+    conn_.pacer->setRttFactor(
+        conn_.transportSettings.startupRttFactor.first,
+        conn_.transportSettings.startupRttFactor.second);
+  } else {
+    conn_.pacer->setRttFactor(
+        conn_.transportSettings.defaultRttFactor.first,
+        conn_.transportSettings.defaultRttFactor.second);
+  }
+  conn_.pacer->refreshPacingRate(pacingWindow_, mrtt);
+  if (state_ == State::Drain) {
+    conn_.pacer->reset();
+  }
+}
+
+std::chrono::microseconds Bbr2CongestionController::minRtt() const noexcept {
+  return minRttSampler_ ? minRttSampler_->minRtt() : 0us;
+}
+
+Bandwidth Bbr2CongestionController::bandwidth() const noexcept {
+  return bandwidthSampler_ ? bandwidthSampler_->getBandwidth() : Bandwidth();
+}
+
+uint64_t Bbr2CongestionController::getWritableBytes() const noexcept {
+  return getCongestionWindow() > conn_.lossState.inflightBytes
+      ? getCongestionWindow() - conn_.lossState.inflightBytes
+      : 0;
+}
+
+uint64_t Bbr2CongestionController::getCongestionWindow() const noexcept {
+  if (state_ == State::ProbeRtt) {
+    return std::min(cwnd_, probeRttCwnd());
+  }
+  return cwnd_;
+}
+
+void Bbr2CongestionController::setAppIdle(
+    bool idle,
+    TimePoint /* eventTime */) noexcept {
+  if (conn_.qLogger) {
+    conn_.qLogger->addAppIdleUpdate(kAppIdle, idle);
+  }
+}
+
+void Bbr2CongestionController::setAppLimited() {
+  if (conn_.lossState.inflightBytes > getCongestionWindow()) {
+    return;
+  }
+  if (bandwidthSampler_) {
+    bandwidthSampler_->onAppLimited();
+  }
+}
+
+bool Bbr2CongestionController::isAppLimited() const noexcept {
+  return bandwidthSampler_ ? bandwidthSampler_->isAppLimited() : false;
+}
+
+void Bbr2CongestionController::onRemoveBytesFromInflight(
+    uint64_t bytesToRemove) {
+  subtractAndCheckUnderflow(conn_.lossState.inflightBytes, bytesToRemove);
+}
+
+void Bbr2CongestionController::getStats(
+    CongestionControllerStats& stats) const {
+  stats.bbr2Stats.state = static_cast<uint8_t>(state_);
+  stats.bbr2Stats.bandwidth = bandwidth().normalize();
+  stats.bbr2Stats.inflightHi = inflightHi_.value_or(0);
+  stats.bbr2Stats.inflightLo = inflightLo_.value_or(0);
+}
+
+Bbr2CongestionController::State Bbr2CongestionController::state()
+    const noexcept {
+  return state_;
+}
+
+folly::Optional<uint64_t> Bbr2CongestionController::inflightHi()
+    const noexcept {
+  return inflightHi_;
+}
+
+folly::Optional<uint64_t> Bbr2CongestionController::inflightLo()
+    const noexcept {
+  return inflightLo_;
+}
+
+std::string bbr2StateToString(Bbr2CongestionController::State state) {
+  switch (state) {
+    case Bbr2CongestionController::State::Startup:
+      return "Startup";
+    case Bbr2CongestionController::State::Drain:
+      return "Drain";
+    case Bbr2CongestionController::State::ProbeBwDown:
+      return "ProbeBwDown";
+    case Bbr2CongestionController::State::ProbeBwCruise:
+      return "ProbeBwCruise";
+    case Bbr2CongestionController::State::ProbeBwRefill:
+      return "ProbeBwRefill";
+    case Bbr2CongestionController::State::ProbeBwUp:
+      return "ProbeBwUp";
+    case Bbr2CongestionController::State::ProbeRtt:
+      return "ProbeRtt";
+  }
+  return "BadBbr2State";
+}
+
+std::ostream& operator<<(
+    std::ostream& os,
+    const Bbr2CongestionController& bbr) {
+  os << "Bbr2: state=" << bbr2StateToString(bbr.state_)
+     << ", cwnd=" << bbr.cwnd_
+     << ", inflightHi=" << bbr.inflightHi_.value_or(0)
+     << ", inflightLo=" << bbr.inflightLo_.value_or(0)
+     << ", pacingGain_=" << bbr.pacingGain_
+     << ", minRtt=" << bbr.minRtt().count()
+     << "us, bandwidth=" << bbr.bandwidth();
+  return os;
+}
+} // namespace quic
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/congestion_control/Bbr.h>
+
+namespace quic {
+
+// Pacing and cwnd gain during Startup
+constexpr float kBbr2StartupPacingGain = 2.77f;
+constexpr float kBbr2StartupCwndGain = 2.0f;
+// Pacing gain during Drain
+constexpr float kBbr2DrainPacingGain = 0.35f;
+// Pacing gains of the ProbeBw phases. Cruise and Refill pace at 1.0.
+constexpr float kBbr2ProbeBwDownPacingGain = 0.9f;
+constexpr float kBbr2ProbeBwUpPacingGain = 1.25f;
+// The highest fraction of inflight bytes that can be lost in a round trip
+// before inflight is considered too high for the path.
+constexpr float kBbr2LossThreshold = 0.02f;
+// Multiplicative decrease applied to the inflight bounds on loss.
+constexpr float kBbr2Beta = 0.7f;
+// Fraction of inflight_hi left unused while cruising, so that other flows can
+// grab some bandwidth.
+constexpr float kBbr2Headroom = 0.15f;
+// Startup ends on loss only once this many packets are lost in a round trip
+// with a loss rate above kBbr2LossThreshold.
+constexpr uint32_t kBbr2StartupFullLossCount = 6;
+// Cwnd during ProbeRtt, as a fraction of the BDP.
+constexpr float kBbr2ProbeRttCwndGain = 0.5f;
+// How long a min rtt sample lasts before ProbeRtt has to refresh it.
+constexpr std::chrono::seconds kBbr2ProbeRttInterval{5};
+// The time between two bandwidth probes is picked at random in
+// [kBbr2ProbeBwMinWait, kBbr2ProbeBwMinWait + kBbr2ProbeBwRandWait).
+constexpr std::chrono::milliseconds kBbr2ProbeBwMinWait{2000};
+constexpr std::chrono::milliseconds kBbr2ProbeBwRandWait{1000};
+// Upper bound of the number of round trips between two bandwidth probes. A
+// Reno flow sharing the bottleneck takes about a BDP worth of packets round
+// trips to fill the pipe, probing at least that often keeps us fair to it.
+constexpr uint64_t kBbr2ProbeBwMaxRounds = 63;
+
+/**
+ * A BBRv2 congestion controller, as described in
+ * https://datatracker.ietf.org/doc/html/draft-cardwell-iccrg-bbr-congestion-control-02
+ *
+ * On top of the BBRv1 model of bottleneck bandwidth and min rtt, it keeps two
+ * bounds on inflight bytes derived from loss: inflight_hi, the highest
+ * inflight the path took without losing more than kBbr2LossThreshold of it,
+ * and inflight_lo, a short term bound lowered on every round trip with loss
+ * while not probing. ProbeBw cycles through Down, Cruise, Refill and Up,
+ * spending most of its time cruising below inflight_hi and probing for more
+ * bandwidth only every few seconds.
+ *
+ * ECN isn't fed to congestion controllers in this tree, so loss is the only
+ * congestion signal.
+ */
+class Bbr2CongestionController : public CongestionController {
+ public:
+  enum class State : uint8_t {
+    Startup,
+    Drain,
+    ProbeBwDown,
+    ProbeBwCruise,
+    ProbeBwRefill,
+    ProbeBwUp,
+    ProbeRtt,
+  };
+
+  explicit Bbr2CongestionController(QuicConnectionStateBase& conn);
+
+  void setRttSampler(
+      std::unique_ptr<BbrCongestionController::MinRttSampler> sampler) noexcept;
+  void setBandwidthSampler(
+      std::unique_ptr<BbrCongestionController::BandwidthSampler>
+          sampler) noexcept;
+
+  void onRemoveBytesFromInflight(uint64_t bytesToRemove) override;
+  void onPacketSent(const OutstandingPacket&) override;
+  void onPacketAckOrLoss(
+      folly::Optional<AckEvent> ackEvent,
+      folly::Optional<LossEvent> lossEvent) override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE ackEvent,
+      const LossEvent* FOLLY_NULLABLE lossEvent) override;
+  uint64_t getWritableBytes() const noexcept override;
+
+  uint64_t getCongestionWindow() const noexcept override;
+  CongestionControlType type() const noexcept override;
+  void setAppIdle(bool idle, TimePoint eventTime) noexcept override;
+  void setAppLimited() override;
+
+  bool isAppLimited() const noexcept override;
+
+  void getStats(CongestionControllerStats& stats) const override;
+
+  State state() const noexcept;
+
+  folly::Optional<uint64_t> inflightHi() const noexcept;
+  folly::Optional<uint64_t> inflightLo() const noexcept;
+
+ private:
+  /* prevInflightBytes: the inflightBytes value before the current
+   *                    onPacketAckOrLoss invocation.
+   * newRoundTrip: whether the ack started a new round trip.
+   */
+  void onPacketAcked(
+      const AckEvent& ack,
+      uint64_t prevInflightBytes,
+      bool newRoundTrip);
+  void onPacketLoss(const LossEvent& loss, uint64_t prevInflightBytes);
+
+  /**
+   * Return if we are at the start of a new round trip.
+   */
+  bool updateRoundTripCounter(TimePoint largestAckedSentTime) noexcept;
+  // Makes the current round trip end with the latest packet sent so far.
+  void startRound() noexcept;
+  // Called at the start of each round trip, with the stats of the last one.
+  void onRoundEnd() noexcept;
+
+  /**
+   * Whether the loss seen in the current round trip shows inflight is higher
+   * than the path can take.
+   */
+  bool isInflightTooHigh(uint64_t inflightBytes) const noexcept;
+  void handleInflightTooHigh(uint64_t inflightBytes, TimePoint eventTime);
+
+  uint64_t updateAckAggregation(const AckEvent& ack);
+  void detectBottleneckBandwidth(bool appLimitedSample);
+
+  void handleAckInProbeBw(
+      const AckEvent& ack,
+      uint64_t prevInflightBytes,
+      bool newRoundTrip);
+  void handleAckInProbeRtt(bool newRoundTrip, TimePoint ackTime) noexcept;
+  bool shouldProbeRtt() noexcept;
+  bool isTimeToProbeBw(TimePoint eventTime) const noexcept;
+  bool isProbingBw() const noexcept;
+
+  void transitToStartup() noexcept;
+  void transitToDrain() noexcept;
+  void transitToProbeBwDown(TimePoint eventTime);
+  void transitToProbeBwCruise() noexcept;
+  void transitToProbeBwRefill() noexcept;
+  void transitToProbeBwUp(TimePoint eventTime) noexcept;
+  void transitToProbeRtt() noexcept;
+
+  uint64_t calculateTargetCwnd(float gain) const noexcept;
+  uint64_t inflightWithHeadroom() const noexcept;
+  uint64_t probeRttCwnd() const noexcept;
+  uint64_t minCwnd() const noexcept;
+  void updateCwnd(uint64_t ackedBytes, uint64_t excessiveBytes) noexcept;
+  void boundCwndForModel() noexcept;
+  void updatePacing() noexcept;
+  std::chrono::microseconds minRtt() const noexcept;
+  Bandwidth bandwidth() const noexcept;
+
+  QuicConnectionStateBase& conn_;
+  State state_{State::Startup};
+
+  // Number of round trips the connection has witnessed
+  uint64_t roundTripCounter_{0};
+  // When a packet with send time later than endOfRoundTrip_ is acked, the
+  // current round trip is ended.
+  TimePoint endOfRoundTrip_;
+  // Send time of the latest packet sent.
+  TimePoint latestSentTime_;
+
+  // Cwnd in bytes
+  uint64_t cwnd_;
+  // Initial cwnd in bytes
+  uint64_t initialCwnd_;
+  // Number of bytes we expect to send over one RTT when paced write.
+  uint64_t pacingWindow_;
+  uint64_t sendQuantum_{0};
+
+  float cwndGain_{kBbr2StartupCwndGain};
+  float pacingGain_{kBbr2StartupPacingGain};
+
+  // Whether we have found the bottleneck link bandwidth
+  bool btlbwFound_{false};
+  Bandwidth previousStartupBandwidth_;
+  // Counter of continuous round trips in Startup that bandwidth isn't growing
+  // fast enough
+  uint8_t slowStartupRoundCounter_{0};
+
+  // Delivery and loss in the current round trip.
+  uint64_t bytesAckedInRound_{0};
+  uint64_t bytesLostInRound_{0};
+  uint32_t packetsLostInRound_{0};
+  // Bytes delivered in the last complete round trip.
+  uint64_t inflightLatest_{0};
+
+  // Upper bound of inflight bytes, set when loss shows inflight went above
+  // what the path can take. Only raised while probing for bandwidth.
+  folly::Optional<uint64_t> inflightHi_;
+  // Short term lower bound of inflight bytes, lowered on each round trip with
+  // loss outside of bandwidth probing and reset when probing starts.
+  folly::Optional<uint64_t> inflightLo_;
+
+  // Start of the current ProbeBw phase.
+  TimePoint cycleStart_;
+  // How long after the start of ProbeBwDown the next bandwidth probe starts.
+  std::chrono::milliseconds probeBwWait_{kBbr2ProbeBwMinWait};
+  uint64_t roundsSinceProbeBw_{0};
+  // Number of round trips spent in ProbeBwUp, inflight_hi grows
+  // exponentially with it.
+  uint8_t probeUpRounds_{0};
+
+  // Once in ProbeRtt, we stay for at least kProbeRttDuration and one round
+  // trip with low inflight bytes.
+  folly::Optional<TimePoint> earliestTimeToExitProbeRtt_;
+  folly::Optional<uint64_t> probeRttRound_;
+
+  std::unique_ptr<BbrCongestionController::MinRttSampler> minRttSampler_;
+  std::unique_ptr<BbrCongestionController::BandwidthSampler> bandwidthSampler_;
+
+  WindowedFilter<
+      uint64_t /* ack bytes count */,
+      MaxFilter<uint64_t>,
+      uint64_t /* roundtrip count */,
+      uint64_t /* roundtrip count */>
+      maxAckHeightFilter_;
+  folly::Optional<TimePoint> ackAggregationStartTime_;
+  uint64_t aggregatedAckBytes_{0};
+
+  // The connection was very inactive and we are leaving that.
+  bool exitingQuiescene_{false};
+
+  friend std::ostream& operator<<(
+      std::ostream& os,
+      const Bbr2CongestionController& bbr);
+};
+
+std::ostream& operator<<(std::ostream& os, const Bbr2CongestionController& bbr);
+
+std::string bbr2StateToString(Bbr2CongestionController::State state);
+
+} // namespace quic
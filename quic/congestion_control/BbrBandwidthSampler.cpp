@@ -96,7 +96,7 @@ void BbrBandwidthSampler::onPacketAcked(
 
 void BbrBandwidthSampler::onAppLimited() {
   appLimited_ = true;
-  appLimitedExitTarget_ = Clock::now();
+  appLimitedExitTarget_ = conn_.lossState.lastRetransmittablePacketSentTime;
   if (conn_.qLogger) {
     conn_.qLogger->addAppLimitedUpdate();
   }
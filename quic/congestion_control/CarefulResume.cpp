@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/CarefulResume.h>
+
+#include <glog/logging.h>
+
+namespace {
+// The path is assumed to have changed, and the saved state not to apply any
+// more, when the RTT is out of [savedMinRtt / 2, savedMinRtt * 10].
+constexpr uint64_t kMinRttDivisor = 2;
+constexpr uint64_t kMaxRttMultiplier = 10;
+} // namespace
+
+namespace quic {
+
+CarefulResume::CarefulResume(
+    QuicConnectionStateBase& conn,
+    std::unique_ptr<CongestionController> congestionController,
+    uint64_t savedBandwidth,
+    std::chrono::microseconds savedMinRtt)
+    : conn_(conn),
+      congestionController_(std::move(congestionController)),
+      savedMinRtt_(savedMinRtt) {
+  CHECK(congestionController_);
+  const auto& config = conn_.transportSettings.carefulResume;
+  uint64_t bdp = savedBandwidth * savedMinRtt_.count() / 1000000;
+  jumpCwndBytes_ = std::min(
+      static_cast<uint64_t>(bdp * config.cwndGain),
+      config.maxJumpCwndInMss * conn_.udpSendPacketLen);
+  if (jumpCwndBytes_ <= congestionController_->getCongestionWindow() ||
+      savedMinRtt_ == 0us) {
+    VLOG(4) << "CarefulResume no jump, saved bdp=" << bdp << " " << conn_;
+    phase_ = Phase::Normal;
+    return;
+  }
+  maybeJump();
+}
+
+void CarefulResume::maybeJump() {
+  if (conn_.lossState.srtt == 0us) {
+    return;
+  }
+  auto rtt = conn_.lossState.srtt;
+  if (rtt < savedMinRtt_ / kMinRttDivisor ||
+      rtt > savedMinRtt_ * kMaxRttMultiplier) {
+    VLOG(4) << "CarefulResume no jump, rtt=" << rtt.count()
+            << "us savedMinRtt=" << savedMinRtt_.count() << "us " << conn_;
+    phase_ = Phase::Normal;
+    return;
+  }
+  VLOG(4) << "CarefulResume jumping to cwnd=" << jumpCwndBytes_ << " "
+          << conn_;
+  phase_ = Phase::Unvalidated;
+  maybeRefreshPacingRate();
+}
+
+void CarefulResume::onRemoveBytesFromInflight(uint64_t bytes) {
+  congestionController_->onRemoveBytesFromInflight(bytes);
+}
+
+void CarefulResume::onPacketSent(const OutstandingPacket& packet) {
+  congestionController_->onPacketSent(packet);
+  if (phase_ == Phase::Unvalidated) {
+    if (!firstJumpSentTime_) {
+      firstJumpSentTime_ = packet.metadata.time;
+    }
+    lastJumpSentTime_ = packet.metadata.time;
+  }
+}
+
+void CarefulResume::onPacketAckOrLoss(
+    folly::Optional<AckEvent> ack,
+    folly::Optional<LossEvent> loss) {
+  onPacketAckOrLossInPlace(ack.get_pointer(), loss.get_pointer());
+}
+
+void CarefulResume::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ack,
+    const LossEvent* FOLLY_NULLABLE loss) {
+  if (loss) {
+    onLoss(*loss);
+  }
+  if (ack && ack->largestAckedPacket.has_value()) {
+    onAck(*ack);
+  }
+  congestionController_->onPacketAckOrLossInPlace(ack, loss);
+  if (phase_ == Phase::Reconnaissance) {
+    maybeJump();
+  } else {
+    maybeRefreshPacingRate();
+  }
+}
+
+void CarefulResume::onAck(const AckEvent& ack) {
+  if (!firstJumpSentTime_ ||
+      (phase_ != Phase::Unvalidated && phase_ != Phase::Validating)) {
+    return;
+  }
+  bool lastJumpPacketAcked = false;
+  for (const auto& packet : ack.ackedPackets) {
+    if (packet.sentTime >= *firstJumpSentTime_) {
+      pipeSize_ += packet.encodedSize;
+      lastJumpPacketAcked |= packet.sentTime >= *lastJumpSentTime_;
+    }
+  }
+  if (pipeSize_ == 0) {
+    return;
+  }
+  if (phase_ == Phase::Unvalidated) {
+    // What is still in flight, plus what this ack just delivered.
+    floorBytes_ = conn_.lossState.inflightBytes;
+    phase_ = Phase::Validating;
+  }
+  if (phase_ == Phase::Validating && lastJumpPacketAcked) {
+    floorBytes_ = std::max(floorBytes_, pipeSize_);
+    phase_ = Phase::Normal;
+  }
+}
+
+void CarefulResume::onLoss(const LossEvent& loss) {
+  if (loss.persistentCongestion) {
+    floorBytes_ = 0;
+  }
+  switch (phase_) {
+    case Phase::Reconnaissance:
+      // Nothing was sent with the jump yet, the saved state doesn't fit.
+      phase_ = Phase::Normal;
+      break;
+    case Phase::Unvalidated:
+    case Phase::Validating:
+      VLOG(4) << "CarefulResume safe retreat, pipeSize=" << pipeSize_ << " "
+              << conn_;
+      floorBytes_ = loss.persistentCongestion ? 0 : pipeSize_ / 2;
+      retreatTime_ = loss.lossTime;
+      phase_ = Phase::SafeRetreat;
+      break;
+    case Phase::SafeRetreat:
+      if (loss.largestLostSentTime && retreatTime_ &&
+          *loss.largestLostSentTime > *retreatTime_) {
+        floorBytes_ = 0;
+      }
+      break;
+    case Phase::Normal:
+      floorBytes_ = 0;
+      break;
+  }
+}
+
+void CarefulResume::maybeRefreshPacingRate() {
+  if (!conn_.pacer) {
+    return;
+  }
+  auto cwnd = getCongestionWindow();
+  if (cwnd <= congestionController_->getCongestionWindow()) {
+    // The wrapped controller paces its own window.
+    return;
+  }
+  conn_.pacer->refreshPacingRate(
+      cwnd,
+      phase_ == Phase::Unvalidated ? savedMinRtt_ : conn_.lossState.srtt);
+}
+
+uint64_t CarefulResume::getWritableBytes() const {
+  auto cwnd = getCongestionWindow();
+  return cwnd > conn_.lossState.inflightBytes
+      ? cwnd - conn_.lossState.inflightBytes
+      : 0;
+}
+
+uint64_t CarefulResume::getCongestionWindow() const {
+  auto cwnd = congestionController_->getCongestionWindow();
+  if (phase_ == Phase::Unvalidated) {
+    return std::max(cwnd, jumpCwndBytes_);
+  }
+  return std::max(cwnd, floorBytes_);
+}
+
+void CarefulResume::setAppIdle(bool idle, TimePoint eventTime) {
+  congestionController_->setAppIdle(idle, eventTime);
+}
+
+void CarefulResume::setAppLimited() {
+  congestionController_->setAppLimited();
+}
+
+CongestionControlType CarefulResume::type() const {
+  return congestionController_->type();
+}
+
+bool CarefulResume::isAppLimited() const {
+  return congestionController_->isAppLimited();
+}
+
+void CarefulResume::getStats(CongestionControllerStats& stats) const {
+  congestionController_->getStats(stats);
+}
+
+CarefulResume::Phase CarefulResume::phase() const noexcept {
+  return phase_;
+}
+
+uint64_t CarefulResume::jumpCwnd() const noexcept {
+  return jumpCwndBytes_;
+}
+
+folly::StringPiece carefulResumePhaseToString(CarefulResume::Phase phase) {
+  switch (phase) {
+    case CarefulResume::Phase::Reconnaissance:
+      return "Reconnaissance";
+    case CarefulResume::Phase::Unvalidated:
+      return "Unvalidated";
+    case CarefulResume::Phase::Validating:
+      return "Validating";
+    case CarefulResume::Phase::Normal:
+      return "Normal";
+    case CarefulResume::Phase::SafeRetreat:
+      return "SafeRetreat";
+  }
+  folly::assume_unreachable();
+}
+
+} // namespace quic
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/state/StateData.h>
+
+namespace quic {
+
+/**
+ * Jumps the congestion window of a resumed connection to what an earlier
+ * connection measured on the same path, following the phases of the Careful
+ * Resume draft. It wraps the connection's congestion controller, which keeps
+ * seeing every event and running as if there had been no jump; the jump is
+ * a lower bound on the window it reports:
+ *
+ * - Reconnaissance: no jump until the connection has an RTT sample, and none
+ *   at all if that sample is below half or above 10 times the saved min rtt.
+ * - Unvalidated: the window is the jump window, paced over the saved min rtt.
+ * - Validating: once the first packet sent after the jump is acked, the
+ *   window is what was in flight then, until the last packet sent while
+ *   Unvalidated is acked.
+ * - Normal: the window is at least what got delivered since the jump, until
+ *   the first loss.
+ * - SafeRetreat: a loss while Unvalidated or Validating brings the window
+ *   down to at least half of what got delivered since the jump, until a
+ *   packet sent after the retreat is lost.
+ */
+class CarefulResume : public CongestionController {
+ public:
+  enum class Phase : uint8_t {
+    Reconnaissance,
+    Unvalidated,
+    Validating,
+    Normal,
+    SafeRetreat,
+  };
+
+  /**
+   * savedBandwidth is in bytes per second. The jump window is derived from it
+   * with conn.transportSettings.carefulResume.
+   */
+  CarefulResume(
+      QuicConnectionStateBase& conn,
+      std::unique_ptr<CongestionController> congestionController,
+      uint64_t savedBandwidth,
+      std::chrono::microseconds savedMinRtt);
+
+  void onRemoveBytesFromInflight(uint64_t bytes) override;
+  void onPacketSent(const OutstandingPacket& packet) override;
+  void onPacketAckOrLoss(
+      folly::Optional<AckEvent> ack,
+      folly::Optional<LossEvent> loss) override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE ack,
+      const LossEvent* FOLLY_NULLABLE loss) override;
+
+  uint64_t getWritableBytes() const override;
+  uint64_t getCongestionWindow() const override;
+  void setAppIdle(bool idle, TimePoint eventTime) override;
+  void setAppLimited() override;
+  CongestionControlType type() const override;
+  bool isAppLimited() const override;
+  void getStats(CongestionControllerStats& stats) const override;
+
+  FOLLY_NODISCARD Phase phase() const noexcept;
+  FOLLY_NODISCARD uint64_t jumpCwnd() const noexcept;
+
+ private:
+  void maybeJump();
+  void onAck(const AckEvent& ack);
+  void onLoss(const LossEvent& loss);
+  void maybeRefreshPacingRate();
+
+  QuicConnectionStateBase& conn_;
+  std::unique_ptr<CongestionController> congestionController_;
+  std::chrono::microseconds savedMinRtt_;
+  uint64_t jumpCwndBytes_;
+  Phase phase_{Phase::Reconnaissance};
+  // Sent time of the first and last packets sent while Unvalidated.
+  folly::Optional<TimePoint> firstJumpSentTime_;
+  folly::Optional<TimePoint> lastJumpSentTime_;
+  // Bytes sent since the jump which have been acked, the draft's PipeSize.
+  uint64_t pipeSize_{0};
+  // Lower bound of the window outside of Unvalidated.
+  uint64_t floorBytes_{0};
+  folly::Optional<TimePoint> retreatTime_;
+};
+
+folly::StringPiece carefulResumePhaseToString(CarefulResume::Phase phase);
+
+} // namespace quic
@@ -134,6 +134,12 @@ void Copa::changeDirection(
 void Copa::onPacketAckOrLoss(
     folly::Optional<AckEvent> ack,
     folly::Optional<LossEvent> loss) {
+  onPacketAckOrLossInPlace(ack.get_pointer(), loss.get_pointer());
+}
+
+void Copa::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ack,
+    const LossEvent* FOLLY_NULLABLE loss) {
   if (loss) {
     onPacketLoss(*loss);
     if (conn_.pacer) {
@@ -33,6 +33,9 @@ class Copa : public CongestionController {
   void onPacketSent(const OutstandingPacket& packet) override;
   void onPacketAckOrLoss(folly::Optional<AckEvent>, folly::Optional<LossEvent>)
       override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE,
+      const LossEvent* FOLLY_NULLABLE) override;
 
   uint64_t getWritableBytes() const noexcept override;
   uint64_t getCongestionWindow() const noexcept override;
@@ -38,6 +38,7 @@ void Copa2::onRemoveBytesFromInflight(uint64_t bytes) {
 void Copa2::onPacketSent(const OutstandingPacket& packet) {
   addAndCheckOverflow(
       conn_.lossState.inflightBytes, packet.metadata.encodedSize);
+  latestSentTime_ = std::max(latestSentTime_, packet.metadata.time);
 
   VLOG(10) << __func__ << " writable=" << getWritableBytes()
            << " cwnd=" << cwndBytes_
@@ -56,6 +57,12 @@ void Copa2::onPacketSent(const OutstandingPacket& packet) {
 void Copa2::onPacketAckOrLoss(
     folly::Optional<AckEvent> ack,
     folly::Optional<LossEvent> loss) {
+  onPacketAckOrLossInPlace(ack.get_pointer(), loss.get_pointer());
+}
+
+void Copa2::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ack,
+    const LossEvent* FOLLY_NULLABLE loss) {
   if (loss) {
     onPacketLoss(*loss);
     if (conn_.pacer) {
@@ -83,7 +90,7 @@ void Copa2::manageLossyMode(folly::Optional<TimePoint> sentTime) {
     lossyMode_ = true;
     numAckedInLossCycle_ = 0;
     numLostInLossCycle_ = 0;
-    lossCycleStartTime_ = Clock::now();
+    lossCycleStartTime_ = latestSentTime_;
     return;
   }
 
@@ -104,7 +111,7 @@ void Copa2::manageLossyMode(folly::Optional<TimePoint> sentTime) {
   lossyMode_ = numLostInLossCycle_ >= numPktsInLossCycle * lossToleranceParam_;
   numAckedInLossCycle_ = 0;
   numLostInLossCycle_ = 0;
-  lossCycleStartTime_ = Clock::now();
+  lossCycleStartTime_ = latestSentTime_;
 }
 
 void Copa2::onPacketLoss(const LossEvent& loss) {
@@ -253,7 +260,7 @@ void Copa2::setAppLimited() {
     return;
   }
   appLimited_ = true;
-  appLimitedExitTarget_ = Clock::now();
+  appLimitedExitTarget_ = latestSentTime_;
   if (conn_.qLogger) {
     conn_.qLogger->addAppLimitedUpdate();
   }
@@ -24,6 +24,9 @@ class Copa2 : public CongestionController {
   void onPacketSent(const OutstandingPacket& packet) override;
   void onPacketAckOrLoss(folly::Optional<AckEvent>, folly::Optional<LossEvent>)
       override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE,
+      const LossEvent* FOLLY_NULLABLE) override;
 
   FOLLY_NODISCARD uint64_t getWritableBytes() const noexcept override;
   FOLLY_NODISCARD uint64_t getCongestionWindow() const noexcept override;
@@ -84,6 +87,9 @@ class Copa2 : public CongestionController {
   // When a packet with a send time later than appLimitedExitTarget_ is acked,
   // an app-limited connection is considered no longer app-limited.
   TimePoint appLimitedExitTarget_;
+  // Send time of the latest packet sent. Loss cycles and app-limited periods
+  // last until a packet sent after their start is acked.
+  TimePoint latestSentTime_;
 };
 
 } // namespace quic
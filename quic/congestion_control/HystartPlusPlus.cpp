@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/HystartPlusPlus.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+HystartPlusPlus::HystartPlusPlus(const QuicConnectionStateBase& conn)
+    : conn_(conn) {}
+
+void HystartPlusPlus::onPacketSent(const OutstandingPacket& packet) noexcept {
+  latestSentTime_ = std::max(latestSentTime_, packet.metadata.time);
+}
+
+uint64_t HystartPlusPlus::onAck(
+    const CongestionController::AckEvent& ack,
+    uint64_t ackedBytes) {
+  DCHECK(inSlowStart());
+  if (!roundEndTarget_) {
+    startRound();
+  }
+  // Without pacing, limit the burst a single ack can release.
+  uint64_t increase = conn_.pacer
+      ? ackedBytes
+      : std::min(
+            ackedBytes,
+            kHystartPlusPlusUnpacedLimitInMss * conn_.udpSendPacketLen);
+  auto rtt = conn_.lossState.lrtt;
+  if (rtt > 0us) {
+    currentRoundMinRtt_ = std::min(rtt, currentRoundMinRtt_.value_or(rtt));
+    if (rttSampleCount_ < std::numeric_limits<uint8_t>::max()) {
+      rttSampleCount_++;
+    }
+  }
+  bool enoughSamples = rttSampleCount_ >= kHystartPlusPlusRttSamples &&
+      currentRoundMinRtt_.has_value();
+  if (phase_ == Phase::SlowStart) {
+    if (enoughSamples && lastRoundMinRtt_) {
+      auto rttThresh = std::max(
+          kHystartPlusPlusMinRttThresh,
+          std::min(
+              kHystartPlusPlusMaxRttThresh,
+              *lastRoundMinRtt_ / kHystartPlusPlusMinRttDivisor));
+      if (*currentRoundMinRtt_ >= *lastRoundMinRtt_ + rttThresh) {
+        VLOG(10) << "HystartPlusPlus enter conservative slow start, rtt="
+                 << currentRoundMinRtt_->count()
+                 << "us lastRoundMinRtt=" << lastRoundMinRtt_->count() << "us "
+                 << conn_;
+        cssBaselineMinRtt_ = currentRoundMinRtt_;
+        cssRounds_ = 0;
+        phase_ = Phase::ConservativeSlowStart;
+      }
+    }
+  } else {
+    increase /= kHystartPlusPlusCssGrowthDivisor;
+    if (enoughSamples && *currentRoundMinRtt_ < *cssBaselineMinRtt_) {
+      VLOG(10) << "HystartPlusPlus spurious rtt increase, back to slow start "
+               << conn_;
+      cssBaselineMinRtt_ = folly::none;
+      phase_ = Phase::SlowStart;
+    }
+  }
+  if (ack.largestAckedPacketSentTime > *roundEndTarget_) {
+    if (phase_ == Phase::ConservativeSlowStart &&
+        ++cssRounds_ >= kHystartPlusPlusCssRounds) {
+      VLOG(10) << "HystartPlusPlus exit slow start " << conn_;
+      phase_ = Phase::CongestionAvoidance;
+    }
+    startRound();
+  }
+  return increase;
+}
+
+void HystartPlusPlus::startRound() noexcept {
+  roundEndTarget_ = latestSentTime_;
+  lastRoundMinRtt_ = currentRoundMinRtt_;
+  currentRoundMinRtt_ = folly::none;
+  rttSampleCount_ = 0;
+}
+
+void HystartPlusPlus::reset() noexcept {
+  phase_ = Phase::SlowStart;
+  roundEndTarget_ = folly::none;
+  currentRoundMinRtt_ = folly::none;
+  lastRoundMinRtt_ = folly::none;
+  rttSampleCount_ = 0;
+  cssBaselineMinRtt_ = folly::none;
+  cssRounds_ = 0;
+}
+
+HystartPlusPlus::Phase HystartPlusPlus::phase() const noexcept {
+  return phase_;
+}
+
+bool HystartPlusPlus::inSlowStart() const noexcept {
+  return phase_ != Phase::CongestionAvoidance;
+}
+
+folly::StringPiece hystartPlusPlusPhaseToString(HystartPlusPlus::Phase phase) {
+  switch (phase) {
+    case HystartPlusPlus::Phase::SlowStart:
+      return "SlowStart";
+    case HystartPlusPlus::Phase::ConservativeSlowStart:
+      return "ConservativeSlowStart";
+    case HystartPlusPlus::Phase::CongestionAvoidance:
+      return "CongestionAvoidance";
+  }
+  folly::assume_unreachable();
+}
+
+} // namespace quic
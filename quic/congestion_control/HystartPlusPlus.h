@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/state/StateData.h>
+
+namespace quic {
+
+/**
+ * HyStart++ (RFC 9406), the slow start exit shared by Cubic and NewReno. The
+ * owning congestion controller calls onAck for each ack it gets in slow
+ * start and grows its cwnd by what it returns, then leaves slow start, with
+ * ssthresh at the current cwnd, once the phase is CongestionAvoidance.
+ *
+ * Slow start is tracked in RTT rounds, a round ending when a packet sent
+ * after the round started is acked. When the min RTT of a round is larger
+ * than the one of the last round by at least the last one / 8, bounded to
+ * [4ms, 16ms], slow start turns into conservative slow start, growing cwnd 4
+ * times slower. If a round of conservative slow start sees an RTT below the
+ * one which started it, the increase was spurious and slow start goes on;
+ * otherwise it ends after 5 rounds. Loss ends slow start in the owning
+ * controller as usual.
+ */
+class HystartPlusPlus {
+ public:
+  enum class Phase : uint8_t {
+    SlowStart,
+    ConservativeSlowStart,
+    CongestionAvoidance,
+  };
+
+  explicit HystartPlusPlus(const QuicConnectionStateBase& conn);
+
+  void onPacketSent(const OutstandingPacket& packet) noexcept;
+
+  /**
+   * ackedBytes are the bytes of the ack the owning controller would grow cwnd
+   * by in plain slow start. Returns the cwnd increase to use instead.
+   */
+  uint64_t onAck(
+      const CongestionController::AckEvent& ack,
+      uint64_t ackedBytes);
+
+  /**
+   * Starts over in slow start, e.g. after persistent congestion.
+   */
+  void reset() noexcept;
+
+  FOLLY_NODISCARD Phase phase() const noexcept;
+  FOLLY_NODISCARD bool inSlowStart() const noexcept;
+
+ private:
+  void startRound() noexcept;
+
+  const QuicConnectionStateBase& conn_;
+  Phase phase_{Phase::SlowStart};
+  // Send time of the latest packet sent, where a new round ends.
+  TimePoint latestSentTime_;
+  // When a packet sent after this is acked, the current round ends.
+  folly::Optional<TimePoint> roundEndTarget_;
+  folly::Optional<std::chrono::microseconds> currentRoundMinRtt_;
+  folly::Optional<std::chrono::microseconds> lastRoundMinRtt_;
+  uint8_t rttSampleCount_{0};
+  // Min RTT of the round which started conservative slow start.
+  folly::Optional<std::chrono::microseconds> cssBaselineMinRtt_;
+  uint8_t cssRounds_{0};
+};
+
+folly::StringPiece hystartPlusPlusPhaseToString(HystartPlusPlus::Phase phase);
+
+} // namespace quic
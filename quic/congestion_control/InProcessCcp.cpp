@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/InProcessCcp.h>
+
+#include <quic/congestion_control/QuicCCP.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace {
+// The agent re-checks the rings at least that often while it sleeps.
+constexpr std::chrono::milliseconds kAgentIdleWait{10};
+} // namespace
+
+namespace quic {
+
+InProcessCcpDatapath::InProcessCcpDatapath(
+    folly::EventBase* evb,
+    InProcessCcpAgent* agent,
+    size_t ringSize)
+    : evb_(evb), agent_(agent), toAgent_(ringSize), toDatapath_(ringSize) {}
+
+uint64_t InProcessCcpDatapath::registerConnection(
+    CCP* ccp,
+    CcpMeasurement start) {
+  DCHECK(evb_->isInEventBaseThread());
+  start.type = CcpMeasurement::Type::Start;
+  start.connId = nextConnId_++;
+  if (!sendMeasurement(start)) {
+    LOG(ERROR) << "InProcessCcpDatapath ring full, connection not registered";
+    return 0;
+  }
+  connections_.emplace(start.connId, ccp);
+  return start.connId;
+}
+
+void InProcessCcpDatapath::unregisterConnection(uint64_t connId) {
+  DCHECK(evb_->isInEventBaseThread());
+  if (connections_.erase(connId) == 0) {
+    return;
+  }
+  CcpMeasurement end;
+  end.type = CcpMeasurement::Type::End;
+  end.connId = connId;
+  if (!sendMeasurement(end)) {
+    pendingEnds_.push_back(connId);
+  }
+}
+
+bool InProcessCcpDatapath::sendMeasurement(const CcpMeasurement& measurement) {
+  if (!pendingEnds_.empty()) {
+    flushPendingEnds();
+  }
+  if (!toAgent_.write(measurement)) {
+    return false;
+  }
+  agent_->wakeUp();
+  return true;
+}
+
+void InProcessCcpDatapath::flushPendingEnds() {
+  CcpMeasurement end;
+  end.type = CcpMeasurement::Type::End;
+  size_t sent = 0;
+  for (; sent < pendingEnds_.size(); sent++) {
+    end.connId = pendingEnds_[sent];
+    if (!toAgent_.write(end)) {
+      break;
+    }
+  }
+  pendingEnds_.erase(pendingEnds_.begin(), pendingEnds_.begin() + sent);
+}
+
+folly::EventBase* InProcessCcpDatapath::getEventBase() const noexcept {
+  return evb_;
+}
+
+size_t InProcessCcpDatapath::numConnections() const noexcept {
+  return connections_.size();
+}
+
+bool InProcessCcpDatapath::readMeasurement(CcpMeasurement& measurement) {
+  return toAgent_.read(measurement);
+}
+
+bool InProcessCcpDatapath::sendUpdate(const CcpControlUpdate& update) {
+  if (!toDatapath_.write(update)) {
+    return false;
+  }
+  scheduleDrain();
+  return true;
+}
+
+bool InProcessCcpDatapath::hasMeasurements() const {
+  return !toAgent_.isEmpty();
+}
+
+void InProcessCcpDatapath::detach() {
+  std::lock_guard<std::mutex> guard(evbMutex_);
+  detached_ = true;
+}
+
+void InProcessCcpDatapath::scheduleDrain() {
+  // A single wake up of the worker applies every update written until it
+  // runs, later ones schedule another.
+  if (drainScheduled_.exchange(true)) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(evbMutex_);
+  if (detached_) {
+    return;
+  }
+  evb_->runInEventBaseThread(
+      [self = shared_from_this()] { self->drainUpdates(); });
+}
+
+void InProcessCcpDatapath::drainUpdates() {
+  drainScheduled_ = false;
+  CcpControlUpdate update;
+  while (toDatapath_.read(update)) {
+    auto it = connections_.find(update.connId);
+    if (it == connections_.end()) {
+      // The connection went away while the agent was working on its report.
+      continue;
+    }
+    it->second->onControlUpdate(update);
+  }
+}
+
+InProcessCcpAgent::InProcessCcpAgent(
+    InProcessCcpAlgorithmFactory algorithmFactory,
+    size_t ringSize)
+    : algorithmFactory_(std::move(algorithmFactory)), ringSize_(ringSize) {
+  CHECK_GT(ringSize_, 1);
+}
+
+InProcessCcpAgent::~InProcessCcpAgent() {
+  stop();
+}
+
+void InProcessCcpAgent::start() {
+  CHECK(!running_.exchange(true)) << "InProcessCcpAgent already started";
+  thread_ = std::thread([this] { run(); });
+}
+
+void InProcessCcpAgent::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(sleepMutex_);
+  }
+  sleepCv_.notify_one();
+  thread_.join();
+}
+
+std::shared_ptr<InProcessCcpDatapath> InProcessCcpAgent::addDatapath(
+    folly::EventBase* evb) {
+  auto datapath =
+      std::make_shared<InProcessCcpDatapath>(evb, this, ringSize_);
+  std::lock_guard<std::mutex> guard(datapathsMutex_);
+  datapaths_.push_back(datapath);
+  datapathsVersion_++;
+  return datapath;
+}
+
+void InProcessCcpAgent::removeDatapath(
+    const std::shared_ptr<InProcessCcpDatapath>& datapath) {
+  datapath->detach();
+  std::lock_guard<std::mutex> guard(datapathsMutex_);
+  datapaths_.erase(
+      std::remove(datapaths_.begin(), datapaths_.end(), datapath),
+      datapaths_.end());
+  datapathsVersion_++;
+}
+
+void InProcessCcpAgent::wakeUp() {
+  // Pairs with the fence in run(), so that either the agent sees what was
+  // just written to the ring before going to sleep, or we see it sleeping.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    {
+      std::lock_guard<std::mutex> guard(sleepMutex_);
+    }
+    sleepCv_.notify_one();
+  }
+}
+
+void InProcessCcpAgent::run() {
+  while (running_.load()) {
+    refreshDatapaths();
+    bool worked = false;
+    for (auto& state : states_) {
+      worked |= process(state);
+    }
+    if (worked) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!hasWork() && running_.load()) {
+      sleepCv_.wait_for(lock, kAgentIdleWait);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+}
+
+bool InProcessCcpAgent::process(DatapathState& state) {
+  CcpMeasurement measurement;
+  size_t processed = 0;
+  // Bounded so that one busy worker doesn't hold up the others.
+  while (processed < ringSize_ &&
+         state.datapath->readMeasurement(measurement)) {
+    processed++;
+    switch (measurement.type) {
+      case CcpMeasurement::Type::Start:
+        state.algorithms[measurement.connId] = algorithmFactory_(measurement);
+        break;
+      case CcpMeasurement::Type::End:
+        state.algorithms.erase(measurement.connId);
+        break;
+      case CcpMeasurement::Type::Report: {
+        auto it = state.algorithms.find(measurement.connId);
+        if (it == state.algorithms.end()) {
+          break;
+        }
+        auto update = it->second->onReport(measurement);
+        update.connId = measurement.connId;
+        if (!state.datapath->sendUpdate(update)) {
+          VLOG(4) << "InProcessCcpAgent dropping update for conn="
+                  << measurement.connId;
+        }
+        break;
+      }
+    }
+  }
+  return processed > 0;
+}
+
+void InProcessCcpAgent::refreshDatapaths() {
+  if (datapathsVersion_.load() == statesVersion_) {
+    return;
+  }
+  std::vector<DatapathState> states;
+  {
+    std::lock_guard<std::mutex> guard(datapathsMutex_);
+    statesVersion_ = datapathsVersion_.load();
+    for (const auto& datapath : datapaths_) {
+      auto it = std::find_if(
+          states_.begin(), states_.end(), [&](const DatapathState& state) {
+            return state.datapath == datapath;
+          });
+      if (it != states_.end()) {
+        states.push_back(std::move(*it));
+      } else {
+        states.push_back(DatapathState{datapath, {}});
+      }
+    }
+  }
+  states_ = std::move(states);
+}
+
+bool InProcessCcpAgent::hasWork() const {
+  if (datapathsVersion_.load() != statesVersion_) {
+    return true;
+  }
+  for (const auto& state : states_) {
+    if (state.datapath->hasMeasurements()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace quic
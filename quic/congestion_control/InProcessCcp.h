@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/QuicConstants.h>
+
+#include <folly/Function.h>
+#include <folly/ProducerConsumerQueue.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/async/EventBase.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace quic {
+
+class CCP;
+
+constexpr size_t kDefaultInProcessCcpRingSize = 4096;
+
+/**
+ * What a connection reports to the in-process CCP. Counters cover the report
+ * interval, the rest is the latest value at the end of it.
+ */
+struct CcpMeasurement {
+  enum class Type : uint8_t {
+    // The connection started, only mss and initCwndBytes are set.
+    Start,
+    Report,
+    // The connection ended, nothing else is set.
+    End,
+  };
+
+  Type type{Type::Report};
+  uint64_t connId{0};
+  uint64_t mss{0};
+  uint64_t initCwndBytes{0};
+  std::chrono::microseconds interval{0};
+  uint64_t bytesAcked{0};
+  uint64_t packetsAcked{0};
+  uint64_t packetsLost{0};
+  uint64_t cwndBytes{0};
+  uint64_t bytesInFlight{0};
+  std::chrono::microseconds srtt{0};
+  // In bytes per second.
+  uint64_t sendRate{0};
+  uint64_t ackRate{0};
+};
+
+/**
+ * What the in-process CCP answers to a report, 0 keeps the current value.
+ */
+struct CcpControlUpdate {
+  uint64_t connId{0};
+  uint64_t cwndBytes{0};
+  // In bytes per second.
+  uint64_t pacingRate{0};
+};
+
+/**
+ * A congestion control algorithm run by InProcessCcpAgent, with one instance
+ * per connection. Unlike a CongestionController it never sees individual
+ * packets, only the reports the connection sends once per report interval.
+ */
+class InProcessCcpAlgorithm {
+ public:
+  virtual ~InProcessCcpAlgorithm() = default;
+
+  /**
+   * Called on the agent thread for each report of the connection. The connId
+   * of the returned update is filled in by the agent.
+   */
+  virtual CcpControlUpdate onReport(const CcpMeasurement& report) = 0;
+};
+
+using InProcessCcpAlgorithmFactory =
+    folly::Function<std::unique_ptr<InProcessCcpAlgorithm>(
+        const CcpMeasurement& start)>;
+
+class InProcessCcpAgent;
+
+/**
+ * The datapath side of the in-process CCP for one QuicServerWorker, the
+ * counterpart of CCPReader. Reports go to the agent and control updates come
+ * back through a pair of single producer single consumer rings. Locks are
+ * only taken to wake up the other side: the worker when the agent sleeps,
+ * and the agent at most once per batch of updates, when it wakes up the
+ * worker to apply them.
+ *
+ * The register/unregister/sendMeasurement functions must be called from the
+ * worker's EventBase thread, the rest belongs to the agent.
+ */
+class InProcessCcpDatapath
+    : public std::enable_shared_from_this<InProcessCcpDatapath> {
+ public:
+  InProcessCcpDatapath(
+      folly::EventBase* evb,
+      InProcessCcpAgent* agent,
+      size_t ringSize);
+
+  /**
+   * Tells the agent about a new connection, returns its id or 0 if the agent
+   * couldn't be told, in which case the connection shouldn't use it.
+   */
+  uint64_t registerConnection(CCP* ccp, CcpMeasurement start);
+  void unregisterConnection(uint64_t connId);
+
+  /**
+   * Returns false if the ring to the agent is full, the measurement is not
+   * sent then.
+   */
+  bool sendMeasurement(const CcpMeasurement& measurement);
+
+  FOLLY_NODISCARD folly::EventBase* getEventBase() const noexcept;
+  FOLLY_NODISCARD size_t numConnections() const noexcept;
+
+  // Agent side.
+  bool readMeasurement(CcpMeasurement& measurement);
+  bool sendUpdate(const CcpControlUpdate& update);
+  FOLLY_NODISCARD bool hasMeasurements() const;
+  // Stops waking up the worker, once it is going away. The agent doesn't
+  // touch the EventBase any more once this returns.
+  void detach();
+
+ private:
+  void scheduleDrain();
+  void drainUpdates();
+  // Sends the End messages which didn't fit in the ring when their connection
+  // went away.
+  void flushPendingEnds();
+
+  folly::EventBase* evb_;
+  InProcessCcpAgent* agent_;
+  folly::ProducerConsumerQueue<CcpMeasurement> toAgent_;
+  folly::ProducerConsumerQueue<CcpControlUpdate> toDatapath_;
+  std::atomic<bool> drainScheduled_{false};
+  // Held by the agent while it posts to evb_, so that detach() waits for it.
+  std::mutex evbMutex_;
+  bool detached_{false};
+
+  // Only touched from the worker's thread.
+  folly::F14FastMap<uint64_t, CCP*> connections_;
+  uint64_t nextConnId_{1};
+  std::vector<uint64_t> pendingEnds_;
+};
+
+/**
+ * Runs in-process CCP algorithms on a dedicated thread, for every worker of a
+ * QuicServer. It is the in-process replacement for the CCP process reached
+ * through the /ccp/portus socket: the thread wakes up when a worker sends
+ * reports, hands each one to the algorithm instance of its connection, and
+ * sends the answer back to the worker. Applications set one up with
+ * QuicServer::setInProcessCcpAgent() and the CCP congestion control type.
+ */
+class InProcessCcpAgent {
+ public:
+  explicit InProcessCcpAgent(
+      InProcessCcpAlgorithmFactory algorithmFactory,
+      size_t ringSize = kDefaultInProcessCcpRingSize);
+  ~InProcessCcpAgent();
+
+  void start();
+  void stop();
+
+  /**
+   * Thread safe, the returned datapath has to be given back to
+   * removeDatapath() before evb goes away. The agent never posts to evb
+   * once removeDatapath() returns.
+   */
+  std::shared_ptr<InProcessCcpDatapath> addDatapath(folly::EventBase* evb);
+  void removeDatapath(const std::shared_ptr<InProcessCcpDatapath>& datapath);
+
+  // Called by datapaths after sending measurements, only takes a lock when
+  // the agent is sleeping.
+  void wakeUp();
+
+ private:
+  struct DatapathState {
+    std::shared_ptr<InProcessCcpDatapath> datapath;
+    folly::F14FastMap<uint64_t, std::unique_ptr<InProcessCcpAlgorithm>>
+        algorithms;
+  };
+
+  void run();
+  // Returns whether there was anything to process.
+  bool process(DatapathState& state);
+  void refreshDatapaths();
+  bool hasWork() const;
+
+  InProcessCcpAlgorithmFactory algorithmFactory_;
+  size_t ringSize_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+
+  std::mutex datapathsMutex_;
+  std::vector<std::shared_ptr<InProcessCcpDatapath>> datapaths_;
+  std::atomic<uint64_t> datapathsVersion_{0};
+  // Only touched from the agent thread.
+  std::vector<DatapathState> states_;
+  uint64_t statesVersion_{0};
+
+  std::mutex sleepMutex_;
+  std::condition_variable sleepCv_;
+  std::atomic<bool> sleeping_{false};
+};
+
+} // namespace quic
@@ -24,6 +24,9 @@ NewReno::NewReno(QuicConnectionStateBase& conn)
       conn_.udpSendPacketLen,
       conn_.transportSettings.maxCwndInMss,
       conn_.transportSettings.minCwndInMss);
+  if (conn_.transportSettings.hystartPlusPlus) {
+    hystartPlusPlus_.emplace(conn_);
+  }
 }
 
 void NewReno::onRemoveBytesFromInflight(uint64_t bytes) {
@@ -40,6 +43,9 @@ void NewReno::onRemoveBytesFromInflight(uint64_t bytes) {
 void NewReno::onPacketSent(const OutstandingPacket& packet) {
   addAndCheckOverflow(
       conn_.lossState.inflightBytes, packet.metadata.encodedSize);
+  if (hystartPlusPlus_) {
+    hystartPlusPlus_->onPacketSent(packet);
+  }
   VLOG(10) << __func__ << " writable=" << getWritableBytes()
            << " cwnd=" << cwndBytes_
            << " inflight=" << conn_.lossState.inflightBytes
@@ -65,8 +71,12 @@ void NewReno::onAckEvent(const AckEvent& ack) {
         getCongestionWindow(),
         kCongestionPacketAck);
   }
-  for (const auto& packet : ack.ackedPackets) {
-    onPacketAcked(packet);
+  if (hystartPlusPlus_ && inSlowStart()) {
+    onAckEventInHystartPlusPlus(ack);
+  } else {
+    for (const auto& packet : ack.ackedPackets) {
+      onPacketAcked(packet);
+    }
   }
   cwndBytes_ = boundedCwnd(
       cwndBytes_,
@@ -75,6 +85,24 @@ void NewReno::onAckEvent(const AckEvent& ack) {
       conn_.transportSettings.minCwndInMss);
 }
 
+void NewReno::onAckEventInHystartPlusPlus(const AckEvent& ack) {
+  uint64_t ackedBytes = 0;
+  for (const auto& packet : ack.ackedPackets) {
+    if (!endOfRecovery_ || packet.sentTime >= *endOfRecovery_) {
+      ackedBytes += packet.encodedSize;
+    }
+  }
+  if (ackedBytes == 0) {
+    return;
+  }
+  addAndCheckOverflow(cwndBytes_, hystartPlusPlus_->onAck(ack, ackedBytes));
+  if (!hystartPlusPlus_->inSlowStart()) {
+    ssthresh_ = cwndBytes_;
+    VLOG(10) << __func__ << " exit slow start, ssthresh=" << ssthresh_ << " "
+             << conn_;
+  }
+}
+
 void NewReno::onPacketAcked(
     const CongestionController::AckEvent::AckPacket& packet) {
   if (endOfRecovery_ && packet.sentTime < *endOfRecovery_) {
@@ -95,6 +123,12 @@ void NewReno::onPacketAcked(
 void NewReno::onPacketAckOrLoss(
     folly::Optional<AckEvent> ackEvent,
     folly::Optional<LossEvent> lossEvent) {
+  onPacketAckOrLossInPlace(ackEvent.get_pointer(), lossEvent.get_pointer());
+}
+
+void NewReno::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ackEvent,
+    const LossEvent* FOLLY_NULLABLE lossEvent) {
   if (lossEvent) {
     onPacketLoss(*lossEvent);
     // When we start to support pacing in NewReno, we need to call onPacketsLoss
@@ -112,7 +146,7 @@ void NewReno::onPacketLoss(const LossEvent& loss) {
       loss.largestLostSentTime.has_value());
   subtractAndCheckUnderflow(conn_.lossState.inflightBytes, loss.lostBytes);
   if (!endOfRecovery_ || *endOfRecovery_ < *loss.largestLostSentTime) {
-    endOfRecovery_ = Clock::now();
+    endOfRecovery_ = loss.lossTime;
     cwndBytes_ = (cwndBytes_ >> kRenoLossReductionFactorShift);
     cwndBytes_ = boundedCwnd(
         cwndBytes_,
@@ -148,6 +182,9 @@ void NewReno::onPacketLoss(const LossEvent& loss) {
           kPersistentCongestion);
     }
     cwndBytes_ = conn_.transportSettings.minCwndInMss * conn_.udpSendPacketLen;
+    if (hystartPlusPlus_) {
+      hystartPlusPlus_->reset();
+    }
   }
 }
 
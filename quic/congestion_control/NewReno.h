@@ -9,6 +9,7 @@
 #pragma once
 
 #include <quic/QuicException.h>
+#include <quic/congestion_control/HystartPlusPlus.h>
 #include <quic/state/StateData.h>
 
 #include <limits>
@@ -22,6 +23,9 @@ class NewReno : public CongestionController {
   void onPacketSent(const OutstandingPacket& packet) override;
   void onPacketAckOrLoss(folly::Optional<AckEvent>, folly::Optional<LossEvent>)
       override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE,
+      const LossEvent* FOLLY_NULLABLE) override;
 
   uint64_t getWritableBytes() const noexcept override;
   uint64_t getCongestionWindow() const noexcept override;
@@ -41,6 +45,7 @@ class NewReno : public CongestionController {
  private:
   void onPacketLoss(const LossEvent&);
   void onAckEvent(const AckEvent&);
+  void onAckEventInHystartPlusPlus(const AckEvent&);
   void onPacketAcked(const CongestionController::AckEvent::AckPacket&);
 
  private:
@@ -48,5 +53,8 @@ class NewReno : public CongestionController {
   uint64_t ssthresh_;
   uint64_t cwndBytes_;
   folly::Optional<TimePoint> endOfRecovery_;
+  // Set when transportSettings.hystartPlusPlus is, slow start then ends
+  // before the first loss once it finds the exit point.
+  folly::Optional<HystartPlusPlus> hystartPlusPlus_;
 };
 } // namespace quic
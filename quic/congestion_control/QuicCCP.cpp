@@ -17,14 +17,8 @@
 #include <ccp/ccp_error.h>
 #endif
 
-// The ccpDatapath field is only defined when ccp is enabled.
-// When ccp is not enabled, we can safely set this to null, because an
-// instance of this class cannot be created (will be denied by
-// ServerCongestionControllerFactory).
-
 namespace quic {
 
-#ifdef CCP_ENABLED
 CCP::CCP(QuicConnectionStateBase& conn)
     : conn_(static_cast<QuicServerConnectionState&>(conn)),
       endOfRecovery_(folly::none),
@@ -36,6 +30,20 @@ CCP::CCP(QuicConnectionStateBase& conn)
       conn_.transportSettings.maxCwndInMss,
       conn_.transportSettings.minCwndInMss);
 
+  inProcessDatapath_ = conn_.inProcessCcpDatapath;
+  if (inProcessDatapath_) {
+    CcpMeasurement start;
+    start.mss = conn_.udpSendPacketLen;
+    start.initCwndBytes = cwndBytes_;
+    inProcessConnId_ = inProcessDatapath_->registerConnection(this, start);
+    lastReportTime_ = Clock::now();
+    if (!inProcessConnId_) {
+      fallback();
+    }
+    return;
+  }
+
+#ifdef CCP_ENABLED
   datapath_ = conn_.ccpDatapath;
 
   struct ccp_datapath_info info = {
@@ -63,14 +71,23 @@ CCP::CCP(QuicConnectionStateBase& conn)
     fallback();
     LOG(ERROR) << "libccp::ccp_connection_start failed\n";
   }
+#else
+  // Neither libccp nor an in-process CCP to talk to.
+  fallback();
+#endif
 }
 
 CCP::~CCP() {
+  if (inProcessConnId_) {
+    inProcessDatapath_->unregisterConnection(inProcessConnId_);
+  }
+#ifdef CCP_ENABLED
   if (ccp_conn_) {
     // Inform CCP that this connection has ended and thus it can free related
     // state.
     ccp_connection_free(datapath_, ccp_conn_->index);
   }
+#endif
 }
 
 void CCP::onRemoveBytesFromInflight(uint64_t bytes) {
@@ -110,11 +127,8 @@ void CCP::onAckEvent(const AckEvent& ack) {
     onRemoveBytesFromInflight(ack.ackedBytes);
   }
 
-  // Add latest state to this batch of udpates. See comment regarding
-  // ccp_primitives struct
-  struct ccp_primitives* mmt = &ccp_conn_->prims;
-  mmt->bytes_acked += ack.ackedBytes;
-  mmt->packets_acked += ack.ackedPackets.size();
+  pendingReport_.bytesAcked += ack.ackedBytes;
+  pendingReport_.packetsAcked += ack.ackedPackets.size();
   for (const auto& packet : ack.ackedPackets) {
     if (packet.encodedSize == 0) {
       continue;
@@ -142,17 +156,20 @@ void CCP::onAckEvent(const AckEvent& ack) {
 void CCP::onPacketAckOrLoss(
     folly::Optional<AckEvent> ackEvent,
     folly::Optional<LossEvent> lossEvent) {
+  onPacketAckOrLossInPlace(ackEvent.get_pointer(), lossEvent.get_pointer());
+}
+
+void CCP::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ackEvent,
+    const LossEvent* FOLLY_NULLABLE lossEvent) {
   // If we are in fallback mode, forward the call to the fallback algorithm.
   if (inFallback_) {
-    fallbackCC_.onPacketAckOrLoss(ackEvent, lossEvent);
-  }
-  if (!ccp_conn_) {
-    return;
+    fallbackCC_.onPacketAckOrLossInPlace(ackEvent, lossEvent);
   }
 
   // If we never connected to ccp in the first place, nothing else to do
   // regardless
-  if (!ccp_conn_) {
+  if (!ccp_conn_ && !inProcessConnId_) {
     return;
   }
 
@@ -172,6 +189,12 @@ void CCP::onPacketAckOrLoss(
     onAckEvent(*ackEvent);
   }
 
+  if (inProcessConnId_) {
+    maybeReportInProcess();
+    return;
+  }
+
+#ifdef CCP_ENABLED
   /**
    * The ccp_primitives struct contains the list of all statistics ccp wants to
    * know about. These are kept as up to date as possible, and fed to ccp_invoke
@@ -180,6 +203,9 @@ void CCP::onPacketAckOrLoss(
    * caller, this is totally abstracted from us.
    */
   struct ccp_primitives* mmt = &ccp_conn_->prims;
+  mmt->bytes_acked = pendingReport_.bytesAcked;
+  mmt->packets_acked = pendingReport_.packetsAcked;
+  mmt->lost_pkts_sample = pendingReport_.packetsLost;
   mmt->snd_cwnd = cwndBytes_;
   mmt->rtt_sample_us = conn_.lossState.srtt.count();
   mmt->bytes_in_flight = conn_.lossState.inflightBytes;
@@ -221,9 +247,68 @@ void CCP::onPacketAckOrLoss(
   // so we need to reset them each time. The other measurements are just the
   // most up-to-date view of the statistics, so they can simply be overwritten
   // each time.
-  mmt->bytes_acked = 0;
-  mmt->packets_acked = 0;
-  mmt->lost_pkts_sample = 0;
+  pendingReport_.bytesAcked = 0;
+  pendingReport_.packetsAcked = 0;
+  pendingReport_.packetsLost = 0;
+#endif
+}
+
+void CCP::maybeReportInProcess() {
+  auto now = Clock::now();
+  auto sinceLastReport = now - lastReportTime_;
+  if (awaitingUpdate_) {
+    // Reports aren't sent any faster than the agent answers them, unless it
+    // stopped answering.
+    if (sinceLastReport < conn_.transportSettings.ccpConfig.fallbackTimeout) {
+      return;
+    }
+    if (!inFallback_) {
+      fallback();
+    }
+  }
+  if (sinceLastReport < reportInterval()) {
+    return;
+  }
+  pendingReport_.type = CcpMeasurement::Type::Report;
+  pendingReport_.connId = inProcessConnId_;
+  pendingReport_.interval =
+      std::chrono::duration_cast<std::chrono::microseconds>(sinceLastReport);
+  pendingReport_.cwndBytes = cwndBytes_;
+  pendingReport_.bytesInFlight = conn_.lossState.inflightBytes;
+  pendingReport_.srtt = conn_.lossState.srtt;
+  pendingReport_.sendRate = sendRate_.normalize();
+  pendingReport_.ackRate = ackRate_.normalize();
+  if (!inProcessDatapath_->sendMeasurement(pendingReport_)) {
+    // Keep counting, the next report covers this interval too.
+    return;
+  }
+  pendingReport_.bytesAcked = 0;
+  pendingReport_.packetsAcked = 0;
+  pendingReport_.packetsLost = 0;
+  lastReportTime_ = now;
+  awaitingUpdate_ = true;
+}
+
+std::chrono::microseconds CCP::reportInterval() const {
+  if (conn_.transportSettings.ccpConfig.reportInterval.count() > 0) {
+    return conn_.transportSettings.ccpConfig.reportInterval;
+  }
+  return conn_.lossState.srtt.count() > 0
+      ? conn_.lossState.srtt
+      : conn_.transportSettings.initialRtt;
+}
+
+void CCP::onControlUpdate(const CcpControlUpdate& update) noexcept {
+  awaitingUpdate_ = false;
+  if (inFallback_) {
+    restoreAfterFallback();
+  }
+  if (update.cwndBytes) {
+    setCongestionWindow(update.cwndBytes);
+  }
+  if (update.pacingRate) {
+    setPacingRate(update.pacingRate);
+  }
 }
 
 void CCP::fallback() {
@@ -249,7 +334,7 @@ void CCP::onLossEvent(const LossEvent& loss) {
   // packets within the same event and multiple distinct loss events.
   if (!endOfRecovery_ || *endOfRecovery_ < *loss.largestLostSentTime) {
     endOfRecovery_ = Clock::now();
-    ccp_conn_->prims.lost_pkts_sample += loss.lostPackets;
+    pendingReport_.packetsLost += loss.lostPackets;
   }
 
   // Fallback algorithm takes care of bytes acked since it shares the same conn_
@@ -289,38 +374,6 @@ void CCP::setCongestionWindow(uint64_t cwnd) noexcept {
 uint64_t CCP::getBytesInFlight() const noexcept {
   return conn_.lossState.inflightBytes;
 }
-#else
-
-CCP::CCP(QuicConnectionStateBase& conn)
-    : conn_(static_cast<QuicServerConnectionState&>(conn)),
-      endOfRecovery_(folly::none),
-      inFallback_(false),
-      fallbackCC_(conn) {}
-
-void CCP::onRemoveBytesFromInflight(uint64_t) {}
-void CCP::onPacketSent(const OutstandingPacket&) {}
-void CCP::onPacketAckOrLoss(
-    folly::Optional<AckEvent>,
-    folly::Optional<LossEvent>) {}
-uint64_t CCP::getWritableBytes() const noexcept {
-  return 0;
-}
-uint64_t CCP::getCongestionWindow() const noexcept {
-  return 0;
-}
-void CCP::setCongestionWindow(uint64_t) noexcept {}
-uint64_t CCP::getBytesInFlight() const noexcept {
-  return 0;
-}
-void CCP::setPacingRate(uint64_t) noexcept {}
-void CCP::onLossEvent(const LossEvent&) {}
-void CCP::onAckEvent(const AckEvent&) {}
-void CCP::fallback() {}
-void CCP::restoreAfterFallback() {}
-
-CCP::~CCP() = default;
-
-#endif
 
 CongestionControlType CCP::type() const noexcept {
   return CongestionControlType::CCP;
@@ -10,6 +10,7 @@
 
 #include <quic/QuicException.h>
 #include <quic/congestion_control/Bandwidth.h>
+#include <quic/congestion_control/InProcessCcp.h>
 #include <quic/congestion_control/QuicCubic.h>
 #include <quic/server/state/ServerStateMachine.h>
 #include <quic/state/StateData.h>
@@ -50,6 +51,13 @@ namespace quic {
  * connection is re-established with CCP, we leave fallback mode and pick up the
  * cwnd where cubic left off.
  *
+ * When the server worker has an InProcessCcpDatapath, CCP runs in this process
+ * instead and libccp isn't involved: acks and losses are aggregated here into
+ * one CcpMeasurement per report interval, and the answers of the
+ * InProcessCcpAgent come back through onControlUpdate(). Fallback works the
+ * same way, it starts when a report goes unanswered for
+ * ccpConfig.fallbackTimeout.
+ *
  */
 class CCP : public CongestionController {
  public:
@@ -60,6 +68,9 @@ class CCP : public CongestionController {
   void onPacketSent(const OutstandingPacket& packet) override;
   void onPacketAckOrLoss(folly::Optional<AckEvent>, folly::Optional<LossEvent>)
       override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE,
+      const LossEvent* FOLLY_NULLABLE) override;
 
   FOLLY_NODISCARD uint64_t getWritableBytes() const noexcept override;
   FOLLY_NODISCARD uint64_t getCongestionWindow() const noexcept override;
@@ -77,6 +88,10 @@ class CCP : public CongestionController {
   // connection.
   void setPacingRate(uint64_t rate) noexcept;
 
+  // Called by the InProcessCcpDatapath with the answer of the in-process CCP
+  // to a report of this connection.
+  void onControlUpdate(const CcpControlUpdate& update) noexcept;
+
   FOLLY_NODISCARD bool isAppLimited() const noexcept override;
 
   void getStats(CongestionControllerStats& /*stats*/) const override {}
@@ -89,6 +104,10 @@ class CCP : public CongestionController {
   void fallback();
   // Go back to using CCP after a period of fallback
   void restoreAfterFallback();
+  // Sends the measurements gathered so far to the in-process CCP, if the
+  // report interval is over.
+  void maybeReportInProcess();
+  FOLLY_NODISCARD std::chrono::microseconds reportInterval() const;
 
  private:
   QuicServerConnectionState& conn_;
@@ -105,6 +124,17 @@ class CCP : public CongestionController {
   // The global (per QuicServerWorker) state needed by libccp, retrieved from
   // the connection's corresponding QuicServerConnectionState.
   struct ccp_datapath* datapath_{nullptr};
+  // Set instead of datapath_ when CCP runs in this process, from the
+  // connection's QuicServerConnectionState as well.
+  InProcessCcpDatapath* inProcessDatapath_{nullptr};
+  // 0 when not registered with inProcessDatapath_.
+  uint64_t inProcessConnId_{0};
+  // Counters since the last report, sent to libccp through ccp_conn_->prims
+  // or to the in-process CCP as is.
+  CcpMeasurement pendingReport_;
+  TimePoint lastReportTime_;
+  // Whether the in-process CCP has yet to answer the last report.
+  bool awaitingUpdate_{false};
   // Used to help ensure we don't count the same loss event multiple times.
   folly::Optional<TimePoint> endOfRecovery_;
   // Current estimate of the send and ack rate, two of the basic statistics sent
@@ -32,6 +32,9 @@ Cubic::Cubic(
   steadyState_.tcpFriendly = tcpFriendly;
   steadyState_.estRenoCwnd = cwndBytes_;
   hystartState_.ackTrain = ackTrain;
+  if (conn_.transportSettings.hystartPlusPlus) {
+    hystartPlusPlus_.emplace(conn_);
+  }
   if (conn_.qLogger) {
     conn_.qLogger->addCongestionMetricUpdate(
         conn_.lossState.inflightBytes,
@@ -81,6 +84,9 @@ void Cubic::onPersistentCongestion() {
   quiescenceStart_ = folly::none;
   hystartState_.found = Cubic::HystartFound::No;
   hystartState_.inRttRound = false;
+  if (hystartPlusPlus_) {
+    hystartPlusPlus_->reset();
+  }
 
   state_ = CubicStates::Hystart;
 
@@ -101,6 +107,10 @@ void Cubic::onPacketSent(const OutstandingPacket& packet) {
         LocalErrorCode::INFLIGHT_BYTES_OVERFLOW);
   }
   conn_.lossState.inflightBytes += packet.metadata.encodedSize;
+  latestSentTime_ = std::max(latestSentTime_, packet.metadata.time);
+  if (hystartPlusPlus_) {
+    hystartPlusPlus_->onPacketSent(packet);
+  }
 }
 
 void Cubic::onPacketLoss(const LossEvent& loss) {
@@ -114,7 +124,7 @@ void Cubic::onPacketLoss(const LossEvent& loss) {
   // as it was already accounted for in a recovery period.
   if (*loss.largestLostSentTime >=
       recoveryState_.endOfRecovery.value_or(*loss.largestLostSentTime)) {
-    recoveryState_.endOfRecovery = Clock::now();
+    recoveryState_.endOfRecovery = loss.lossTime;
     cubicReduction(loss.lossTime);
     if (state_ == CubicStates::Hystart || state_ == CubicStates::Steady) {
       state_ = CubicStates::FastRecovery;
@@ -318,6 +328,12 @@ void Cubic::cubicReduction(TimePoint lossTime) noexcept {
 void Cubic::onPacketAckOrLoss(
     folly::Optional<AckEvent> ackEvent,
     folly::Optional<LossEvent> lossEvent) {
+  onPacketAckOrLossInPlace(ackEvent.get_pointer(), lossEvent.get_pointer());
+}
+
+void Cubic::onPacketAckOrLossInPlace(
+    const AckEvent* FOLLY_NULLABLE ackEvent,
+    const LossEvent* FOLLY_NULLABLE lossEvent) {
   // TODO: current code in detectLossPackets only gives back a loss event when
   // largestLostPacketNum isn't a folly::none. But we should probably also check
   // against it here anyway just in case the loss code is changed in the
@@ -388,11 +404,25 @@ void Cubic::startHystartRttRound(TimePoint time) noexcept {
   hystartState_.ackCount = 0;
   hystartState_.lastSampledRtt = hystartState_.currSampledRtt;
   hystartState_.currSampledRtt = folly::none;
-  hystartState_.rttRoundEndTarget = Clock::now();
+  hystartState_.rttRoundEndTarget = latestSentTime_;
   hystartState_.inRttRound = true;
   hystartState_.found = HystartFound::No;
 }
 
+void Cubic::exitHystart() noexcept {
+  hystartState_.inRttRound = false;
+  ssthresh_ = cwndBytes_;
+  /* Now we exit slow start, reset currSampledRtt to be maximal value so
+   * that next time we go back to slow start, we won't be using a very old
+   * sampled RTT as the lastSampledRtt:
+   */
+  hystartState_.currSampledRtt = folly::none;
+  steadyState_.lastMaxCwndBytes = folly::none;
+  steadyState_.lastReductionTime = folly::none;
+  quiescenceStart_ = folly::none;
+  state_ = CubicStates::Steady;
+}
+
 bool Cubic::isRecovered(TimePoint packetSentTime) noexcept {
   CHECK(recoveryState_.endOfRecovery.has_value());
   return packetSentTime > *recoveryState_.endOfRecovery;
@@ -413,6 +443,10 @@ float Cubic::pacingGain() const noexcept {
 }
 
 void Cubic::onPacketAckedInHystart(const AckEvent& ack) {
+  if (hystartPlusPlus_) {
+    onPacketAckedInHystartPlusPlus(ack);
+    return;
+  }
   if (!hystartState_.inRttRound) {
     startHystartRttRound(ack.ackTime);
   }
@@ -444,17 +478,7 @@ void Cubic::onPacketAckedInHystart(const AckEvent& ack) {
                << (*exitReason == Cubic::ExitReason::SSTHRESH
                        ? "cwnd > ssthresh"
                        : "found exit point");
-      hystartState_.inRttRound = false;
-      ssthresh_ = cwndBytes_;
-      /* Now we exit slow start, reset currSampledRtt to be maximal value so
-       * that next time we go back to slow start, we won't be using a very old
-       * sampled RTT as the lastSampledRtt:
-       */
-      hystartState_.currSampledRtt = folly::none;
-      steadyState_.lastMaxCwndBytes = folly::none;
-      steadyState_.lastReductionTime = folly::none;
-      quiescenceStart_ = folly::none;
-      state_ = CubicStates::Steady;
+      exitHystart();
     } else {
       // No exit yet, but we may still need to end this RTT round
       VLOG(20) << "Cubic Hystart, mayEndHystartRttRound, largestAckedPacketNum="
@@ -537,6 +561,29 @@ void Cubic::onPacketAckedInHystart(const AckEvent& ack) {
   }
 }
 
+void Cubic::onPacketAckedInHystartPlusPlus(const AckEvent& ack) {
+  auto increase = hystartPlusPlus_->onAck(ack, ack.ackedBytes);
+  if (std::numeric_limits<decltype(cwndBytes_)>::max() - cwndBytes_ <
+      increase) {
+    throw QuicInternalException(
+        "Cubic HystartPlusPlus: cwnd overflow", LocalErrorCode::CWND_OVERFLOW);
+  }
+  VLOG(15) << "Cubic HystartPlusPlus increase cwnd=" << cwndBytes_ << ", by "
+           << increase << ", phase="
+           << hystartPlusPlusPhaseToString(hystartPlusPlus_->phase());
+  cwndBytes_ = boundedCwnd(
+      cwndBytes_ + increase,
+      conn_.udpSendPacketLen,
+      conn_.transportSettings.maxCwndInMss,
+      conn_.transportSettings.minCwndInMss);
+  if (cwndBytes_ >= ssthresh_ || !hystartPlusPlus_->inSlowStart()) {
+    VLOG(15) << "Cubic exit slow start, reason = "
+             << (cwndBytes_ >= ssthresh_ ? "cwnd > ssthresh"
+                                         : "HystartPlusPlus exit");
+    exitHystart();
+  }
+}
+
 /**
  * Note: The Cubic paper, and linux/chromium implementation differ on the
  * definition of "time to origin", or the variable K in the paper. In the paper,
@@ -10,6 +10,7 @@
 
 #include <quic/QuicException.h>
 #include <quic/congestion_control/CongestionControlFunctions.h>
+#include <quic/congestion_control/HystartPlusPlus.h>
 
 #include <quic/state/StateData.h>
 
@@ -80,6 +81,9 @@ class Cubic : public CongestionController {
 
   void onPacketAckOrLoss(folly::Optional<AckEvent>, folly::Optional<LossEvent>)
       override;
+  void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE,
+      const LossEvent* FOLLY_NULLABLE) override;
   void onRemoveBytesFromInflight(uint64_t) override;
   void onPacketSent(const OutstandingPacket& packet) override;
 
@@ -103,6 +107,7 @@ class Cubic : public CongestionController {
   bool isAppIdle() const noexcept;
   void onPacketAcked(const AckEvent& ack);
   void onPacketAckedInHystart(const AckEvent& ack);
+  void onPacketAckedInHystartPlusPlus(const AckEvent& ack);
   void onPacketAckedInSteady(const AckEvent& ack);
   void onPacketAckedInRecovery(const AckEvent& ack);
 
@@ -113,6 +118,7 @@ class Cubic : public CongestionController {
   float pacingGain() const noexcept;
 
   void startHystartRttRound(TimePoint time) noexcept;
+  void exitHystart() noexcept;
 
   void cubicReduction(TimePoint lossTime) noexcept;
   void updateTimeToOrigin() noexcept;
@@ -178,8 +184,13 @@ class Cubic : public CongestionController {
 
   // if quiescenceStart_ has a value, then the connection is app limited
   folly::Optional<TimePoint> quiescenceStart_;
+  // Send time of the latest packet sent, where a new Hystart round ends.
+  TimePoint latestSentTime_;
 
   HystartState hystartState_;
+  // Replaces the Hystart exit point detection when
+  // transportSettings.hystartPlusPlus is set.
+  folly::Optional<HystartPlusPlus> hystartPlusPlus_;
   SteadyState steadyState_;
   RecoveryState recoveryState_;
 
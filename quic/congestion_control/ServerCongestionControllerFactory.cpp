@@ -9,6 +9,7 @@
 #include <quic/congestion_control/ServerCongestionControllerFactory.h>
 
 #include <quic/congestion_control/Bbr.h>
+#include <quic/congestion_control/Bbr2.h>
 #include <quic/congestion_control/BbrBandwidthSampler.h>
 #include <quic/congestion_control/BbrRttSampler.h>
 #include <quic/congestion_control/Copa.h>
@@ -30,13 +31,18 @@ ServerCongestionControllerFactory::makeCongestionController(
       congestionController = std::make_unique<NewReno>(conn);
       break;
     case CongestionControlType::CCP:
-#ifdef CCP_ENABLED
+#ifndef CCP_ENABLED
+      // Without libccp, only an in-process CCP can be used.
+      if (!static_cast<QuicServerConnectionState&>(conn)
+               .inProcessCcpDatapath) {
+        LOG(ERROR)
+            << "Server CC Factory cannot make CCP without an in-process CCP agent (unless recompiled with -DCCP_ENABLED). Falling back to cubic.";
+        congestionController = std::make_unique<Cubic>(conn);
+        break;
+      }
+#endif
       congestionController = std::make_unique<CCP>(conn);
       break;
-#else
-      LOG(ERROR)
-          << "Server CC Factory cannot make CCP (unless recompiled with -DCCP_ENABLED). Falling back to cubic.";
-#endif
     case CongestionControlType::Cubic:
       congestionController = std::make_unique<Cubic>(conn);
       break;
@@ -54,6 +60,14 @@ ServerCongestionControllerFactory::makeCongestionController(
       congestionController = std::move(bbr);
       break;
     }
+    case CongestionControlType::BBR2: {
+      auto bbr2 = std::make_unique<Bbr2CongestionController>(conn);
+      bbr2->setRttSampler(
+          std::make_unique<BbrRttSampler>(kBbr2ProbeRttInterval));
+      bbr2->setBandwidthSampler(std::make_unique<BbrBandwidthSampler>(conn));
+      congestionController = std::move(bbr2);
+      break;
+    }
     case CongestionControlType::None:
       break;
     case CongestionControlType::MAX:
@@ -66,12 +66,13 @@ void TokenlessPacer::onPacketSent() {}
 
 void TokenlessPacer::onPacketsLoss() {}
 
-std::chrono::microseconds TokenlessPacer::getTimeUntilNextWrite() const {
-  auto now = Clock::now();
+std::chrono::microseconds TokenlessPacer::getTimeUntilNextWrite(
+    TimePoint currentTime) const {
   // If we don't have a lastWriteTime_, we want to write immediately.
   auto timeSinceLastWrite =
       std::chrono::duration_cast<std::chrono::microseconds>(
-          now - lastWriteTime_.value_or(now - 2 * writeInterval_));
+          currentTime -
+          lastWriteTime_.value_or(currentTime - 2 * writeInterval_));
   if (timeSinceLastWrite >= writeInterval_) {
     return 0us;
   }
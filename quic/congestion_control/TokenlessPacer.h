@@ -33,7 +33,8 @@ class TokenlessPacer : public Pacer {
 
   void setRttFactor(uint8_t numerator, uint8_t denominator) override;
 
-  std::chrono::microseconds getTimeUntilNextWrite() const override;
+  std::chrono::microseconds getTimeUntilNextWrite(
+      TimePoint currentTime) const override;
 
   uint64_t updateAndGetWriteBatchSize(TimePoint currentTime) override;
 
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/Bbr2.h>
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/congestion_control/test/Mocks.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+class Bbr2Test : public Test {};
+
+TEST_F(Bbr2Test, InitStates) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  conn.udpSendPacketLen = 1000;
+  Bbr2CongestionController bbr(conn);
+  EXPECT_EQ(CongestionControlType::BBR2, bbr.type());
+  EXPECT_EQ(Bbr2CongestionController::State::Startup, bbr.state());
+  EXPECT_EQ("Startup", bbr2StateToString(bbr.state()));
+  EXPECT_EQ(
+      1000 * conn.transportSettings.initCwndInMss, bbr.getCongestionWindow());
+  EXPECT_EQ(bbr.getWritableBytes(), bbr.getCongestionWindow());
+  EXPECT_FALSE(bbr.inflightHi().has_value());
+  EXPECT_FALSE(bbr.inflightLo().has_value());
+  CongestionControllerStats stats;
+  bbr.getStats(stats);
+  EXPECT_EQ(
+      static_cast<uint8_t>(Bbr2CongestionController::State::Startup),
+      stats.bbr2Stats.state);
+  EXPECT_EQ(0, stats.bbr2Stats.inflightHi);
+  EXPECT_EQ(0, stats.bbr2Stats.inflightLo);
+}
+
+TEST_F(Bbr2Test, StartupExitsOnHighLoss) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  conn.udpSendPacketLen = 1000;
+  Bbr2CongestionController bbr(conn);
+  auto mockRttSampler = std::make_unique<NiceMock<MockMinRttSampler>>();
+  auto mockBandwidthSampler =
+      std::make_unique<NiceMock<MockBandwidthSampler>>();
+  auto rawRttSampler = mockRttSampler.get();
+  auto rawBandwidthSampler = mockBandwidthSampler.get();
+  bbr.setRttSampler(std::move(mockRttSampler));
+  bbr.setBandwidthSampler(std::move(mockBandwidthSampler));
+  EXPECT_CALL(*rawRttSampler, minRtt()).WillRepeatedly(Return(10ms));
+  EXPECT_CALL(*rawBandwidthSampler, getBandwidth())
+      .WillRepeatedly(Return(Bandwidth(1000, 1ms)));
+
+  std::vector<OutstandingPacket> packets;
+  for (PacketNum i = 0; i < 20; i++) {
+    packets.push_back(makeTestingWritePacket(i, 1000, 1000 * (i + 1)));
+    bbr.onPacketSent(packets.back());
+  }
+
+  // A couple of losses out of 20 packets don't end Startup.
+  CongestionController::LossEvent loss;
+  for (PacketNum i = 0; i < 2; i++) {
+    loss.addLostPacket(packets[i]);
+  }
+  bbr.onPacketAckOrLoss(folly::none, loss);
+  EXPECT_EQ(Bbr2CongestionController::State::Startup, bbr.state());
+  EXPECT_FALSE(bbr.inflightHi().has_value());
+
+  CongestionController::LossEvent loss2;
+  for (PacketNum i = 2; i < 2 + kBbr2StartupFullLossCount; i++) {
+    loss2.addLostPacket(packets[i]);
+  }
+  bbr.onPacketAckOrLoss(folly::none, loss2);
+  EXPECT_EQ(Bbr2CongestionController::State::Startup, bbr.state());
+  EXPECT_TRUE(bbr.inflightHi().has_value());
+
+  auto ackedPacket = packets[2 + kBbr2StartupFullLossCount];
+  bbr.onPacketAckOrLoss(
+      makeAck(
+          ackedPacket.packet.header.getPacketSequenceNum(),
+          1000,
+          ackedPacket.metadata.time + 10ms,
+          ackedPacket.metadata.time),
+      folly::none);
+  EXPECT_NE(Bbr2CongestionController::State::Startup, bbr.state());
+}
+
+TEST_F(Bbr2Test, NoLargestAckedPacketNoCrash) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  Bbr2CongestionController bbr(conn);
+  CongestionController::LossEvent loss;
+  loss.largestLostPacketNum = 0;
+  CongestionController::AckEvent ack;
+  bbr.onPacketAckOrLoss(ack, loss);
+}
+
+// Drives a connection with a 1000 bytes per ms bottleneck and a 10ms min rtt
+// through the states of the model.
+class Bbr2ModelTest : public Test {
+ public:
+  void SetUp() override {
+    conn_.udpSendPacketLen = kPacketSize;
+    bbr_ = std::make_unique<Bbr2CongestionController>(conn_);
+    auto rttSampler = std::make_unique<NiceMock<MockMinRttSampler>>();
+    auto bandwidthSampler = std::make_unique<NiceMock<MockBandwidthSampler>>();
+    rttSampler_ = rttSampler.get();
+    bandwidthSampler_ = bandwidthSampler.get();
+    bbr_->setRttSampler(std::move(rttSampler));
+    bbr_->setBandwidthSampler(std::move(bandwidthSampler));
+    ON_CALL(*rttSampler_, minRtt()).WillByDefault(Return(kMinRtt));
+    ON_CALL(*bandwidthSampler_, getBandwidth())
+        .WillByDefault(Return(Bandwidth(kPacketSize, 1ms)));
+    now_ = Clock::now();
+  }
+
+  std::vector<OutstandingPacket> sendPackets(size_t count) {
+    std::vector<OutstandingPacket> packets;
+    for (size_t i = 0; i < count; i++) {
+      totalBytesSent_ += kPacketSize;
+      packets.push_back(makeTestingWritePacket(
+          nextPacketNum_++, kPacketSize, totalBytesSent_, now_));
+      bbr_->onPacketSent(packets.back());
+    }
+    return packets;
+  }
+
+  void ack(const OutstandingPacket& packet) {
+    bbr_->onPacketAckOrLoss(
+        makeAck(
+            packet.packet.header.getPacketSequenceNum(),
+            kPacketSize,
+            now_,
+            packet.metadata.time),
+        folly::none);
+  }
+
+  void lose(const std::vector<OutstandingPacket>& packets) {
+    CongestionController::LossEvent loss(now_);
+    for (const auto& packet : packets) {
+      loss.addLostPacket(packet);
+    }
+    bbr_->onPacketAckOrLoss(folly::none, loss);
+  }
+
+  // One round trip with a single packet, acked after rtt.
+  void sendAndAckRound(std::chrono::microseconds rtt = kMinRtt) {
+    auto packet = sendPackets(1).front();
+    now_ += rtt;
+    ack(packet);
+  }
+
+  void reachProbeBwCruise() {
+    for (int i = 0; i < 10 &&
+         bbr_->state() != Bbr2CongestionController::State::ProbeBwCruise;
+         i++) {
+      sendAndAckRound();
+    }
+    ASSERT_EQ(Bbr2CongestionController::State::ProbeBwCruise, bbr_->state());
+  }
+
+  void reachProbeBwRefill() {
+    reachProbeBwCruise();
+    now_ += kBbr2ProbeBwMinWait + kBbr2ProbeBwRandWait;
+    sendAndAckRound();
+    ASSERT_EQ(Bbr2CongestionController::State::ProbeBwRefill, bbr_->state());
+  }
+
+ protected:
+  static constexpr uint64_t kPacketSize = 1000;
+  static constexpr std::chrono::microseconds kMinRtt = 10ms;
+
+  QuicConnectionStateBase conn_{QuicNodeType::Server};
+  std::unique_ptr<Bbr2CongestionController> bbr_;
+  MockMinRttSampler* rttSampler_;
+  MockBandwidthSampler* bandwidthSampler_;
+  TimePoint now_;
+  PacketNum nextPacketNum_{0};
+  uint64_t totalBytesSent_{0};
+};
+
+constexpr uint64_t Bbr2ModelTest::kPacketSize;
+constexpr std::chrono::microseconds Bbr2ModelTest::kMinRtt;
+
+TEST_F(Bbr2ModelTest, ProbeBwPhases) {
+  // Startup ends once the bandwidth stops growing, and the queue is already
+  // drained then.
+  for (int i = 0; i < kStartupSlowGrowRoundLimit + 1; i++) {
+    EXPECT_EQ(Bbr2CongestionController::State::Startup, bbr_->state());
+    sendAndAckRound();
+  }
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwDown, bbr_->state());
+  sendAndAckRound();
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwCruise, bbr_->state());
+
+  // Cruise until it is time to probe again, then refill the pipe for a round
+  // trip before probing.
+  sendAndAckRound();
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwCruise, bbr_->state());
+  now_ += kBbr2ProbeBwMinWait + kBbr2ProbeBwRandWait;
+  sendAndAckRound();
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwRefill, bbr_->state());
+  sendAndAckRound();
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwUp, bbr_->state());
+
+  // Too much loss ends the probe and bounds inflight to what was in flight
+  // when it happened.
+  EXPECT_FALSE(bbr_->inflightHi().has_value());
+  auto packets = sendPackets(20);
+  now_ += kMinRtt;
+  lose({packets[0], packets[1]});
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwDown, bbr_->state());
+  ASSERT_TRUE(bbr_->inflightHi().has_value());
+  EXPECT_EQ(20 * kPacketSize, *bbr_->inflightHi());
+  CongestionControllerStats stats;
+  bbr_->getStats(stats);
+  EXPECT_EQ(
+      static_cast<uint8_t>(Bbr2CongestionController::State::ProbeBwDown),
+      stats.bbr2Stats.state);
+  EXPECT_EQ(20 * kPacketSize, stats.bbr2Stats.inflightHi);
+}
+
+TEST_F(Bbr2ModelTest, LossInRefillSetsInflightHi) {
+  reachProbeBwRefill();
+  auto packets = sendPackets(20);
+  now_ += kMinRtt;
+  lose({packets[0], packets[1]});
+  // Refill still ends after its round trip.
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwRefill, bbr_->state());
+  ASSERT_TRUE(bbr_->inflightHi().has_value());
+  EXPECT_EQ(20 * kPacketSize, *bbr_->inflightHi());
+  ack(packets[2]);
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwUp, bbr_->state());
+  EXPECT_LE(bbr_->getCongestionWindow(), *bbr_->inflightHi());
+}
+
+TEST_F(Bbr2ModelTest, InflightLo) {
+  reachProbeBwCruise();
+  // Every round trip with loss outside of probing lowers inflight_lo.
+  auto packets = sendPackets(10);
+  now_ += kMinRtt;
+  lose({packets[0]});
+  ack(packets[1]);
+  ASSERT_TRUE(bbr_->inflightLo().has_value());
+  auto inflightLo = *bbr_->inflightLo();
+  EXPECT_LE(bbr_->getCongestionWindow(), inflightLo);
+
+  packets = sendPackets(10);
+  now_ += kMinRtt;
+  lose({packets[0]});
+  ack(packets[1]);
+  ASSERT_TRUE(bbr_->inflightLo().has_value());
+  EXPECT_LT(*bbr_->inflightLo(), inflightLo);
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwCruise, bbr_->state());
+  // A single loss isn't enough to bound inflight from above.
+  EXPECT_FALSE(bbr_->inflightHi().has_value());
+
+  // Probing starts from scratch.
+  now_ += kBbr2ProbeBwMinWait + kBbr2ProbeBwRandWait;
+  sendAndAckRound();
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwRefill, bbr_->state());
+  EXPECT_FALSE(bbr_->inflightLo().has_value());
+}
+
+TEST_F(Bbr2ModelTest, ProbeRtt) {
+  reachProbeBwCruise();
+  auto cwnd = bbr_->getCongestionWindow();
+  EXPECT_CALL(*rttSampler_, minRttExpired()).WillRepeatedly(Return(true));
+  sendAndAckRound();
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeRtt, bbr_->state());
+  EXPECT_LT(bbr_->getCongestionWindow(), cwnd);
+
+  // Stays for kProbeRttDuration and a round trip, then goes back to
+  // cruising.
+  EXPECT_CALL(*rttSampler_, minRttExpired()).WillRepeatedly(Return(false));
+  sendAndAckRound();
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeRtt, bbr_->state());
+  EXPECT_CALL(*rttSampler_, timestampMinRtt(_)).Times(1);
+  sendAndAckRound(kProbeRttDuration);
+  EXPECT_EQ(Bbr2CongestionController::State::ProbeBwCruise, bbr_->state());
+}
+
+} // namespace test
+} // namespace quic
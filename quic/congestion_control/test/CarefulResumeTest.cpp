@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/CarefulResume.h>
+
+#include <folly/portability/GTest.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/congestion_control/NewReno.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kMss = 1000;
+// 10 MB/s over 40ms, the jump window is half of that 400KB bdp.
+constexpr uint64_t kSavedBandwidth = 10 * 1000 * 1000;
+constexpr std::chrono::microseconds kSavedMinRtt = 40ms;
+constexpr uint64_t kJumpCwnd = 200 * 1000;
+
+} // namespace
+
+class CarefulResumeTest : public Test {
+ public:
+  void SetUp() override {
+    conn_.udpSendPacketLen = kMss;
+    conn_.transportSettings.carefulResume.enabled = true;
+  }
+
+  std::unique_ptr<CarefulResume> makeCarefulResume(
+      uint64_t savedBandwidth = kSavedBandwidth) {
+    auto newReno = std::make_unique<NewReno>(conn_);
+    newReno_ = newReno.get();
+    return std::make_unique<CarefulResume>(
+        conn_, std::move(newReno), savedBandwidth, kSavedMinRtt);
+  }
+
+  OutstandingPacket send(CarefulResume& cc, PacketNum packetNum) {
+    auto packet = makeTestingWritePacket(
+        packetNum, kMss, kMss * packetNum, start_ + packetNum * 1ms);
+    cc.onPacketSent(packet);
+    return packet;
+  }
+
+  void ack(CarefulResume& cc, const OutstandingPacket& packet) {
+    cc.onPacketAckOrLoss(
+        makeAck(
+            packet.packet.header.getPacketSequenceNum(),
+            kMss,
+            packet.metadata.time + kSavedMinRtt,
+            packet.metadata.time),
+        folly::none);
+  }
+
+  void lose(CarefulResume& cc, const OutstandingPacket& packet) {
+    CongestionController::LossEvent loss(packet.metadata.time + kSavedMinRtt);
+    loss.addLostPacket(packet);
+    cc.onPacketAckOrLoss(folly::none, loss);
+  }
+
+ protected:
+  QuicConnectionStateBase conn_{QuicNodeType::Server};
+  TimePoint start_{Clock::now()};
+  NewReno* newReno_{nullptr};
+};
+
+TEST_F(CarefulResumeTest, JumpsAfterRttSample) {
+  auto cc = makeCarefulResume();
+  auto initCwnd = conn_.transportSettings.initCwndInMss * kMss;
+  EXPECT_EQ(CarefulResume::Phase::Reconnaissance, cc->phase());
+  EXPECT_EQ(initCwnd, cc->getCongestionWindow());
+  EXPECT_EQ(kJumpCwnd, cc->jumpCwnd());
+
+  auto packet = send(*cc, 1);
+  conn_.lossState.srtt = 50ms;
+  ack(*cc, packet);
+  EXPECT_EQ(CarefulResume::Phase::Unvalidated, cc->phase());
+  EXPECT_EQ(kJumpCwnd, cc->getCongestionWindow());
+  EXPECT_EQ(kJumpCwnd, cc->getWritableBytes());
+  EXPECT_EQ(CongestionControlType::NewReno, cc->type());
+}
+
+TEST_F(CarefulResumeTest, NoJumpWhenRttChanged) {
+  conn_.lossState.srtt = kSavedMinRtt / 3;
+  auto cc = makeCarefulResume();
+  EXPECT_EQ(CarefulResume::Phase::Normal, cc->phase());
+  EXPECT_EQ(
+      conn_.transportSettings.initCwndInMss * kMss, cc->getCongestionWindow());
+
+  conn_.lossState.srtt = kSavedMinRtt * 11;
+  cc = makeCarefulResume();
+  EXPECT_EQ(CarefulResume::Phase::Normal, cc->phase());
+}
+
+TEST_F(CarefulResumeTest, NoJumpBelowInitialWindow) {
+  conn_.lossState.srtt = kSavedMinRtt;
+  auto cc = makeCarefulResume(1000);
+  EXPECT_EQ(CarefulResume::Phase::Normal, cc->phase());
+  EXPECT_EQ(
+      conn_.transportSettings.initCwndInMss * kMss, cc->getCongestionWindow());
+}
+
+TEST_F(CarefulResumeTest, JumpCapped) {
+  conn_.transportSettings.carefulResume.maxJumpCwndInMss = 50;
+  auto cc = makeCarefulResume();
+  EXPECT_EQ(50 * kMss, cc->jumpCwnd());
+}
+
+TEST_F(CarefulResumeTest, Validates) {
+  conn_.lossState.srtt = kSavedMinRtt;
+  auto cc = makeCarefulResume();
+  ASSERT_EQ(CarefulResume::Phase::Unvalidated, cc->phase());
+  std::vector<OutstandingPacket> packets;
+  for (PacketNum packetNum = 1; packetNum <= 100; packetNum++) {
+    packets.push_back(send(*cc, packetNum));
+  }
+
+  ack(*cc, packets[0]);
+  EXPECT_EQ(CarefulResume::Phase::Validating, cc->phase());
+  // What was in flight when the first jump packet got acked.
+  EXPECT_EQ(100 * kMss, cc->getCongestionWindow());
+
+  for (size_t i = 1; i < packets.size(); i++) {
+    ack(*cc, packets[i]);
+  }
+  EXPECT_EQ(CarefulResume::Phase::Normal, cc->phase());
+  EXPECT_EQ(
+      std::max<uint64_t>(100 * kMss, newReno_->getCongestionWindow()),
+      cc->getCongestionWindow());
+
+  // The first loss hands the window back to the wrapped controller.
+  lose(*cc, send(*cc, 101));
+  EXPECT_LT(cc->getCongestionWindow(), 100 * kMss);
+  EXPECT_EQ(newReno_->getCongestionWindow(), cc->getCongestionWindow());
+}
+
+TEST_F(CarefulResumeTest, SafeRetreat) {
+  conn_.lossState.srtt = kSavedMinRtt;
+  auto cc = makeCarefulResume();
+  std::vector<OutstandingPacket> packets;
+  for (PacketNum packetNum = 1; packetNum <= 100; packetNum++) {
+    packets.push_back(send(*cc, packetNum));
+  }
+  for (size_t i = 0; i < 60; i++) {
+    ack(*cc, packets[i]);
+  }
+  lose(*cc, packets[60]);
+  EXPECT_EQ(CarefulResume::Phase::SafeRetreat, cc->phase());
+  // At least half of what got delivered since the jump.
+  auto retreatCwnd =
+      std::max<uint64_t>(30 * kMss, newReno_->getCongestionWindow());
+  EXPECT_EQ(retreatCwnd, cc->getCongestionWindow());
+
+  // Packets sent before the retreat don't lower it further.
+  lose(*cc, packets[61]);
+  EXPECT_EQ(retreatCwnd, cc->getCongestionWindow());
+
+  auto packet = makeTestingWritePacket(
+      200, kMss, 200 * kMss, packets.back().metadata.time + 2 * kSavedMinRtt);
+  cc->onPacketSent(packet);
+  lose(*cc, packet);
+  EXPECT_LT(cc->getCongestionWindow(), retreatCwnd);
+  EXPECT_EQ(newReno_->getCongestionWindow(), cc->getCongestionWindow());
+}
+
+} // namespace test
+} // namespace quic
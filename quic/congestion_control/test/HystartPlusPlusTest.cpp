@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/HystartPlusPlus.h>
+
+#include <folly/portability/GTest.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/congestion_control/NewReno.h>
+#include <quic/congestion_control/QuicCubic.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+constexpr uint64_t kMss = 1000;
+constexpr size_t kFlightSize = 10;
+} // namespace
+
+class HystartPlusPlusTest : public Test {
+ public:
+  void SetUp() override {
+    conn_.udpSendPacketLen = kMss;
+    conn_.transportSettings.hystartPlusPlus = true;
+  }
+
+  // A flight of packets 1us apart, sent once the previous one is acked.
+  std::vector<OutstandingPacket> makeFlight(std::chrono::microseconds rtt) {
+    std::vector<OutstandingPacket> flight;
+    for (size_t i = 0; i < kFlightSize; i++) {
+      flight.push_back(makeTestingWritePacket(
+          nextPacketNum_, kMss, kMss * (nextPacketNum_ + 1), sentTime_));
+      nextPacketNum_++;
+      sentTime_ += 1us;
+    }
+    sentTime_ += rtt;
+    return flight;
+  }
+
+  CongestionController::AckEvent ackPacket(
+      const OutstandingPacket& packet,
+      std::chrono::microseconds rtt) {
+    conn_.lossState.lrtt = rtt;
+    conn_.lossState.srtt = rtt;
+    return makeAck(
+        packet.packet.header.getPacketSequenceNum(),
+        packet.metadata.encodedSize,
+        packet.metadata.time + rtt,
+        packet.metadata.time);
+  }
+
+  // Returns the cwnd increase over the round, stops once slow start is over.
+  uint64_t runRound(HystartPlusPlus& hystart, std::chrono::microseconds rtt) {
+    auto flight = makeFlight(rtt);
+    for (const auto& packet : flight) {
+      hystart.onPacketSent(packet);
+    }
+    uint64_t increase = 0;
+    for (const auto& packet : flight) {
+      if (!hystart.inSlowStart()) {
+        break;
+      }
+      increase += hystart.onAck(ackPacket(packet, rtt), kMss);
+    }
+    return increase;
+  }
+
+  void runRound(
+      CongestionController& congestionController,
+      std::chrono::microseconds rtt) {
+    auto flight = makeFlight(rtt);
+    for (const auto& packet : flight) {
+      congestionController.onPacketSent(packet);
+    }
+    for (const auto& packet : flight) {
+      congestionController.onPacketAckOrLoss(
+          ackPacket(packet, rtt), folly::none);
+    }
+  }
+
+ protected:
+  QuicConnectionStateBase conn_{QuicNodeType::Server};
+  PacketNum nextPacketNum_{0};
+  TimePoint sentTime_{Clock::now()};
+};
+
+TEST_F(HystartPlusPlusTest, StableRtt) {
+  HystartPlusPlus hystart(conn_);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(kFlightSize * kMss, runRound(hystart, 40ms));
+  }
+  EXPECT_EQ(HystartPlusPlus::Phase::SlowStart, hystart.phase());
+}
+
+TEST_F(HystartPlusPlusTest, JitterBelowThreshold) {
+  HystartPlusPlus hystart(conn_);
+  // The threshold is 40ms / 8.
+  for (int i = 0; i < 10; i++) {
+    runRound(hystart, i % 2 ? 44ms : 40ms);
+  }
+  EXPECT_EQ(HystartPlusPlus::Phase::SlowStart, hystart.phase());
+}
+
+TEST_F(HystartPlusPlusTest, ConservativeSlowStart) {
+  HystartPlusPlus hystart(conn_);
+  runRound(hystart, 40ms);
+  runRound(hystart, 40ms);
+  runRound(hystart, 50ms);
+  EXPECT_EQ(HystartPlusPlus::Phase::ConservativeSlowStart, hystart.phase());
+  for (size_t i = 0; i < kHystartPlusPlusCssRounds - 1; i++) {
+    EXPECT_EQ(
+        kFlightSize * kMss / kHystartPlusPlusCssGrowthDivisor,
+        runRound(hystart, 50ms));
+    EXPECT_EQ(HystartPlusPlus::Phase::ConservativeSlowStart, hystart.phase());
+  }
+  // The first ack of the next flight ends the last round.
+  EXPECT_EQ(kMss / kHystartPlusPlusCssGrowthDivisor, runRound(hystart, 50ms));
+  EXPECT_EQ(HystartPlusPlus::Phase::CongestionAvoidance, hystart.phase());
+  EXPECT_FALSE(hystart.inSlowStart());
+}
+
+TEST_F(HystartPlusPlusTest, SpuriousRttIncrease) {
+  HystartPlusPlus hystart(conn_);
+  runRound(hystart, 40ms);
+  runRound(hystart, 40ms);
+  runRound(hystart, 50ms);
+  ASSERT_EQ(HystartPlusPlus::Phase::ConservativeSlowStart, hystart.phase());
+  runRound(hystart, 40ms);
+  EXPECT_EQ(HystartPlusPlus::Phase::SlowStart, hystart.phase());
+  EXPECT_EQ(kFlightSize * kMss, runRound(hystart, 40ms));
+}
+
+TEST_F(HystartPlusPlusTest, MaxIncreaseWithoutPacing) {
+  HystartPlusPlus hystart(conn_);
+  auto flight = makeFlight(40ms);
+  hystart.onPacketSent(flight.back());
+  EXPECT_EQ(
+      kHystartPlusPlusUnpacedLimitInMss * kMss,
+      hystart.onAck(ackPacket(flight.back(), 40ms), 20 * kMss));
+}
+
+TEST_F(HystartPlusPlusTest, Reset) {
+  HystartPlusPlus hystart(conn_);
+  runRound(hystart, 40ms);
+  runRound(hystart, 40ms);
+  runRound(hystart, 50ms);
+  ASSERT_EQ(HystartPlusPlus::Phase::ConservativeSlowStart, hystart.phase());
+  hystart.reset();
+  EXPECT_EQ(HystartPlusPlus::Phase::SlowStart, hystart.phase());
+  // Without the last round's rtt there is nothing to compare to.
+  runRound(hystart, 80ms);
+  EXPECT_EQ(HystartPlusPlus::Phase::SlowStart, hystart.phase());
+}
+
+TEST_F(HystartPlusPlusTest, CubicIgnoresJitter) {
+  Cubic hystartPlusPlusCubic(conn_);
+  conn_.transportSettings.hystartPlusPlus = false;
+  Cubic hystartCubic(conn_);
+  for (int i = 0; i < 6; i++) {
+    runRound(hystartPlusPlusCubic, i % 2 ? 44ms : 40ms);
+  }
+  for (int i = 0; i < 6; i++) {
+    runRound(hystartCubic, i % 2 ? 44ms : 40ms);
+  }
+  EXPECT_EQ(CubicStates::Hystart, hystartPlusPlusCubic.state());
+  EXPECT_EQ(CubicStates::Steady, hystartCubic.state());
+}
+
+TEST_F(HystartPlusPlusTest, CubicExitsSlowStart) {
+  Cubic cubic(conn_);
+  runRound(cubic, 40ms);
+  runRound(cubic, 40ms);
+  runRound(cubic, 50ms);
+  EXPECT_EQ(CubicStates::Hystart, cubic.state());
+  for (size_t i = 0; i < kHystartPlusPlusCssRounds; i++) {
+    runRound(cubic, 50ms);
+  }
+  EXPECT_EQ(CubicStates::Steady, cubic.state());
+  CongestionControllerStats stats;
+  cubic.getStats(stats);
+  EXPECT_LE(stats.cubicStats.ssthresh, cubic.getCongestionWindow());
+}
+
+TEST_F(HystartPlusPlusTest, NewRenoExitsSlowStart) {
+  NewReno newReno(conn_);
+  runRound(newReno, 40ms);
+  runRound(newReno, 40ms);
+  runRound(newReno, 50ms);
+  EXPECT_TRUE(newReno.inSlowStart());
+  auto cssStartCwnd = newReno.getCongestionWindow();
+  for (size_t i = 0; i < kHystartPlusPlusCssRounds; i++) {
+    runRound(newReno, 50ms);
+  }
+  EXPECT_FALSE(newReno.inSlowStart());
+  // Each round grows cwnd by a quarter of a flight, and a tiny bit once in
+  // congestion avoidance.
+  EXPECT_LT(
+      newReno.getCongestionWindow(),
+      cssStartCwnd + kHystartPlusPlusCssRounds * kFlightSize * kMss / 2);
+}
+
+TEST_F(HystartPlusPlusTest, NewRenoRestartsAfterPersistentCongestion) {
+  NewReno newReno(conn_);
+  runRound(newReno, 40ms);
+  runRound(newReno, 40ms);
+  for (size_t i = 0; i < kHystartPlusPlusCssRounds + 1; i++) {
+    runRound(newReno, 50ms);
+  }
+  ASSERT_FALSE(newReno.inSlowStart());
+
+  auto flight = makeFlight(50ms);
+  for (const auto& packet : flight) {
+    newReno.onPacketSent(packet);
+  }
+  CongestionController::LossEvent loss(flight.back().metadata.time + 1s);
+  for (const auto& packet : flight) {
+    loss.addLostPacket(packet);
+  }
+  loss.persistentCongestion = true;
+  newReno.onPacketAckOrLoss(folly::none, loss);
+  EXPECT_EQ(
+      conn_.transportSettings.minCwndInMss * kMss,
+      newReno.getCongestionWindow());
+  EXPECT_TRUE(newReno.inSlowStart());
+  auto cwnd = newReno.getCongestionWindow();
+  sentTime_ = loss.lossTime + 1us;
+  runRound(newReno, 50ms);
+  EXPECT_EQ(cwnd + kFlightSize * kMss, newReno.getCongestionWindow());
+}
+
+} // namespace test
+} // namespace quic
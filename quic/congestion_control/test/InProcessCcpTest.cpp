@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/InProcessCcp.h>
+
+#include <folly/portability/GTest.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/congestion_control/QuicCCP.h>
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+
+#include <thread>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kMss = 1000;
+
+// Grows the cwnd by what got acked during the interval, like slow start.
+class TestAlgorithm : public InProcessCcpAlgorithm {
+ public:
+  explicit TestAlgorithm(uint64_t initCwndBytes) : cwndBytes_(initCwndBytes) {}
+
+  CcpControlUpdate onReport(const CcpMeasurement& report) override {
+    cwndBytes_ += report.bytesAcked;
+    CcpControlUpdate update;
+    update.cwndBytes = cwndBytes_;
+    return update;
+  }
+
+ private:
+  uint64_t cwndBytes_;
+};
+
+} // namespace
+
+class InProcessCcpTest : public Test {
+ public:
+  void SetUp() override {
+    conn_ = std::make_unique<QuicServerConnectionState>(
+        FizzServerQuicHandshakeContext::Builder().build());
+    conn_->udpSendPacketLen = kMss;
+    conn_->lossState.srtt = 10ms;
+    agent_ = std::make_unique<InProcessCcpAgent>(
+        [](const CcpMeasurement& start) {
+          return std::make_unique<TestAlgorithm>(start.initCwndBytes);
+        },
+        16);
+    datapath_ = agent_->addDatapath(&evb_);
+    conn_->inProcessCcpDatapath = datapath_.get();
+  }
+
+  void TearDown() override {
+    agent_->removeDatapath(datapath_);
+    agent_->stop();
+  }
+
+  // Sends a packet and acks it right away.
+  void sendAndAck(CCP& ccp, PacketNum packetNum) {
+    auto packet = makeTestingWritePacket(packetNum, kMss, kMss * packetNum);
+    ccp.onPacketSent(packet);
+    ccp.onPacketAckOrLoss(
+        makeAck(packetNum, kMss, Clock::now(), packet.metadata.time),
+        folly::none);
+  }
+
+ protected:
+  folly::EventBase evb_;
+  std::unique_ptr<QuicServerConnectionState> conn_;
+  std::unique_ptr<InProcessCcpAgent> agent_;
+  std::shared_ptr<InProcessCcpDatapath> datapath_;
+};
+
+TEST_F(InProcessCcpTest, RegistersConnection) {
+  {
+    CCP ccp(*conn_);
+    EXPECT_EQ(1, datapath_->numConnections());
+    CcpMeasurement measurement;
+    ASSERT_TRUE(datapath_->readMeasurement(measurement));
+    EXPECT_EQ(CcpMeasurement::Type::Start, measurement.type);
+    EXPECT_EQ(kMss, measurement.mss);
+    EXPECT_EQ(ccp.getCongestionWindow(), measurement.initCwndBytes);
+  }
+  EXPECT_EQ(0, datapath_->numConnections());
+  CcpMeasurement measurement;
+  ASSERT_TRUE(datapath_->readMeasurement(measurement));
+  EXPECT_EQ(CcpMeasurement::Type::End, measurement.type);
+}
+
+TEST_F(InProcessCcpTest, ReportsOncePerInterval) {
+  conn_->transportSettings.ccpConfig.reportInterval = 1h;
+  CCP ccp(*conn_);
+  CcpMeasurement measurement;
+  ASSERT_TRUE(datapath_->readMeasurement(measurement));
+  for (PacketNum packetNum = 1; packetNum <= 10; packetNum++) {
+    sendAndAck(ccp, packetNum);
+  }
+  // Nothing until the interval is over.
+  EXPECT_FALSE(datapath_->hasMeasurements());
+}
+
+TEST_F(InProcessCcpTest, BatchesAcksIntoOneReport) {
+  // Only the answer to the report can allow the next one here.
+  conn_->transportSettings.ccpConfig.fallbackTimeout = 1h;
+  CCP ccp(*conn_);
+  CcpMeasurement measurement;
+  ASSERT_TRUE(datapath_->readMeasurement(measurement));
+  std::this_thread::sleep_for(conn_->lossState.srtt);
+  sendAndAck(ccp, 1);
+  ASSERT_TRUE(datapath_->readMeasurement(measurement));
+  EXPECT_EQ(CcpMeasurement::Type::Report, measurement.type);
+  EXPECT_EQ(kMss, measurement.bytesAcked);
+  EXPECT_EQ(1, measurement.packetsAcked);
+  EXPECT_GE(measurement.interval, conn_->lossState.srtt);
+
+  // No more reports until this one is answered, acks keep being counted.
+  std::this_thread::sleep_for(conn_->lossState.srtt);
+  for (PacketNum packetNum = 2; packetNum <= 5; packetNum++) {
+    sendAndAck(ccp, packetNum);
+  }
+  EXPECT_FALSE(datapath_->hasMeasurements());
+  CcpControlUpdate update;
+  update.connId = measurement.connId;
+  ccp.onControlUpdate(update);
+  sendAndAck(ccp, 6);
+  ASSERT_TRUE(datapath_->readMeasurement(measurement));
+  EXPECT_EQ(5 * kMss, measurement.bytesAcked);
+  EXPECT_EQ(5, measurement.packetsAcked);
+}
+
+TEST_F(InProcessCcpTest, AgentUpdatesCwnd) {
+  conn_->transportSettings.ccpConfig.reportInterval = 1us;
+  agent_->start();
+  CCP ccp(*conn_);
+  auto initCwnd = ccp.getCongestionWindow();
+  std::this_thread::sleep_for(1ms);
+  sendAndAck(ccp, 1);
+  auto deadline = Clock::now() + 5s;
+  while (ccp.getCongestionWindow() == initCwnd && Clock::now() < deadline) {
+    evb_.loopOnce(EVLOOP_NONBLOCK);
+  }
+  EXPECT_EQ(initCwnd + kMss, ccp.getCongestionWindow());
+}
+
+TEST_F(InProcessCcpTest, FallbackWhenAgentDoesNotAnswer) {
+  conn_->transportSettings.ccpConfig.reportInterval = 1us;
+  conn_->transportSettings.ccpConfig.fallbackTimeout = 1ms;
+  CCP ccp(*conn_);
+  std::this_thread::sleep_for(1ms);
+  sendAndAck(ccp, 1);
+  CcpMeasurement measurement;
+  while (datapath_->readMeasurement(measurement)) {
+  }
+  std::this_thread::sleep_for(
+      conn_->transportSettings.ccpConfig.fallbackTimeout);
+  sendAndAck(ccp, 2);
+  // Falls back to cubic, and keeps reporting in case the agent comes back.
+  EXPECT_TRUE(datapath_->hasMeasurements());
+  auto fallbackCwnd = ccp.getCongestionWindow();
+
+  CcpControlUpdate update;
+  update.connId = measurement.connId;
+  update.cwndBytes = 3 * kMss;
+  ccp.onControlUpdate(update);
+  EXPECT_EQ(3 * kMss, ccp.getCongestionWindow());
+  EXPECT_NE(fallbackCwnd, ccp.getCongestionWindow());
+}
+
+TEST_F(InProcessCcpTest, NoUpdatesAfterDetach) {
+  CCP ccp(*conn_);
+  CcpMeasurement measurement;
+  ASSERT_TRUE(datapath_->readMeasurement(measurement));
+  auto cwnd = ccp.getCongestionWindow();
+  datapath_->detach();
+  // Written to the ring, but the worker isn't woken up to apply it.
+  CcpControlUpdate update;
+  update.connId = measurement.connId;
+  update.cwndBytes = cwnd + kMss;
+  EXPECT_TRUE(datapath_->sendUpdate(update));
+  evb_.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(cwnd, ccp.getCongestionWindow());
+}
+
+TEST(InProcessCcpDatapathTest, RingFull) {
+  InProcessCcpAgent agent(
+      [](const CcpMeasurement&) { return std::unique_ptr<TestAlgorithm>(); },
+      4);
+  folly::EventBase evb;
+  auto datapath = agent.addDatapath(&evb);
+  CcpMeasurement measurement;
+  // A ring of 4 holds 3 entries.
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(datapath->sendMeasurement(measurement));
+  }
+  EXPECT_FALSE(datapath->sendMeasurement(measurement));
+  EXPECT_TRUE(datapath->readMeasurement(measurement));
+  EXPECT_TRUE(datapath->sendMeasurement(measurement));
+  agent.removeDatapath(datapath);
+}
+
+} // namespace test
+} // namespace quic
@@ -35,9 +35,9 @@ TEST_F(TokenlessPacerTest, RateCalculator) {
     return PacingRate::Builder().setInterval(1234us).setBurstSize(4321).build();
   });
   pacer.refreshPacingRate(200000, 200us);
-  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite());
+  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite(Clock::now()));
   EXPECT_EQ(4321, pacer.updateAndGetWriteBatchSize(Clock::now()));
-  EXPECT_NEAR(1234, pacer.getTimeUntilNextWrite().count(), 100);
+  EXPECT_NEAR(1234, pacer.getTimeUntilNextWrite(Clock::now()).count(), 100);
 }
 
 TEST_F(TokenlessPacerTest, NoCompensateTimerDrift) {
@@ -54,7 +54,7 @@ TEST_F(TokenlessPacerTest, NoCompensateTimerDrift) {
 }
 
 TEST_F(TokenlessPacerTest, NextWriteTime) {
-  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite());
+  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite(Clock::now()));
 
   pacer.setPacingRateCalculator([](const QuicConnectionStateBase&,
                                    uint64_t,
@@ -65,11 +65,11 @@ TEST_F(TokenlessPacerTest, NextWriteTime) {
   pacer.refreshPacingRate(20, 1000us);
   // Right after refresh, it's always 0us. You can always send right after an
   // ack.
-  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite());
+  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite(Clock::now()));
   EXPECT_EQ(10, pacer.updateAndGetWriteBatchSize(Clock::now()));
 
   // Then we use real delay:
-  EXPECT_NEAR(1000, pacer.getTimeUntilNextWrite().count(), 100);
+  EXPECT_NEAR(1000, pacer.getTimeUntilNextWrite(Clock::now()).count(), 100);
 }
 
 TEST_F(TokenlessPacerTest, RttFactor) {
@@ -100,7 +100,7 @@ TEST_F(TokenlessPacerTest, ImpossibleToPace) {
         .build();
   });
   pacer.refreshPacingRate(200 * conn.udpSendPacketLen, 100us);
-  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite());
+  EXPECT_EQ(0us, pacer.getTimeUntilNextWrite(Clock::now()));
   EXPECT_EQ(
       conn.transportSettings.writeConnectionDataPacketsLimit,
       pacer.updateAndGetWriteBatchSize(Clock::now()));
@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/test/PathSimulator.h>
+
+#include <quic/common/test/TestUtils.h>
+#include <quic/congestion_control/CongestionControllerFactory.h>
+#include <quic/congestion_control/TokenlessPacer.h>
+#include <quic/loss/QuicLossFunctions.h>
+#include <quic/state/QuicStateFunctions.h>
+
+namespace quic {
+namespace test {
+
+struct PathSimulator::Flow {
+  explicit Flow(SimulatedFlow configIn)
+      : config(std::move(configIn)),
+        remainingBytes(config.bytesToSend.value_or(0)) {}
+
+  SimulatedFlow config;
+  QuicConnectionStateBase conn{QuicNodeType::Client};
+  // Packets neither acked nor declared lost yet, in send order.
+  std::deque<OutstandingPacket> outstandings;
+  PacketNum nextPacketNum{0};
+  folly::Optional<PacketNum> largestAcked;
+  // Bytes left to send when the flow has a limited amount of data, lost
+  // bytes are added back.
+  uint64_t remainingBytes;
+  bool started{false};
+
+  // Only the latest event scheduled for each of these is acted on.
+  folly::Optional<TimePoint> pendingWrite;
+  folly::Optional<TimePoint> pendingLossTimer;
+  folly::Optional<TimePoint> pendingPto;
+
+  uint64_t ackedBytesInInterval{0};
+  FlowStats stats;
+};
+
+PathSimulator::PathSimulator(
+    SimulatedLink link,
+    std::vector<SimulatedFlow> flows,
+    uint64_t seed,
+    std::chrono::microseconds sampleInterval)
+    : link_(std::move(link)),
+      sampleInterval_(sampleInterval),
+      rng_(seed),
+      start_(Clock::now()),
+      now_(start_),
+      linkFreeTime_(start_) {
+  CHECK_GT(link_.bytesPerSecond, 0);
+  CHECK_GT(sampleInterval_.count(), 0);
+  DefaultCongestionControllerFactory factory;
+  for (auto& config : flows) {
+    auto flow = std::make_unique<Flow>(std::move(config));
+    auto& conn = flow->conn;
+    auto ccType = flow->config.congestionControlType;
+    conn.transportSettings = flow->config.transportSettings;
+    conn.transportSettings.defaultCongestionController = ccType;
+    // Same setup as the transport: the pacer has to exist by the time the
+    // congestion controller is made.
+    if (flow->config.pacingEnabled) {
+      conn.transportSettings.pacingEnabled = true;
+      conn.canBePaced = true;
+      bool usingBbr = ccType == CongestionControlType::BBR ||
+          ccType == CongestionControlType::BBR2;
+      auto minCwnd = usingBbr ? kMinCwndInMssForBbr
+                              : conn.transportSettings.minCwndInMss;
+      conn.pacer = std::make_unique<TokenlessPacer>(conn, minCwnd);
+    }
+    conn.congestionController =
+        factory.makeCongestionController(conn, ccType);
+    auto startTime = start_ + flow->config.startTime;
+    flows_.push_back(std::move(flow));
+    scheduleWrite(flows_.size() - 1, startTime);
+  }
+  schedule(start_ + sampleInterval_, EventType::Sample);
+}
+
+PathSimulator::~PathSimulator() = default;
+
+void PathSimulator::run(std::chrono::microseconds duration) {
+  auto end = now_ + duration;
+  while (!events_.empty() && events_.top().time <= end) {
+    auto event = events_.top();
+    events_.pop();
+    now_ = event.time;
+    switch (event.type) {
+      case EventType::Write:
+        onWrite(event.flow);
+        break;
+      case EventType::Ack:
+        onAck(event.flow, event.packetNum);
+        break;
+      case EventType::LossTimer:
+        onLossTimer(event.flow);
+        break;
+      case EventType::Pto:
+        onPto(event.flow);
+        break;
+      case EventType::Sample:
+        onSample();
+        break;
+    }
+  }
+  now_ = end;
+}
+
+TimePoint PathSimulator::now() const noexcept {
+  return now_;
+}
+
+std::chrono::microseconds PathSimulator::elapsed() const noexcept {
+  return std::chrono::duration_cast<std::chrono::microseconds>(now_ - start_);
+}
+
+size_t PathSimulator::numFlows() const noexcept {
+  return flows_.size();
+}
+
+const FlowStats& PathSimulator::flowStats(size_t flow) const {
+  return flows_.at(flow)->stats;
+}
+
+const QuicConnectionStateBase& PathSimulator::conn(size_t flow) const {
+  return flows_.at(flow)->conn;
+}
+
+const std::vector<FlowSample>& PathSimulator::samples() const noexcept {
+  return samples_;
+}
+
+void PathSimulator::writeSamplesCsv(std::ostream& os) const {
+  os << "time_us,flow,cwnd,inflight,goodput,srtt_us,queueing_delay_us\n";
+  for (const auto& sample : samples_) {
+    os << sample.time.count() << "," << sample.flow << ","
+       << sample.congestionWindow << "," << sample.inflightBytes << ","
+       << sample.goodput << "," << sample.srtt.count() << ","
+       << sample.queueingDelay.count() << "\n";
+  }
+}
+
+double PathSimulator::fairnessIndex() const {
+  double sum = 0;
+  double sumOfSquares = 0;
+  for (const auto& flow : flows_) {
+    double acked = flow->stats.ackedBytes;
+    sum += acked;
+    sumOfSquares += acked * acked;
+  }
+  if (sumOfSquares == 0) {
+    return 1;
+  }
+  return sum * sum / (flows_.size() * sumOfSquares);
+}
+
+void PathSimulator::schedule(
+    TimePoint time,
+    EventType type,
+    size_t flow,
+    PacketNum packetNum) {
+  events_.push(Event{time, nextEventSeq_++, type, flow, packetNum});
+}
+
+bool PathSimulator::hasDataToSend(const Flow& flow) const {
+  if (!flow.config.bytesToSend) {
+    return true;
+  }
+  return !flow.stats.completionTime && flow.remainingBytes > 0;
+}
+
+void PathSimulator::scheduleWrite(size_t flowIndex, TimePoint time) {
+  auto& flow = *flows_[flowIndex];
+  if (flow.pendingWrite && *flow.pendingWrite <= time) {
+    return;
+  }
+  flow.pendingWrite = time;
+  schedule(time, EventType::Write, flowIndex);
+}
+
+void PathSimulator::onWrite(size_t flowIndex) {
+  auto& flow = *flows_[flowIndex];
+  if (flow.pendingWrite != now_) {
+    return;
+  }
+  flow.pendingWrite = folly::none;
+  flow.started = true;
+  auto& conn = flow.conn;
+  auto& cc = *conn.congestionController;
+  if (!hasDataToSend(flow)) {
+    if (!flow.outstandings.empty() && !cc.isAppLimited()) {
+      cc.setAppLimited();
+    }
+    return;
+  }
+  // Once cwnd limited, the next ack or loss schedules a write.
+  if (cc.getWritableBytes() < conn.udpSendPacketLen) {
+    return;
+  }
+  uint64_t batchSize = std::numeric_limits<uint64_t>::max();
+  if (conn.pacer) {
+    auto timeUntilNextWrite = conn.pacer->getTimeUntilNextWrite(now_);
+    if (timeUntilNextWrite > 0us) {
+      scheduleWrite(flowIndex, now_ + timeUntilNextWrite);
+      return;
+    }
+    batchSize = conn.pacer->updateAndGetWriteBatchSize(now_);
+  }
+  for (uint64_t i = 0; i < batchSize && hasDataToSend(flow) &&
+       cc.getWritableBytes() >= conn.udpSendPacketLen;
+       i++) {
+    sendPacket(flowIndex);
+  }
+  if (conn.pacer && hasDataToSend(flow) &&
+      cc.getWritableBytes() >= conn.udpSendPacketLen) {
+    scheduleWrite(flowIndex, now_ + conn.pacer->getTimeUntilNextWrite(now_));
+  }
+}
+
+void PathSimulator::sendPacket(size_t flowIndex) {
+  auto& flow = *flows_[flowIndex];
+  auto& conn = flow.conn;
+  uint64_t size = conn.udpSendPacketLen;
+  auto packetNum = flow.nextPacketNum++;
+  conn.lossState.totalBytesSent += size;
+  auto packet = makeTestingWritePacket(
+      packetNum,
+      size,
+      conn.lossState.totalBytesSent,
+      now_,
+      conn.lossState.inflightBytes + size);
+  packet.isAppLimited = conn.congestionController->isAppLimited();
+  if (conn.lossState.lastAckedTime.has_value() &&
+      conn.lossState.lastAckedPacketSentTime.has_value()) {
+    packet.lastAckedPacketInfo.emplace(
+        *conn.lossState.lastAckedPacketSentTime,
+        *conn.lossState.lastAckedTime,
+        *conn.lossState.adjustedLastAckedTime,
+        conn.lossState.totalBytesSentAtLastAck,
+        conn.lossState.totalBytesAckedAtLastAck);
+  }
+  conn.lossState.largestSent = packetNum;
+  conn.congestionController->onPacketSent(packet);
+  if (conn.pacer) {
+    conn.pacer->onPacketSent();
+  }
+  conn.lossState.lastRetransmittablePacketSentTime = now_;
+  flow.outstandings.push_back(std::move(packet));
+  flow.stats.sentBytes += size;
+  flow.remainingBytes -= std::min(size, flow.remainingBytes);
+
+  auto pto = calculatePTO(conn) *
+      (1ULL << std::min(conn.lossState.ptoCount, (uint32_t)10));
+  flow.pendingPto = now_ + pto;
+  schedule(*flow.pendingPto, EventType::Pto, flowIndex);
+
+  if (draw(link_.lossRate)) {
+    return;
+  }
+  while (!bottleneckQueue_.empty() && bottleneckQueue_.front().first <= now_) {
+    queuedBytes_ -= bottleneckQueue_.front().second;
+    bottleneckQueue_.pop_front();
+  }
+  if (queuedBytes_ + size > link_.bufferBytes) {
+    return;
+  }
+  std::chrono::nanoseconds serviceTime(
+      size * 1000 * 1000 * 1000 / link_.bytesPerSecond);
+  linkFreeTime_ = std::max(linkFreeTime_, now_) + serviceTime;
+  bottleneckQueue_.emplace_back(linkFreeTime_, size);
+  queuedBytes_ += size;
+  auto receiveTime = linkFreeTime_ + link_.oneWayDelay;
+  if (draw(link_.reorderRate)) {
+    receiveTime += link_.reorderDelay;
+  }
+  schedule(
+      receiveTime + link_.oneWayDelay + flow.config.extraDelay,
+      EventType::Ack,
+      flowIndex,
+      packetNum);
+}
+
+void PathSimulator::onAck(size_t flowIndex, PacketNum packetNum) {
+  auto& flow = *flows_[flowIndex];
+  auto& conn = flow.conn;
+  auto packetIt = std::lower_bound(
+      flow.outstandings.begin(),
+      flow.outstandings.end(),
+      packetNum,
+      [](const OutstandingPacket& packet, PacketNum num) {
+        return packet.packet.header.getPacketSequenceNum() < num;
+      });
+  if (packetIt == flow.outstandings.end() ||
+      packetIt->packet.header.getPacketSequenceNum() != packetNum) {
+    // Already declared lost.
+    return;
+  }
+  auto packet = std::move(*packetIt);
+  flow.outstandings.erase(packetIt);
+
+  auto sentTime = packet.metadata.time;
+  auto size = packet.metadata.encodedSize;
+  auto rttSample =
+      std::chrono::duration_cast<std::chrono::microseconds>(now_ - sentTime);
+  if (!flow.largestAcked || *flow.largestAcked < packetNum) {
+    flow.largestAcked = packetNum;
+    updateRtt(conn, rttSample, 0us);
+  }
+  conn.lossState.ptoCount = 0;
+
+  CongestionController::AckEvent ack;
+  ack.ackTime = now_;
+  ack.adjustedAckTime = now_;
+  ack.largestAckedPacket = packetNum;
+  ack.largestAckedPacketSentTime = sentTime;
+  ack.largestAckedPacketAppLimited = packet.isAppLimited;
+  ack.ackedBytes = size;
+  ack.mrttSample = rttSample;
+  conn.lossState.totalBytesAcked += size;
+  conn.lossState.totalBytesSentAtLastAck = conn.lossState.totalBytesSent;
+  conn.lossState.totalBytesAckedAtLastAck = conn.lossState.totalBytesAcked;
+  conn.lossState.lastAckedPacketSentTime = sentTime;
+  conn.lossState.lastAckedTime = now_;
+  conn.lossState.adjustedLastAckedTime = now_;
+  ack.ackedPackets.push_back(
+      makeAckPacketFromOutstandingPacket(std::move(packet)));
+  flow.stats.ackedBytes += size;
+  flow.ackedBytesInInterval += size;
+
+  auto loss = detectLoss(flow);
+  conn.congestionController->onPacketAckOrLoss(
+      std::move(ack), std::move(loss));
+
+  if (flow.config.bytesToSend && !flow.stats.completionTime &&
+      flow.stats.ackedBytes >= *flow.config.bytesToSend) {
+    flow.stats.completionTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            now_ - start_ - flow.config.startTime);
+  }
+  scheduleLossTimers(flowIndex);
+  scheduleWrite(flowIndex, now_);
+}
+
+folly::Optional<CongestionController::LossEvent> PathSimulator::detectLoss(
+    Flow& flow) {
+  if (!flow.largestAcked) {
+    return folly::none;
+  }
+  auto& conn = flow.conn;
+  std::chrono::microseconds delayUntilLost =
+      std::max(conn.lossState.srtt, conn.lossState.lrtt) *
+      conn.transportSettings.timeReorderingThreshDividend /
+      conn.transportSettings.timeReorderingThreshDivisor;
+  CongestionController::LossEvent loss(now_);
+  while (!flow.outstandings.empty()) {
+    const auto& packet = flow.outstandings.front();
+    auto packetNum = packet.packet.header.getPacketSequenceNum();
+    if (packetNum >= *flow.largestAcked) {
+      break;
+    }
+    bool lostByTimeout = (now_ - packet.metadata.time) > delayUntilLost;
+    bool lostByReorder =
+        (*flow.largestAcked - packetNum) > conn.lossState.reorderingThreshold;
+    if (!(lostByTimeout || lostByReorder)) {
+      break;
+    }
+    loss.addLostPacket(packet);
+    flow.outstandings.pop_front();
+  }
+  if (!loss.lostPackets) {
+    return folly::none;
+  }
+  loss.persistentCongestion = isPersistentCongestion(
+      conn, *loss.smallestLostSentTime, *loss.largestLostSentTime);
+  flow.stats.lostBytes += loss.lostBytes;
+  if (flow.config.bytesToSend) {
+    flow.remainingBytes += loss.lostBytes;
+  }
+  return loss;
+}
+
+void PathSimulator::scheduleLossTimers(size_t flowIndex) {
+  auto& flow = *flows_[flowIndex];
+  flow.pendingLossTimer = folly::none;
+  if (flow.outstandings.empty()) {
+    flow.pendingPto = folly::none;
+    return;
+  }
+  const auto& earliest = flow.outstandings.front();
+  if (!flow.largestAcked ||
+      earliest.packet.header.getPacketSequenceNum() >= *flow.largestAcked) {
+    return;
+  }
+  auto& conn = flow.conn;
+  std::chrono::microseconds delayUntilLost =
+      std::max(conn.lossState.srtt, conn.lossState.lrtt) *
+      conn.transportSettings.timeReorderingThreshDividend /
+      conn.transportSettings.timeReorderingThreshDivisor;
+  // Loss by timeout needs strictly more than delayUntilLost.
+  flow.pendingLossTimer = earliest.metadata.time + delayUntilLost + 1us;
+  schedule(*flow.pendingLossTimer, EventType::LossTimer, flowIndex);
+}
+
+void PathSimulator::onLossTimer(size_t flowIndex) {
+  auto& flow = *flows_[flowIndex];
+  if (flow.pendingLossTimer != now_) {
+    return;
+  }
+  flow.pendingLossTimer = folly::none;
+  auto loss = detectLoss(flow);
+  if (loss) {
+    flow.conn.congestionController->onPacketAckOrLoss(
+        folly::none, std::move(loss));
+  }
+  scheduleLossTimers(flowIndex);
+  scheduleWrite(flowIndex, now_);
+}
+
+void PathSimulator::onPto(size_t flowIndex) {
+  auto& flow = *flows_[flowIndex];
+  if (flow.pendingPto != now_) {
+    return;
+  }
+  flow.pendingPto = folly::none;
+  if (flow.outstandings.empty()) {
+    return;
+  }
+  // Like the transport, send two probes regardless of cwnd. Their acks let
+  // loss detection catch up with whatever is left outstanding.
+  flow.conn.lossState.ptoCount++;
+  for (int i = 0; i < 2; i++) {
+    sendPacket(flowIndex);
+  }
+}
+
+void PathSimulator::onSample() {
+  for (size_t i = 0; i < flows_.size(); i++) {
+    auto& flow = *flows_[i];
+    if (!flow.started) {
+      continue;
+    }
+    const auto& conn = flow.conn;
+    samples_.push_back(FlowSample{
+        elapsed(),
+        i,
+        conn.congestionController->getCongestionWindow(),
+        conn.lossState.inflightBytes,
+        flow.ackedBytesInInterval * 1000 * 1000 / sampleInterval_.count(),
+        conn.lossState.srtt,
+        queueingDelay()});
+    flow.ackedBytesInInterval = 0;
+  }
+  schedule(now_ + sampleInterval_, EventType::Sample);
+}
+
+std::chrono::microseconds PathSimulator::queueingDelay() const {
+  if (linkFreeTime_ <= now_) {
+    return 0us;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      linkFreeTime_ - now_);
+}
+
+bool PathSimulator::draw(double probability) {
+  if (probability <= 0) {
+    return false;
+  }
+  return std::uniform_real_distribution<double>(0, 1)(rng_) < probability;
+}
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/state/StateData.h>
+
+#include <folly/Optional.h>
+
+#include <deque>
+#include <ostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace quic {
+namespace test {
+
+/**
+ * The bottleneck link shared by all the flows of a PathSimulator. Packets are
+ * served in arrival order at bytesPerSecond out of a drop-tail buffer of
+ * bufferBytes, then take oneWayDelay to reach the receiver. Acks take another
+ * oneWayDelay to come back and are never lost.
+ */
+struct SimulatedLink {
+  uint64_t bytesPerSecond{1000 * 1000};
+  std::chrono::microseconds oneWayDelay{10000};
+  uint64_t bufferBytes{100 * kDefaultUDPSendPacketLen};
+  // Probability for each packet to be dropped before reaching the bottleneck.
+  double lossRate{0};
+  // Probability for each packet to be held for reorderDelay after leaving the
+  // bottleneck, letting the packets behind it overtake it.
+  double reorderRate{0};
+  std::chrono::microseconds reorderDelay{0};
+};
+
+struct SimulatedFlow {
+  CongestionControlType congestionControlType{CongestionControlType::Cubic};
+  bool pacingEnabled{false};
+  // When the flow starts, relative to the start of the simulation.
+  std::chrono::microseconds startTime{0};
+  // Delay added to the acks of this flow only, e.g. to look at rtt fairness.
+  std::chrono::microseconds extraDelay{0};
+  // The flow stops once that many bytes are acked, none means it never runs
+  // out of data to send.
+  folly::Optional<uint64_t> bytesToSend;
+  // What the flow's connection starts with, the congestion controller type
+  // and pacing are set from the above.
+  TransportSettings transportSettings;
+};
+
+/**
+ * State of a flow at the end of a sampling interval.
+ */
+struct FlowSample {
+  // Since the start of the simulation.
+  std::chrono::microseconds time;
+  size_t flow;
+  uint64_t congestionWindow;
+  uint64_t inflightBytes;
+  // Bytes acked during the interval, per second.
+  uint64_t goodput;
+  std::chrono::microseconds srtt;
+  // Time the bottleneck needs to drain its buffer.
+  std::chrono::microseconds queueingDelay;
+};
+
+struct FlowStats {
+  uint64_t sentBytes{0};
+  uint64_t ackedBytes{0};
+  uint64_t lostBytes{0};
+  // Since the start of the flow, set once bytesToSend are all acked.
+  folly::Optional<std::chrono::microseconds> completionTime;
+
+  double retransmissionRate() const {
+    return sentBytes ? static_cast<double>(lostBytes) / sentBytes : 0;
+  }
+};
+
+/**
+ * Runs flows over a simulated bottleneck link without any socket, each flow
+ * driving a real QuicConnectionStateBase with the congestion controller made
+ * by DefaultCongestionControllerFactory, and a TokenlessPacer when pacing is
+ * enabled. Time only moves forward from one event to the next, so a run of
+ * minutes takes well under a second.
+ *
+ * The sender side mirrors what the transport does with the connection state:
+ * rtt samples, packet and time threshold loss detection, PTO probes, and the
+ * bookkeeping bandwidth sampling relies on. The receiver acks every packet
+ * right away. Loss and reordering at the link are drawn from an RNG seeded
+ * with the given seed, so the same seed always gives the same run unless the
+ * congestion controller itself draws random numbers.
+ */
+class PathSimulator {
+ public:
+  PathSimulator(
+      SimulatedLink link,
+      std::vector<SimulatedFlow> flows,
+      uint64_t seed = 0,
+      std::chrono::microseconds sampleInterval =
+          std::chrono::milliseconds(100));
+
+  ~PathSimulator();
+
+  /**
+   * Runs the simulation for duration past the current simulated time. It can
+   * be called again to keep going.
+   */
+  void run(std::chrono::microseconds duration);
+
+  TimePoint now() const noexcept;
+  std::chrono::microseconds elapsed() const noexcept;
+
+  size_t numFlows() const noexcept;
+  const FlowStats& flowStats(size_t flow) const;
+  const QuicConnectionStateBase& conn(size_t flow) const;
+
+  const std::vector<FlowSample>& samples() const noexcept;
+
+  /**
+   * Writes the samples as CSV, one line per flow and interval.
+   */
+  void writeSamplesCsv(std::ostream& os) const;
+
+  /**
+   * Jain's fairness index of the bytes acked so far by each flow, 1 when
+   * every flow got the same share.
+   */
+  double fairnessIndex() const;
+
+ private:
+  struct Flow;
+
+  enum class EventType : uint8_t {
+    Write,
+    Ack,
+    LossTimer,
+    Pto,
+    Sample,
+  };
+
+  struct Event {
+    TimePoint time;
+    // Breaks ties between events scheduled at the same time, in scheduling
+    // order.
+    uint64_t seq;
+    EventType type;
+    size_t flow;
+    PacketNum packetNum;
+
+    bool operator>(const Event& other) const {
+      return time > other.time || (time == other.time && seq > other.seq);
+    }
+  };
+
+  void schedule(
+      TimePoint time,
+      EventType type,
+      size_t flow = 0,
+      PacketNum packetNum = 0);
+
+  void onWrite(size_t flowIndex);
+  void onAck(size_t flowIndex, PacketNum packetNum);
+  void onLossTimer(size_t flowIndex);
+  void onPto(size_t flowIndex);
+  void onSample();
+
+  bool hasDataToSend(const Flow& flow) const;
+  void sendPacket(size_t flowIndex);
+  void scheduleWrite(size_t flowIndex, TimePoint time);
+  void scheduleLossTimers(size_t flowIndex);
+  // Declares lost the outstanding packets the time and packet thresholds
+  // allow, returns none if there aren't any.
+  folly::Optional<CongestionController::LossEvent> detectLoss(Flow& flow);
+  std::chrono::microseconds queueingDelay() const;
+  bool draw(double probability);
+
+  SimulatedLink link_;
+  std::vector<std::unique_ptr<Flow>> flows_;
+  std::chrono::microseconds sampleInterval_;
+  std::mt19937_64 rng_;
+
+  TimePoint start_;
+  TimePoint now_;
+  uint64_t nextEventSeq_{0};
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+
+  // When the bottleneck is done with the packets already queued.
+  TimePoint linkFreeTime_;
+  // Departure time and size of each packet in the bottleneck buffer.
+  std::deque<std::pair<TimePoint, uint64_t>> bottleneckQueue_;
+  uint64_t queuedBytes_{0};
+
+  std::vector<FlowSample> samples_;
+};
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/congestion_control/test/PathSimulator.h>
+
+#include <folly/portability/GTest.h>
+
+#include <sstream>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+
+// 10Mbps, 40ms rtt, with a buffer of one BDP.
+SimulatedLink makeLink() {
+  SimulatedLink link;
+  link.bytesPerSecond = 1250 * 1000;
+  link.oneWayDelay = 20ms;
+  link.bufferBytes = 50 * 1000;
+  return link;
+}
+
+SimulatedFlow makeFlow(CongestionControlType type, bool pacingEnabled) {
+  SimulatedFlow flow;
+  flow.congestionControlType = type;
+  flow.pacingEnabled = pacingEnabled;
+  return flow;
+}
+
+} // namespace
+
+class PathSimulatorTest : public Test {};
+
+TEST_F(PathSimulatorTest, SingleFlowFillsLink) {
+  auto link = makeLink();
+  PathSimulator simulator(
+      link, {makeFlow(CongestionControlType::Cubic, false)});
+  simulator.run(10s);
+  EXPECT_EQ(10s, simulator.elapsed());
+  const auto& stats = simulator.flowStats(0);
+  EXPECT_GT(stats.ackedBytes, link.bytesPerSecond * 10 * 8 / 10);
+  EXPECT_LE(stats.ackedBytes, link.bytesPerSecond * 10);
+  EXPECT_GT(simulator.conn(0).lossState.srtt, 2 * link.oneWayDelay);
+}
+
+TEST_F(PathSimulatorTest, Samples) {
+  PathSimulator simulator(
+      makeLink(),
+      {makeFlow(CongestionControlType::NewReno, false)},
+      0 /* seed */,
+      100ms);
+  simulator.run(1s);
+  ASSERT_EQ(10, simulator.samples().size());
+  std::chrono::microseconds sampleTime = 0us;
+  for (const auto& sample : simulator.samples()) {
+    sampleTime += 100ms;
+    EXPECT_EQ(sampleTime, sample.time);
+    EXPECT_EQ(0, sample.flow);
+    EXPECT_GT(sample.congestionWindow, 0);
+  }
+
+  std::stringstream csv;
+  simulator.writeSamplesCsv(csv);
+  std::string line;
+  size_t lines = 0;
+  while (std::getline(csv, line)) {
+    lines++;
+  }
+  EXPECT_EQ(simulator.samples().size() + 1, lines);
+}
+
+TEST_F(PathSimulatorTest, SameSeedSameRun) {
+  auto link = makeLink();
+  link.lossRate = 0.01;
+  link.reorderRate = 0.01;
+  link.reorderDelay = 5ms;
+  auto runOnce = [&](uint64_t seed) {
+    PathSimulator simulator(
+        link,
+        {makeFlow(CongestionControlType::Cubic, false),
+         makeFlow(CongestionControlType::NewReno, false)},
+        seed);
+    simulator.run(5s);
+    std::stringstream csv;
+    simulator.writeSamplesCsv(csv);
+    return csv.str();
+  };
+  EXPECT_EQ(runOnce(1), runOnce(1));
+  EXPECT_NE(runOnce(1), runOnce(2));
+}
+
+TEST_F(PathSimulatorTest, RandomLossIsRecovered) {
+  auto link = makeLink();
+  link.lossRate = 0.01;
+  SimulatedFlow flow = makeFlow(CongestionControlType::Cubic, false);
+  flow.bytesToSend = 1000 * 1000;
+  PathSimulator simulator(link, {flow});
+  simulator.run(30s);
+  const auto& stats = simulator.flowStats(0);
+  EXPECT_GT(stats.lostBytes, 0);
+  ASSERT_TRUE(stats.completionTime.has_value());
+  EXPECT_GE(stats.ackedBytes, *flow.bytesToSend);
+  EXPECT_LT(*stats.completionTime, 30s);
+}
+
+TEST_F(PathSimulatorTest, LateFlowGetsItsShare) {
+  SimulatedFlow late = makeFlow(CongestionControlType::Cubic, false);
+  late.startTime = 5s;
+  PathSimulator simulator(
+      makeLink(), {makeFlow(CongestionControlType::Cubic, false), late});
+  simulator.run(5s);
+  EXPECT_GT(simulator.flowStats(0).ackedBytes, 0);
+  EXPECT_EQ(0, simulator.flowStats(1).sentBytes);
+  simulator.run(55s);
+  EXPECT_GT(simulator.flowStats(1).ackedBytes, 0);
+  EXPECT_GT(simulator.fairnessIndex(), 0.8);
+}
+
+class PathSimulatorCongestionControlTest
+    : public PathSimulatorTest,
+      public WithParamInterface<CongestionControlType> {};
+
+TEST_P(PathSimulatorCongestionControlTest, UsesLink) {
+  auto link = makeLink();
+  PathSimulator simulator(link, {makeFlow(GetParam(), true)});
+  simulator.run(10s);
+  const auto& stats = simulator.flowStats(0);
+  LOG(INFO) << congestionControlTypeToString(GetParam())
+            << ": acked=" << stats.ackedBytes
+            << " retransmission rate=" << stats.retransmissionRate();
+  EXPECT_GT(stats.ackedBytes, link.bytesPerSecond * 10 / 2);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    PathSimulatorCongestionControlTests,
+    PathSimulatorCongestionControlTest,
+    Values(
+        CongestionControlType::Cubic,
+        CongestionControlType::NewReno,
+        CongestionControlType::Copa,
+        CongestionControlType::Copa2,
+        CongestionControlType::BBR,
+        CongestionControlType::BBR2));
+
+TEST_F(PathSimulatorTest, Bbr2ShallowBufferComparedToBbr) {
+  // 24Mbps, 40ms, with a buffer of a fifth of the BDP.
+  SimulatedLink link;
+  link.bytesPerSecond = 3 * 1000 * 1000;
+  link.oneWayDelay = 20ms;
+  link.bufferBytes = 24 * 1000;
+  PathSimulator bbrSimulator(
+      link, {makeFlow(CongestionControlType::BBR, true)});
+  bbrSimulator.run(10s);
+  PathSimulator bbr2Simulator(
+      link, {makeFlow(CongestionControlType::BBR2, true)});
+  bbr2Simulator.run(10s);
+  const auto& bbr = bbrSimulator.flowStats(0);
+  const auto& bbr2 = bbr2Simulator.flowStats(0);
+  LOG(INFO) << "BBR: acked=" << bbr.ackedBytes
+            << " retransmission rate=" << bbr.retransmissionRate();
+  LOG(INFO) << "BBR2: acked=" << bbr2.ackedBytes
+            << " retransmission rate=" << bbr2.retransmissionRate();
+  EXPECT_GT(bbr.lostBytes, 0);
+  EXPECT_LT(bbr2.retransmissionRate(), bbr.retransmissionRate());
+  EXPECT_GT(bbr2.ackedBytes, bbr.ackedBytes * 8 / 10);
+}
+
+TEST_F(PathSimulatorTest, HystartPlusPlusLessSlowStartOvershoot) {
+  // 10Mbps, 40ms, with a buffer of ten BDPs for slow start to overshoot into.
+  auto link = makeLink();
+  link.bufferBytes = 500 * 1000;
+  auto runOnce = [&](bool hystartPlusPlus) {
+    SimulatedFlow flow = makeFlow(CongestionControlType::NewReno, false);
+    flow.transportSettings.hystartPlusPlus = hystartPlusPlus;
+    PathSimulator simulator(link, {flow});
+    simulator.run(3s);
+    std::chrono::microseconds maxQueueingDelay = 0us;
+    for (const auto& sample : simulator.samples()) {
+      maxQueueingDelay = std::max(maxQueueingDelay, sample.queueingDelay);
+    }
+    const auto& stats = simulator.flowStats(0);
+    LOG(INFO) << (hystartPlusPlus ? "HyStart++" : "slow start")
+              << ": acked=" << stats.ackedBytes << " lost=" << stats.lostBytes
+              << " max queueing delay=" << maxQueueingDelay.count() << "us";
+    return std::make_pair(stats, maxQueueingDelay);
+  };
+  auto slowStart = runOnce(false);
+  auto hystartPlusPlus = runOnce(true);
+  EXPECT_GT(slowStart.first.lostBytes, 0);
+  EXPECT_LT(hystartPlusPlus.first.lostBytes, slowStart.first.lostBytes);
+  EXPECT_LT(hystartPlusPlus.second, slowStart.second);
+  // The link stays busy either way.
+  EXPECT_GT(
+      hystartPlusPlus.first.ackedBytes, slowStart.first.ackedBytes * 8 / 10);
+}
+
+} // namespace test
+} // namespace quic
@@ -14,17 +14,18 @@ constexpr folly::StringPiece retryPacketKey =
 constexpr folly::StringPiece retryPacketNonce =
     "\xe5\x49\x30\xf9\x7f\x21\x36\xf0\x53\x0a\x8c\x1c";
 
-std::unique_ptr<folly::IOBuf>
-FizzRetryIntegrityTagGenerator::getRetryIntegrityTag(
-    const folly::IOBuf* pseudoRetryPacket) {
-  std::unique_ptr<fizz::Aead> retryCipher =
-      fizz::OpenSSLEVPCipher::makeCipher<fizz::AESGCM128>();
+FizzRetryIntegrityTagGenerator::FizzRetryIntegrityTagGenerator()
+    : retryCipher_(fizz::OpenSSLEVPCipher::makeCipher<fizz::AESGCM128>()) {
   fizz::TrafficKey trafficKey;
   trafficKey.key = folly::IOBuf::copyBuffer(retryPacketKey);
   trafficKey.iv = folly::IOBuf::copyBuffer(retryPacketNonce);
-  retryCipher->setKey(std::move(trafficKey));
+  retryCipher_->setKey(std::move(trafficKey));
+}
 
-  return retryCipher->encrypt(
+std::unique_ptr<folly::IOBuf>
+FizzRetryIntegrityTagGenerator::getRetryIntegrityTag(
+    const folly::IOBuf* pseudoRetryPacket) {
+  return retryCipher_->encrypt(
       std::make_unique<folly::IOBuf>(), pseudoRetryPacket, 0);
 }
 
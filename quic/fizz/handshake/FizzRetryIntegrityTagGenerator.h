@@ -2,14 +2,22 @@
 
 #pragma once
 
+#include <fizz/crypto/aead/Aead.h>
 #include <quic/handshake/RetryIntegrityTagGenerator.h>
 
 namespace quic {
 
 class FizzRetryIntegrityTagGenerator : public RetryIntegrityTagGenerator {
  public:
+  FizzRetryIntegrityTagGenerator();
+
   std::unique_ptr<folly::IOBuf> getRetryIntegrityTag(
       const folly::IOBuf* pseudoRetryPacket) override;
+
+ private:
+  // The key and nonce are fixed, so the cipher is keyed once and reused for
+  // every tag.
+  std::unique_ptr<fizz::Aead> retryCipher_;
 };
 
 } // namespace quic
@@ -24,6 +24,9 @@ std::unique_ptr<folly::IOBuf> encodeAppToken(const AppToken& appToken) {
   fizz::detail::writeVector<uint8_t>(appToken.sourceAddresses, appender);
   fizz::detail::write(appToken.version, appender);
   fizz::detail::writeBuf<uint16_t>(appToken.appParams, appender);
+  fizz::detail::write(appToken.bandwidth, appender);
+  fizz::detail::write(
+      static_cast<uint64_t>(appToken.minRtt.count()), appender);
   return buf;
 }
 
@@ -44,6 +47,14 @@ folly::Optional<AppToken> decodeAppToken(const folly::IOBuf& buf) {
     }
     fizz::detail::read(appToken.version, cursor);
     fizz::detail::readBuf<uint16_t>(appToken.appParams, cursor);
+    // Tickets issued before the path characteristics were added end here.
+    if (cursor.isAtEnd()) {
+      return appToken;
+    }
+    uint64_t minRttUs;
+    fizz::detail::read(appToken.bandwidth, cursor);
+    fizz::detail::read(minRttUs, cursor);
+    appToken.minRtt = std::chrono::microseconds(minRttUs);
   } catch (const std::exception&) {
     return folly::none;
   }
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/fizz/server/handshake/BatchSigningCert.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+void SequentialBatchSigner::signBatch(folly::Range<Request*> requests) {
+  for (auto& request : requests) {
+    try {
+      request.signature = request.cert->sign(
+          request.scheme, request.context, request.toBeSigned);
+    } catch (const std::exception&) {
+      request.error = std::current_exception();
+    }
+  }
+}
+
+BatchSigningService::BatchSigningService(
+    std::unique_ptr<BatchSigner> signer,
+    Options options)
+    : signer_(std::move(signer)), options_(options) {
+  CHECK(signer_);
+  CHECK_GT(options_.maxBatchSize, 0);
+  queue_.reserve(options_.maxBatchSize);
+}
+
+std::unique_ptr<folly::IOBuf> BatchSigningService::signInline(
+    BatchSigner::Request request) {
+  signer_->signBatch(folly::range(&request, &request + 1));
+  numBatches_.fetch_add(1, std::memory_order_relaxed);
+  numSignatures_.fetch_add(1, std::memory_order_relaxed);
+  if (request.error) {
+    std::rethrow_exception(request.error);
+  }
+  return std::move(request.signature);
+}
+
+std::unique_ptr<folly::IOBuf> BatchSigningService::sign(
+    const fizz::SelfCert& cert,
+    fizz::SignatureScheme scheme,
+    fizz::CertificateVerifyContext context,
+    folly::ByteRange toBeSigned) {
+  Pending pending;
+  pending.request.cert = &cert;
+  pending.request.scheme = scheme;
+  pending.request.context = context;
+  pending.request.toBeSigned = toBeSigned;
+  if (options_.maxBatchSize == 1 || !signer_->amortizesBatches()) {
+    return signInline(std::move(pending.request));
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  bool leader = queue_.empty();
+  queue_.push_back(&pending);
+  if (queue_.size() >= options_.maxBatchSize) {
+    signBatch(lock, std::move(queue_));
+  } else if (leader) {
+    // The leader is still in queue_ unless someone else filled the batch, so
+    // it is the one to sign whatever joined once the delay is over.
+    auto deadline = std::chrono::steady_clock::now() + options_.maxDelay;
+    cv_.wait_until(lock, deadline, [&] { return pending.taken; });
+    if (!pending.taken) {
+      signBatch(lock, std::move(queue_));
+    }
+  }
+  cv_.wait(lock, [&] { return pending.done; });
+  lock.unlock();
+
+  if (pending.request.error) {
+    std::rethrow_exception(pending.request.error);
+  }
+  return std::move(pending.request.signature);
+}
+
+void BatchSigningService::signBatch(
+    std::unique_lock<std::mutex>& lock,
+    std::vector<Pending*> batch) {
+  queue_.clear();
+  queue_.reserve(options_.maxBatchSize);
+  for (auto pending : batch) {
+    pending->taken = true;
+  }
+  // Wake the leader of this batch, if it isn't us, so that it stops waiting
+  // for the delay to expire.
+  cv_.notify_all();
+  lock.unlock();
+
+  std::vector<BatchSigner::Request> requests;
+  requests.reserve(batch.size());
+  for (auto pending : batch) {
+    requests.push_back(std::move(pending->request));
+  }
+  signer_->signBatch(folly::range(requests));
+  numBatches_.fetch_add(1, std::memory_order_relaxed);
+  numSignatures_.fetch_add(requests.size(), std::memory_order_relaxed);
+
+  lock.lock();
+  for (size_t i = 0; i < batch.size(); ++i) {
+    batch[i]->request = std::move(requests[i]);
+    batch[i]->done = true;
+  }
+  cv_.notify_all();
+}
+
+BatchSigningCert::BatchSigningCert(
+    std::shared_ptr<const fizz::SelfCert> cert,
+    std::shared_ptr<BatchSigningService> service)
+    : cert_(std::move(cert)), service_(std::move(service)) {
+  CHECK(cert_);
+  CHECK(service_);
+}
+
+std::string BatchSigningCert::getIdentity() const {
+  return cert_->getIdentity();
+}
+
+std::vector<std::string> BatchSigningCert::getAltIdentities() const {
+  return cert_->getAltIdentities();
+}
+
+std::vector<fizz::SignatureScheme> BatchSigningCert::getSigSchemes() const {
+  return cert_->getSigSchemes();
+}
+
+fizz::CertificateMsg BatchSigningCert::getCertMessage(
+    fizz::Buf certificateRequestContext) const {
+  return cert_->getCertMessage(std::move(certificateRequestContext));
+}
+
+fizz::CompressedCertificate BatchSigningCert::getCompressedCert(
+    fizz::CertificateCompressionAlgorithm algo) const {
+  return cert_->getCompressedCert(algo);
+}
+
+fizz::Buf BatchSigningCert::sign(
+    fizz::SignatureScheme scheme,
+    fizz::CertificateVerifyContext context,
+    folly::ByteRange toBeSigned) const {
+  return service_->sign(*cert_, scheme, context, toBeSigned);
+}
+
+folly::ssl::X509UniquePtr BatchSigningCert::getX509() const {
+  return cert_->getX509();
+}
+
+} // namespace quic
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <fizz/protocol/Certificate.h>
+#include <folly/Range.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace quic {
+
+/**
+ * Computes a batch of CertificateVerify signatures at once. Implementations
+ * can amortize work across the batch, e.g. with a multi-buffer ECDSA engine
+ * or an offload device that takes several operations per call.
+ */
+class BatchSigner {
+ public:
+  struct Request {
+    const fizz::SelfCert* cert;
+    fizz::SignatureScheme scheme;
+    fizz::CertificateVerifyContext context;
+    folly::ByteRange toBeSigned;
+    std::unique_ptr<folly::IOBuf> signature;
+    std::exception_ptr error;
+  };
+
+  virtual ~BatchSigner() = default;
+
+  /**
+   * Fill in signature, or error, for every request.
+   */
+  virtual void signBatch(folly::Range<Request*> requests) = 0;
+
+  /**
+   * Whether signing requests together costs less than signing them one by
+   * one. When it doesn't, BatchSigningService doesn't queue anything and
+   * signs each request right away on its caller's thread.
+   */
+  virtual bool amortizesBatches() const {
+    return true;
+  }
+};
+
+/**
+ * Signs every request of the batch in turn with its own certificate. Nothing
+ * is amortized, so BatchSigningService signs inline with it.
+ */
+class SequentialBatchSigner : public BatchSigner {
+ public:
+  void signBatch(folly::Range<Request*> requests) override;
+
+  bool amortizesBatches() const override {
+    return false;
+  }
+};
+
+/**
+ * Collects signatures requested by concurrent handshakes and hands them to a
+ * BatchSigner together. The first request of a batch waits for up to maxDelay
+ * for others to join, and a batch is signed as soon as it has maxBatchSize
+ * requests.
+ *
+ * Batching only pays off with a BatchSigner which amortizes work across the
+ * batch, with any other one, or a maxBatchSize of 1, every request is signed
+ * inline on its caller's thread without queueing or delay.
+ *
+ * When batching, sign() blocks its caller until its signature is ready, so it
+ * only makes sense when handshakes run on a thread pool, see
+ * FizzServerQuicHandshakeContext::Builder::setHandshakeOffloadExecutor.
+ */
+class BatchSigningService {
+ public:
+  struct Options {
+    size_t maxBatchSize{16};
+    std::chrono::microseconds maxDelay{200};
+  };
+
+  BatchSigningService(std::unique_ptr<BatchSigner> signer, Options options);
+
+  std::unique_ptr<folly::IOBuf> sign(
+      const fizz::SelfCert& cert,
+      fizz::SignatureScheme scheme,
+      fizz::CertificateVerifyContext context,
+      folly::ByteRange toBeSigned);
+
+  uint64_t numBatches() const {
+    return numBatches_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t numSignatures() const {
+    return numSignatures_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::unique_ptr<folly::IOBuf> signInline(BatchSigner::Request request);
+
+  struct Pending {
+    BatchSigner::Request request;
+    bool taken{false};
+    bool done{false};
+  };
+
+  // Signs the batch with mutex_ released, then wakes up its callers.
+  void signBatch(
+      std::unique_lock<std::mutex>& lock,
+      std::vector<Pending*> batch);
+
+  std::unique_ptr<BatchSigner> signer_;
+  const Options options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<Pending*> queue_;
+
+  std::atomic<uint64_t> numBatches_{0};
+  std::atomic<uint64_t> numSignatures_{0};
+};
+
+/**
+ * SelfCert which forwards everything to the wrapped certificate except for
+ * sign(), which goes through a BatchSigningService. Install it in the
+ * CertManager of the FizzServerContext used by FizzServerQuicHandshakeContext
+ * in place of the certificate it wraps.
+ */
+class BatchSigningCert : public fizz::SelfCert {
+ public:
+  BatchSigningCert(
+      std::shared_ptr<const fizz::SelfCert> cert,
+      std::shared_ptr<BatchSigningService> service);
+
+  std::string getIdentity() const override;
+
+  std::vector<std::string> getAltIdentities() const override;
+
+  std::vector<fizz::SignatureScheme> getSigSchemes() const override;
+
+  fizz::CertificateMsg getCertMessage(
+      fizz::Buf certificateRequestContext = nullptr) const override;
+
+  fizz::CompressedCertificate getCompressedCert(
+      fizz::CertificateCompressionAlgorithm algo) const override;
+
+  fizz::Buf sign(
+      fizz::SignatureScheme scheme,
+      fizz::CertificateVerifyContext context,
+      folly::ByteRange toBeSigned) const override;
+
+  folly::ssl::X509UniquePtr getX509() const override;
+
+ private:
+  std::shared_ptr<const fizz::SelfCert> cert_;
+  std::shared_ptr<BatchSigningService> service_;
+};
+
+} // namespace quic
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/fizz/server/handshake/FizzReplayCache.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+FizzReplayCache::FizzReplayCache(std::shared_ptr<ReplayCacheBackend> backend)
+    : backend_(std::move(backend)) {
+  CHECK(backend_);
+}
+
+folly::Future<fizz::server::ReplayCacheResult> FizzReplayCache::check(
+    folly::ByteRange identifier) {
+  return backend_->testAndInsert(identifier)
+      .thenTry([](folly::Try<bool>&& seen) {
+        if (seen.hasException()) {
+          VLOG(4) << "Replay cache error: " << seen.exception().what();
+          return fizz::server::ReplayCacheResult::MaybeReplay;
+        }
+        return *seen ? fizz::server::ReplayCacheResult::MaybeReplay
+                     : fizz::server::ReplayCacheResult::NotReplay;
+      });
+}
+
+} // namespace quic
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <fizz/server/ReplayCache.h>
+#include <quic/server/handshake/ShardedReplayCache.h>
+
+namespace quic {
+
+/**
+ * fizz::server::ReplayCache on top of a ReplayCacheBackend. Pass it to
+ * FizzServerContext::setEarlyDataSettings of the context shared by all the
+ * workers so that they all consult the same anti-replay state before
+ * accepting 0-RTT. If the backend fails, early data is rejected.
+ */
+class FizzReplayCache : public fizz::server::ReplayCache {
+ public:
+  explicit FizzReplayCache(std::shared_ptr<ReplayCacheBackend> backend);
+
+  folly::Future<fizz::server::ReplayCacheResult> check(
+      folly::ByteRange identifier) override;
+
+ private:
+  std::shared_ptr<ReplayCacheBackend> backend_;
+};
+
+} // namespace quic
@@ -13,7 +13,9 @@
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
 
 #include <fizz/protocol/Protocol.h>
+#include <fizz/record/Types.h>
 #include <fizz/server/State.h>
+#include <folly/io/Cursor.h>
 
 // This is necessary for the conversion between QuicServerConnectionState and
 // QuicConnectionStateBase and can be removed once ServerHandshake accepts
@@ -32,6 +34,41 @@ class FailingAppTokenValidator : public fizz::server::AppTokenValidator {
     return false;
   }
 };
+
+/**
+ * Whether queue starts with a whole ClientHello offering neither a PSK nor
+ * early data. Resumption runs the app token validator, which reads and
+ * updates the connection state, so it has to stay on the worker. A partial
+ * ClientHello only makes the state machine wait, which is cheap anyway.
+ */
+bool isFullHandshakeClientHello(const folly::IOBufQueue& queue) {
+  // Handshake message type and 24 bit length.
+  constexpr size_t kHandshakeHeaderSize = 4;
+  if (queue.chainLength() < kHandshakeHeaderSize) {
+    return false;
+  }
+  folly::io::Cursor cursor(queue.front());
+  auto type = cursor.read<uint8_t>();
+  size_t length = cursor.read<uint8_t>() << 16;
+  length |= cursor.readBE<uint16_t>();
+  if (type != static_cast<uint8_t>(fizz::HandshakeType::client_hello) ||
+      queue.chainLength() < kHandshakeHeaderSize + length) {
+    return false;
+  }
+  try {
+    auto chlo = fizz::decode<fizz::ClientHello>(cursor);
+    for (const auto& extension : chlo.extensions) {
+      if (extension.extension_type == fizz::ExtensionType::pre_shared_key ||
+          extension.extension_type == fizz::ExtensionType::early_data) {
+        return false;
+      }
+    }
+  } catch (const std::exception&) {
+    // Let the state machine report the error.
+    return false;
+  }
+  return true;
+}
 } // namespace
 
 namespace quic {
@@ -85,11 +122,83 @@ EncryptionLevel FizzServerHandshake::getReadRecordLayerEncryptionLevel() {
       state_.readRecordLayer()->getEncryptionLevel());
 }
 
+void FizzServerHandshake::cancel() {
+  if (offloadCanceled_) {
+    offloadCanceled_->store(true, std::memory_order_release);
+  }
+  ServerHandshake::cancel();
+}
+
 void FizzServerHandshake::processSocketData(folly::IOBufQueue& queue) {
+  auto& offloadExecutor = fizzContext_->getHandshakeOffloadExecutor();
+  // Only the ClientHello flight of a full handshake does asymmetric crypto,
+  // what comes after it is cheap enough to stay on the worker.
+  if (offloadExecutor &&
+      getReadRecordLayerEncryptionLevel() == EncryptionLevel::Initial &&
+      isFullHandshakeClientHello(queue)) {
+    offloadSocketData(*offloadExecutor, queue);
+    return;
+  }
   startActions(
       machine_.processSocketData(state_, queue, fizz::Aead::AeadOptions()));
 }
 
+void FizzServerHandshake::offloadSocketData(
+    HandshakeOffloadExecutor& offloadExecutor,
+    folly::IOBufQueue& queue) {
+  // The worker keeps appending to queue while the state machine runs, so the
+  // offloaded job gets its own copy of what is there now. actionGuard_ is held
+  // until the job is back on the worker, which keeps the connection alive and
+  // stops anything else from touching state_ meanwhile. The job only touches
+  // state_ and input off the worker, and the keep alive token keeps the
+  // worker's EventBase around for it to come back to.
+  if (!offloadCanceled_) {
+    offloadCanceled_ = std::make_shared<std::atomic<bool>>(false);
+  }
+  auto input = std::make_shared<folly::IOBufQueue>(
+      folly::IOBufQueue::cacheChainLength());
+  input->append(queue.move());
+  bool added = offloadExecutor.tryAdd(
+      [this,
+       input,
+       &queue,
+       canceled = offloadCanceled_,
+       workerExecutor = folly::getKeepAliveToken(executor_)](
+          std::chrono::microseconds queueDelay) mutable {
+        folly::Optional<fizz::server::AsyncActions> actions;
+        // A connection closed while the job was queued needs no handshake.
+        if (!canceled->load(std::memory_order_acquire)) {
+          actions = machine_.processSocketData(
+              state_, *input, fizz::Aead::AeadOptions());
+        }
+        workerExecutor->add([this,
+                             input,
+                             &queue,
+                             canceled = std::move(canceled),
+                             queueDelay,
+                             actions = std::move(actions)]() mutable {
+          if (!actions || canceled->load(std::memory_order_acquire)) {
+            // This may destroy the connection, and this with it.
+            actionGuard_ = folly::DelayedDestruction::DestructorGuard(nullptr);
+            return;
+          }
+          QUIC_STATS(conn_->statsCallback, onHandshakeQueueDelay, queueDelay);
+          // Whatever the state machine did not consume goes back in front of
+          // the data which arrived in the meantime.
+          auto arrived = queue.move();
+          queue.append(input->move());
+          queue.append(std::move(arrived));
+          startActions(std::move(*actions));
+        });
+      });
+  if (!added) {
+    QUIC_STATS(conn_->statsCallback, onHandshakeOffloadRejected);
+    onError(std::make_pair(
+        "Handshake offload queue full", TransportErrorCode::SERVER_BUSY));
+    actionGuard_ = folly::DelayedDestruction::DestructorGuard(nullptr);
+  }
+}
+
 std::pair<std::unique_ptr<Aead>, std::unique_ptr<PacketNumberCipher>>
 FizzServerHandshake::buildCiphers(folly::ByteRange secret) {
   auto aead = FizzAead::wrap(fizz::Protocol::deriveRecordAeadWithLabel(
@@ -104,6 +213,28 @@ FizzServerHandshake::buildCiphers(folly::ByteRange secret) {
   return {std::move(aead), std::move(headerCipher)};
 }
 
+std::pair<std::unique_ptr<Aead>, std::unique_ptr<PacketNumberCipher>>
+FizzServerHandshake::buildCiphers(
+    fizz::CipherSuite cipherSuite,
+    const TrafficKey& key,
+    folly::ByteRange headerKey) {
+  auto fizzAead = cryptoFactory_->getFizzFactory()->makeAead(cipherSuite);
+  auto headerCipher = cryptoFactory_->makePacketNumberCipher(cipherSuite);
+  // The keys come from another process, the ciphers only DCHECK their sizes.
+  if (key.key->computeChainDataLength() != fizzAead->keyLength() ||
+      key.iv->computeChainDataLength() != fizzAead->ivLength() ||
+      headerKey.size() != headerCipher->keyLength()) {
+    throw std::runtime_error("Invalid handoff key length");
+  }
+  fizz::TrafficKey trafficKey;
+  trafficKey.key = key.key->clone();
+  trafficKey.iv = key.iv->clone();
+  fizzAead->setKey(std::move(trafficKey));
+  headerCipher->setKey(headerKey);
+
+  return {FizzAead::wrap(std::move(fizzAead)), std::move(headerCipher)};
+}
+
 void FizzServerHandshake::processAccept() {
   addProcessingActions(machine_.processAccept(
       state_, executor_, state_.context(), transportParams_));
@@ -13,9 +13,12 @@
 
 #include <fizz/server/ServerProtocol.h>
 
+#include <atomic>
+
 namespace quic {
 
 class FizzServerQuicHandshakeContext;
+class HandshakeOffloadExecutor;
 struct QuicServerConnectionState;
 
 class FizzServerHandshake : public ServerHandshake {
@@ -32,6 +35,12 @@ class FizzServerHandshake : public ServerHandshake {
    */
   const fizz::server::FizzServerContext* getContext() const;
 
+  /**
+   * Also drops the result of a ClientHello being processed on the
+   * HandshakeOffloadExecutor, if any, once it is back on the worker.
+   */
+  void cancel() override;
+
  private:
   void initializeImpl(
       HandshakeCallback* callback,
@@ -39,8 +48,16 @@ class FizzServerHandshake : public ServerHandshake {
 
   EncryptionLevel getReadRecordLayerEncryptionLevel() override;
   void processSocketData(folly::IOBufQueue& queue) override;
+  void offloadSocketData(
+      HandshakeOffloadExecutor& offloadExecutor,
+      folly::IOBufQueue& queue);
   std::pair<std::unique_ptr<Aead>, std::unique_ptr<PacketNumberCipher>>
   buildCiphers(folly::ByteRange secret) override;
+  std::pair<std::unique_ptr<Aead>, std::unique_ptr<PacketNumberCipher>>
+  buildCiphers(
+      fizz::CipherSuite cipherSuite,
+      const TrafficKey& key,
+      folly::ByteRange headerKey) override;
 
   void processAccept() override;
   bool processPendingCryptoEvent() override;
@@ -52,6 +69,10 @@ class FizzServerHandshake : public ServerHandshake {
   std::unique_ptr<FizzCryptoFactory> cryptoFactory_;
 
   std::shared_ptr<FizzServerQuicHandshakeContext> fizzContext_;
+
+  // Set when the handshake is canceled, shared with the offloaded jobs which
+  // outlive the transport.
+  std::shared_ptr<std::atomic<bool>> offloadCanceled_;
 };
 
 } // namespace quic
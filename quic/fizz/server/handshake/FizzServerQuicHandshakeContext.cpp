@@ -37,9 +37,12 @@ FizzServerQuicHandshakeContext::Builder::build() && {
     context_ = std::make_shared<const fizz::server::FizzServerContext>();
   }
 
-  return std::shared_ptr<FizzServerQuicHandshakeContext>(
+  auto handshakeContext = std::shared_ptr<FizzServerQuicHandshakeContext>(
       new FizzServerQuicHandshakeContext(
           std::move(context_), std::move(cryptoFactory_)));
+  handshakeContext->handshakeOffloadExecutor_ =
+      std::move(handshakeOffloadExecutor_);
+  return handshakeContext;
 }
 
 } // namespace quic
@@ -10,6 +10,7 @@
 
 #include <fizz/server/FizzServerContext.h>
 #include <quic/fizz/handshake/FizzCryptoFactory.h>
+#include <quic/server/handshake/HandshakeOffloadExecutor.h>
 #include <quic/server/handshake/ServerHandshakeFactory.h>
 
 namespace quic {
@@ -28,6 +29,11 @@ class FizzServerQuicHandshakeContext
     return context_;
   }
 
+  const std::shared_ptr<HandshakeOffloadExecutor>& getHandshakeOffloadExecutor()
+      const {
+    return handshakeOffloadExecutor_;
+  }
+
  private:
   /**
    * We make the constructor private so that users have to use the Builder
@@ -48,6 +54,8 @@ class FizzServerQuicHandshakeContext
 
   std::unique_ptr<CryptoFactory> cryptoFactory_;
 
+  std::shared_ptr<HandshakeOffloadExecutor> handshakeOffloadExecutor_;
+
  public:
   class Builder {
    public:
@@ -63,11 +71,24 @@ class FizzServerQuicHandshakeContext
       return std::move(*this);
     }
 
+    /**
+     * Process ClientHellos, which carry the key exchange and the certificate
+     * signature, on the given executor instead of the worker EventBase.
+     * ClientHellos offering a PSK or early data stay on the worker, since
+     * validating their app token touches the connection state.
+     */
+    Builder&& setHandshakeOffloadExecutor(
+        std::shared_ptr<HandshakeOffloadExecutor> executor) && {
+      handshakeOffloadExecutor_ = std::move(executor);
+      return std::move(*this);
+    }
+
     std::shared_ptr<FizzServerQuicHandshakeContext> build() &&;
 
    private:
     std::shared_ptr<const fizz::server::FizzServerContext> context_;
     std::unique_ptr<CryptoFactory> cryptoFactory_;
+    std::shared_ptr<HandshakeOffloadExecutor> handshakeOffloadExecutor_;
   };
 };
 
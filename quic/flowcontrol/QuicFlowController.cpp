@@ -27,8 +27,9 @@ folly::Optional<uint64_t> calculateNewWindowUpdate(
     const TimePoint& updateTime) {
   DCHECK_LE(curReadOffset, curAdvertisedOffset);
   auto nextAdvertisedOffset = curReadOffset + windowSize;
-  if (nextAdvertisedOffset == curAdvertisedOffset) {
-    // No change in flow control
+  if (nextAdvertisedOffset <= curAdvertisedOffset) {
+    // No change in flow control, or the window shrunk and the advertised
+    // offset can't go back.
     return folly::none;
   }
   bool enoughTimeElapsed = lastSendTime && updateTime > *lastSendTime &&
@@ -64,9 +65,20 @@ inline void decrementWithOverFlowCheck(T& num, T diff) {
   num -= diff;
 }
 
+// The window to advertise, smaller when the connection's memory budget is
+// running out.
+inline uint64_t getAdvertisedWindowSize(
+    const QuicConnectionStateBase& conn,
+    uint64_t windowSize) {
+  return conn.memoryBudget ? conn.memoryBudget->scaleWindow(windowSize)
+                           : windowSize;
+}
+
 inline uint64_t calculateMaximumData(const QuicStreamState& stream) {
   return std::max(
-      stream.currentReadOffset + stream.flowControlState.windowSize,
+      stream.currentReadOffset +
+          getAdvertisedWindowSize(
+              stream.conn, stream.flowControlState.windowSize),
       stream.flowControlState.advertisedMaxOffset);
 }
 } // namespace
@@ -83,7 +95,7 @@ bool maybeSendConnWindowUpdate(
   auto newAdvertisedOffset = calculateNewWindowUpdate(
       flowControlState.sumCurReadOffset,
       flowControlState.advertisedMaxOffset,
-      flowControlState.windowSize,
+      getAdvertisedWindowSize(conn, flowControlState.windowSize),
       conn.lossState.srtt,
       conn.transportSettings,
       flowControlState.timeOfLastFlowControlUpdate,
@@ -113,7 +125,7 @@ bool maybeSendStreamWindowUpdate(
   auto newAdvertisedOffset = calculateNewWindowUpdate(
       stream.currentReadOffset,
       flowControlState.advertisedMaxOffset,
-      flowControlState.windowSize,
+      getAdvertisedWindowSize(stream.conn, flowControlState.windowSize),
       stream.conn.lossState.srtt,
       stream.conn.transportSettings,
       flowControlState.timeOfLastFlowControlUpdate,
@@ -410,7 +422,8 @@ void updateFlowControlStateWithSettings(
 
 MaxDataFrame generateMaxDataFrame(const QuicConnectionStateBase& conn) {
   return MaxDataFrame(std::max(
-      conn.flowControlState.sumCurReadOffset + conn.flowControlState.windowSize,
+      conn.flowControlState.sumCurReadOffset +
+          getAdvertisedWindowSize(conn, conn.flowControlState.windowSize),
       conn.flowControlState.advertisedMaxOffset));
 }
 
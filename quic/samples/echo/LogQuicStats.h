@@ -72,6 +72,16 @@ class LogQuicStats : public quic::QuicTransportStatsCallback {
     VLOG(2) << prefix_ << "onForwardedPacketProcessed";
   }
 
+  void onForwardedPacketBatchSent(uint32_t numPackets) override {
+    VLOG(2) << prefix_
+            << "onForwardedPacketBatchSent numPackets=" << numPackets;
+  }
+
+  void onForwardedPacketBatchReceived(uint32_t numPackets) override {
+    VLOG(2) << prefix_
+            << "onForwardedPacketBatchReceived numPackets=" << numPackets;
+  }
+
   void onClientInitialReceived(QuicVersion version) override {
     VLOG(2) << prefix_
             << "onClientInitialReceived, version: " << quic::toString(version);
@@ -81,6 +91,17 @@ class LogQuicStats : public quic::QuicTransportStatsCallback {
     VLOG(2) << prefix_ << "onConnectionRateLimited";
   }
 
+  void onConnectionAdmission(AdmissionDecision decision) override {
+    VLOG(2) << prefix_ << "onConnectionAdmission decision="
+            << toString(decision);
+  }
+
+  void onRoutingTableLookup(bool found, std::chrono::nanoseconds duration)
+      override {
+    VLOG(2) << prefix_ << "onRoutingTableLookup found=" << found
+            << " duration=" << duration.count() << "ns";
+  }
+
   // connection level metrics:
   void onNewConnection() override {
     VLOG(2) << prefix_ << "onNewConnection";
@@ -192,6 +213,58 @@ class LogQuicStats : public quic::QuicTransportStatsCallback {
     VLOG(2) << prefix_ << "onZeroRttBufferedPruned";
   }
 
+  void onRttSample(std::chrono::microseconds rtt) override {
+    VLOG(2) << prefix_ << "onRttSample rtt=" << rtt.count() << "us";
+  }
+
+  void onCwndSample(uint64_t cwndBytes) override {
+    VLOG(2) << prefix_ << "onCwndSample cwnd=" << cwndBytes;
+  }
+
+  void onWriteBurst(uint64_t numPackets) override {
+    VLOG(2) << prefix_ << "onWriteBurst packets=" << numPackets;
+  }
+
+  void onAckProcessed(std::chrono::microseconds duration) override {
+    VLOG(2) << prefix_ << "onAckProcessed duration=" << duration.count()
+            << "us";
+  }
+
+  void onHandshakeDone(std::chrono::microseconds duration) override {
+    VLOG(2) << prefix_ << "onHandshakeDone duration=" << duration.count()
+            << "us";
+  }
+
+  bool wantsLatencySamples() const override {
+    return VLOG_IS_ON(2);
+  }
+
+  void onHandshakeQueueDelay(std::chrono::microseconds delay) override {
+    VLOG(2) << prefix_ << "onHandshakeQueueDelay delay=" << delay.count()
+            << "us";
+  }
+
+  void onHandshakeOffloadRejected() override {
+    VLOG(2) << prefix_ << "onHandshakeOffloadRejected";
+  }
+
+  void onPathStateCacheLookup(bool hit) override {
+    VLOG(2) << prefix_ << "onPathStateCacheLookup hit=" << hit;
+  }
+
+  void onConnectionCompletion(
+      bool warmStarted,
+      std::chrono::microseconds duration) override {
+    VLOG(2) << prefix_ << "onConnectionCompletion warmStarted=" << warmStarted
+            << " duration=" << duration.count() << "us";
+  }
+
+  void onHotPathLatency(HotPathPhase phase, std::chrono::nanoseconds duration)
+      override {
+    VLOG(2) << prefix_ << "onHotPathLatency phase=" << toString(phase)
+            << " duration=" << duration.count() << "ns";
+  }
+
  private:
   std::string prefix_;
 };
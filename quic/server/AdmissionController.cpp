@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/AdmissionController.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+bool TokenBucketAdmissionController::TokenBucket::refill(
+    TimePoint time,
+    double rate,
+    double burst) {
+  if (!lastRefill) {
+    tokens = burst;
+  } else if (time > *lastRefill) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        time - *lastRefill);
+    tokens = std::min(burst, tokens + rate * elapsed.count() / 1000000.0);
+  }
+  if (!lastRefill || time > *lastRefill) {
+    lastRefill = time;
+  }
+  return tokens >= 1;
+}
+
+TokenBucketAdmissionController::TokenBucketAdmissionController(
+    AdmissionControlConfig config)
+    : config_(std::move(config)),
+      prefixBuckets_(std::max<size_t>(config_.maxTrackedPrefixes, 1)) {
+  CHECK_GT(config_.burst, 0);
+  CHECK_LE(config_.retryLoopTime, config_.dropLoopTime);
+}
+
+folly::IPAddress TokenBucketAdmissionController::prefixOf(
+    const folly::IPAddress& client) const {
+  if (client.isIPv4Mapped()) {
+    return client.createIPv4().mask(config_.ipv4PrefixLength);
+  }
+  return client.mask(
+      client.isV4() ? config_.ipv4PrefixLength : config_.ipv6PrefixLength);
+}
+
+AdmissionController::Decision TokenBucketAdmissionController::admit(
+    const folly::IPAddress& client,
+    TimePoint time,
+    std::chrono::microseconds loopTime) {
+  if (loopTime >= config_.dropLoopTime) {
+    return Decision::DROP;
+  }
+  if (loopTime >= config_.retryLoopTime) {
+    return Decision::RETRY;
+  }
+  TokenBucket* prefixBucket = nullptr;
+  if (config_.prefixRate > 0) {
+    auto prefix = prefixOf(client);
+    auto it = prefixBuckets_.find(prefix);
+    if (it == prefixBuckets_.end()) {
+      prefixBuckets_.insert(prefix, TokenBucket());
+      it = prefixBuckets_.find(prefix);
+    }
+    prefixBucket = &it->second;
+    if (!prefixBucket->refill(
+            time, config_.prefixRate, config_.prefixBurst)) {
+      return Decision::DROP;
+    }
+  }
+  if (!bucket_.refill(time, config_.rate, config_.burst)) {
+    return Decision::RETRY;
+  }
+  bucket_.tokens -= 1;
+  if (prefixBucket) {
+    prefixBucket->tokens -= 1;
+  }
+  return Decision::ACCEPT;
+}
+
+} // namespace quic
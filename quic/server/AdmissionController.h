@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <folly/container/EvictingCacheMap.h>
+
+#include <quic/QuicConstants.h>
+#include <quic/state/QuicTransportStatsCallback.h>
+
+namespace quic {
+
+/*
+ * Decides what a worker does with a client Initial that carries no retry
+ * token, i.e. an attempt to open a new connection whose address has not been
+ * validated yet. Unlike RateLimiter, it can tell apart "make the client prove
+ * its address" (Retry) from "do no work at all for it" (drop), and it is told
+ * how loaded the worker currently is.
+ */
+class AdmissionController {
+ public:
+  using Decision = QuicTransportStatsCallback::AdmissionDecision;
+
+  AdmissionController() = default;
+
+  virtual ~AdmissionController() = default;
+
+  /*
+   * client is the peer address of the Initial, time its receive time and
+   * loopTime how long the worker's event loop currently takes per iteration,
+   * which is how long every established connection on it waits for its
+   * packets to be processed.
+   */
+  virtual Decision admit(
+      const folly::IPAddress& client,
+      TimePoint time,
+      std::chrono::microseconds loopTime) = 0;
+};
+
+struct AdmissionControlConfig {
+  // New connections accepted per second by a worker, and how many can be
+  // accepted back to back after a quiet period.
+  double rate{1000};
+  double burst{1000};
+
+  // Same, for all the clients in one source prefix. 0 disables the per prefix
+  // limit.
+  double prefixRate{100};
+  double prefixBurst{100};
+  uint8_t ipv4PrefixLength{24};
+  uint8_t ipv6PrefixLength{48};
+  // Bounds the memory used for the per prefix buckets. Least recently seen
+  // prefixes are forgotten first.
+  size_t maxTrackedPrefixes{16 * 1024};
+
+  // Above this loop time every new connection has to go through Retry, which
+  // costs the worker one packet instead of a handshake.
+  std::chrono::microseconds retryLoopTime{5000};
+  // Above this loop time new connections are dropped without a response.
+  std::chrono::microseconds dropLoopTime{20000};
+};
+
+/*
+ * Token bucket based admission controller. In order:
+ *   - loop time above dropLoopTime: DROP.
+ *   - loop time above retryLoopTime: RETRY.
+ *   - the client's prefix is out of tokens: DROP. A single prefix opening
+ *     connections faster than prefixRate is either abusive or spoofed, and a
+ *     Retry to it would still cost a packet each.
+ *   - the worker is out of tokens: RETRY.
+ *   - otherwise ACCEPT.
+ * Tokens are only taken on ACCEPT, so that a client coming back with a retry
+ * token (which bypasses admission control) isn't charged twice.
+ */
+class TokenBucketAdmissionController : public AdmissionController {
+ public:
+  explicit TokenBucketAdmissionController(AdmissionControlConfig config);
+
+  Decision admit(
+      const folly::IPAddress& client,
+      TimePoint time,
+      std::chrono::microseconds loopTime) override;
+
+  size_t numTrackedPrefixes() const {
+    return prefixBuckets_.size();
+  }
+
+ private:
+  struct TokenBucket {
+    double tokens{0};
+    folly::Optional<TimePoint> lastRefill;
+
+    // Refills for the time elapsed since the last call and returns whether at
+    // least one token is available.
+    bool refill(TimePoint time, double rate, double burst);
+  };
+
+  folly::IPAddress prefixOf(const folly::IPAddress& client) const;
+
+  const AdmissionControlConfig config_;
+  TokenBucket bucket_;
+  folly::EvictingCacheMap<folly::IPAddress, TokenBucket> prefixBuckets_;
+};
+
+} // namespace quic
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/ConnectionIdRoutingTable.h>
+
+namespace quic {
+
+bool ConnectionIdRoutingTable::insert(
+    const ConnectionId& connId,
+    uint32_t workerIndex) {
+  return map_.insert(connId, workerIndex).second;
+}
+
+void ConnectionIdRoutingTable::erase(
+    const ConnectionId& connId,
+    uint32_t workerIndex) {
+  map_.erase_if_equal(connId, workerIndex);
+}
+
+folly::Optional<uint32_t> ConnectionIdRoutingTable::find(
+    const ConnectionId& connId) const {
+  auto it = map_.find(connId);
+  if (it == map_.cend()) {
+    return folly::none;
+  }
+  return it->second;
+}
+
+} // namespace quic
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/hash/SpookyHashV2.h>
+
+#include <quic/codec/QuicConnectionId.h>
+
+namespace quic {
+
+/**
+ * Process wide index of which worker owns each server chosen connection id.
+ *
+ * Workers add and remove their own connection ids as they are bound and
+ * unbound, and any worker can look up the owner of a packet in one probe,
+ * whatever ConnectionIdAlgo encoded in the id and however many workers there
+ * were when it was chosen. Lookups are lock free (hazard pointers), writes
+ * lock one of the map's shards.
+ */
+class ConnectionIdRoutingTable {
+ public:
+  ConnectionIdRoutingTable() = default;
+
+  /**
+   * Returns false if connId is already owned by another worker.
+   */
+  bool insert(const ConnectionId& connId, uint32_t workerIndex);
+
+  /**
+   * Removes connId only if it is still owned by workerIndex.
+   */
+  void erase(const ConnectionId& connId, uint32_t workerIndex);
+
+  folly::Optional<uint32_t> find(const ConnectionId& connId) const;
+
+  size_t size() const {
+    return map_.size();
+  }
+
+ private:
+  // The map picks its shard from the top bits of the hash, which
+  // ConnectionIdHash leaves empty.
+  struct Hash {
+    size_t operator()(const ConnectionId& connId) const {
+      return folly::hash::SpookyHashV2::Hash64(connId.data(), connId.size(), 0);
+    }
+  };
+
+  folly::ConcurrentHashMap<ConnectionId, uint32_t, Hash> map_;
+};
+
+} // namespace quic
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/PathStateCache.h>
+
+#include <quic/state/StateData.h>
+
+#include <glog/logging.h>
+
+namespace quic {
+
+PathStateCache::PathStateCache(PathStateCacheConfig config)
+    : config_(std::move(config)) {
+  CHECK_GT(config_.cwndGain, 0);
+  CHECK_LE(config_.minInitialRtt, config_.maxInitialRtt);
+  auto shardCapacity =
+      std::max<size_t>((config_.capacity + kNumShards - 1) / kNumShards, 1);
+  for (size_t i = 0; i < kNumShards; i++) {
+    shards_.push_back(std::make_unique<Shard>(shardCapacity));
+  }
+}
+
+folly::IPAddress PathStateCache::prefixOf(
+    const folly::IPAddress& client) const {
+  if (client.isIPv4Mapped()) {
+    return client.createIPv4().mask(config_.ipv4PrefixLength);
+  }
+  return client.mask(
+      client.isV4() ? config_.ipv4PrefixLength : config_.ipv6PrefixLength);
+}
+
+PathStateCache::Shard& PathStateCache::shardOf(const folly::IPAddress& prefix) {
+  return *shards_[prefix.hash() % kNumShards];
+}
+
+folly::Optional<CachedPathState> PathStateCache::get(
+    const folly::IPAddress& client,
+    TimePoint now) {
+  auto prefix = prefixOf(client);
+  auto& shard = shardOf(prefix);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto it = shard.map.find(prefix);
+  if (it == shard.map.end()) {
+    return folly::none;
+  }
+  if (now > it->second.updateTime + config_.maxAge) {
+    shard.map.erase(it);
+    return folly::none;
+  }
+  return it->second;
+}
+
+void PathStateCache::update(
+    const folly::IPAddress& client,
+    const CachedPathState& state) {
+  auto prefix = prefixOf(client);
+  auto& shard = shardOf(prefix);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  shard.map.set(prefix, state);
+}
+
+void PathStateCache::applyTo(
+    const CachedPathState& state,
+    TransportSettings& settings) const {
+  if (state.srtt > 0us) {
+    settings.initialRtt = std::min(
+        std::max(state.srtt, config_.minInitialRtt), config_.maxInitialRtt);
+  }
+  if (state.bandwidth == 0 || state.minRtt == 0us ||
+      state.minRtt == kDefaultMinRtt) {
+    return;
+  }
+  // The connection's packet size isn't known yet, assume the default one.
+  uint64_t bdpInMss = state.bandwidth * state.minRtt.count() / 1000000 /
+      kDefaultUDPSendPacketLen;
+  uint64_t cwndInMss = std::min(
+      static_cast<uint64_t>(bdpInMss * config_.cwndGain),
+      std::min(config_.maxInitCwndInMss, settings.maxCwndInMss));
+  settings.initCwndInMss = std::max(settings.initCwndInMss, cwndInMss);
+}
+
+size_t PathStateCache::size() const {
+  size_t total = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    total += shard->map.size();
+  }
+  return total;
+}
+
+uint64_t estimateBandwidth(
+    const CongestionController& congestionController,
+    std::chrono::microseconds srtt) {
+  switch (congestionController.type()) {
+    case CongestionControlType::BBR: {
+      CongestionControllerStats stats;
+      congestionController.getStats(stats);
+      return stats.bbrStats.bandwidth;
+    }
+    case CongestionControlType::BBR2: {
+      CongestionControllerStats stats;
+      congestionController.getStats(stats);
+      return stats.bbr2Stats.bandwidth;
+    }
+    default:
+      if (srtt == 0us) {
+        return 0;
+      }
+      return congestionController.getCongestionWindow() * 1000000 /
+          srtt.count();
+  }
+}
+
+} // namespace quic
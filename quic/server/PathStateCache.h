@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <folly/container/EvictingCacheMap.h>
+
+#include <quic/QuicConstants.h>
+#include <quic/state/TransportSettings.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace quic {
+
+class CongestionController;
+
+/**
+ * What the last connection to a client prefix learnt about its path.
+ */
+struct CachedPathState {
+  std::chrono::microseconds srtt{0};
+  std::chrono::microseconds minRtt{0};
+  // In bytes per second, 0 if the congestion controller had no estimate.
+  uint64_t bandwidth{0};
+  TimePoint updateTime;
+};
+
+struct PathStateCacheConfig {
+  // Least recently used prefixes are forgotten first.
+  size_t capacity{64 * 1024};
+  // Older entries are not used to warm start connections.
+  std::chrono::seconds maxAge{600};
+  uint8_t ipv4PrefixLength{24};
+  uint8_t ipv6PrefixLength{48};
+
+  // A warm started connection starts with this fraction of the cached
+  // bandwidth-delay product as its congestion window, never less than
+  // TransportSettings::initCwndInMss nor more than maxInitCwndInMss.
+  double cwndGain{0.5};
+  uint64_t maxInitCwndInMss{100};
+  // Bounds for the initial RTT taken from the cached smoothed RTT.
+  std::chrono::microseconds minInitialRtt{kGranularity};
+  std::chrono::microseconds maxInitialRtt{std::chrono::seconds(1)};
+};
+
+/**
+ * Process wide cache of the RTT and bandwidth seen by the last connection of
+ * each client prefix, so that a new connection from the same network doesn't
+ * have to rediscover them starting from initCwndInMss and initialRtt.
+ *
+ * Shared by every worker of a QuicServer: connections record their path state
+ * when they close, and the worker seeds the transport settings of new ones
+ * from it. The map is split in shards, each behind its own lock.
+ */
+class PathStateCache {
+ public:
+  explicit PathStateCache(PathStateCacheConfig config = PathStateCacheConfig());
+
+  /**
+   * Returns the state cached for client's prefix unless it is older than
+   * maxAge.
+   */
+  folly::Optional<CachedPathState> get(
+      const folly::IPAddress& client,
+      TimePoint now);
+
+  void update(const folly::IPAddress& client, const CachedPathState& state);
+
+  /**
+   * Seeds initialRtt and initCwndInMss of settings from state, within the
+   * configured caps.
+   */
+  void applyTo(const CachedPathState& state, TransportSettings& settings)
+      const;
+
+  size_t size() const;
+
+  const PathStateCacheConfig& getConfig() const {
+    return config_;
+  }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct Shard {
+    explicit Shard(size_t capacity) : map(capacity) {}
+
+    mutable std::mutex mutex;
+    folly::EvictingCacheMap<folly::IPAddress, CachedPathState> map;
+  };
+
+  folly::IPAddress prefixOf(const folly::IPAddress& client) const;
+  Shard& shardOf(const folly::IPAddress& prefix);
+
+  const PathStateCacheConfig config_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+/**
+ * Bandwidth estimate of the congestion controller in bytes per second: the
+ * one from BBR's bandwidth sampler, cwnd / srtt for the others.
+ */
+uint64_t estimateBandwidth(
+    const CongestionController& congestionController,
+    std::chrono::microseconds srtt);
+
+} // namespace quic
@@ -20,6 +20,7 @@
 #include <quic/server/QuicReusePortUDPSocketFactory.h>
 #include <quic/server/QuicServerTransport.h>
 #include <quic/server/QuicSharedUDPSocketFactory.h>
+#include <quic/server/ReusePortBpf.h>
 #include <quic/server/SlidingWindowRateLimiter.h>
 
 DEFINE_bool(
@@ -30,7 +31,8 @@ DEFINE_bool(
 namespace quic {
 namespace {
 // Determine which worker to route to
-// This **MUST** be kept in sync with the BPF program (if supplied)
+// This **MUST** be kept in sync with the BPF program (if supplied), see
+// makeReusePortBpfProgram.
 size_t getWorkerToRouteTo(
     const RoutingData& routingData,
     size_t numWorkers,
@@ -74,6 +76,29 @@ void QuicServer::setRateLimit(uint64_t count, std::chrono::seconds window) {
   rateLimit_ = folly::make_optional<RateLimit>(count, window);
 }
 
+void QuicServer::setAdmissionControl(AdmissionControlConfig config) {
+  admissionControl_ = std::move(config);
+}
+
+void QuicServer::enableConnectionIdRoutingTable(bool enabled) {
+  CHECK(!initialized_)
+      << "Routing table must be enabled before the server is initialized";
+  routingTable_ =
+      enabled ? std::make_shared<ConnectionIdRoutingTable>() : nullptr;
+}
+
+void QuicServer::setPathStateCache(std::shared_ptr<PathStateCache> cache) {
+  CHECK(!initialized_)
+      << "Path state cache must be set before the server is initialized";
+  pathStateCache_ = std::move(cache);
+}
+
+void QuicServer::enableReusePortBpf(bool enabled) {
+  CHECK(!initialized_)
+      << "Reuseport BPF must be enabled before the server is initialized";
+  reusePortBpf_ = enabled;
+}
+
 void QuicServer::setSupportedVersion(const std::vector<QuicVersion>& versions) {
   supportedVersions_ = versions;
 }
@@ -187,7 +212,18 @@ void QuicServer::initializeWorkers(
       worker->setRateLimiter(std::make_unique<SlidingWindowRateLimiter>(
           rateLimit_->count, rateLimit_->window));
     }
+    if (admissionControl_) {
+      worker->setAdmissionController(
+          std::make_unique<TokenBucketAdmissionController>(
+              *admissionControl_));
+    }
     worker->setWorkerId(i);
+    if (routingTable_) {
+      worker->setConnectionIdRoutingTable(routingTable_);
+    }
+    if (pathStateCache_) {
+      worker->setPathStateCache(pathStateCache_);
+    }
     worker->setTransportSettingsOverrideFn(transportSettingsOverrideFn_);
     workers_.push_back(std::move(worker));
     evbToWorkers_.emplace(workerEvb, workers_.back().get());
@@ -266,6 +302,10 @@ void QuicServer::bindWorkersToSocket(
               self->boundAddress_ = worker->getAddress();
             }
           }
+          if (self->inProcessCcpAgent_) {
+            worker->setInProcessCcpDatapath(
+                self->inProcessCcpAgent_->addDatapath(workerEvb));
+          }
           if (usingCCP) {
             auto serverId = self->boundAddress_.getIPAddress().hash() |
                 self->boundAddress_.getPort();
@@ -288,6 +328,18 @@ void QuicServer::bindWorkersToSocket(
               ccpInitFailed = true;
             }
           }
+          if (idx == (numWorkers - 1) && self->reusePortBpf_) {
+            // Every socket of the group is bound now, in worker order, which
+            // is the order the program's indices refer to.
+            if (dynamic_cast<DefaultConnectionIdAlgo*>(
+                    self->connIdAlgo_.get())) {
+              attachReusePortBpfProgram(
+                  folly::NetworkSocket::fromFd(worker->getFD()), numWorkers);
+            } else {
+              LOG(WARNING) << "Not attaching reuseport BPF program, it only "
+                           << "supports the DefaultConnectionIdAlgo";
+            }
+          }
           if (idx == (numWorkers - 1)) {
             VLOG(4) << "Initialized all workers in the eventbase";
             self->initialized_ = true;
@@ -428,8 +480,12 @@ void QuicServer::routeDataToWorker(
     return;
   }
 
-  auto workerToRunOn =
-      getWorkerToRouteTo(routingData, workers_.size(), connIdAlgo_.get());
+  // The receiving worker already looked the connection id up in the routing
+  // table, if enabled.
+  const auto& tableWorker = routingData.workerIndex;
+  auto workerToRunOn = tableWorker && *tableWorker < workers_.size()
+      ? *tableWorker
+      : getWorkerToRouteTo(routingData, workers_.size(), connIdAlgo_.get());
   auto& worker = workers_[workerToRunOn];
   VLOG_IF(4, !worker->getEventBase()->isInEventBaseThread())
       << " Routing to worker in different EVB, to workerId=" << workerToRunOn;
@@ -489,6 +545,9 @@ void QuicServer::shutdown(LocalErrorCode error) {
       if (usingCCP) {
         worker->getCcpReader()->shutdown();
       }
+      if (inProcessCcpAgent_ && worker->getInProcessCcpDatapath()) {
+        inProcessCcpAgent_->removeDatapath(worker->getInProcessCcpDatapath());
+      }
       workerPtr_.reset();
     });
     // protecting the erase in map with the mutex since
@@ -606,6 +665,12 @@ void QuicServer::setCcpId(uint64_t ccpId) {
   ccpId_ = ccpId;
 }
 
+void QuicServer::setInProcessCcpAgent(
+    std::shared_ptr<InProcessCcpAgent> agent) {
+  CHECK(!initialized_);
+  inProcessCcpAgent_ = std::move(agent);
+}
+
 bool QuicServer::isUsingCCP() {
   auto foundId = ccpId_ != 0;
 #ifdef CCP_ENABLED
@@ -662,6 +727,54 @@ void QuicServer::stopPacketForwarding(std::chrono::milliseconds delay) {
   }
 }
 
+std::vector<Buf> QuicServer::handoffConnections() {
+  std::vector<Buf> handoffStates;
+  if (!initialized_) {
+    return handoffStates;
+  }
+  runOnAllWorkersSync([&handoffStates](auto worker) {
+    auto workerStates = worker->handoffConnections();
+    std::move(
+        workerStates.begin(),
+        workerStates.end(),
+        std::back_inserter(handoffStates));
+  });
+  return handoffStates;
+}
+
+size_t QuicServer::resumeConnections(std::vector<Buf> handoffStates) {
+  std::lock_guard<std::mutex> guard(startMutex_);
+  if (!initialized_ || shutdown_) {
+    return 0;
+  }
+  size_t numResumed = 0;
+  for (auto& handoffState : handoffStates) {
+    auto state = decodeConnectionHandoffState(*handoffState);
+    if (!state) {
+      LOG(ERROR) << "Failed to decode connection handoff state";
+      continue;
+    }
+    // Route it where its packets will be routed.
+    auto connIdParams =
+        connIdAlgo_->parseConnectionId(state->serverConnectionId);
+    if (connIdParams.hasError()) {
+      LOG(ERROR) << "Cannot route handed off connection, CID="
+                 << state->serverConnectionId;
+      continue;
+    }
+    auto& worker = workers_[connIdParams->workerId % workers_.size()];
+    worker->getEventBase()->runImmediatelyOrRunInEventBaseThreadAndWait(
+        [&] {
+          if (worker->resumeConnection(std::move(*state))) {
+            numResumed++;
+          }
+        });
+  }
+  VLOG(2) << "Resumed " << numResumed << " of " << handoffStates.size()
+          << " handed off connections";
+  return numResumed;
+}
+
 void QuicServer::setTransportStatsCallbackFactory(
     std::unique_ptr<QuicTransportStatsCallbackFactory> statsFactory) {
   CHECK(statsFactory);
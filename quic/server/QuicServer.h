@@ -102,6 +102,40 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
 
   void setRateLimit(uint64_t count, std::chrono::seconds window);
 
+  /**
+   * Enable token bucket and load based admission control of new connections.
+   * Every worker gets its own controller with the given config, so the rates
+   * are per worker.
+   */
+  void setAdmissionControl(AdmissionControlConfig config);
+
+  /**
+   * Keep a process wide index from connection id to worker, and use it to
+   * route packets instead of the worker id encoded in the connection id when
+   * it knows the connection. This saves a hop between workers when the
+   * encoded worker id is stale (e.g. the number of workers changed) or when
+   * the ConnectionIdAlgo doesn't encode it. Must be called before
+   * initialize().
+   */
+  void enableConnectionIdRoutingTable(bool enabled);
+
+  /**
+   * Share cache between the workers: closing connections record the RTT and
+   * bandwidth of their client's prefix in it, and new connections from that
+   * prefix start with an initial RTT, congestion window and pacing rate
+   * derived from them. Must be called before initialize().
+   */
+  void setPathStateCache(std::shared_ptr<PathStateCache> cache);
+
+  /**
+   * Attach a classic BPF program to the listening sockets so that the kernel
+   * delivers short header packets straight to the worker encoded in their
+   * connection id, instead of hashing them to a random worker which then
+   * forwards them. Only used with the DefaultConnectionIdAlgo, whose layout
+   * the program mirrors. Must be called before initialize().
+   */
+  void enableReusePortBpf(bool enabled);
+
   /**
    * Set list of supported QUICVersion for this server. These versions will be
    * used during the 'Version-Negotiation' phase with the client.
@@ -184,6 +218,15 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
    */
   void setCcpId(uint64_t ccpId);
 
+  /**
+   * Run CCP in this process: connections using the CCP congestion control
+   * type report to agent through each worker's InProcessCcpDatapath instead
+   * of talking to an external CCP. Must be called before start(), and the
+   * app is responsible for starting and stopping the agent, which must
+   * outlive the server.
+   */
+  void setInProcessCcpAgent(std::shared_ptr<InProcessCcpAgent> agent);
+
   /**
    * Tells the server to start rejecting any new connection
    */
@@ -275,6 +318,24 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
    */
   void stopPacketForwarding(std::chrono::milliseconds delay);
 
+  /*
+   * Hands off the quiescent connections of all workers to the server taking
+   * over. The returned states are opaque and are meant to be passed to
+   * resumeConnections() in the other process, the same way the listening
+   * sockets are. Handed off connections close silently, the others keep
+   * running and have their packets forwarded as usual.
+   * Note that this method cannot be called on a worker's thread.
+   */
+  std::vector<Buf> handoffConnections();
+
+  /*
+   * Resumes the connections handed off by the server being taken over, each on
+   * the worker its packets are routed to. Returns the number of connections
+   * resumed, the states that cannot be decoded or routed are dropped.
+   * Note that this method cannot be called on a worker's thread.
+   */
+  size_t resumeConnections(std::vector<Buf> handoffStates);
+
   /**
    * Set takenover socket fds for the quic server from another process.
    * Quic server calls ::dup for each fd and will not bind to the address for
@@ -433,6 +494,7 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
   uint32_t hostId_{0};
   ConnectionIdVersion cidVersion_{ConnectionIdVersion::V1};
   bool rejectNewConnections_{false};
+  bool reusePortBpf_{false};
   // factory to create per worker QuicTransportStatsCallback
   std::unique_ptr<QuicTransportStatsCallbackFactory> transportStatsFactory_;
   // factory to create per worker ConnectionIdAlgo
@@ -451,6 +513,9 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
     std::chrono::seconds window;
   };
   folly::Optional<RateLimit> rateLimit_;
+  folly::Optional<AdmissionControlConfig> admissionControl_;
+  std::shared_ptr<ConnectionIdRoutingTable> routingTable_;
+  std::shared_ptr<PathStateCache> pathStateCache_;
 
   // Options to AsyncUDPSocket::bind, only controls IPV6_ONLY currently.
   folly::AsyncUDPSocket::BindOptions bindOptions_;
@@ -462,6 +527,7 @@ class QuicServer : public QuicServerWorker::WorkerCallback,
   // in case there are multiple concurrent instances (e.g. when proxygen is
   // migrating connections and there are two concurrent instances of proxygen)
   uint64_t ccpId_{0};
+  std::shared_ptr<InProcessCcpAgent> inProcessCcpAgent_;
 };
 
 } // namespace quic
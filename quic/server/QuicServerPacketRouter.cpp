@@ -104,6 +104,81 @@ void TakeoverHandlerCallback::onDataAvailable(
   takeoverPktHandler_.processForwardedPacket(client, std::move(data));
 }
 
+bool TakeoverHandlerCallback::shouldOnlyNotify() {
+  return transportSettings_.maxForwardedPacketBatchSize > 1;
+}
+
+void TakeoverHandlerCallback::onNotifyDataAvailable(
+    folly::AsyncUDPSocket& sock) noexcept {
+  const size_t numPackets = transportSettings_.maxForwardedPacketBatchSize;
+  const size_t readBufferSize = transportSettings_.maxRecvPacketSize +
+      kMaxBufSizeForTakeoverEncapsulation;
+  recvmmsgStorage_.resize(numPackets);
+  auto& msgs = recvmmsgStorage_.msgs;
+  auto& addrs = recvmmsgStorage_.addrs;
+  auto& readBuffers = recvmmsgStorage_.readBuffers;
+  auto& iovecs = recvmmsgStorage_.iovecs;
+  for (size_t i = 0; i < numPackets; ++i) {
+    // Buffers not handed out by the previous call are reused as is.
+    if (!readBuffers[i]) {
+      readBuffers[i] = folly::IOBuf::create(readBufferSize);
+    }
+    iovecs[i].iov_base = readBuffers[i]->writableData();
+    iovecs[i].iov_len = readBufferSize;
+
+    auto* rawAddr = reinterpret_cast<sockaddr*>(&addrs[i]);
+    rawAddr->sa_family = sock.address().getFamily();
+
+    struct msghdr* msg = &msgs[i].msg_hdr;
+    msg->msg_name = rawAddr;
+    msg->msg_namelen = sizeof(struct sockaddr_storage);
+    msg->msg_iov = &iovecs[i];
+    msg->msg_iovlen = 1;
+    msg->msg_control = nullptr;
+    msg->msg_controllen = 0;
+    msg->msg_flags = 0;
+  }
+
+  int numMsgsRecvd = sock.recvmmsg(msgs.data(), numPackets, 0, nullptr);
+  if (numMsgsRecvd < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      // The socket will notify us again when it is readable.
+      return;
+    }
+    return onReadError(folly::AsyncSocketException(
+        folly::AsyncSocketException::INTERNAL_ERROR,
+        "::recvmmsg() failed",
+        errno));
+  }
+  VLOG(10) << "Worker=" << this << " Received " << numMsgsRecvd
+           << " (takeover) packets on thread=" << folly::getCurrentThreadID()
+           << ", workerId=" << static_cast<uint32_t>(worker_->getWorkerId())
+           << ", processId=" << static_cast<uint32_t>(worker_->getProcessId());
+  QUIC_STATS(
+      worker_->getStatsCallback(),
+      onForwardedPacketBatchReceived,
+      numMsgsRecvd);
+  for (int i = 0; i < numMsgsRecvd; ++i) {
+    QUIC_STATS(worker_->getStatsCallback(), onForwardedPacketReceived);
+    const auto& msg = msgs[i].msg_hdr;
+    if (msg.msg_flags & MSG_TRUNC) {
+      // This is an error, drop the packet and keep its buffer.
+      continue;
+    }
+    folly::SocketAddress client;
+    try {
+      client.setFromSockaddr(
+          reinterpret_cast<sockaddr*>(&addrs[i]), msg.msg_namelen);
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Invalid forwarding peer address ex=" << ex.what();
+      continue;
+    }
+    Buf data = std::move(readBuffers[i]);
+    data->append(msgs[i].msg_len);
+    takeoverPktHandler_.processForwardedPacket(client, std::move(data));
+  }
+}
+
 void TakeoverHandlerCallback::onReadError(
     const folly::AsyncSocketException& ex) noexcept {
   folly::DelayedDestruction::DestructorGuard dg(this);
@@ -153,6 +228,9 @@ TakeoverPacketHandler::TakeoverPacketHandler(QuicServerWorker* worker)
     : worker_(worker) {}
 
 TakeoverPacketHandler::~TakeoverPacketHandler() {
+  // The worker and its stats may be gone already, drop what is pending.
+  cancelLoopCallback();
+  pendingPackets_.clear();
   stop();
 }
 
@@ -160,6 +238,13 @@ void TakeoverPacketHandler::setSocketFactory(QuicUDPSocketFactory* factory) {
   socketFactory_ = factory;
 }
 
+void TakeoverPacketHandler::setMaxBatchSize(size_t maxBatchSize) {
+  maxBatchSize_ = maxBatchSize;
+  if (pendingPackets_.size() >= maxBatchSize_) {
+    flush();
+  }
+}
+
 void TakeoverPacketHandler::forwardPacket(Buf writeBuffer) {
   if (!pktForwardingSocket_) {
     CHECK(socketFactory_);
@@ -168,7 +253,52 @@ void TakeoverPacketHandler::forwardPacket(Buf writeBuffer) {
     localAddress.setFromHostPort("::1", 0);
     pktForwardingSocket_->bind(localAddress);
   }
-  pktForwardingSocket_->write(pktForwardDestAddr_, std::move(writeBuffer));
+  if (maxBatchSize_ <= 1) {
+    pktForwardingSocket_->write(pktForwardDestAddr_, std::move(writeBuffer));
+    QUIC_STATS(worker_->getStatsCallback(), onForwardedPacketBatchSent, 1);
+    return;
+  }
+  pendingPackets_.push_back(std::move(writeBuffer));
+  if (pendingPackets_.size() >= maxBatchSize_) {
+    flush();
+    return;
+  }
+  if (!isLoopCallbackScheduled()) {
+    worker_->getEventBase()->runInLoop(this);
+  }
+}
+
+void TakeoverPacketHandler::flush() {
+  cancelLoopCallback();
+  if (pendingPackets_.empty()) {
+    return;
+  }
+  CHECK(pktForwardingSocket_);
+  // Every packet carries its own takeover header, they can't be coalesced
+  // with GSO since they are not the same size.
+  int ret;
+  if (pendingPackets_.size() == 1) {
+    ret = pktForwardingSocket_->write(pktForwardDestAddr_, pendingPackets_[0]);
+    ret = ret < 0 ? -1 : 1;
+  } else {
+    ret = pktForwardingSocket_->writem(
+        folly::range(&pktForwardDestAddr_, &pktForwardDestAddr_ + 1),
+        pendingPackets_.data(),
+        pendingPackets_.size());
+  }
+  if (ret < static_cast<int>(pendingPackets_.size())) {
+    // Same as any other UDP write failure, the peer retransmits.
+    VLOG(4) << "Forwarded packets dropped on write, sent=" << ret
+            << " pending=" << pendingPackets_.size();
+  }
+  if (ret > 0) {
+    QUIC_STATS(worker_->getStatsCallback(), onForwardedPacketBatchSent, ret);
+  }
+  pendingPackets_.clear();
+}
+
+void TakeoverPacketHandler::runLoopCallback() noexcept {
+  flush();
 }
 
 std::unique_ptr<folly::AsyncUDPSocket> TakeoverPacketHandler::makeSocket(
@@ -250,6 +380,7 @@ void TakeoverPacketHandler::processForwardedPacket(
 }
 
 void TakeoverPacketHandler::stop() {
+  flush();
   packetForwardingEnabled_ = false;
   pktForwardingSocket_.reset();
 }
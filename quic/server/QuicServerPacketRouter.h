@@ -9,12 +9,14 @@
 #pragma once
 
 #include <folly/io/async/AsyncUDPSocket.h>
+#include <folly/io/async/EventBase.h>
 
 #include <quic/QuicConstants.h>
 #include <quic/codec/ConnectionIdAlgo.h>
 #include <quic/server/QuicServerTransportFactory.h>
 #include <quic/server/QuicUDPSocketFactory.h>
 #include <quic/state/QuicTransportStatsCallback.h>
+#include <quic/state/StateData.h>
 
 namespace quic {
 class QuicServerWorker;
@@ -46,6 +48,10 @@ struct RoutingData {
   // Source connection may not be present for short header packets.
   folly::Optional<ConnectionId> sourceConnId;
 
+  // Worker owning destinationConnId in the connection id routing table, if
+  // the table is enabled and has it.
+  folly::Optional<uint32_t> workerIndex;
+
   RoutingData(
       HeaderForm headerFormIn,
       bool isInitialIn,
@@ -67,14 +73,22 @@ struct RoutingData {
  * It's purpose is to forward the packets belonging to
  * another quic server (on the same host) and process the packets forwarded by
  * another quic server.
+ *
+ * Forwarded packets are queued and written out with one sendmmsg at the end
+ * of the event loop iteration, or as soon as maxBatchSize of them are pending.
  */
-class TakeoverPacketHandler {
+class TakeoverPacketHandler : public folly::EventBase::LoopCallback {
  public:
   explicit TakeoverPacketHandler(QuicServerWorker* worker);
-  virtual ~TakeoverPacketHandler();
+  virtual ~TakeoverPacketHandler() override;
 
   void setSocketFactory(QuicUDPSocketFactory* factory);
 
+  /**
+   * With a maxBatchSize of 1 or less every packet is forwarded immediately.
+   */
+  void setMaxBatchSize(size_t maxBatchSize);
+
   void setDestination(const folly::SocketAddress& destAddr);
 
   void forwardPacketToAnotherServer(
@@ -84,8 +98,15 @@ class TakeoverPacketHandler {
 
   void processForwardedPacket(const folly::SocketAddress& client, Buf data);
 
+  /**
+   * Writes out every pending forwarded packet.
+   */
+  void flush();
+
   void stop();
 
+  void runLoopCallback() noexcept override;
+
   TakeoverProtocolVersion getTakeoverProtocolVersion() const noexcept {
     return TakeoverProtocolVersion::V0;
   }
@@ -104,6 +125,8 @@ class TakeoverPacketHandler {
   std::unique_ptr<folly::AsyncUDPSocket> pktForwardingSocket_;
   bool packetForwardingEnabled_{false};
   QuicUDPSocketFactory* socketFactory_{nullptr};
+  size_t maxBatchSize_{1};
+  std::vector<Buf> pendingPackets_;
 };
 
 /**
@@ -143,6 +166,11 @@ class TakeoverHandlerCallback : public folly::AsyncUDPSocket::ReadCallback,
   // AsyncUDPSocket ReadCallback methods
   void getReadBuffer(void** buf, size_t* len) noexcept override;
 
+  // Reads forwarded packets with recvmmsg when batching is enabled.
+  bool shouldOnlyNotify() override;
+
+  void onNotifyDataAvailable(folly::AsyncUDPSocket& sock) noexcept override;
+
   void onDataAvailable(
       const folly::SocketAddress& client,
       size_t len,
@@ -162,5 +190,6 @@ class TakeoverHandlerCallback : public folly::AsyncUDPSocket::ReadCallback,
   folly::SocketAddress address_;
   std::unique_ptr<folly::AsyncUDPSocket> socket_;
   Buf readBuffer_;
+  RecvmmsgStorage recvmmsgStorage_;
 };
 } // namespace quic
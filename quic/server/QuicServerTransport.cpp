@@ -9,10 +9,12 @@
 #include <quic/server/QuicServerTransport.h>
 
 #include <quic/common/WindowedCounter.h>
+#include <quic/congestion_control/CarefulResume.h>
 #include <quic/d6d/BinarySearchProbeSizeRaiser.h>
 #include <quic/d6d/ConstantStepProbeSizeRaiser.h>
 #include <quic/dsr/frontend/WriteFunctions.h>
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/server/PathStateCache.h>
 #include <quic/server/handshake/AppToken.h>
 #include <quic/server/handshake/DefaultAppTokenValidator.h>
 #include <quic/server/handshake/StatelessResetGenerator.h>
@@ -130,6 +132,7 @@ void QuicServerTransport::onReadData(
   bool waitingForFirstPacket = !hasReceivedPackets(*conn_);
   onServerReadData(*serverConn_, readData);
   processPendingData(true);
+  maybeUpdateMemoryUsage();
 
   if (closeState_ == CloseState::CLOSED) {
     return;
@@ -145,6 +148,7 @@ void QuicServerTransport::onReadData(
     connCallback_->onFirstPeerPacketProcessed();
   }
   maybeWriteNewSessionTicket();
+  maybeStartCarefulResume();
   maybeNotifyConnectionIdBound();
   maybeIssueConnectionIds();
   maybeStartD6DProbing();
@@ -153,10 +157,59 @@ void QuicServerTransport::onReadData(
 
 void QuicServerTransport::accept() {
   setIdleTimer();
+  updateFlowControlStateWithSettings(
+      conn_->flowControlState, conn_->transportSettings);
+  auto appTokenValidator =
+      std::make_unique<DefaultAppTokenValidator>(serverConn_);
+  appTokenValidator_ = appTokenValidator.get();
+  serverConn_->serverHandshakeLayer->initialize(
+      evb_, this, std::move(appTokenValidator));
+}
+
+std::unique_ptr<folly::IOBuf> QuicServerTransport::handoff() {
+  if (closeState_ != CloseState::OPEN) {
+    return nullptr;
+  }
+  auto state = getConnectionHandoffState(*serverConn_);
+  if (!state) {
+    return nullptr;
+  }
+  auto buf = encodeConnectionHandoffState(*state);
+  // The peer keeps talking to the new process, it must not see a close.
+  closeImpl(
+      std::make_pair(
+          QuicErrorCode(LocalErrorCode::CONNECTION_ABANDONED),
+          std::string("Connection handed off")),
+      false /* drainConnection */,
+      false /* sendCloseImmediately */);
+  return buf;
+}
+
+bool QuicServerTransport::resumeFromHandoff(ConnectionHandoffState state) {
+  CHECK(routingCb_);
   updateFlowControlStateWithSettings(
       conn_->flowControlState, conn_->transportSettings);
   serverConn_->serverHandshakeLayer->initialize(
       evb_, this, std::make_unique<DefaultAppTokenValidator>(serverConn_));
+  if (!restoreConnectionHandoffState(*serverConn_, std::move(state))) {
+    // None of its connection ids were bound, there is nothing to unbind.
+    setRoutingCallback(nullptr);
+    return false;
+  }
+  // Everything these notify about or send has already happened in the old
+  // process.
+  notifiedRouting_ = true;
+  notifiedConnIdBound_ = true;
+  newSessionTicketWritten_ = true;
+  // There is no fizz state machine to write a ticket with either.
+  pathTicketWritten_ = true;
+  connectionIdsIssued_ = true;
+  for (const auto& connIdData : conn_->selfConnectionIds) {
+    routingCb_->onConnectionIdAvailable(shared_from_this(), connIdData.connId);
+  }
+  setIdleTimer();
+  maybeNotifyTransportReady();
+  return true;
 }
 
 void QuicServerTransport::writeData() {
@@ -219,15 +272,15 @@ void QuicServerTransport::writeData() {
     }
     return;
   }
-  uint64_t packetLimit =
-      (isConnectionPaced(*conn_)
-           ? conn_->pacer->updateAndGetWriteBatchSize(Clock::now())
-           : conn_->transportSettings.writeConnectionDataPacketsLimit);
+  uint64_t packetLimit = getWriteDataPacketsLimit(*conn_);
   // At the end of this function, clear out any probe packets credit we didn't
   // use.
   SCOPE_EXIT {
     conn_->pendingEvents.numProbePackets = {};
   };
+  SCOPE_EXIT {
+    maybeUpdateMemoryUsage();
+  };
   if (conn_->initialWriteCipher) {
     auto& initialCryptoStream =
         *getCryptoStream(*conn_->cryptoState, EncryptionLevel::Initial);
@@ -329,10 +382,12 @@ void QuicServerTransport::closeTransport() {
   // Clear out pending data.
   serverConn_->pendingZeroRttData.reset();
   serverConn_->pendingOneRttData.reset();
+  maybeUpdatePathStateCache();
   onServerClose(*serverConn_);
 }
 
 void QuicServerTransport::unbindConnection() {
+  releaseMemoryUsage(*conn_);
   if (routingCb_) {
     auto routingCb = routingCb_;
     routingCb_ = nullptr;
@@ -386,6 +441,7 @@ void QuicServerTransport::onCryptoEventAvailable() noexcept {
       return;
     }
     maybeWriteNewSessionTicket();
+    maybeStartCarefulResume();
     maybeNotifyConnectionIdBound();
     maybeIssueConnectionIds();
     writeSocketData();
@@ -472,38 +528,76 @@ void QuicServerTransport::processPendingData(bool async) {
 }
 
 void QuicServerTransport::maybeWriteNewSessionTicket() {
-  if (!newSessionTicketWritten_ && !ctx_->getSendNewSessionTicket() &&
-      serverConn_->serverHandshakeLayer->isHandshakeDone()) {
-    if (conn_->qLogger) {
-      conn_->qLogger->addTransportStateUpdate(kWriteNst);
-    }
+  if (ctx_->getSendNewSessionTicket() ||
+      !serverConn_->serverHandshakeLayer->isHandshakeDone()) {
+    return;
+  }
+  if (!newSessionTicketWritten_) {
     newSessionTicketWritten_ = true;
-    AppToken appToken;
-    appToken.transportParams = createTicketTransportParameters(
-        conn_->transportSettings.idleTimeout.count(),
-        conn_->transportSettings.maxRecvPacketSize,
-        conn_->transportSettings.advertisedInitialConnectionWindowSize,
-        conn_->transportSettings.advertisedInitialBidiLocalStreamWindowSize,
-        conn_->transportSettings.advertisedInitialBidiRemoteStreamWindowSize,
-        conn_->transportSettings.advertisedInitialUniStreamWindowSize,
-        conn_->transportSettings.advertisedInitialMaxStreamsBidi,
-        conn_->transportSettings.advertisedInitialMaxStreamsUni);
-    appToken.sourceAddresses = serverConn_->tokenSourceAddresses;
-    appToken.version = conn_->version.value();
-    // If a client connects to server for the first time and doesn't attempt
-    // early data, tokenSourceAddresses will not be set because
-    // validateAndUpdateSourceAddressToken is not called in this case.
-    // So checking if source address token is empty here and adding peerAddr
-    // if so.
-    // TODO accumulate recent source tokens
-    if (appToken.sourceAddresses.empty()) {
-      appToken.sourceAddresses.push_back(conn_->peerAddress.getIPAddress());
-    }
-    if (conn_->earlyDataAppParamsGetter) {
-      appToken.appParams = conn_->earlyDataAppParamsGetter();
-    }
-    serverConn_->serverHandshakeLayer->writeNewSessionTicket(appToken);
+    writeNewSessionTicket();
+    return;
+  }
+  // Send the path measured so far to the client in a second ticket.
+  const auto& carefulResume = conn_->transportSettings.carefulResume;
+  if (carefulResume.enabled && !pathTicketWritten_ &&
+      conn_->lossState.totalBytesAcked >= carefulResume.ticketRefreshBytes) {
+    pathTicketWritten_ = true;
+    writeNewSessionTicket();
+  }
+}
+
+void QuicServerTransport::writeNewSessionTicket() {
+  if (conn_->qLogger) {
+    conn_->qLogger->addTransportStateUpdate(kWriteNst);
+  }
+  AppToken appToken;
+  appToken.transportParams = createTicketTransportParameters(
+      conn_->transportSettings.idleTimeout.count(),
+      conn_->transportSettings.maxRecvPacketSize,
+      conn_->transportSettings.advertisedInitialConnectionWindowSize,
+      conn_->transportSettings.advertisedInitialBidiLocalStreamWindowSize,
+      conn_->transportSettings.advertisedInitialBidiRemoteStreamWindowSize,
+      conn_->transportSettings.advertisedInitialUniStreamWindowSize,
+      conn_->transportSettings.advertisedInitialMaxStreamsBidi,
+      conn_->transportSettings.advertisedInitialMaxStreamsUni);
+  appToken.sourceAddresses = serverConn_->tokenSourceAddresses;
+  appToken.version = conn_->version.value();
+  // If a client connects to server for the first time and doesn't attempt
+  // early data, tokenSourceAddresses will not be set because
+  // validateAndUpdateSourceAddressToken is not called in this case.
+  // So checking if source address token is empty here and adding peerAddr
+  // if so.
+  // TODO accumulate recent source tokens
+  if (appToken.sourceAddresses.empty()) {
+    appToken.sourceAddresses.push_back(conn_->peerAddress.getIPAddress());
+  }
+  if (conn_->earlyDataAppParamsGetter) {
+    appToken.appParams = conn_->earlyDataAppParamsGetter();
+  }
+  if (conn_->transportSettings.carefulResume.enabled &&
+      conn_->congestionController && conn_->lossState.srtt > 0us &&
+      conn_->lossState.mrtt != kDefaultMinRtt) {
+    appToken.bandwidth = estimateBandwidth(
+        *conn_->congestionController, conn_->lossState.srtt);
+    appToken.minRtt = conn_->lossState.mrtt;
+  }
+  serverConn_->serverHandshakeLayer->writeNewSessionTicket(appToken);
+}
+
+void QuicServerTransport::maybeStartCarefulResume() {
+  if (carefulResumeStarted_ || !appTokenValidator_ ||
+      !appTokenValidator_->getResumedPath() || !conn_->congestionController) {
+    return;
   }
+  carefulResumeStarted_ = true;
+  const auto& resumedPath = *appTokenValidator_->getResumedPath();
+  serverConn_->resumedBandwidth = resumedPath.bandwidth;
+  serverConn_->resumedMinRtt = resumedPath.minRtt;
+  conn_->congestionController = std::make_unique<CarefulResume>(
+      *conn_,
+      std::move(conn_->congestionController),
+      serverConn_->resumedBandwidth,
+      serverConn_->resumedMinRtt);
 }
 
 void QuicServerTransport::maybeNotifyConnectionIdBound() {
@@ -549,6 +643,33 @@ void QuicServerTransport::maybeIssueConnectionIds() {
   }
 }
 
+void QuicServerTransport::setMemoryBudget(MemoryBudget* memoryBudget) {
+  releaseMemoryUsage(*conn_);
+  conn_->memoryBudget = memoryBudget;
+  maybeUpdateMemoryUsage();
+}
+
+void QuicServerTransport::maybeUpdateMemoryUsage() {
+  if (!conn_->memoryBudget) {
+    return;
+  }
+  // Packets waiting for their keys are buffered outside of the streams.
+  uint64_t pendingBytes = 0;
+  for (const auto* pendingData :
+       {serverConn_->pendingZeroRttData.get(),
+        serverConn_->pendingOneRttData.get()}) {
+    if (!pendingData) {
+      continue;
+    }
+    for (const auto& readData : *pendingData) {
+      if (readData.networkData.data) {
+        pendingBytes += readData.networkData.data->computeChainDataLength();
+      }
+    }
+  }
+  updateMemoryUsage(*conn_, pendingBytes);
+}
+
 void QuicServerTransport::maybeNotifyTransportReady() {
   if (!transportReadyNotified_ && connCallback_ && hasWriteCipher()) {
     if (conn_->qLogger) {
@@ -609,6 +730,51 @@ void QuicServerTransport::setCcpDatapath(struct ccp_datapath* datapath) {
 }
 #endif
 
+void QuicServerTransport::setInProcessCcpDatapath(
+    InProcessCcpDatapath* datapath) {
+  serverConn_->inProcessCcpDatapath = datapath;
+}
+
+void QuicServerTransport::setPathStateCache(
+    PathStateCache* cache,
+    bool warmStarted) {
+  serverConn_->pathStateCache = cache;
+  serverConn_->warmStarted = warmStarted;
+  if (warmStarted && conn_->pacer) {
+    // Spread the larger initial window over one cached RTT instead of
+    // sending it in a single burst.
+    conn_->pacer->refreshPacingRate(
+        conn_->transportSettings.initCwndInMss * conn_->udpSendPacketLen,
+        conn_->transportSettings.initialRtt);
+  }
+}
+
+void QuicServerTransport::maybeUpdatePathStateCache() {
+  auto cache = serverConn_->pathStateCache;
+  if (!cache) {
+    return;
+  }
+  if (conn_->lossState.lastAckedTime) {
+    QUIC_STATS(
+        conn_->statsCallback,
+        onConnectionCompletion,
+        serverConn_->warmStarted,
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            *conn_->lossState.lastAckedTime - conn_->connectionTime));
+  }
+  if (conn_->lossState.srtt == 0us || !conn_->congestionController) {
+    // Nothing was learnt about the path.
+    return;
+  }
+  CachedPathState state;
+  state.srtt = conn_->lossState.srtt;
+  state.minRtt = conn_->lossState.mrtt;
+  state.bandwidth =
+      estimateBandwidth(*conn_->congestionController, conn_->lossState.srtt);
+  state.updateTime = Clock::now();
+  cache->update(conn_->peerAddress.getIPAddress(), state);
+}
+
 const std::shared_ptr<const folly::AsyncTransportCertificate>
 QuicServerTransport::getPeerCertificate() const {
   const auto handshakeLayer = serverConn_->serverHandshakeLayer;
@@ -671,9 +837,9 @@ void QuicServerTransport::registerAllTransportKnobParamHandlers() {
           return;
         }
         if (cctype == CongestionControlType::CCP) {
-          bool ccpAvailable = false;
+          bool ccpAvailable = server_conn->inProcessCcpDatapath != nullptr;
 #ifdef CCP_ENABLED
-          ccpAvailable = server_conn->ccpDatapath != nullptr;
+          ccpAvailable |= server_conn->ccpDatapath != nullptr;
 #endif
           if (!ccpAvailable) {
             LOG(ERROR) << "ccp not enabled on this server";
@@ -13,7 +13,9 @@
 #include <quic/codec/ConnectionIdAlgo.h>
 #include <quic/common/TransportKnobs.h>
 #include <quic/congestion_control/CongestionControllerFactory.h>
+#include <quic/server/handshake/DefaultAppTokenValidator.h>
 #include <quic/server/handshake/ServerTransportParametersExtension.h>
+#include <quic/server/state/ConnectionHandoff.h>
 #include <quic/server/state/ServerConnectionIdRejector.h>
 #include <quic/server/state/ServerStateMachine.h>
 #include <quic/state/QuicTransportStatsCallback.h>
@@ -101,6 +103,12 @@ class QuicServerTransport
 
   void setClientChosenDestConnectionId(const ConnectionId& serverCid);
 
+  /**
+   * Set the budget shared by this connection with the other connections of
+   * its worker for the bytes they buffer.
+   */
+  void setMemoryBudget(MemoryBudget* memoryBudget);
+
   // From QuicTransportBase
   void onReadData(
       const folly::SocketAddress& peer,
@@ -118,6 +126,25 @@ class QuicServerTransport
 
   virtual void accept();
 
+  /**
+   * Exports the state of this connection and closes it without notifying the
+   * peer, so that another process can resume it with resumeFromHandoff().
+   * Returns nullptr, leaving the connection untouched, if it is not
+   * quiescent. Idle streams are handed off with the connection, the
+   * application hands off its own state for them alongside.
+   */
+  virtual std::unique_ptr<folly::IOBuf> handoff();
+
+  /**
+   * Used instead of accept() on a transport resuming a connection handed off
+   * by another process. Transport settings, ConnectionIdAlgo and routing
+   * callback must be set already. Returns false if the state cannot be
+   * restored, the transport must then be dropped. The streams handed off
+   * exist once this returns, the application sets its callbacks on them
+   * again.
+   */
+  virtual bool resumeFromHandoff(ConnectionHandoffState state);
+
   virtual void setBufAccessor(BufAccessor* bufAccessor);
 
 #ifdef CCP_ENABLED
@@ -129,6 +156,19 @@ class QuicServerTransport
   void setCcpDatapath(struct ccp_datapath* datapath);
 #endif
 
+  /*
+   * Has connections using the CCP congestion control algorithm report to an
+   * in-process CCP agent through datapath, which has to outlive them.
+   */
+  void setInProcessCcpDatapath(InProcessCcpDatapath* datapath);
+
+  /*
+   * Has the connection record its path state in cache when it closes. Called
+   * after setTransportSettings(), warmStarted tells whether the settings were
+   * seeded from the cache, in which case the pacer is too.
+   */
+  void setPathStateCache(PathStateCache* cache, bool warmStarted);
+
   const std::shared_ptr<const folly::AsyncTransportCertificate>
   getPeerCertificate() const override;
 
@@ -148,11 +188,15 @@ class QuicServerTransport
  private:
   void processPendingData(bool async);
   void maybeNotifyTransportReady();
+  void maybeUpdateMemoryUsage();
   void maybeNotifyConnectionIdBound();
   void maybeWriteNewSessionTicket();
+  void writeNewSessionTicket();
+  void maybeStartCarefulResume();
   void maybeIssueConnectionIds();
   bool hasReadCipher() const;
   void maybeStartD6DProbing();
+  void maybeUpdatePathStateCache();
   void registerAllTransportKnobParamHandlers();
 
  private:
@@ -161,8 +205,14 @@ class QuicServerTransport
   bool notifiedRouting_{false};
   bool notifiedConnIdBound_{false};
   bool newSessionTicketWritten_{false};
+  // Whether the second ticket, carrying the path measured after the
+  // handshake, was written.
+  bool pathTicketWritten_{false};
+  bool carefulResumeStarted_{false};
   bool connectionIdsIssued_{false};
   QuicServerConnectionState* serverConn_;
+  // Owned by the handshake layer, only set on accepted connections.
+  const DefaultAppTokenValidator* appTokenValidator_{nullptr};
   std::unordered_map<
       uint64_t,
       std::function<void(QuicServerConnectionState*, uint64_t)>>
@@ -12,6 +12,7 @@
 #include <folly/io/SocketOptionMap.h>
 #include <folly/system/ThreadId.h>
 #include <quic/QuicConstants.h>
+#include <quic/api/QuicBatchWriter.h>
 #include <quic/common/SocketUtil.h>
 #include <quic/common/Timers.h>
 
@@ -51,6 +52,8 @@ folly::EventBase* QuicServerWorker::getEventBase() const {
 
 void QuicServerWorker::setSocket(
     std::unique_ptr<folly::AsyncUDPSocket> socket) {
+  statelessResponseWriter_.flush();
+  statelessResetGenerator_.reset();
   socket_ = std::move(socket);
   evb_ = socket_->getEventBase();
 }
@@ -73,6 +76,7 @@ void QuicServerWorker::bind(
         folly::SocketOptionKey::ApplyPos::PRE_BIND);
   }
   socket_->bind(address, bindOptions);
+  statelessResetGenerator_.reset();
   if (socketOptions_) {
     applySocketOptions(
         *socket_.get(),
@@ -142,12 +146,46 @@ void QuicServerWorker::setRateLimiter(
   newConnRateLimiter_ = std::move(rateLimiter);
 }
 
+void QuicServerWorker::setAdmissionController(
+    std::unique_ptr<AdmissionController> admissionController) {
+  admissionController_ = std::move(admissionController);
+}
+
+void QuicServerWorker::setConnectionIdRoutingTable(
+    std::shared_ptr<ConnectionIdRoutingTable> routingTable) {
+  routingTable_ = std::move(routingTable);
+}
+
+void QuicServerWorker::setPathStateCache(
+    std::shared_ptr<PathStateCache> pathStateCache) {
+  pathStateCache_ = std::move(pathStateCache);
+}
+
 void QuicServerWorker::start() {
   CHECK(socket_);
   if (!pacingTimer_) {
     pacingTimer_ = TimerHighRes::newTimer(
         evb_, transportSettings_.pacingTimerTickInterval);
   }
+  if (transportSettings_.usePacingWheel && !pacingWheel_) {
+    pacingWheel_ = PacingWheel::newWheel(pacingTimer_);
+    if (transportSettings_.useThreadLocalBatching) {
+      // The connections written in a pass go out in one batch.
+      pacingWheel_->setDrainCallback(
+          [] { BatchWriterFactory::flushThreadLocalBatchWriter(); });
+    }
+  }
+  if (transportSettings_.useFairPacing && !fairPacingScheduler_) {
+    fairPacingScheduler_ = FairPacingScheduler::newScheduler(
+        evb_,
+        transportSettings_.fairPacingQuantumInPackets,
+        transportSettings_.fairPacingPacketsPerPass);
+    if (transportSettings_.useThreadLocalBatching) {
+      // The turns of a pass, from all the connections, go out in one batch.
+      fairPacingScheduler_->setDrainCallback(
+          [] { BatchWriterFactory::flushThreadLocalBatchWriter(); });
+    }
+  }
   socket_->resumeRead(this);
   VLOG(10) << folly::format(
       "Registered read on worker={}, thread={}, processId={}",
@@ -228,7 +266,8 @@ bool QuicServerWorker::maybeSendVersionNegotiationPacketOrDrop(
     QUIC_STATS(statsCallback_, onWrite, len);
     QUIC_STATS(statsCallback_, onPacketProcessed);
     QUIC_STATS(statsCallback_, onPacketSent);
-    socket_->write(client, versionNegotiationPacket->second);
+    statelessResponseWriter_.write(
+        *socket_, client, std::move(versionNegotiationPacket->second));
     return true;
   }
   return false;
@@ -492,9 +531,23 @@ void QuicServerWorker::forwardNetworkData(
     RoutingData&& routingData,
     NetworkData&& networkData,
     bool isForwardedData) {
+  if (!routingData.isUsingClientConnId && routingTable_) {
+    // A connection id in the table is routed to its owner whether or not the
+    // ConnectionIdAlgo can parse it, e.g. once handed off from a server using
+    // another algo.
+    auto lookupStart = Clock::now();
+    routingData.workerIndex =
+        routingTable_->find(routingData.destinationConnId);
+    QUIC_STATS(
+        statsCallback_,
+        onRoutingTableLookup,
+        routingData.workerIndex.has_value(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - lookupStart));
+  }
   // if it's not Client initial or ZeroRtt, AND if the connectionId version
   // mismatches: foward if pktForwarding is enabled else dropPacket
-  if (!routingData.isUsingClientConnId &&
+  if (!routingData.isUsingClientConnId && !routingData.workerIndex &&
       !connIdAlgo_->canParse(routingData.destinationConnId)) {
     if (packetForwardingEnabled_ && !isForwardedData) {
       VLOG(3) << folly::format(
@@ -632,6 +685,31 @@ void QuicServerWorker::dispatchPacketData(
           }
         }
 
+        if (!maybeEncryptedRetryToken && admissionController_) {
+          auto decision = admissionController_->admit(
+              client.getIPAddress(),
+              networkData.receiveTimePoint,
+              std::chrono::microseconds(
+                  static_cast<int64_t>(getEventBase()->getAvgLoopTime())));
+          if (decision == AdmissionController::Decision::RETRY &&
+              !transportSettings_.retryTokenSecret.hasValue()) {
+            VLOG(4) << "Dropping instead of sending retry packet since retry "
+                    << "token secret is not set";
+            decision = AdmissionController::Decision::DROP;
+          }
+          QUIC_STATS(statsCallback_, onConnectionAdmission, decision);
+          if (decision == AdmissionController::Decision::RETRY) {
+            sendRetryPacket(
+                client,
+                routingData.destinationConnId,
+                routingData.sourceConnId.value_or(
+                    ConnectionId(std::vector<uint8_t>())));
+            return;
+          } else if (decision == AdmissionController::Decision::DROP) {
+            return;
+          }
+        }
+
         // create 'accepting' transport
         auto sock = makeSocket(getEventBase());
         auto trans = transportFactory_->make(
@@ -641,46 +719,7 @@ void QuicServerWorker::dispatchPacketData(
           cannotMakeTransport = true;
         } else {
           CHECK(trans);
-          if (transportSettings_.dataPathType ==
-                  DataPathType::ContinuousMemory &&
-              bufAccessor_) {
-            trans->setBufAccessor(bufAccessor_.get());
-          }
-          trans->setPacingTimer(pacingTimer_);
-          trans->setRoutingCallback(this);
-          trans->setSupportedVersions(supportedVersions_);
-          trans->setOriginalPeerAddress(client);
-#ifdef CCP_ENABLED
-          trans->setCcpDatapath(getCcpReader()->getDatapath());
-#endif
-          trans->setCongestionControllerFactory(ccFactory_);
-          if (statsCallback_) {
-            trans->setTransportStatsCallback(statsCallback_.get());
-          }
-          if (transportSettingsOverrideFn_) {
-            folly::Optional<TransportSettings> overridenTransportSettings =
-                transportSettingsOverrideFn_(
-                    transportSettings_, client.getIPAddress());
-            if (overridenTransportSettings) {
-              if (overridenTransportSettings->dataPathType !=
-                  transportSettings_.dataPathType) {
-                // It's too complex to support that.
-                LOG(ERROR)
-                    << "Overriding DataPathType isn't supported. Requested daapath="
-                    << (overridenTransportSettings->dataPathType ==
-                                DataPathType::ContinuousMemory
-                            ? "ContinuousMemory"
-                            : "ChainedMemory");
-              }
-              trans->setTransportSettings(*overridenTransportSettings);
-            } else {
-              trans->setTransportSettings(transportSettings_);
-            }
-          } else {
-            trans->setTransportSettings(transportSettings_);
-          }
-          trans->setConnectionIdAlgo(connIdAlgo_.get());
-          trans->setServerConnectionIdRejector(this);
+          configureTransport(*trans, client);
           if (routingData.sourceConnId) {
             trans->setClientConnectionId(*routingData.sourceConnId);
           }
@@ -774,6 +813,21 @@ void QuicServerWorker::dispatchPacketData(
         routingData.destinationConnId);
   }
 
+  if (handedOffConnectionIds_.count(routingData.destinationConnId)) {
+    // The connection lives on in the process which took it over, a reset
+    // would kill it there too.
+    VLOG(4) << folly::format(
+        "Dropping packet for handed off connection from client={}, "
+        "routingInfo={}",
+        client.describe(),
+        logRoutingInfo(routingData.destinationConnId));
+    QUIC_STATS(
+        statsCallback_,
+        onPacketDropped,
+        PacketDropReason::CONNECTION_NOT_FOUND);
+    return;
+  }
+
   if (!packetForwardingEnabled_ || isForwardedData) {
     QUIC_STATS(
         statsCallback_,
@@ -831,15 +885,12 @@ void QuicServerWorker::sendResetPacket(
     resetSize = std::max<uint16_t>(
         folly::Random::secureRand32() % resetSize, kMinStatelessPacketSize);
   }
-  CHECK(transportSettings_.statelessResetTokenSecret.has_value());
-  StatelessResetGenerator generator(
-      *transportSettings_.statelessResetTokenSecret,
-      getAddress().getFullyQualified());
-  StatelessResetToken token = generator.generateToken(connId);
+  StatelessResetToken token =
+      getStatelessResetGenerator().generateToken(connId);
   StatelessResetPacketBuilder builder(resetSize, token);
   auto resetData = std::move(builder).buildPacket();
   auto resetDataLen = resetData->computeChainDataLength();
-  socket_->write(client, std::move(resetData));
+  statelessResponseWriter_.write(*socket_, client, std::move(resetData));
   QUIC_STATS(statsCallback_, onWrite, resetDataLen);
   QUIC_STATS(statsCallback_, onPacketSent);
   QUIC_STATS(statsCallback_, onStatelessReset);
@@ -878,10 +929,10 @@ bool QuicServerWorker::validateRetryToken(
   }
 
   // Try to decode the token
-  RetryTokenGenerator generator(transportSettings_.retryTokenSecret.value());
   auto buf = folly::IOBuf::copyBuffer(encryptedToken);
 
-  auto maybeDecryptedToken = generator.decryptToken(std::move(buf));
+  auto maybeDecryptedToken =
+      getRetryTokenGenerator().decryptToken(std::move(buf));
   if (!maybeDecryptedToken) {
     return false;
   }
@@ -923,8 +974,7 @@ void QuicServerWorker::sendRetryPacket(
     const ConnectionId& dstConnId,
     const ConnectionId& srcConnId) {
   // Create the encrypted retry token
-  RetryTokenGenerator generator(transportSettings_.retryTokenSecret.value());
-  auto encryptedToken = generator.encryptToken(
+  auto encryptedToken = getRetryTokenGenerator().encryptToken(
       dstConnId, client.getIPAddress(), client.getPort());
   CHECK(encryptedToken.has_value());
   std::string encryptedTokenStr =
@@ -947,8 +997,7 @@ void QuicServerWorker::sendRetryPacket(
       QuicVersion::MVFST_INVALID,
       folly::IOBuf::copyBuffer(encryptedTokenStr));
   Buf pseudoRetryPacketBuf = std::move(pseudoBuilder).buildPacket();
-  FizzRetryIntegrityTagGenerator fizzRetryIntegrityTagGenerator;
-  auto integrityTag = fizzRetryIntegrityTagGenerator.getRetryIntegrityTag(
+  auto integrityTag = retryIntegrityTagGenerator_.getRetryIntegrityTag(
       pseudoRetryPacketBuf.get());
 
   // Create the actual retry packet
@@ -962,11 +1011,30 @@ void QuicServerWorker::sendRetryPacket(
   auto retryData = std::move(builder).buildPacket();
   auto retryDataLen = retryData->computeChainDataLength();
 
-  socket_->write(client, retryData);
+  statelessResponseWriter_.write(*socket_, client, std::move(retryData));
   QUIC_STATS(statsCallback_, onWrite, retryDataLen);
   QUIC_STATS(statsCallback_, onPacketSent);
 }
 
+RetryTokenGenerator& QuicServerWorker::getRetryTokenGenerator() {
+  CHECK(transportSettings_.retryTokenSecret.hasValue());
+  if (!retryTokenGenerator_) {
+    retryTokenGenerator_ = std::make_unique<RetryTokenGenerator>(
+        transportSettings_.retryTokenSecret.value());
+  }
+  return *retryTokenGenerator_;
+}
+
+StatelessResetGenerator& QuicServerWorker::getStatelessResetGenerator() {
+  CHECK(transportSettings_.statelessResetTokenSecret.has_value());
+  if (!statelessResetGenerator_) {
+    statelessResetGenerator_ = std::make_unique<StatelessResetGenerator>(
+        *transportSettings_.statelessResetTokenSecret,
+        getAddress().getFullyQualified());
+  }
+  return *statelessResetGenerator_;
+}
+
 void QuicServerWorker::allowBeingTakenOver(
     std::unique_ptr<folly::AsyncUDPSocket> socket,
     const folly::SocketAddress& address) {
@@ -1050,6 +1118,16 @@ CCPReader* QuicServerWorker::getCcpReader() const noexcept {
   return ccpReader_.get();
 }
 
+void QuicServerWorker::setInProcessCcpDatapath(
+    std::shared_ptr<InProcessCcpDatapath> inProcessCcpDatapath) {
+  inProcessCcpDatapath_ = std::move(inProcessCcpDatapath);
+}
+
+const std::shared_ptr<InProcessCcpDatapath>&
+QuicServerWorker::getInProcessCcpDatapath() const noexcept {
+  return inProcessCcpDatapath_;
+}
+
 void QuicServerWorker::setNewConnectionSocketFactory(
     QuicUDPSocketFactory* factory) {
   socketFactory_ = factory;
@@ -1074,6 +1152,24 @@ void QuicServerWorker::setFizzContext(
 void QuicServerWorker::setTransportSettings(
     TransportSettings transportSettings) {
   transportSettings_ = transportSettings;
+  retryTokenGenerator_.reset();
+  statelessResetGenerator_.reset();
+  statelessResponseWriter_.setMaxBatchSize(
+      transportSettings_.maxStatelessResponseBatchSize);
+  takeoverPktHandler_.setMaxBatchSize(
+      transportSettings_.maxForwardedPacketBatchSize);
+  if (transportSettings_.workerMemoryBudget > 0) {
+    // Transports keep a pointer to the budget, update it in place.
+    if (memoryBudget_) {
+      memoryBudget_->setBudget(
+          transportSettings_.workerMemoryBudget,
+          transportSettings_.workerMemoryPressureThreshold);
+    } else {
+      memoryBudget_ = std::make_unique<MemoryBudget>(
+          transportSettings_.workerMemoryBudget,
+          transportSettings_.workerMemoryPressureThreshold);
+    }
+  }
   if (transportSettings_.batchingMode != QuicBatchingMode::BATCHING_MODE_GSO) {
     if (transportSettings_.dataPathType == DataPathType::ContinuousMemory) {
       LOG(ERROR) << "Unsupported data path type and batching mode combination";
@@ -1116,6 +1212,122 @@ QuicServerWorker::getConnectionIdMap() const {
   return connectionIdMap_;
 }
 
+void QuicServerWorker::configureTransport(
+    QuicServerTransport& trans,
+    const folly::SocketAddress& client) {
+  if (transportSettings_.dataPathType == DataPathType::ContinuousMemory &&
+      bufAccessor_) {
+    trans.setBufAccessor(bufAccessor_.get());
+  }
+  trans.setPacingTimer(pacingTimer_);
+  trans.setPacingWheel(pacingWheel_);
+  trans.setFairPacingScheduler(fairPacingScheduler_);
+  trans.setRoutingCallback(this);
+  trans.setSupportedVersions(supportedVersions_);
+  trans.setOriginalPeerAddress(client);
+#ifdef CCP_ENABLED
+  trans.setCcpDatapath(getCcpReader()->getDatapath());
+#endif
+  trans.setInProcessCcpDatapath(inProcessCcpDatapath_.get());
+  trans.setCongestionControllerFactory(ccFactory_);
+  if (statsCallback_) {
+    trans.setTransportStatsCallback(statsCallback_.get());
+  }
+  folly::Optional<TransportSettings> overridenTransportSettings;
+  if (transportSettingsOverrideFn_) {
+    overridenTransportSettings =
+        transportSettingsOverrideFn_(transportSettings_, client.getIPAddress());
+    if (overridenTransportSettings &&
+        overridenTransportSettings->dataPathType !=
+            transportSettings_.dataPathType) {
+      // It's too complex to support that.
+      LOG(ERROR)
+          << "Overriding DataPathType isn't supported. Requested daapath="
+          << (overridenTransportSettings->dataPathType ==
+                      DataPathType::ContinuousMemory
+                  ? "ContinuousMemory"
+                  : "ChainedMemory");
+    }
+  }
+  folly::Optional<CachedPathState> pathState;
+  if (pathStateCache_) {
+    pathState = pathStateCache_->get(client.getIPAddress(), Clock::now());
+    QUIC_STATS(statsCallback_, onPathStateCacheLookup, pathState.has_value());
+  }
+  if (pathState) {
+    if (!overridenTransportSettings) {
+      overridenTransportSettings = transportSettings_;
+    }
+    pathStateCache_->applyTo(*pathState, *overridenTransportSettings);
+  }
+  trans.setTransportSettings(
+      overridenTransportSettings ? *overridenTransportSettings
+                                 : transportSettings_);
+  if (pathStateCache_) {
+    trans.setPathStateCache(pathStateCache_.get(), pathState.has_value());
+  }
+  trans.setConnectionIdAlgo(connIdAlgo_.get());
+  trans.setServerConnectionIdRejector(this);
+  if (memoryBudget_) {
+    trans.setMemoryBudget(memoryBudget_.get());
+  }
+}
+
+std::vector<Buf> QuicServerWorker::handoffConnections() {
+  std::vector<Buf> handoffStates;
+  // Handed off transports are unbound as they close, iterate over copies.
+  auto boundServerTransports = boundServerTransports_;
+  folly::F14FastMap<QuicServerTransport*, std::vector<ConnectionId>>
+      transportConnIds;
+  for (const auto& it : connectionIdMap_) {
+    transportConnIds[it.second.get()].push_back(it.first);
+  }
+  for (auto& it : boundServerTransports) {
+    auto transport = it.second.lock();
+    if (!transport) {
+      continue;
+    }
+    auto handoffState = transport->handoff();
+    if (handoffState) {
+      handoffStates.push_back(std::move(handoffState));
+      for (const auto& connId : transportConnIds[transport.get()]) {
+        handedOffConnectionIds_.insert(connId);
+      }
+    }
+  }
+  VLOG(2) << "Handed off " << handoffStates.size() << " of "
+          << boundServerTransports.size() << " connections";
+  return handoffStates;
+}
+
+bool QuicServerWorker::resumeConnection(ConnectionHandoffState state) {
+  CHECK(getEventBase()->isInEventBaseThread());
+  if (shutdown_) {
+    return false;
+  }
+  for (const auto& connIdData : state.selfConnectionIds) {
+    if (connectionIdMap_.count(connIdData.connId)) {
+      LOG(ERROR) << "Connection already exists for resumed CID="
+                 << connIdData.connId;
+      return false;
+    }
+  }
+  auto trans = transportFactory_->make(
+      getEventBase(), makeSocket(getEventBase()), state.peerAddress, ctx_);
+  if (!trans) {
+    return false;
+  }
+  configureTransport(*trans, state.originalPeerAddress);
+  if (!trans->resumeFromHandoff(std::move(state))) {
+    LOG(ERROR) << "Failed to restore handed off connection";
+    return false;
+  }
+  for (const auto& observer : observerList_.getAll()) {
+    observer->accept(trans.get());
+  }
+  return true;
+}
+
 const QuicServerWorker::SrcToTransportMap&
 QuicServerWorker::getSrcToTransportMap() const {
   return sourceAddressMap_;
@@ -1137,9 +1349,14 @@ void QuicServerWorker::onConnectionIdAvailable(
     LOG(ERROR) << "connectionIdMap_ already has CID=" << id
                << " Is same transport: "
                << (existingTransportPtr == transportPtr);
-  } else if (boundServerTransports_.emplace(transportPtr, weakTransport)
-                 .second) {
-    QUIC_STATS(statsCallback_, onNewConnection);
+  } else {
+    if (routingTable_ && !routingTable_->insert(id, workerId_)) {
+      LOG(ERROR) << "Routing table already has CID=" << id
+                 << " for another worker";
+    }
+    if (boundServerTransports_.emplace(transportPtr, weakTransport).second) {
+      QUIC_STATS(statsCallback_, onNewConnection);
+    }
   }
 }
 
@@ -1192,6 +1409,9 @@ void QuicServerWorker::onConnectionUnbound(
       }
     }
     connectionIdMap_.erase(connId.connId);
+    if (routingTable_ && incorrectTransportPtr == nullptr) {
+      routingTable_->erase(connId.connId, workerId_);
+    }
     if (incorrectTransportPtr != nullptr) {
       if (boundServerTransports_.find(incorrectTransportPtr) !=
           boundServerTransports_.end()) {
@@ -1242,13 +1462,21 @@ void QuicServerWorker::shutdownAllConnections(LocalErrorCode error) {
     }
   }
   sourceAddressMap_.clear();
+  if (routingTable_) {
+    for (const auto& it : connectionIdMap_) {
+      routingTable_->erase(it.first, workerId_);
+    }
+  }
   connectionIdMap_.clear();
   takeoverPktHandler_.stop();
   if (statsCallback_) {
     statsCallback_.reset();
   }
+  statelessResponseWriter_.flush();
   socket_.reset();
   takeoverCB_.reset();
+  fairPacingScheduler_.reset();
+  pacingWheel_.reset();
   pacingTimer_.reset();
 }
 
@@ -17,13 +17,23 @@
 
 #include <quic/codec/ConnectionIdAlgo.h>
 #include <quic/common/BufAccessor.h>
+#include <quic/common/FairPacingScheduler.h>
+#include <quic/common/PacingWheel.h>
 #include <quic/common/Timers.h>
 #include <quic/congestion_control/CongestionControllerFactory.h>
+#include <quic/congestion_control/InProcessCcp.h>
+#include <quic/fizz/handshake/FizzRetryIntegrityTagGenerator.h>
+#include <quic/server/AdmissionController.h>
 #include <quic/server/CCPReader.h>
+#include <quic/server/ConnectionIdRoutingTable.h>
+#include <quic/server/PathStateCache.h>
 #include <quic/server/QuicServerPacketRouter.h>
 #include <quic/server/QuicServerTransportFactory.h>
 #include <quic/server/QuicUDPSocketFactory.h>
 #include <quic/server/RateLimiter.h>
+#include <quic/server/StatelessResponseWriter.h>
+#include <quic/server/handshake/RetryTokenGenerator.h>
+#include <quic/server/handshake/StatelessResetGenerator.h>
 #include <quic/server/state/ServerConnectionIdRejector.h>
 #include <quic/state/QuicConnectionStats.h>
 #include <quic/state/QuicTransportStatsCallback.h>
@@ -322,6 +332,27 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
    */
   void setRateLimiter(std::unique_ptr<RateLimiter> rateLimiter);
 
+  /**
+   * Set the admission controller which decides whether new connections
+   * without a retry token are accepted, sent a Retry or dropped. It is
+   * consulted after the rate limiter, if any.
+   */
+  void setAdmissionController(
+      std::unique_ptr<AdmissionController> admissionController);
+
+  /**
+   * Publish the connection ids of this worker's connections, keyed by its
+   * worker id, to a routing table shared with the other workers.
+   */
+  void setConnectionIdRoutingTable(
+      std::shared_ptr<ConnectionIdRoutingTable> routingTable);
+
+  /**
+   * Warm start new connections from the path state of earlier connections
+   * from the same client prefix, which this worker's connections add to.
+   */
+  void setPathStateCache(std::shared_ptr<PathStateCache> pathStateCache);
+
   /*
    * Get a reference to this worker's corresponding CCPReader.
    * Each worker has a CCPReader that handles recieving messages from CCP
@@ -329,6 +360,16 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
    */
   FOLLY_NODISCARD CCPReader* getCcpReader() const noexcept;
 
+  /*
+   * Set the datapath through which this worker's connections using CCP talk
+   * to an in-process CCP agent, instead of the CCPReader.
+   */
+  void setInProcessCcpDatapath(
+      std::shared_ptr<InProcessCcpDatapath> inProcessCcpDatapath);
+
+  FOLLY_NODISCARD const std::shared_ptr<InProcessCcpDatapath>&
+  getInProcessCcpDatapath() const noexcept;
+
   // Read callback
   void getReadBuffer(void** buf, size_t* len) noexcept override;
 
@@ -398,6 +439,20 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
 
   void shutdownAllConnections(LocalErrorCode error);
 
+  /**
+   * Hands off all quiescent connections, returning the state to pass to
+   * resumeConnection() in the process taking over. Handed off connections are
+   * closed without notifying the peer, the others are left running. Packets
+   * still received for the handed off connections are dropped.
+   */
+  std::vector<Buf> handoffConnections();
+
+  /**
+   * Resumes a connection handed off by another process. Returns false if one
+   * of its connection ids is already in use or its state cannot be restored.
+   */
+  bool resumeConnection(ConnectionHandoffState state);
+
   // for unit test
   folly::AsyncUDPSocket::ReadCallback* getTakeoverHandlerCallback() {
     return takeoverCB_.get();
@@ -490,6 +545,13 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
       folly::EventBase* evb,
       int fd) const;
 
+  /**
+   * Applies this worker's settings and callbacks to a new transport.
+   */
+  void configureTransport(
+      QuicServerTransport& trans,
+      const folly::SocketAddress& client);
+
   /**
    * Tries to get the encrypted retry token from a client initial packet
    */
@@ -518,6 +580,13 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
       LongHeaderInvariant& invariant,
       size_t datagramLen);
 
+  /**
+   * The generators are keyed on first use and kept until the secrets or the
+   * bound address change, instead of being keyed for every response.
+   */
+  RetryTokenGenerator& getRetryTokenGenerator();
+  StatelessResetGenerator& getStatelessResetGenerator();
+
   /**
    * Helper method to extract and log routing info from the given (dest) connId
    */
@@ -540,6 +609,10 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   QuicServerTransportFactory* transportFactory_;
   std::shared_ptr<CongestionControllerFactory> ccFactory_{nullptr};
 
+  // Shared by all the transports of this worker, declared before the maps
+  // holding them so that it outlives them.
+  std::unique_ptr<MemoryBudget> memoryBudget_;
+
   // A server transport's membership is exclusive to only one of these maps.
   ConnIdToTransportMap connectionIdMap_;
   SrcToTransportMap sourceAddressMap_;
@@ -557,6 +630,11 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   folly::F14FastMap<QuicServerTransport*, std::weak_ptr<QuicServerTransport>>
       boundServerTransports_;
 
+  // Connection ids of the connections handed off by handoffConnections().
+  // Their packets may still reach this process, e.g. forwarded by the new
+  // process before it resumed them, and are dropped without a reset.
+  folly::F14FastSet<ConnectionId, ConnectionIdHash> handedOffConnectionIds_;
+
   Buf readBuffer_;
   bool shutdown_{false};
   std::vector<QuicVersion> supportedVersions_;
@@ -581,6 +659,12 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   bool packetForwardingEnabled_{false};
   using PacketDropReason = QuicTransportStatsCallback::PacketDropReason;
   TimerHighRes::SharedPtr pacingTimer_;
+  // Shares pacingTimer_ between the paced connections when
+  // transportSettings_.usePacingWheel is set.
+  PacingWheel::SharedPtr pacingWheel_;
+  // Writes the paced bursts of the connections in turn when
+  // transportSettings_.useFairPacing is set.
+  FairPacingScheduler::SharedPtr fairPacingScheduler_;
 
   // Used to override certain transport parameters, given the client address
   TransportSettingsOverrideFn transportSettingsOverrideFn_;
@@ -591,6 +675,17 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   // Rate limits the creation of new connections for this worker.
   std::unique_ptr<RateLimiter> newConnRateLimiter_;
 
+  // Sheds new connections based on their rate and on the worker's load.
+  std::unique_ptr<AdmissionController> admissionController_;
+
+  std::shared_ptr<ConnectionIdRoutingTable> routingTable_;
+
+  // Pre-keyed state and batching for the stateless responses.
+  std::unique_ptr<RetryTokenGenerator> retryTokenGenerator_;
+  std::unique_ptr<StatelessResetGenerator> statelessResetGenerator_;
+  FizzRetryIntegrityTagGenerator retryIntegrityTagGenerator_;
+  StatelessResponseWriter statelessResponseWriter_;
+
   // EventRecvmsgCallback data
   std::unique_ptr<MsgHdr> msgHdr_;
 
@@ -630,6 +725,8 @@ class QuicServerWorker : public folly::AsyncUDPSocket::ReadCallback,
   AcceptObserverList observerList_;
 
   std::unique_ptr<CCPReader> ccpReader_;
+  std::shared_ptr<InProcessCcpDatapath> inProcessCcpDatapath_;
+  std::shared_ptr<PathStateCache> pathStateCache_;
 
   TimePoint largestPacketReceiveTime_{TimePoint::min()};
 };
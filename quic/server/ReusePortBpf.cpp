@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/ReusePortBpf.h>
+
+#include <folly/String.h>
+#include <folly/portability/Sockets.h>
+#include <glog/logging.h>
+
+#include <quic/QuicConstants.h>
+#include <quic/codec/QuicConnectionId.h>
+
+namespace quic {
+
+#ifdef __linux__
+namespace {
+// Offset of the destination connection id in a short header packet.
+constexpr uint32_t kShortHeaderDcidOffset = 1;
+constexpr uint32_t kLongHeaderBit = 0x80;
+constexpr uint32_t kCidVersionMask = 0xc0;
+// Anything at least the size of the group makes the kernel hash instead.
+constexpr uint32_t kFallbackIndex = 0xffffffff;
+} // namespace
+
+std::vector<sock_filter> makeReusePortBpfProgram(size_t numWorkers) {
+  CHECK_GT(numWorkers, 0);
+  constexpr uint32_t v1Bits = static_cast<uint32_t>(ConnectionIdVersion::V1)
+      << 6;
+  constexpr uint32_t v2Bits = static_cast<uint32_t>(ConnectionIdVersion::V2)
+      << 6;
+  // Jump offsets are relative to the next instruction, keep them in sync
+  // with the indices in the comments.
+  return {
+      // 0: X = payload length
+      BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+      BPF_STMT(BPF_MISC | BPF_TAX, 0),
+      // 2: long header packets go to the kernel hash (-> 23)
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+      BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, kLongHeaderBit, 19, 0),
+      // 4: the smallest connection id we can parse must fit (else -> 23)
+      BPF_STMT(BPF_MISC | BPF_TXA, 0),
+      BPF_JUMP(
+          BPF_JMP | BPF_JGE | BPF_K,
+          kShortHeaderDcidOffset + kMinSelfConnectionIdV1Size,
+          0,
+          17),
+      // 6: dispatch on the version bits (V1 -> 10, V2 -> 18, else -> 23)
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kShortHeaderDcidOffset),
+      BPF_STMT(BPF_ALU | BPF_AND | BPF_K, kCidVersionMask),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, v1Bits, 1, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, v2Bits, 8, 13),
+      // 10: V1, workerId = (cid[2] & 0x3f) << 2 | cid[3] >> 6 (-> 21)
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kShortHeaderDcidOffset + 3),
+      BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 6),
+      BPF_STMT(BPF_MISC | BPF_TAX, 0),
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kShortHeaderDcidOffset + 2),
+      BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0x3f),
+      BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 2),
+      BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0),
+      BPF_JUMP(BPF_JMP | BPF_JA, 3, 0, 0),
+      // 18: V2, the connection id must be longer (else -> 23),
+      // workerId = cid[4]
+      BPF_STMT(BPF_MISC | BPF_TXA, 0),
+      BPF_JUMP(
+          BPF_JMP | BPF_JGE | BPF_K,
+          kShortHeaderDcidOffset + kMinSelfConnectionIdV2Size,
+          0,
+          3),
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kShortHeaderDcidOffset + 4),
+      // 21: workerId % numWorkers, as getWorkerToRouteTo does
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(numWorkers)),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+      // 23: let the kernel hash
+      BPF_STMT(BPF_RET | BPF_K, kFallbackIndex),
+  };
+}
+#endif
+
+bool attachReusePortBpfProgram(folly::NetworkSocket socket, size_t numWorkers) {
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+  auto program = makeReusePortBpfProgram(numWorkers);
+  sock_fprog fprog;
+  fprog.len = program.size();
+  fprog.filter = program.data();
+  if (::setsockopt(
+          socket.toFd(),
+          SOL_SOCKET,
+          SO_ATTACH_REUSEPORT_CBPF,
+          &fprog,
+          sizeof(fprog)) != 0) {
+    LOG(ERROR) << "Failed to attach reuseport BPF program: "
+               << folly::errnoStr(errno);
+    return false;
+  }
+  return true;
+#else
+  (void)socket;
+  (void)numWorkers;
+  LOG(ERROR) << "Reuseport BPF programs are not supported on this platform";
+  return false;
+#endif
+}
+
+} // namespace quic
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/net/NetworkSocket.h>
+
+#include <vector>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+namespace quic {
+
+#ifdef __linux__
+/**
+ * Classic BPF program for SO_ATTACH_REUSEPORT_CBPF which steers each packet
+ * to the socket of the worker that owns its connection, the same way
+ * QuicServer::routeDataToWorker does in userspace with the
+ * DefaultConnectionIdAlgo.
+ *
+ * The program runs on the UDP payload. For short header packets it reads the
+ * version bits of the destination connection id, extracts the worker id from
+ * where that ConnectionIdVersion puts it, and returns workerId % numWorkers.
+ * Long header packets, unknown versions and truncated packets return an
+ * out of range index, for which the kernel falls back to its own hash.
+ *
+ * The returned index is the position of the socket in the reuseport group,
+ * i.e. the order in which the sockets were bound, so worker i must have
+ * bound the i-th socket.
+ */
+std::vector<sock_filter> makeReusePortBpfProgram(size_t numWorkers);
+#endif
+
+/**
+ * Attach the program above to the reuseport group of socket. Returns false
+ * and logs if the platform doesn't support it or the setsockopt fails, in
+ * which case the kernel keeps hashing and routeDataToWorker keeps forwarding
+ * between workers.
+ */
+bool attachReusePortBpfProgram(folly::NetworkSocket socket, size_t numWorkers);
+
+} // namespace quic
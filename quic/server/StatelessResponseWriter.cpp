@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/StatelessResponseWriter.h>
+
+namespace quic {
+
+StatelessResponseWriter::StatelessResponseWriter(size_t maxBatchSize)
+    : maxBatchSize_(maxBatchSize) {}
+
+void StatelessResponseWriter::setMaxBatchSize(size_t maxBatchSize) {
+  maxBatchSize_ = maxBatchSize;
+  if (bufs_.size() >= maxBatchSize_) {
+    flush();
+  }
+}
+
+void StatelessResponseWriter::write(
+    folly::AsyncUDPSocket& sock,
+    const folly::SocketAddress& client,
+    Buf buf) {
+  if (maxBatchSize_ <= 1) {
+    sock.write(client, buf);
+    return;
+  }
+  if (sock_ && sock_ != &sock) {
+    flush();
+  }
+  sock_ = &sock;
+  addrs_.push_back(client);
+  bufs_.push_back(std::move(buf));
+  if (bufs_.size() >= maxBatchSize_) {
+    flush();
+    return;
+  }
+  if (!isLoopCallbackScheduled()) {
+    sock.getEventBase()->runInLoop(this);
+  }
+}
+
+void StatelessResponseWriter::flush() {
+  cancelLoopCallback();
+  if (bufs_.empty()) {
+    return;
+  }
+  CHECK(sock_);
+  int ret = bufs_.size() == 1
+      ? (sock_->write(addrs_[0], bufs_[0]) < 0 ? -1 : 1)
+      : sock_->writem(
+            folly::range(addrs_.data(), addrs_.data() + addrs_.size()),
+            bufs_.data(),
+            bufs_.size());
+  if (ret < static_cast<int>(bufs_.size())) {
+    // Nothing depends on these responses, so whatever the socket did not
+    // take is dropped rather than retried.
+    VLOG(4) << "Stateless responses dropped on write, sent=" << ret
+            << " pending=" << bufs_.size();
+  }
+  reset();
+}
+
+void StatelessResponseWriter::reset() {
+  cancelLoopCallback();
+  addrs_.clear();
+  bufs_.clear();
+  sock_ = nullptr;
+}
+
+void StatelessResponseWriter::runLoopCallback() noexcept {
+  flush();
+}
+
+} // namespace quic
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/io/async/AsyncUDPSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <quic/common/BufUtil.h>
+
+#include <vector>
+
+namespace quic {
+
+/**
+ * Queues the stateless responses a server worker sends (Version Negotiation,
+ * Retry and Stateless Reset) and writes them out with a single sendmmsg at
+ * the end of the event loop iteration, or as soon as maxBatchSize of them are
+ * pending. Under an Initial flood this replaces one syscall per response with
+ * one per batch.
+ *
+ * With a maxBatchSize of 1 or less every response is written immediately,
+ * which is the default behavior of the worker.
+ */
+class StatelessResponseWriter : public folly::EventBase::LoopCallback {
+ public:
+  explicit StatelessResponseWriter(size_t maxBatchSize = 1);
+
+  ~StatelessResponseWriter() override = default;
+
+  void setMaxBatchSize(size_t maxBatchSize);
+
+  /**
+   * Writes or queues buf for client. All the responses of a batch must go
+   * out of the same socket, a different socket flushes the pending ones
+   * first.
+   */
+  void write(
+      folly::AsyncUDPSocket& sock,
+      const folly::SocketAddress& client,
+      Buf buf);
+
+  /**
+   * Writes out every pending response.
+   */
+  void flush();
+
+  /**
+   * Drops every pending response, e.g. because the socket is going away.
+   */
+  void reset();
+
+  size_t pending() const {
+    return bufs_.size();
+  }
+
+  void runLoopCallback() noexcept override;
+
+ private:
+  size_t maxBatchSize_;
+  folly::AsyncUDPSocket* sock_{nullptr};
+  std::vector<folly::SocketAddress> addrs_;
+  std::vector<Buf> bufs_;
+};
+
+} // namespace quic
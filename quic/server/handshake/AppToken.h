@@ -11,6 +11,7 @@
 #include <quic/QuicConstants.h>
 #include <quic/handshake/TransportParameters.h>
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -26,6 +27,10 @@ struct AppToken {
   std::vector<folly::IPAddress> sourceAddresses;
   QuicVersion version;
   std::unique_ptr<folly::IOBuf> appParams;
+  // Path characteristics measured by the connection which issued the ticket,
+  // 0 when unknown. The bandwidth is in bytes per second.
+  uint64_t bandwidth{0};
+  std::chrono::microseconds minRtt{0};
 };
 
 TicketTransportParameters createTicketTransportParameters(
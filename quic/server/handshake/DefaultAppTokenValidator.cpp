@@ -36,6 +36,7 @@ bool DefaultAppTokenValidator::validate(
     const fizz::server::ResumptionState& resumptionState) const {
   conn_->transportParamsMatching = false;
   conn_->sourceTokenMatching = false;
+  resumedPath_ = folly::none;
 
   if (!resumptionState.appToken) {
     VLOG(10) << "App token does not exist";
@@ -142,6 +143,14 @@ bool DefaultAppTokenValidator::validate(
     return false;
   }
 
+  const auto& carefulResume = conn_->transportSettings.carefulResume;
+  if (carefulResume.enabled && appToken->bandwidth > 0 &&
+      appToken->minRtt > 0us &&
+      std::chrono::system_clock::now() - resumptionState.ticketIssueTime <=
+          carefulResume.maxTicketAge) {
+    resumedPath_ = ResumedPath{appToken->bandwidth, appToken->minRtt};
+  }
+
   updateTransportParamsFromTicket(
       *conn_,
       *ticketIdleTimeout,
@@ -156,4 +165,9 @@ bool DefaultAppTokenValidator::validate(
   return true;
 }
 
+const folly::Optional<DefaultAppTokenValidator::ResumedPath>&
+DefaultAppTokenValidator::getResumedPath() const {
+  return resumedPath_;
+}
+
 } // namespace quic
@@ -14,6 +14,7 @@
 #include <folly/Optional.h>
 #include <folly/io/IOBuf.h>
 
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -28,12 +29,28 @@ struct QuicServerConnectionState;
 
 class DefaultAppTokenValidator : public fizz::server::AppTokenValidator {
  public:
+  // Path characteristics saved in a session ticket, the bandwidth is in bytes
+  // per second.
+  struct ResumedPath {
+    uint64_t bandwidth{0};
+    std::chrono::microseconds minRtt{0};
+  };
+
   explicit DefaultAppTokenValidator(QuicServerConnectionState* conn);
 
   bool validate(const fizz::server::ResumptionState&) const override;
 
+  /**
+   * The path characteristics of the last ticket validated, when
+   * transportSettings.carefulResume is enabled and they are fresh enough.
+   * They are left for the transport to apply on its EventBase rather than
+   * written to the connection here.
+   */
+  const folly::Optional<ResumedPath>& getResumedPath() const;
+
  private:
   QuicServerConnectionState* conn_;
+  mutable folly::Optional<ResumedPath> resumedPath_;
 };
 
 } // namespace quic
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/handshake/HandshakeOffloadExecutor.h>
+
+#include <folly/ScopeGuard.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <glog/logging.h>
+
+namespace quic {
+
+HandshakeOffloadExecutor::HandshakeOffloadExecutor(
+    std::shared_ptr<folly::Executor> executor,
+    size_t maxPending)
+    : executor_(std::move(executor)),
+      maxPending_(maxPending),
+      pending_(std::make_shared<std::atomic<size_t>>(0)) {
+  CHECK(executor_);
+  CHECK_GT(maxPending_, 0);
+}
+
+std::shared_ptr<HandshakeOffloadExecutor>
+HandshakeOffloadExecutor::makeThreadPool(size_t numThreads, size_t maxPending) {
+  auto executor = std::make_shared<folly::CPUThreadPoolExecutor>(
+      numThreads,
+      std::make_shared<folly::NamedThreadFactory>("QuicHandshake"));
+  return std::make_shared<HandshakeOffloadExecutor>(
+      std::move(executor), maxPending);
+}
+
+bool HandshakeOffloadExecutor::tryAdd(Job job) {
+  auto pending = pending_->load(std::memory_order_relaxed);
+  do {
+    if (pending >= maxPending_) {
+      return false;
+    }
+  } while (!pending_->compare_exchange_weak(
+      pending, pending + 1, std::memory_order_relaxed));
+
+  auto enqueueTime = std::chrono::steady_clock::now();
+  executor_->add(
+      [job = std::move(job), counter = pending_, enqueueTime]() mutable {
+        auto queueDelay = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - enqueueTime);
+        SCOPE_EXIT {
+          counter->fetch_sub(1, std::memory_order_relaxed);
+        };
+        job(queueDelay);
+      });
+  return true;
+}
+
+} // namespace quic
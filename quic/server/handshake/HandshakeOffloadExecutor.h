@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/Function.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace quic {
+
+/**
+ * Runs the expensive steps of server handshakes (key exchange and certificate
+ * signature) off the worker EventBase, so that a burst of new connections
+ * doesn't delay packet processing for the established ones.
+ *
+ * At most maxPending handshake steps can be queued or running at once across
+ * all the workers sharing this executor. Once the bound is reached tryAdd()
+ * fails and the handshake is refused, rather than letting the queueing delay
+ * grow past the client's retransmission timeout.
+ */
+class HandshakeOffloadExecutor {
+ public:
+  using Job = folly::Function<void(std::chrono::microseconds queueDelay)>;
+
+  HandshakeOffloadExecutor(
+      std::shared_ptr<folly::Executor> executor,
+      size_t maxPending);
+
+  /**
+   * Convenience to offload to a dedicated CPUThreadPoolExecutor.
+   */
+  static std::shared_ptr<HandshakeOffloadExecutor> makeThreadPool(
+      size_t numThreads,
+      size_t maxPending);
+
+  /**
+   * Schedules job on the executor. The job is told how long it waited in the
+   * queue. Returns false, without running the job, if maxPending jobs are
+   * already queued or running.
+   */
+  bool tryAdd(Job job);
+
+  size_t pending() const {
+    return pending_->load(std::memory_order_relaxed);
+  }
+
+  size_t maxPending() const {
+    return maxPending_;
+  }
+
+ private:
+  std::shared_ptr<folly::Executor> executor_;
+  const size_t maxPending_;
+  // Shared with the queued jobs so that finishing one never touches this
+  // object, which may be gone by then.
+  std::shared_ptr<std::atomic<size_t>> pending_;
+};
+
+} // namespace quic
@@ -134,6 +134,28 @@ ServerHandshake::getZeroRttReadHeaderCipher() {
   return std::move(zeroRttReadHeaderCipher_);
 }
 
+void ServerHandshake::resumeFromHandoff(
+    fizz::CipherSuite cipherSuite,
+    folly::Optional<std::string> alpn,
+    const TrafficKey& oneRttReadKey,
+    const TrafficKey& oneRttWriteKey,
+    folly::ByteRange oneRttReadHeaderKey,
+    folly::ByteRange oneRttWriteHeaderKey) {
+  CHECK(phase_ == Phase::Handshake);
+  auto readCiphers =
+      buildCiphers(cipherSuite, oneRttReadKey, oneRttReadHeaderKey);
+  auto writeCiphers =
+      buildCiphers(cipherSuite, oneRttWriteKey, oneRttWriteHeaderKey);
+  oneRttReadCipher_ = std::move(readCiphers.first);
+  oneRttReadHeaderCipher_ = std::move(readCiphers.second);
+  oneRttWriteCipher_ = std::move(writeCiphers.first);
+  oneRttWriteHeaderCipher_ = std::move(writeCiphers.second);
+  handoffAlpn_ = std::move(alpn);
+  resumedFromHandoff_ = true;
+  handshakeDone_ = true;
+  phase_ = Phase::Established;
+}
+
 /**
  * The application will not get any more callbacks from the handshake layer
  * after this method returns.
@@ -161,6 +183,9 @@ const fizz::server::State& ServerHandshake::getState() const {
 
 const folly::Optional<std::string>& ServerHandshake::getApplicationProtocol()
     const {
+  if (resumedFromHandoff_) {
+    return handoffAlpn_;
+  }
   return state_.alpn();
 }
 
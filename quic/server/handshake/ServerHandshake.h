@@ -155,6 +155,21 @@ class ServerHandshake : public Handshake {
    */
   std::unique_ptr<PacketNumberCipher> getZeroRttReadHeaderCipher();
 
+  /**
+   * Puts a handshake which never ran in the state of one which completed in
+   * another process, with the 1-rtt ciphers rebuilt from their keys. The
+   * ciphers are then returned by the edge triggered getters above. Used to
+   * resume connections handed off during a takeover. Throws if the keys do
+   * not fit the cipher suite.
+   */
+  void resumeFromHandoff(
+      fizz::CipherSuite cipherSuite,
+      folly::Optional<std::string> alpn,
+      const TrafficKey& oneRttReadKey,
+      const TrafficKey& oneRttWriteKey,
+      folly::ByteRange oneRttReadHeaderKey,
+      folly::ByteRange oneRttWriteHeaderKey);
+
   /**
    * The application will not get any more callbacks from the handshake layer
    * after this method returns.
@@ -256,6 +271,8 @@ class ServerHandshake : public Handshake {
 
   bool inHandshakeStack_{false};
   bool handshakeDone_{false};
+  bool resumedFromHandoff_{false};
+  folly::Optional<std::string> handoffAlpn_;
   bool handshakeEventAvailable_{false};
 
   std::shared_ptr<ServerTransportParametersExtension> transportParams_;
@@ -269,6 +286,11 @@ class ServerHandshake : public Handshake {
   virtual void processSocketData(folly::IOBufQueue& queue) = 0;
   virtual std::pair<std::unique_ptr<Aead>, std::unique_ptr<PacketNumberCipher>>
   buildCiphers(folly::ByteRange secret) = 0;
+  virtual std::pair<std::unique_ptr<Aead>, std::unique_ptr<PacketNumberCipher>>
+  buildCiphers(
+      fizz::CipherSuite cipherSuite,
+      const TrafficKey& key,
+      folly::ByteRange headerKey) = 0;
 
   virtual void processAccept() = 0;
   /*
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/handshake/ShardedReplayCache.h>
+
+#include <folly/Bits.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <glog/logging.h>
+
+namespace quic {
+
+namespace {
+// About 1% false positives with 7 hashes.
+constexpr size_t kBitsPerEntry = 10;
+} // namespace
+
+ShardedReplayCache::ShardedReplayCache(Options options)
+    : options_(std::move(options)),
+      bucketDuration_(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              options_.window) /
+          std::max<size_t>(options_.numBuckets - 1, 1)) {
+  CHECK_GT(options_.numShards, 0);
+  CHECK_GT(options_.numHashes, 0);
+  CHECK_GE(options_.numBuckets, 2);
+  CHECK_GT(bucketDuration_.count(), 0);
+  auto bits = folly::nextPowTwo(std::max<size_t>(
+      options_.capacity * kBitsPerEntry / options_.numShards, 64));
+  wordsPerBucket_ = bits / 64;
+  bitMask_ = bits - 1;
+  shards_ = std::make_unique<Shard[]>(options_.numShards);
+  for (size_t i = 0; i < options_.numShards; ++i) {
+    shards_[i].bits.resize(wordsPerBucket_ * options_.numBuckets);
+  }
+}
+
+folly::Future<bool> ShardedReplayCache::testAndInsert(
+    folly::ByteRange identifier) {
+  return folly::makeFuture(testAndInsert(identifier, Clock::now()));
+}
+
+bool ShardedReplayCache::testAndInsert(
+    folly::ByteRange identifier,
+    TimePoint now) {
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  folly::hash::SpookyHashV2::Hash128(
+      identifier.data(), identifier.size(), &h1, &h2);
+  // Shard on bits the bloom indexes below barely depend on.
+  auto& shard = shards_[(h1 >> 32) % options_.numShards];
+  // An odd stride visits distinct bits for all the hashes.
+  h2 |= 1;
+
+  std::lock_guard<folly::SpinLock> guard(shard.lock);
+  maybeRotate(shard, now);
+  bool seen = false;
+  for (size_t bucket = 0; bucket < options_.numBuckets && !seen; ++bucket) {
+    const uint64_t* words = shard.bits.data() + bucket * wordsPerBucket_;
+    bool inBucket = true;
+    for (size_t i = 0; i < options_.numHashes && inBucket; ++i) {
+      uint64_t bit = (h1 + i * h2) & bitMask_;
+      inBucket = words[bit / 64] & (uint64_t(1) << (bit % 64));
+    }
+    seen = inBucket;
+  }
+  uint64_t* newest = shard.bits.data() + shard.newestBucket * wordsPerBucket_;
+  for (size_t i = 0; i < options_.numHashes; ++i) {
+    uint64_t bit = (h1 + i * h2) & bitMask_;
+    newest[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+  return seen;
+}
+
+void ShardedReplayCache::maybeRotate(Shard& shard, TimePoint now) {
+  if (!shard.newestBucketStart) {
+    shard.newestBucketStart = now;
+    return;
+  }
+  if (now - *shard.newestBucketStart < bucketDuration_) {
+    return;
+  }
+  if (now - *shard.newestBucketStart >= bucketDuration_ * options_.numBuckets) {
+    // Idle for longer than the whole ring, everything has expired.
+    std::fill(shard.bits.begin(), shard.bits.end(), 0);
+    shard.newestBucketStart = now;
+    return;
+  }
+  while (now - *shard.newestBucketStart >= bucketDuration_) {
+    shard.newestBucket = (shard.newestBucket + 1) % options_.numBuckets;
+    auto begin = shard.bits.begin() + shard.newestBucket * wordsPerBucket_;
+    std::fill(begin, begin + wordsPerBucket_, 0);
+    *shard.newestBucketStart += bucketDuration_;
+  }
+}
+
+} // namespace quic
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/SpinLock.h>
+#include <folly/futures/Future.h>
+#include <folly/lang/Align.h>
+
+#include <quic/QuicConstants.h>
+
+#include <memory>
+#include <vector>
+
+namespace quic {
+
+/**
+ * Where the 0-RTT anti-replay state lives. A single instance is shared by all
+ * the workers of a process, and an implementation can forward to a local
+ * daemon to share the state across processes too.
+ */
+class ReplayCacheBackend {
+ public:
+  virtual ~ReplayCacheBackend() = default;
+
+  /**
+   * Record identifier and return whether it may have been recorded before
+   * within the anti-replay window. False positives are allowed (they only
+   * cost a 0-RTT rejection), false negatives are not.
+   */
+  virtual folly::Future<bool> testAndInsert(folly::ByteRange identifier) = 0;
+};
+
+/**
+ * In-process ReplayCacheBackend.
+ *
+ * Identifiers are hashed to one of numShards shards, each behind its own
+ * spin lock so that workers rarely contend. A shard is a ring of numBuckets
+ * bloom filters; new identifiers go into the newest one and lookups check all
+ * of them. Every window / (numBuckets - 1) the oldest filter is cleared and
+ * becomes the newest, so an identifier is remembered for at least window and
+ * memory stays constant no matter the rate.
+ *
+ * window should cover the ClockSkewTolerance given to the FizzServerContext,
+ * beyond which fizz rejects early data from the ticket age alone.
+ */
+class ShardedReplayCache : public ReplayCacheBackend {
+ public:
+  struct Options {
+    size_t numShards{64};
+    // Identifiers expected within one bucket across all the shards. Sized
+    // for about a 1% false positive rate with the default numHashes.
+    size_t capacity{1 << 20};
+    size_t numHashes{7};
+    std::chrono::milliseconds window{10000};
+    size_t numBuckets{4};
+  };
+
+  explicit ShardedReplayCache(Options options);
+
+  folly::Future<bool> testAndInsert(folly::ByteRange identifier) override;
+
+  bool testAndInsert(folly::ByteRange identifier, TimePoint now);
+
+ private:
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    folly::SpinLock lock;
+    // numBuckets filters of wordsPerBucket_ words each.
+    std::vector<uint64_t> bits;
+    size_t newestBucket{0};
+    folly::Optional<TimePoint> newestBucketStart;
+  };
+
+  void maybeRotate(Shard& shard, TimePoint now);
+
+  const Options options_;
+  const std::chrono::microseconds bucketDuration_;
+  size_t wordsPerBucket_;
+  // Bits per bucket minus one, the number of bits is a power of 2.
+  uint64_t bitMask_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+} // namespace quic
@@ -87,6 +87,9 @@ void expectAppTokenEqual(
   } else {
     EXPECT_EQ(decodedAppToken->appParams->computeChainDataLength(), 0);
   }
+
+  EXPECT_EQ(decodedAppToken->bandwidth, appToken.bandwidth);
+  EXPECT_EQ(decodedAppToken->minRtt, appToken.minRtt);
 }
 
 TEST(AppTokenTest, TestEncodeAndDecodeNoSourceAddresses) {
@@ -246,5 +249,46 @@ TEST(AppTokenTest, TestEncodeAndDecodeIPv6AndIPv4AddressesWithAppToken) {
   expectAppTokenEqual(decodeAppToken(*buf), appToken);
 }
 
+TEST(AppTokenTest, TestEncodeAndDecodeWithPathCharacteristics) {
+  AppToken appToken;
+  appToken.transportParams = createTicketTransportParameters(
+      kDefaultIdleTimeout.count(),
+      kDefaultUDPReadBufferSize,
+      kDefaultConnectionWindowSize,
+      kDefaultStreamWindowSize,
+      kDefaultStreamWindowSize,
+      kDefaultStreamWindowSize,
+      std::numeric_limits<uint32_t>::max(),
+      std::numeric_limits<uint32_t>::max());
+  appToken.sourceAddresses = {folly::IPAddress("1.2.3.4")};
+  appToken.version = QuicVersion::MVFST;
+  appToken.bandwidth = 10 * 1000 * 1000;
+  appToken.minRtt = std::chrono::microseconds(40000);
+  Buf buf = encodeAppToken(appToken);
+
+  expectAppTokenEqual(decodeAppToken(*buf), appToken);
+}
+
+TEST(AppTokenTest, TestDecodeWithoutPathCharacteristics) {
+  AppToken appToken;
+  appToken.transportParams = createTicketTransportParameters(
+      kDefaultIdleTimeout.count(),
+      kDefaultUDPReadBufferSize,
+      kDefaultConnectionWindowSize,
+      kDefaultStreamWindowSize,
+      kDefaultStreamWindowSize,
+      kDefaultStreamWindowSize,
+      std::numeric_limits<uint32_t>::max(),
+      std::numeric_limits<uint32_t>::max());
+  appToken.sourceAddresses = {folly::IPAddress("1.2.3.4")};
+  appToken.version = QuicVersion::MVFST;
+  Buf buf = encodeAppToken(appToken);
+  // A ticket issued before bandwidth and min rtt were added.
+  buf->coalesce();
+  buf->trimEnd(2 * sizeof(uint64_t));
+
+  expectAppTokenEqual(decodeAppToken(*buf), appToken);
+}
+
 } // namespace test
 } // namespace quic
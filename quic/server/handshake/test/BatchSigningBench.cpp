@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <fizz/crypto/test/TestUtil.h>
+#include <fizz/protocol/Certificate.h>
+#include <folly/Benchmark.h>
+#include <quic/fizz/server/handshake/BatchSigningCert.h>
+
+#include <array>
+#include <thread>
+
+/**
+ * Measures CertificateVerify signatures per second when several handshake
+ * threads sign at once, either directly with the certificate or through a
+ * BatchSigningService. SequentialBatchSigner signs inline and should match
+ * sign_direct, QueuedSequentialBatchSigner shows what queueing costs when
+ * nothing is amortized. Plug a multi-buffer BatchSigner in place of it to
+ * check that a backend beats sign_direct before batching with it.
+ */
+
+using namespace quic;
+
+namespace {
+
+constexpr size_t kNumThreads = 8;
+
+// Signs one by one, but makes BatchSigningService form batches.
+class QueuedSequentialBatchSigner : public SequentialBatchSigner {
+ public:
+  bool amortizesBatches() const override {
+    return true;
+  }
+};
+
+std::shared_ptr<fizz::SelfCert> makeCert() {
+  std::vector<folly::ssl::X509UniquePtr> certs;
+  certs.emplace_back(fizz::test::getCert(fizz::test::kP256Certificate));
+  return std::make_shared<fizz::SelfCertImpl<fizz::KeyType::P256>>(
+      fizz::test::getPrivateKey(fizz::test::kP256Key), std::move(certs));
+}
+
+void signConcurrently(const fizz::SelfCert& cert, size_t iters) {
+  std::array<uint8_t, 32> toBeSigned{};
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, count = iters / kNumThreads + 1] {
+      for (size_t j = 0; j < count; ++j) {
+        folly::doNotOptimizeAway(cert.sign(
+            fizz::SignatureScheme::ecdsa_secp256r1_sha256,
+            fizz::CertificateVerifyContext::Server,
+            folly::range(toBeSigned)));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+void signBatched(
+    size_t iters,
+    std::unique_ptr<BatchSigner> signer,
+    size_t maxBatchSize) {
+  folly::BenchmarkSuspender suspender;
+  auto service = std::make_shared<BatchSigningService>(
+      std::move(signer),
+      BatchSigningService::Options{
+          maxBatchSize, std::chrono::microseconds(100)});
+  BatchSigningCert cert(makeCert(), service);
+  suspender.dismiss();
+  signConcurrently(cert, iters);
+}
+
+} // namespace
+
+BENCHMARK(sign_direct, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto cert = makeCert();
+  suspender.dismiss();
+  signConcurrently(*cert, iters);
+}
+
+BENCHMARK_RELATIVE(sign_sequential_inline, iters) {
+  signBatched(iters, std::make_unique<SequentialBatchSigner>(), kNumThreads);
+}
+
+BENCHMARK_RELATIVE(sign_queued_batch_4, iters) {
+  signBatched(iters, std::make_unique<QueuedSequentialBatchSigner>(), 4);
+}
+
+BENCHMARK_RELATIVE(sign_queued_batch_8, iters) {
+  signBatched(
+      iters, std::make_unique<QueuedSequentialBatchSigner>(), kNumThreads);
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <folly/Conv.h>
+
+#include <fizz/crypto/test/TestUtil.h>
+#include <fizz/protocol/Certificate.h>
+
+#include <quic/fizz/server/handshake/BatchSigningCert.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+
+std::shared_ptr<fizz::SelfCert> makeCert() {
+  std::vector<folly::ssl::X509UniquePtr> certs;
+  certs.emplace_back(fizz::test::getCert(fizz::test::kP256Certificate));
+  return std::make_shared<fizz::SelfCertImpl<fizz::KeyType::P256>>(
+      fizz::test::getPrivateKey(fizz::test::kP256Key), std::move(certs));
+}
+
+void verify(folly::ByteRange toBeSigned, folly::IOBuf& signature) {
+  fizz::PeerCertImpl<fizz::KeyType::P256> peerCert(
+      fizz::test::getCert(fizz::test::kP256Certificate));
+  peerCert.verify(
+      fizz::SignatureScheme::ecdsa_secp256r1_sha256,
+      fizz::CertificateVerifyContext::Server,
+      toBeSigned,
+      signature.coalesce());
+}
+
+// Records the size of every batch before signing it sequentially, and
+// pretends batches are cheaper so that they are formed.
+class RecordingBatchSigner : public SequentialBatchSigner {
+ public:
+  explicit RecordingBatchSigner(std::vector<size_t>& batchSizes)
+      : batchSizes_(batchSizes) {}
+
+  void signBatch(folly::Range<Request*> requests) override {
+    batchSizes_.push_back(requests.size());
+    SequentialBatchSigner::signBatch(requests);
+  }
+
+  bool amortizesBatches() const override {
+    return true;
+  }
+
+ private:
+  std::vector<size_t>& batchSizes_;
+};
+
+} // namespace
+
+TEST(BatchSigningCertTest, ForwardsToCert) {
+  auto cert = makeCert();
+  auto service = std::make_shared<BatchSigningService>(
+      std::make_unique<SequentialBatchSigner>(),
+      BatchSigningService::Options{1, std::chrono::microseconds(0)});
+  BatchSigningCert batchCert(cert, service);
+  EXPECT_EQ(batchCert.getIdentity(), cert->getIdentity());
+  EXPECT_EQ(batchCert.getSigSchemes(), cert->getSigSchemes());
+
+  auto toBeSigned = folly::StringPiece("to be signed");
+  auto signature = batchCert.sign(
+      fizz::SignatureScheme::ecdsa_secp256r1_sha256,
+      fizz::CertificateVerifyContext::Server,
+      folly::ByteRange(toBeSigned));
+  verify(folly::ByteRange(toBeSigned), *signature);
+  EXPECT_EQ(service->numBatches(), 1);
+  EXPECT_EQ(service->numSignatures(), 1);
+}
+
+TEST(BatchSigningCertTest, SequentialSignsInline) {
+  constexpr size_t kNumThreads = 8;
+  // A batch is never full, so every signature would wait for 30s if it were
+  // queued.
+  auto service = std::make_shared<BatchSigningService>(
+      std::make_unique<SequentialBatchSigner>(),
+      BatchSigningService::Options{2 * kNumThreads, std::chrono::seconds(30)});
+  BatchSigningCert batchCert(makeCert(), service);
+  auto toBeSigned = folly::StringPiece("to be signed");
+  std::vector<std::unique_ptr<folly::IOBuf>> signatures(kNumThreads);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, i] {
+      signatures[i] = batchCert.sign(
+          fizz::SignatureScheme::ecdsa_secp256r1_sha256,
+          fizz::CertificateVerifyContext::Server,
+          folly::ByteRange(toBeSigned));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(30));
+  EXPECT_EQ(service->numBatches(), kNumThreads);
+  EXPECT_EQ(service->numSignatures(), kNumThreads);
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    ASSERT_TRUE(signatures[i]);
+    verify(folly::ByteRange(toBeSigned), *signatures[i]);
+  }
+}
+
+TEST(BatchSigningCertTest, DelayExpires) {
+  std::vector<size_t> batchSizes;
+  auto service = std::make_shared<BatchSigningService>(
+      std::make_unique<RecordingBatchSigner>(batchSizes),
+      BatchSigningService::Options{16, std::chrono::microseconds(1000)});
+  BatchSigningCert batchCert(makeCert(), service);
+  auto toBeSigned = folly::StringPiece("to be signed");
+  auto signature = batchCert.sign(
+      fizz::SignatureScheme::ecdsa_secp256r1_sha256,
+      fizz::CertificateVerifyContext::Server,
+      folly::ByteRange(toBeSigned));
+  verify(folly::ByteRange(toBeSigned), *signature);
+  EXPECT_THAT(batchSizes, ElementsAre(1));
+}
+
+TEST(BatchSigningCertTest, ConcurrentSignaturesBatched) {
+  constexpr size_t kNumThreads = 8;
+  std::vector<size_t> batchSizes;
+  // Long enough that the batch is only ever signed once it is full.
+  auto service = std::make_shared<BatchSigningService>(
+      std::make_unique<RecordingBatchSigner>(batchSizes),
+      BatchSigningService::Options{kNumThreads, std::chrono::seconds(30)});
+  BatchSigningCert batchCert(makeCert(), service);
+
+  std::vector<std::string> inputs;
+  std::vector<std::unique_ptr<folly::IOBuf>> signatures(kNumThreads);
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    inputs.push_back(folly::to<std::string>("to be signed ", i));
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, i] {
+      signatures[i] = batchCert.sign(
+          fizz::SignatureScheme::ecdsa_secp256r1_sha256,
+          fizz::CertificateVerifyContext::Server,
+          folly::ByteRange(folly::StringPiece(inputs[i])));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_THAT(batchSizes, ElementsAre(kNumThreads));
+  EXPECT_EQ(service->numSignatures(), kNumThreads);
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    ASSERT_TRUE(signatures[i]);
+    verify(folly::ByteRange(folly::StringPiece(inputs[i])), *signatures[i]);
+  }
+}
+
+TEST(BatchSigningCertTest, ErrorPropagated) {
+  class FailingBatchSigner : public BatchSigner {
+   public:
+    void signBatch(folly::Range<Request*> requests) override {
+      for (auto& request : requests) {
+        request.error =
+            std::make_exception_ptr(std::runtime_error("no signature"));
+      }
+    }
+  };
+  auto service = std::make_shared<BatchSigningService>(
+      std::make_unique<FailingBatchSigner>(),
+      BatchSigningService::Options{1, std::chrono::microseconds(0)});
+  BatchSigningCert batchCert(makeCert(), service);
+  EXPECT_THROW(
+      batchCert.sign(
+          fizz::SignatureScheme::ecdsa_secp256r1_sha256,
+          fizz::CertificateVerifyContext::Server,
+          folly::ByteRange(folly::StringPiece("to be signed"))),
+      std::runtime_error);
+}
+
+} // namespace test
+} // namespace quic
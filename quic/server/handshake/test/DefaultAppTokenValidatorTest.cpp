@@ -90,6 +90,49 @@ TEST(
   EXPECT_EQ(conn.flowControlState.advertisedMaxOffset, initialMaxData - 1);
 }
 
+TEST(DefaultAppTokenValidatorTest, TestCarefulResumePathCharacteristics) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.peerAddress = folly::SocketAddress("1.2.3.4", 443);
+  conn.version = QuicVersion::MVFST;
+  conn.transportSettings.zeroRttSourceTokenMatchingPolicy =
+      ZeroRttSourceTokenMatchingPolicy::LIMIT_IF_NO_EXACT_MATCH;
+  conn.transportSettings.carefulResume.enabled = true;
+
+  AppToken appToken;
+  appToken.transportParams = createTicketTransportParameters(
+      conn.transportSettings.idleTimeout.count(),
+      conn.transportSettings.maxRecvPacketSize,
+      conn.transportSettings.advertisedInitialConnectionWindowSize,
+      conn.transportSettings.advertisedInitialBidiLocalStreamWindowSize,
+      conn.transportSettings.advertisedInitialBidiRemoteStreamWindowSize,
+      conn.transportSettings.advertisedInitialUniStreamWindowSize,
+      conn.transportSettings.advertisedInitialMaxStreamsBidi,
+      conn.transportSettings.advertisedInitialMaxStreamsUni);
+  appToken.bandwidth = 10 * 1000 * 1000;
+  appToken.minRtt = std::chrono::microseconds(40000);
+  ResumptionState resState;
+  resState.appToken = encodeAppToken(appToken);
+  resState.ticketIssueTime = std::chrono::system_clock::now();
+
+  conn.earlyDataAppParamsValidator = [](const folly::Optional<std::string>&,
+                                        const Buf&) { return true; };
+  DefaultAppTokenValidator validator(&conn);
+  EXPECT_TRUE(validator.validate(resState));
+  ASSERT_TRUE(validator.getResumedPath().has_value());
+  EXPECT_EQ(validator.getResumedPath()->bandwidth, appToken.bandwidth);
+  EXPECT_EQ(validator.getResumedPath()->minRtt, appToken.minRtt);
+  // Left for the transport to apply on its EventBase.
+  EXPECT_EQ(conn.resumedBandwidth, 0);
+
+  // Too old to describe the path any more.
+  resState.ticketIssueTime = std::chrono::system_clock::now() -
+      conn.transportSettings.carefulResume.maxTicketAge -
+      std::chrono::seconds(1);
+  EXPECT_TRUE(validator.validate(resState));
+  EXPECT_FALSE(validator.getResumedPath().has_value());
+}
+
 TEST(DefaultAppTokenValidatorTest, TestInvalidNullAppToken) {
   QuicServerConnectionState conn(
       FizzServerQuicHandshakeContext::Builder().build());
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <folly/executors/ManualExecutor.h>
+#include <folly/synchronization/Baton.h>
+
+#include <quic/server/handshake/HandshakeOffloadExecutor.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+TEST(HandshakeOffloadExecutorTest, BoundsPending) {
+  auto executor = std::make_shared<folly::ManualExecutor>();
+  HandshakeOffloadExecutor offload(executor, 2);
+  int ran = 0;
+  EXPECT_TRUE(offload.tryAdd([&](std::chrono::microseconds) { ran++; }));
+  EXPECT_TRUE(offload.tryAdd([&](std::chrono::microseconds) { ran++; }));
+  EXPECT_FALSE(offload.tryAdd([&](std::chrono::microseconds) { ran++; }));
+  EXPECT_EQ(offload.pending(), 2);
+
+  executor->drain();
+  EXPECT_EQ(ran, 2);
+  EXPECT_EQ(offload.pending(), 0);
+  EXPECT_TRUE(offload.tryAdd([&](std::chrono::microseconds) { ran++; }));
+  executor->drain();
+  EXPECT_EQ(ran, 3);
+}
+
+TEST(HandshakeOffloadExecutorTest, PendingWhileRunning) {
+  auto executor = std::make_shared<folly::ManualExecutor>();
+  HandshakeOffloadExecutor offload(executor, 1);
+  size_t pendingInJob = 0;
+  EXPECT_TRUE(offload.tryAdd(
+      [&](std::chrono::microseconds) { pendingInJob = offload.pending(); }));
+  executor->drain();
+  EXPECT_EQ(pendingInJob, 1);
+  EXPECT_EQ(offload.pending(), 0);
+}
+
+TEST(HandshakeOffloadExecutorTest, ReportsQueueDelay) {
+  auto executor = std::make_shared<folly::ManualExecutor>();
+  HandshakeOffloadExecutor offload(executor, 1);
+  std::chrono::microseconds queueDelay{0};
+  EXPECT_TRUE(offload.tryAdd(
+      [&](std::chrono::microseconds delay) { queueDelay = delay; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  executor->drain();
+  EXPECT_GE(queueDelay, std::chrono::milliseconds(10));
+}
+
+TEST(HandshakeOffloadExecutorTest, ThreadPool) {
+  auto offload = HandshakeOffloadExecutor::makeThreadPool(2, 16);
+  folly::Baton<> baton;
+  EXPECT_TRUE(offload->tryAdd([&](std::chrono::microseconds) {
+    baton.post();
+  }));
+  baton.wait();
+}
+
+} // namespace test
+} // namespace quic
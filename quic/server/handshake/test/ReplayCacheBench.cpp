@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <quic/server/handshake/ShardedReplayCache.h>
+
+#include <array>
+#include <cstring>
+#include <thread>
+
+/**
+ * Measures the cost of a 0-RTT replay check, from one thread and from several
+ * threads sharing the cache the way workers do.
+ */
+
+using namespace quic;
+
+namespace {
+
+void checkBinders(ShardedReplayCache& cache, size_t iters, uint64_t seed) {
+  // Same size as a SHA256 PSK binder.
+  std::array<uint8_t, 32> binder{};
+  auto now = Clock::now();
+  for (uint64_t i = 0; i < iters; ++i) {
+    uint64_t id = seed + i;
+    std::memcpy(binder.data(), &id, sizeof(id));
+    folly::doNotOptimizeAway(cache.testAndInsert(folly::range(binder), now));
+  }
+}
+
+void checkConcurrently(size_t iters, size_t numThreads) {
+  folly::BenchmarkSuspender suspender;
+  ShardedReplayCache cache{ShardedReplayCache::Options()};
+  suspender.dismiss();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&, i] {
+      checkBinders(cache, iters / numThreads + 1, uint64_t(i) << 40);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace
+
+BENCHMARK(replay_check_single_thread, iters) {
+  folly::BenchmarkSuspender suspender;
+  ShardedReplayCache cache{ShardedReplayCache::Options()};
+  suspender.dismiss();
+  checkBinders(cache, iters, 0);
+}
+
+BENCHMARK_RELATIVE(replay_check_4_threads, iters) {
+  checkConcurrently(iters, 4);
+}
+
+BENCHMARK_RELATIVE(replay_check_16_threads, iters) {
+  checkConcurrently(iters, 16);
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -18,6 +18,8 @@
 #include <fizz/protocol/test/Mocks.h>
 #include <fizz/server/test/Mocks.h>
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/io/async/test/MockAsyncTransport.h>
@@ -33,6 +35,7 @@
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
 #include <quic/handshake/HandshakeLayer.h>
 #include <quic/server/handshake/AppToken.h>
+#include <quic/server/handshake/HandshakeOffloadExecutor.h>
 #include <quic/server/handshake/ServerHandshake.h>
 #include <quic/state/StateData.h>
 
@@ -85,6 +88,7 @@ class ServerHandshakeTest : public Test {
     setupClientAndServerContext();
     auto fizzServerContext = FizzServerQuicHandshakeContext::Builder()
                                  .setFizzServerContext(serverCtx)
+                                 .setHandshakeOffloadExecutor(offloadExecutor)
                                  .build();
     conn.reset(new TestingServerConnectionState(fizzServerContext));
     cryptoState = conn->cryptoState.get();
@@ -366,6 +370,7 @@ class ServerHandshakeTest : public Test {
   std::shared_ptr<fizz::test::MockCertificateVerifier> verifier;
   std::shared_ptr<fizz::client::FizzClientContext> clientCtx;
   std::shared_ptr<fizz::server::FizzServerContext> serverCtx;
+  std::shared_ptr<HandshakeOffloadExecutor> offloadExecutor;
   folly::Baton<> handshakeCv;
   bool inRoundScope_{false};
   bool waitForData{false};
@@ -865,5 +870,124 @@ TEST_F(ServerHandshakeZeroRttTest, TestRejectZeroRttInvalidToken) {
   EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::Established);
   expectOneRttCipher(true);
 }
+
+class ServerHandshakeOffloadTest : public ServerHandshakeTest {
+ public:
+  ~ServerHandshakeOffloadTest() override = default;
+
+  void setupClientAndServerContext() override {
+    cpuExecutor = std::make_shared<folly::ManualExecutor>();
+    offloadExecutor =
+        std::make_shared<HandshakeOffloadExecutor>(cpuExecutor, 1);
+  }
+
+  std::shared_ptr<folly::ManualExecutor> cpuExecutor;
+};
+
+TEST_F(ServerHandshakeOffloadTest, TestHandshakeSuccess) {
+  clientServerRound();
+  // The ClientHello waits for the offload executor.
+  EXPECT_EQ(offloadExecutor->pending(), 1);
+  EXPECT_EQ(conn->handshakeWriteCipher, nullptr);
+  EXPECT_GT(conn->getDestructorGuardCount(), 0);
+
+  cpuExecutor->drain();
+  evb.loop();
+  EXPECT_EQ(offloadExecutor->pending(), 0);
+  EXPECT_NE(handshakeWriteCipher, nullptr);
+
+  serverClientRound();
+  clientServerRound();
+  EXPECT_EQ(offloadExecutor->pending(), 0);
+  EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::Established);
+  if (ex) {
+    std::rethrow_exception(ex);
+  }
+  expectOneRttCipher(true);
+  EXPECT_TRUE(handshakeSuccess);
+}
+
+TEST_F(ServerHandshakeOffloadTest, TestQueueFull) {
+  EXPECT_TRUE(offloadExecutor->tryAdd([](std::chrono::microseconds) {}));
+  clientServerRound();
+  ASSERT_TRUE(ex);
+  try {
+    std::rethrow_exception(ex);
+  } catch (const QuicTransportException& e) {
+    EXPECT_EQ(e.errorCode(), TransportErrorCode::SERVER_BUSY);
+  }
+  EXPECT_EQ(conn->getDestructorGuardCount(), 0);
+  cpuExecutor->drain();
+  EXPECT_EQ(offloadExecutor->pending(), 0);
+}
+
+TEST_F(ServerHandshakeOffloadTest, TestCancelWhileOffloaded) {
+  clientServerRound();
+  EXPECT_EQ(offloadExecutor->pending(), 1);
+  EXPECT_CALL(serverCallback, onCryptoEventAvailable()).Times(0);
+  handshake->cancel();
+  cpuExecutor->drain();
+  // The canceled job skipped the state machine.
+  EXPECT_EQ(
+      handshake->getState().state(),
+      fizz::server::StateEnum::ExpectingClientHello);
+  // The connection is only destroyed once the job is back on the worker.
+  conn.reset();
+  evb.loop();
+}
+
+class ServerHandshakeThreadOffloadTest : public ServerHandshakeTest {
+ public:
+  ~ServerHandshakeThreadOffloadTest() override = default;
+
+  void setupClientAndServerContext() override {
+    offloadExecutor = HandshakeOffloadExecutor::makeThreadPool(1, 1);
+  }
+};
+
+TEST_F(ServerHandshakeThreadOffloadTest, TestHandshakeSuccess) {
+  clientServerRound();
+  // The job holds a keep alive on evb until it is back from the offload
+  // thread.
+  evb.loop();
+  EXPECT_EQ(offloadExecutor->pending(), 0);
+  EXPECT_NE(handshakeWriteCipher, nullptr);
+
+  serverClientRound();
+  clientServerRound();
+  EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::Established);
+  if (ex) {
+    std::rethrow_exception(ex);
+  }
+  expectOneRttCipher(true);
+  EXPECT_TRUE(handshakeSuccess);
+}
+
+class ServerHandshakeZeroRttOffloadTest : public ServerHandshakeZeroRttTest {
+ public:
+  ~ServerHandshakeZeroRttOffloadTest() override = default;
+
+  void setupClientAndServerContext() override {
+    cpuExecutor = std::make_shared<folly::ManualExecutor>();
+    offloadExecutor =
+        std::make_shared<HandshakeOffloadExecutor>(cpuExecutor, 1);
+    ServerHandshakeZeroRttTest::setupClientAndServerContext();
+  }
+
+  std::shared_ptr<folly::ManualExecutor> cpuExecutor;
+};
+
+TEST_F(ServerHandshakeZeroRttOffloadTest, TestResumptionStaysOnWorker) {
+  // The app token validator reads and updates the connection state.
+  EXPECT_CALL(*validator_, validate(_)).WillOnce(Return(true));
+  clientServerRound();
+  EXPECT_EQ(offloadExecutor->pending(), 0);
+  EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::KeysDerived);
+  expectZeroRttCipher(true, false);
+  serverClientRound();
+  clientServerRound();
+  EXPECT_EQ(handshake->getPhase(), ServerHandshake::Phase::Established);
+  expectZeroRttCipher(true, true);
+}
 } // namespace test
 } // namespace quic
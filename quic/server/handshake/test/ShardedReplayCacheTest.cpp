@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include <quic/fizz/server/handshake/FizzReplayCache.h>
+#include <quic/server/handshake/ShardedReplayCache.h>
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+
+ShardedReplayCache::Options makeOptions() {
+  ShardedReplayCache::Options options;
+  options.numShards = 4;
+  options.capacity = 1024;
+  options.window = 3s;
+  options.numBuckets = 4;
+  return options;
+}
+
+folly::ByteRange toRange(folly::StringPiece str) {
+  return folly::ByteRange(str);
+}
+
+class FailingReplayCacheBackend : public ReplayCacheBackend {
+ public:
+  folly::Future<bool> testAndInsert(folly::ByteRange) override {
+    return folly::makeFuture<bool>(std::runtime_error("unavailable"));
+  }
+};
+
+} // namespace
+
+TEST(ShardedReplayCacheTest, DetectsReplay) {
+  ShardedReplayCache cache(makeOptions());
+  auto now = Clock::now();
+  EXPECT_FALSE(cache.testAndInsert(toRange("binder1"), now));
+  EXPECT_FALSE(cache.testAndInsert(toRange("binder2"), now));
+  EXPECT_TRUE(cache.testAndInsert(toRange("binder1"), now));
+  EXPECT_TRUE(cache.testAndInsert(toRange("binder2"), now + 1s));
+}
+
+TEST(ShardedReplayCacheTest, RemembersForWindow) {
+  ShardedReplayCache cache(makeOptions());
+  auto now = Clock::now();
+  EXPECT_FALSE(cache.testAndInsert(toRange("binder"), now));
+  // Buckets are 1s long, the one the binder went into is only cleared once
+  // the fourth bucket after it starts.
+  EXPECT_TRUE(cache.testAndInsert(toRange("binder"), now + 3s));
+}
+
+TEST(ShardedReplayCacheTest, ForgetsAfterWindow) {
+  ShardedReplayCache cache(makeOptions());
+  auto now = Clock::now();
+  EXPECT_FALSE(cache.testAndInsert(toRange("binder"), now));
+  for (int i = 1; i <= 4; i++) {
+    cache.testAndInsert(
+        toRange(folly::to<std::string>("other", i)),
+        now + std::chrono::seconds(i));
+  }
+  EXPECT_FALSE(cache.testAndInsert(toRange("binder"), now + 4s));
+}
+
+TEST(ShardedReplayCacheTest, ForgetsAfterIdle) {
+  ShardedReplayCache cache(makeOptions());
+  auto now = Clock::now();
+  EXPECT_FALSE(cache.testAndInsert(toRange("binder"), now));
+  EXPECT_FALSE(cache.testAndInsert(toRange("binder"), now + 1h));
+}
+
+TEST(ShardedReplayCacheTest, FalsePositiveRate) {
+  auto options = makeOptions();
+  options.capacity = 10000;
+  ShardedReplayCache cache(options);
+  auto now = Clock::now();
+  for (int i = 0; i < 10000; i++) {
+    cache.testAndInsert(toRange(folly::to<std::string>("inserted", i)), now);
+  }
+  int falsePositives = 0;
+  for (int i = 0; i < 10000; i++) {
+    if (cache.testAndInsert(toRange(folly::to<std::string>("fresh", i)), now)) {
+      falsePositives++;
+    }
+  }
+  EXPECT_LT(falsePositives, 300);
+}
+
+TEST(ShardedReplayCacheTest, FizzReplayCache) {
+  FizzReplayCache cache(std::make_shared<ShardedReplayCache>(makeOptions()));
+  EXPECT_EQ(
+      cache.check(toRange("binder")).get(),
+      fizz::server::ReplayCacheResult::NotReplay);
+  EXPECT_EQ(
+      cache.check(toRange("binder")).get(),
+      fizz::server::ReplayCacheResult::MaybeReplay);
+}
+
+TEST(ShardedReplayCacheTest, FizzReplayCacheBackendError) {
+  FizzReplayCache cache(std::make_shared<FailingReplayCacheBackend>());
+  EXPECT_EQ(
+      cache.check(toRange("binder")).get(),
+      fizz::server::ReplayCacheResult::MaybeReplay);
+}
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/state/ConnectionHandoff.h>
+
+#include <quic/state/QuicPacingFunctions.h>
+
+#include <fizz/record/Types.h>
+
+#include <algorithm>
+
+namespace quic {
+
+namespace {
+
+// Bumped whenever the encoding changes, a process only resumes connections
+// handed off with the same version.
+constexpr uint8_t kConnectionHandoffVersion = 3;
+
+bool isStreamQuiescent(const QuicStreamLike& stream) {
+  return stream.readBuffer.empty() && stream.writeBuffer.empty() &&
+      stream.retransmissionBuffer.empty() && stream.lossBuffer.empty();
+}
+
+bool isQuiescent(const QuicServerConnectionState& conn) {
+  if (conn.state != ServerState::Open || conn.localConnectionError ||
+      conn.peerConnectionError) {
+    return false;
+  }
+  if (!conn.serverHandshakeLayer->isHandshakeDone() ||
+      !conn.serverHandshakeLayer->getState().cipher() ||
+      !conn.sentHandshakeDone || !conn.version || !conn.readCodec ||
+      !conn.readCodec->getOneRttReadCipher() ||
+      !conn.readCodec->getOneRttHeaderCipher() || !conn.oneRttWriteCipher ||
+      !conn.oneRttWriteHeaderCipher || !conn.clientChosenDestConnectionId ||
+      !conn.clientConnectionId || !conn.serverConnectionId) {
+    return false;
+  }
+  if (!conn.outstandings.packets.empty() || conn.outstandingPathValidation) {
+    return false;
+  }
+  const auto& pendingEvents = conn.pendingEvents;
+  if (!pendingEvents.resets.empty() || pendingEvents.pathChallenge ||
+      !pendingEvents.frames.empty() || !pendingEvents.knobs.empty() ||
+      pendingEvents.anyProbePackets() || pendingEvents.connWindowUpdate ||
+      pendingEvents.sendPing || pendingEvents.sendDataBlocked) {
+    return false;
+  }
+  const auto& ackState = conn.ackStates.appDataAckState;
+  if (ackState.needsToSendAckImmediately || ackState.numRxPacketsRecvd > 0) {
+    return false;
+  }
+  if (!isStreamQuiescent(conn.cryptoState->initialStream) ||
+      !isStreamQuiescent(conn.cryptoState->handshakeStream) ||
+      !isStreamQuiescent(conn.cryptoState->oneRttStream)) {
+    return false;
+  }
+  if (!conn.datagramState.readBuffer.empty() ||
+      !conn.datagramState.writeBuffer.empty()) {
+    return false;
+  }
+  const auto& streamManager = *conn.streamManager;
+  if (streamManager.hasWritable() || streamManager.hasBlocked() ||
+      streamManager.hasWindowUpdates() ||
+      !streamManager.stopSendingStreams().empty() || streamManager.hasLoss()) {
+    return false;
+  }
+  for (const auto& it : streamManager.streams()) {
+    const auto& stream = it.second;
+    if (!isStreamQuiescent(stream) || stream.finalReadOffset ||
+        stream.finalWriteOffset || stream.dsrSender ||
+        stream.writeBufMeta.length > 0 ||
+        !stream.retransmissionBufMetas.empty() ||
+        !stream.lossBufMetas.empty()) {
+      return false;
+    }
+    if (stream.sendState != StreamSendState::Open &&
+        stream.sendState != StreamSendState::Invalid) {
+      return false;
+    }
+    if (stream.recvState != StreamRecvState::Open &&
+        stream.recvState != StreamRecvState::Invalid) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TrafficKey cloneKey(const TrafficKey& key) {
+  return TrafficKey{key.key->clone(), key.iv->clone()};
+}
+
+void writeBytes(folly::ByteRange bytes, folly::io::Appender& appender) {
+  fizz::detail::writeBuf<uint8_t>(
+      folly::IOBuf::wrapBuffer(bytes.data(), bytes.size()), appender);
+}
+
+void writeOptional(
+    const folly::Optional<uint64_t>& value,
+    folly::io::Appender& appender) {
+  fizz::detail::write(static_cast<uint8_t>(value.has_value()), appender);
+  if (value) {
+    fizz::detail::write(*value, appender);
+  }
+}
+
+void writeSocketAddress(
+    const folly::SocketAddress& address,
+    folly::io::Appender& appender) {
+  fizz::detail::write(
+      static_cast<uint8_t>(address.isInitialized()), appender);
+  if (!address.isInitialized()) {
+    return;
+  }
+  auto ip = address.getIPAddress();
+  writeBytes(folly::ByteRange(ip.bytes(), ip.byteCount()), appender);
+  fizz::detail::write(address.getPort(), appender);
+}
+
+void writeConnectionIds(
+    const std::vector<ConnectionIdData>& connIds,
+    folly::io::Appender& appender) {
+  fizz::detail::write(static_cast<uint16_t>(connIds.size()), appender);
+  for (const auto& connIdData : connIds) {
+    writeBytes(
+        folly::ByteRange(connIdData.connId.data(), connIdData.connId.size()),
+        appender);
+    fizz::detail::write(connIdData.sequenceNumber, appender);
+    fizz::detail::write(
+        static_cast<uint8_t>(connIdData.token.has_value()), appender);
+    if (connIdData.token) {
+      appender.push(connIdData.token->data(), connIdData.token->size());
+    }
+  }
+}
+
+void writeKey(const TrafficKey& key, folly::io::Appender& appender) {
+  fizz::detail::writeBuf<uint8_t>(key.key, appender);
+  fizz::detail::writeBuf<uint8_t>(key.iv, appender);
+}
+
+Buf readBuf(folly::io::Cursor& cursor) {
+  Buf buf;
+  fizz::detail::readBuf<uint8_t>(buf, cursor);
+  if (!buf) {
+    buf = folly::IOBuf::create(0);
+  }
+  return buf;
+}
+
+template <class T>
+T readInt(folly::io::Cursor& cursor) {
+  T value;
+  fizz::detail::read(value, cursor);
+  return value;
+}
+
+folly::Optional<uint64_t> readOptional(folly::io::Cursor& cursor) {
+  if (!readInt<uint8_t>(cursor)) {
+    return folly::none;
+  }
+  return readInt<uint64_t>(cursor);
+}
+
+ConnectionId readConnectionId(folly::io::Cursor& cursor) {
+  auto buf = readBuf(cursor);
+  auto range = buf->coalesce();
+  return ConnectionId(std::vector<uint8_t>(range.begin(), range.end()));
+}
+
+folly::SocketAddress readSocketAddress(folly::io::Cursor& cursor) {
+  if (!readInt<uint8_t>(cursor)) {
+    return folly::SocketAddress();
+  }
+  auto ip = readBuf(cursor);
+  auto port = readInt<uint16_t>(cursor);
+  return folly::SocketAddress(
+      folly::IPAddress::fromBinary(ip->coalesce()), port);
+}
+
+std::vector<ConnectionIdData> readConnectionIds(folly::io::Cursor& cursor) {
+  std::vector<ConnectionIdData> connIds;
+  auto count = readInt<uint16_t>(cursor);
+  for (uint16_t i = 0; i < count; ++i) {
+    auto connId = readConnectionId(cursor);
+    auto sequenceNumber = readInt<uint64_t>(cursor);
+    if (readInt<uint8_t>(cursor)) {
+      StatelessResetToken token;
+      cursor.pull(token.data(), token.size());
+      connIds.emplace_back(connId, sequenceNumber, token);
+    } else {
+      connIds.emplace_back(connId, sequenceNumber);
+    }
+  }
+  return connIds;
+}
+
+TrafficKey readKey(folly::io::Cursor& cursor) {
+  TrafficKey key;
+  key.key = readBuf(cursor);
+  key.iv = readBuf(cursor);
+  return key;
+}
+
+} // namespace
+
+folly::Optional<ConnectionHandoffState> getConnectionHandoffState(
+    const QuicServerConnectionState& conn) {
+  if (!isQuiescent(conn)) {
+    return folly::none;
+  }
+  auto oneRttReadKey = conn.readCodec->getOneRttReadCipher()->getKey();
+  auto oneRttWriteKey = conn.oneRttWriteCipher->getKey();
+  if (!oneRttReadKey || !oneRttWriteKey) {
+    // The crypto backend doesn't let the keys out.
+    return folly::none;
+  }
+
+  ConnectionHandoffState state;
+  state.version = *conn.version;
+  state.peerAddress = conn.peerAddress;
+  state.originalPeerAddress = conn.originalPeerAddress;
+  state.serverAddr = conn.serverAddr;
+  state.clientChosenDestConnectionId = *conn.clientChosenDestConnectionId;
+  state.clientConnectionId = *conn.clientConnectionId;
+  state.serverConnectionId = *conn.serverConnectionId;
+  state.selfConnectionIds = conn.selfConnectionIds;
+  state.peerConnectionIds = conn.peerConnectionIds;
+  state.nextSelfConnectionIdSequence = conn.nextSelfConnectionIdSequence;
+
+  state.cipherSuite = *conn.serverHandshakeLayer->getState().cipher();
+  state.alpn = conn.serverHandshakeLayer->getApplicationProtocol();
+  state.oneRttReadKey = cloneKey(*oneRttReadKey);
+  state.oneRttWriteKey = cloneKey(*oneRttWriteKey);
+  state.oneRttReadHeaderKey =
+      conn.readCodec->getOneRttHeaderCipher()->getKey()->clone();
+  state.oneRttWriteHeaderKey = conn.oneRttWriteHeaderCipher->getKey()->clone();
+
+  const auto& ackState = conn.ackStates.appDataAckState;
+  state.nextPacketNum = ackState.nextPacketNum;
+  state.largestAckedByPeer = ackState.largestAckedByPeer;
+  state.largestReceivedPacketNum = ackState.largestReceivedPacketNum;
+  state.acks = ackState.acks;
+
+  state.peerIdleTimeout = conn.peerIdleTimeout;
+  state.udpSendPacketLen = conn.udpSendPacketLen;
+  state.peerMaxUdpPayloadSize = conn.peerMaxUdpPayloadSize;
+  state.peerAckDelayExponent = conn.peerAckDelayExponent;
+  state.peerActiveConnectionIdLimit = conn.peerActiveConnectionIdLimit;
+
+  state.flowControlState = conn.flowControlState;
+  state.streamIdState = conn.streamManager->getStreamIdState();
+  for (const auto& it : conn.streamManager->streams()) {
+    const auto& stream = it.second;
+    StreamHandoffState streamState;
+    streamState.id = stream.id;
+    streamState.currentReadOffset = stream.currentReadOffset;
+    streamState.currentWriteOffset = stream.currentWriteOffset;
+    streamState.maxOffsetObserved = stream.maxOffsetObserved;
+    streamState.windowSize = stream.flowControlState.windowSize;
+    streamState.advertisedMaxOffset =
+        stream.flowControlState.advertisedMaxOffset;
+    streamState.peerAdvertisedMaxOffset =
+        stream.flowControlState.peerAdvertisedMaxOffset;
+    streamState.priority = stream.priority;
+    streamState.isControl = stream.isControl;
+    state.streams.push_back(streamState);
+  }
+
+  state.srtt = conn.lossState.srtt;
+  state.lrtt = conn.lossState.lrtt;
+  state.rttvar = conn.lossState.rttvar;
+  state.mrtt = conn.lossState.mrtt;
+  return state;
+}
+
+bool restoreConnectionHandoffState(
+    QuicServerConnectionState& conn,
+    ConnectionHandoffState state) {
+  CHECK(!conn.readCodec);
+  // The state comes from another process, it is validated before the
+  // connection is touched.
+  if (state.selfConnectionIds.empty() || !state.oneRttReadHeaderKey ||
+      !state.oneRttWriteHeaderKey) {
+    return false;
+  }
+  const auto& openStreams = state.streamIdState.openStreams;
+  for (const auto& streamState : state.streams) {
+    if (std::find(openStreams.begin(), openStreams.end(), streamState.id) ==
+        openStreams.end()) {
+      VLOG(4) << "Handed off stream is not open, id=" << streamState.id;
+      return false;
+    }
+  }
+  try {
+    conn.serverHandshakeLayer->resumeFromHandoff(
+        state.cipherSuite,
+        std::move(state.alpn),
+        state.oneRttReadKey,
+        state.oneRttWriteKey,
+        state.oneRttReadHeaderKey->coalesce(),
+        state.oneRttWriteHeaderKey->coalesce());
+  } catch (const std::exception& ex) {
+    VLOG(4) << "Failed to restore connection handoff state: " << ex.what();
+    return false;
+  }
+  conn.version = state.version;
+  conn.peerAddress = state.peerAddress;
+  conn.originalPeerAddress = state.originalPeerAddress;
+  conn.serverAddr = state.serverAddr;
+  conn.clientChosenDestConnectionId = state.clientChosenDestConnectionId;
+  conn.clientConnectionId = state.clientConnectionId;
+  conn.serverConnectionId = state.serverConnectionId;
+  conn.selfConnectionIds = std::move(state.selfConnectionIds);
+  conn.peerConnectionIds = std::move(state.peerConnectionIds);
+  conn.nextSelfConnectionIdSequence = state.nextSelfConnectionIdSequence;
+
+  conn.peerIdleTimeout = state.peerIdleTimeout;
+  conn.udpSendPacketLen = state.udpSendPacketLen;
+  conn.peerMaxUdpPayloadSize = state.peerMaxUdpPayloadSize;
+  conn.peerAckDelayExponent = state.peerAckDelayExponent;
+  conn.peerActiveConnectionIdLimit = state.peerActiveConnectionIdLimit;
+
+  conn.readCodec = std::make_unique<QuicReadCodec>(QuicNodeType::Server);
+  conn.readCodec->setClientConnectionId(*conn.clientConnectionId);
+  conn.readCodec->setServerConnectionId(*conn.serverConnectionId);
+  conn.readCodec->setCodecParameters(
+      CodecParameters(conn.peerAckDelayExponent, state.version));
+  conn.readCodec->setOneRttReadCipher(
+      conn.serverHandshakeLayer->getOneRttReadCipher());
+  conn.readCodec->setOneRttHeaderCipher(
+      conn.serverHandshakeLayer->getOneRttReadHeaderCipher());
+  conn.oneRttWriteCipher = conn.serverHandshakeLayer->getOneRttWriteCipher();
+  conn.oneRttWriteHeaderCipher =
+      conn.serverHandshakeLayer->getOneRttWriteHeaderCipher();
+  conn.writableBytesLimit = folly::none;
+  conn.sentHandshakeDone = true;
+  // Nothing will ever be sent or received in these spaces again.
+  conn.initialWriteCipher.reset();
+  conn.handshakeWriteCipher.reset();
+
+  auto& ackState = conn.ackStates.appDataAckState;
+  ackState.nextPacketNum = state.nextPacketNum;
+  ackState.largestAckedByPeer = state.largestAckedByPeer;
+  ackState.largestReceivedPacketNum = state.largestReceivedPacketNum;
+  ackState.acks = std::move(state.acks);
+
+  conn.flowControlState = state.flowControlState;
+  conn.streamManager->setStreamIdState(state.streamIdState);
+  for (const auto& streamState : state.streams) {
+    auto stream = conn.streamManager->getStream(streamState.id);
+    CHECK(stream);
+    stream->currentReadOffset = streamState.currentReadOffset;
+    stream->currentReceiveOffset = streamState.currentReadOffset;
+    stream->currentWriteOffset = streamState.currentWriteOffset;
+    stream->maxOffsetObserved = streamState.maxOffsetObserved;
+    if (streamState.currentWriteOffset > 0) {
+      // Everything written has been acked, or it would still be buffered.
+      stream->ackedIntervals.insert(0, streamState.currentWriteOffset - 1);
+    }
+    stream->flowControlState.windowSize = streamState.windowSize;
+    stream->flowControlState.advertisedMaxOffset =
+        streamState.advertisedMaxOffset;
+    stream->flowControlState.peerAdvertisedMaxOffset =
+        streamState.peerAdvertisedMaxOffset;
+    conn.streamManager->setStreamPriority(
+        stream->id,
+        streamState.priority.level,
+        streamState.priority.incremental);
+    if (streamState.isControl) {
+      conn.streamManager->setStreamAsControl(*stream);
+    }
+  }
+
+  conn.lossState.srtt = state.srtt;
+  conn.lossState.lrtt = state.lrtt;
+  conn.lossState.rttvar = state.rttvar;
+  conn.lossState.mrtt = state.mrtt;
+  updatePacingOnKeyEstablished(conn);
+  return true;
+}
+
+std::unique_ptr<folly::IOBuf> encodeConnectionHandoffState(
+    const ConnectionHandoffState& state) {
+  auto buf = folly::IOBuf::create(512);
+  folly::io::Appender appender(buf.get(), 512);
+  fizz::detail::write(kConnectionHandoffVersion, appender);
+  fizz::detail::write(static_cast<uint32_t>(state.version), appender);
+  writeSocketAddress(state.peerAddress, appender);
+  writeSocketAddress(state.originalPeerAddress, appender);
+  writeSocketAddress(state.serverAddr, appender);
+
+  for (const auto* connId :
+       {&state.clientChosenDestConnectionId,
+        &state.clientConnectionId,
+        &state.serverConnectionId}) {
+    writeBytes(folly::ByteRange(connId->data(), connId->size()), appender);
+  }
+  writeConnectionIds(state.selfConnectionIds, appender);
+  writeConnectionIds(state.peerConnectionIds, appender);
+  fizz::detail::write(state.nextSelfConnectionIdSequence, appender);
+
+  fizz::detail::write(static_cast<uint16_t>(state.cipherSuite), appender);
+  fizz::detail::write(static_cast<uint8_t>(state.alpn.has_value()), appender);
+  if (state.alpn) {
+    writeBytes(folly::ByteRange(folly::StringPiece(*state.alpn)), appender);
+  }
+  writeKey(state.oneRttReadKey, appender);
+  writeKey(state.oneRttWriteKey, appender);
+  fizz::detail::writeBuf<uint8_t>(state.oneRttReadHeaderKey, appender);
+  fizz::detail::writeBuf<uint8_t>(state.oneRttWriteHeaderKey, appender);
+
+  fizz::detail::write(state.nextPacketNum, appender);
+  writeOptional(state.largestAckedByPeer, appender);
+  writeOptional(state.largestReceivedPacketNum, appender);
+  fizz::detail::write(static_cast<uint16_t>(state.acks.size()), appender);
+  for (auto it = state.acks.cbegin(); it != state.acks.cend(); ++it) {
+    fizz::detail::write(it->start, appender);
+    fizz::detail::write(it->end, appender);
+  }
+
+  fizz::detail::write(
+      static_cast<uint64_t>(state.peerIdleTimeout.count()), appender);
+  fizz::detail::write(state.udpSendPacketLen, appender);
+  fizz::detail::write(state.peerMaxUdpPayloadSize, appender);
+  fizz::detail::write(state.peerAckDelayExponent, appender);
+  fizz::detail::write(state.peerActiveConnectionIdLimit, appender);
+
+  const auto& flowControl = state.flowControlState;
+  for (auto value :
+       {flowControl.windowSize,
+        flowControl.advertisedMaxOffset,
+        flowControl.peerAdvertisedMaxOffset,
+        flowControl.sumCurReadOffset,
+        flowControl.sumMaxObservedOffset,
+        flowControl.sumCurWriteOffset,
+        flowControl.sumCurStreamBufferLen,
+        flowControl.peerAdvertisedInitialMaxStreamOffsetBidiLocal,
+        flowControl.peerAdvertisedInitialMaxStreamOffsetBidiRemote,
+        flowControl.peerAdvertisedInitialMaxStreamOffsetUni}) {
+    fizz::detail::write(value, appender);
+  }
+  writeOptional(flowControl.largestMaxOffsetReceived, appender);
+
+  const auto& streamIds = state.streamIdState;
+  for (auto value :
+       {streamIds.nextAcceptablePeerBidirectionalStreamId,
+        streamIds.nextAcceptablePeerUnidirectionalStreamId,
+        streamIds.nextAcceptableLocalBidirectionalStreamId,
+        streamIds.nextAcceptableLocalUnidirectionalStreamId,
+        streamIds.nextBidirectionalStreamId,
+        streamIds.nextUnidirectionalStreamId,
+        streamIds.maxLocalBidirectionalStreamId,
+        streamIds.maxLocalUnidirectionalStreamId,
+        streamIds.maxRemoteBidirectionalStreamId,
+        streamIds.maxRemoteUnidirectionalStreamId}) {
+    fizz::detail::write(value, appender);
+  }
+  fizz::detail::write(
+      static_cast<uint32_t>(streamIds.openStreams.size()), appender);
+  for (auto streamId : streamIds.openStreams) {
+    fizz::detail::write(streamId, appender);
+  }
+
+  fizz::detail::write(static_cast<uint32_t>(state.streams.size()), appender);
+  for (const auto& stream : state.streams) {
+    fizz::detail::write(stream.id, appender);
+    fizz::detail::write(stream.currentReadOffset, appender);
+    fizz::detail::write(stream.currentWriteOffset, appender);
+    fizz::detail::write(stream.maxOffsetObserved, appender);
+    fizz::detail::write(stream.windowSize, appender);
+    fizz::detail::write(stream.advertisedMaxOffset, appender);
+    fizz::detail::write(stream.peerAdvertisedMaxOffset, appender);
+    fizz::detail::write(static_cast<uint8_t>(stream.priority.level), appender);
+    fizz::detail::write(
+        static_cast<uint8_t>(stream.priority.incremental), appender);
+    fizz::detail::write(static_cast<uint8_t>(stream.isControl), appender);
+  }
+
+  for (auto rtt : {state.srtt, state.lrtt, state.rttvar, state.mrtt}) {
+    fizz::detail::write(static_cast<uint64_t>(rtt.count()), appender);
+  }
+  return buf;
+}
+
+folly::Optional<ConnectionHandoffState> decodeConnectionHandoffState(
+    const folly::IOBuf& buf) {
+  ConnectionHandoffState state;
+  folly::io::Cursor cursor(&buf);
+  try {
+    if (readInt<uint8_t>(cursor) != kConnectionHandoffVersion) {
+      return folly::none;
+    }
+    state.version = static_cast<QuicVersion>(readInt<uint32_t>(cursor));
+    state.peerAddress = readSocketAddress(cursor);
+    state.originalPeerAddress = readSocketAddress(cursor);
+    state.serverAddr = readSocketAddress(cursor);
+
+    state.clientChosenDestConnectionId = readConnectionId(cursor);
+    state.clientConnectionId = readConnectionId(cursor);
+    state.serverConnectionId = readConnectionId(cursor);
+    state.selfConnectionIds = readConnectionIds(cursor);
+    state.peerConnectionIds = readConnectionIds(cursor);
+    state.nextSelfConnectionIdSequence = readInt<uint64_t>(cursor);
+
+    state.cipherSuite =
+        static_cast<fizz::CipherSuite>(readInt<uint16_t>(cursor));
+    if (readInt<uint8_t>(cursor)) {
+      state.alpn = readBuf(cursor)->moveToFbString().toStdString();
+    }
+    state.oneRttReadKey = readKey(cursor);
+    state.oneRttWriteKey = readKey(cursor);
+    state.oneRttReadHeaderKey = readBuf(cursor);
+    state.oneRttWriteHeaderKey = readBuf(cursor);
+
+    state.nextPacketNum = readInt<uint64_t>(cursor);
+    state.largestAckedByPeer = readOptional(cursor);
+    state.largestReceivedPacketNum = readOptional(cursor);
+    auto numAckIntervals = readInt<uint16_t>(cursor);
+    for (uint16_t i = 0; i < numAckIntervals; ++i) {
+      auto start = readInt<uint64_t>(cursor);
+      auto end = readInt<uint64_t>(cursor);
+      state.acks.insert(start, end);
+    }
+
+    state.peerIdleTimeout =
+        std::chrono::milliseconds(readInt<uint64_t>(cursor));
+    state.udpSendPacketLen = readInt<uint64_t>(cursor);
+    state.peerMaxUdpPayloadSize = readInt<uint64_t>(cursor);
+    state.peerAckDelayExponent = readInt<uint64_t>(cursor);
+    state.peerActiveConnectionIdLimit = readInt<uint64_t>(cursor);
+
+    auto& flowControl = state.flowControlState;
+    for (auto* value :
+         {&flowControl.windowSize,
+          &flowControl.advertisedMaxOffset,
+          &flowControl.peerAdvertisedMaxOffset,
+          &flowControl.sumCurReadOffset,
+          &flowControl.sumMaxObservedOffset,
+          &flowControl.sumCurWriteOffset,
+          &flowControl.sumCurStreamBufferLen,
+          &flowControl.peerAdvertisedInitialMaxStreamOffsetBidiLocal,
+          &flowControl.peerAdvertisedInitialMaxStreamOffsetBidiRemote,
+          &flowControl.peerAdvertisedInitialMaxStreamOffsetUni}) {
+      *value = readInt<uint64_t>(cursor);
+    }
+    flowControl.largestMaxOffsetReceived = readOptional(cursor);
+
+    auto& streamIds = state.streamIdState;
+    for (auto* value :
+         {&streamIds.nextAcceptablePeerBidirectionalStreamId,
+          &streamIds.nextAcceptablePeerUnidirectionalStreamId,
+          &streamIds.nextAcceptableLocalBidirectionalStreamId,
+          &streamIds.nextAcceptableLocalUnidirectionalStreamId,
+          &streamIds.nextBidirectionalStreamId,
+          &streamIds.nextUnidirectionalStreamId,
+          &streamIds.maxLocalBidirectionalStreamId,
+          &streamIds.maxLocalUnidirectionalStreamId,
+          &streamIds.maxRemoteBidirectionalStreamId,
+          &streamIds.maxRemoteUnidirectionalStreamId}) {
+      *value = readInt<StreamId>(cursor);
+    }
+    auto numOpenStreams = readInt<uint32_t>(cursor);
+    for (uint32_t i = 0; i < numOpenStreams; ++i) {
+      streamIds.openStreams.push_back(readInt<StreamId>(cursor));
+    }
+
+    auto numStreams = readInt<uint32_t>(cursor);
+    for (uint32_t i = 0; i < numStreams; ++i) {
+      StreamHandoffState stream;
+      stream.id = readInt<StreamId>(cursor);
+      stream.currentReadOffset = readInt<uint64_t>(cursor);
+      stream.currentWriteOffset = readInt<uint64_t>(cursor);
+      stream.maxOffsetObserved = readInt<uint64_t>(cursor);
+      stream.windowSize = readInt<uint64_t>(cursor);
+      stream.advertisedMaxOffset = readInt<uint64_t>(cursor);
+      stream.peerAdvertisedMaxOffset = readInt<uint64_t>(cursor);
+      auto level = readInt<uint8_t>(cursor);
+      auto incremental = readInt<uint8_t>(cursor);
+      stream.priority = Priority(level, incremental);
+      stream.isControl = readInt<uint8_t>(cursor);
+      state.streams.push_back(stream);
+    }
+
+    for (auto* rtt : {&state.srtt, &state.lrtt, &state.rttvar, &state.mrtt}) {
+      *rtt = std::chrono::microseconds(readInt<uint64_t>(cursor));
+    }
+  } catch (const std::exception& ex) {
+    VLOG(4) << "Failed to decode connection handoff state: " << ex.what();
+    return folly::none;
+  }
+  return state;
+}
+
+} // namespace quic
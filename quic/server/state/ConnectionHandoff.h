@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/server/state/ServerStateMachine.h>
+
+#include <folly/Optional.h>
+#include <folly/io/IOBuf.h>
+
+namespace quic {
+
+/**
+ * State of a stream of a connection being handed off. Only streams without
+ * any buffered, in flight or lost data can be handed off, so the offsets and
+ * flow control windows are all there is to it.
+ */
+struct StreamHandoffState {
+  StreamId id;
+  uint64_t currentReadOffset{0};
+  uint64_t currentWriteOffset{0};
+  uint64_t maxOffsetObserved{0};
+  uint64_t windowSize{0};
+  uint64_t advertisedMaxOffset{0};
+  uint64_t peerAdvertisedMaxOffset{0};
+  Priority priority{kDefaultPriority};
+  bool isControl{false};
+};
+
+/**
+ * Everything needed to resume an established server connection in another
+ * process, e.g. the one taking over the listening sockets during a hot
+ * restart. Compared to forwarding its packets to the old process until it
+ * drains, the connection stays a single hop away and the old process can
+ * exit right away.
+ *
+ * Only quiescent connections can be handed off: handshake done and
+ * confirmed, nothing in flight, nothing buffered on any stream, and every
+ * ack-eliciting packet received acked. Anything else (loss recovery state,
+ * buffered data, pending frames) is not carried over.
+ *
+ * Idle streams, e.g. the control and QPACK streams of HTTP/3, are carried
+ * over with their offsets and flow control windows. The application state
+ * that goes with them is not: the application hands it off alongside, and
+ * sets its callbacks on the streams again once the connection is resumed.
+ */
+struct ConnectionHandoffState {
+  QuicVersion version;
+  folly::SocketAddress peerAddress;
+  folly::SocketAddress originalPeerAddress;
+  folly::SocketAddress serverAddr;
+
+  ConnectionId clientChosenDestConnectionId;
+  ConnectionId clientConnectionId;
+  ConnectionId serverConnectionId;
+  std::vector<ConnectionIdData> selfConnectionIds;
+  std::vector<ConnectionIdData> peerConnectionIds;
+  uint64_t nextSelfConnectionIdSequence{0};
+
+  // 1-rtt keys, there is no other key material left once the handshake is
+  // confirmed.
+  fizz::CipherSuite cipherSuite;
+  folly::Optional<std::string> alpn;
+  TrafficKey oneRttReadKey;
+  TrafficKey oneRttWriteKey;
+  Buf oneRttReadHeaderKey;
+  Buf oneRttWriteHeaderKey;
+
+  // AppData packet number space.
+  PacketNum nextPacketNum{0};
+  folly::Optional<PacketNum> largestAckedByPeer;
+  folly::Optional<PacketNum> largestReceivedPacketNum;
+  AckBlocks acks;
+
+  // Negotiated with the peer.
+  std::chrono::milliseconds peerIdleTimeout;
+  uint64_t udpSendPacketLen{0};
+  uint64_t peerMaxUdpPayloadSize{0};
+  uint64_t peerAckDelayExponent{0};
+  uint64_t peerActiveConnectionIdLimit{0};
+
+  QuicConnectionStateBase::ConnectionFlowControlState flowControlState;
+  QuicStreamManager::StreamIdState streamIdState;
+  // Only the streams whose state has been created, the other open ones are
+  // in streamIdState.
+  std::vector<StreamHandoffState> streams;
+
+  // Saves the new process from having to estimate the rtt from scratch.
+  std::chrono::microseconds srtt;
+  std::chrono::microseconds lrtt;
+  std::chrono::microseconds rttvar;
+  std::chrono::microseconds mrtt;
+};
+
+/**
+ * Returns the handoff state of conn, or none if it isn't quiescent.
+ */
+folly::Optional<ConnectionHandoffState> getConnectionHandoffState(
+    const QuicServerConnectionState& conn);
+
+/**
+ * Restores a handoff state on a connection which has not processed any
+ * packet yet, installing its read codec and ciphers. The connection must
+ * have its ConnectionIdAlgo and transport settings set already.
+ * Returns false, leaving the connection to be dropped, if the state cannot be
+ * restored, e.g. its keys do not match its cipher suite.
+ */
+bool restoreConnectionHandoffState(
+    QuicServerConnectionState& conn,
+    ConnectionHandoffState state);
+
+std::unique_ptr<folly::IOBuf> encodeConnectionHandoffState(
+    const ConnectionHandoffState& state);
+
+folly::Optional<ConnectionHandoffState> decodeConnectionHandoffState(
+    const folly::IOBuf& buf);
+
+} // namespace quic
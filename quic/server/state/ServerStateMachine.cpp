@@ -395,6 +395,11 @@ void updateHandshakeState(QuicServerConnectionState& conn) {
     if (conn.version != QuicVersion::MVFST_D24 && !conn.sentHandshakeDone) {
       sendSimpleFrame(conn, HandshakeDoneFrame());
       conn.sentHandshakeDone = true;
+      QUIC_STATS(
+          conn.statsCallback,
+          onHandshakeDone,
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              Clock::now() - conn.connectionTime));
     }
   }
 }
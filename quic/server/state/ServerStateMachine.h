@@ -40,6 +40,9 @@
 
 namespace quic {
 
+class InProcessCcpDatapath;
+class PathStateCache;
+
 enum ServerState {
   Open,
   Closed,
@@ -139,6 +142,22 @@ struct QuicServerConnectionState : public QuicConnectionStateBase {
   struct ccp_datapath* ccpDatapath;
 #endif
 
+  // The worker's InProcessCcpDatapath when CCP runs in this process, which
+  // the QuicCCP congestion control algorithm reports to instead of libccp.
+  InProcessCcpDatapath* inProcessCcpDatapath{nullptr};
+
+  // Where the connection records its path state when it closes, shared with
+  // the other workers.
+  PathStateCache* pathStateCache{nullptr};
+  // Whether the transport settings were seeded from pathStateCache.
+  bool warmStarted{false};
+
+  // Path characteristics from the session ticket of a 0-RTT resumption, set
+  // by the transport when careful resume starts. The bandwidth is in bytes
+  // per second.
+  uint64_t resumedBandwidth{0};
+  std::chrono::microseconds resumedMinRtt{0};
+
   folly::Optional<ConnectionIdData> createAndAddNewSelfConnId() override;
 
   QuicServerConnectionState(
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+#include <quic/server/AdmissionController.h>
+
+using namespace quic;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Decision = AdmissionController::Decision;
+
+AdmissionControlConfig makeConfig() {
+  AdmissionControlConfig config;
+  config.rate = 10;
+  config.burst = 10;
+  config.prefixRate = 0;
+  config.retryLoopTime = 5ms;
+  config.dropLoopTime = 20ms;
+  return config;
+}
+
+} // namespace
+
+TEST(AdmissionControllerTest, AcceptsUpToBurstThenRetries) {
+  TokenBucketAdmissionController controller(makeConfig());
+  folly::IPAddress client("1.2.3.4");
+  auto now = Clock::now();
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(controller.admit(client, now, 0us), Decision::ACCEPT);
+  }
+  EXPECT_EQ(controller.admit(client, now, 0us), Decision::RETRY);
+  // 10 per second, so one token is back after 100ms.
+  now += 100ms;
+  EXPECT_EQ(controller.admit(client, now, 0us), Decision::ACCEPT);
+  EXPECT_EQ(controller.admit(client, now, 0us), Decision::RETRY);
+}
+
+TEST(AdmissionControllerTest, RefillCappedAtBurst) {
+  TokenBucketAdmissionController controller(makeConfig());
+  folly::IPAddress client("1.2.3.4");
+  auto now = Clock::now();
+  EXPECT_EQ(controller.admit(client, now, 0us), Decision::ACCEPT);
+  now += 1h;
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(controller.admit(client, now, 0us), Decision::ACCEPT);
+  }
+  EXPECT_EQ(controller.admit(client, now, 0us), Decision::RETRY);
+}
+
+TEST(AdmissionControllerTest, LoopTimeSheds) {
+  TokenBucketAdmissionController controller(makeConfig());
+  folly::IPAddress client("1.2.3.4");
+  auto now = Clock::now();
+  EXPECT_EQ(controller.admit(client, now, 4ms), Decision::ACCEPT);
+  EXPECT_EQ(controller.admit(client, now, 5ms), Decision::RETRY);
+  EXPECT_EQ(controller.admit(client, now, 19ms), Decision::RETRY);
+  EXPECT_EQ(controller.admit(client, now, 20ms), Decision::DROP);
+  // Shed connections don't take a token.
+  for (int i = 0; i < 9; i++) {
+    EXPECT_EQ(controller.admit(client, now, 0us), Decision::ACCEPT);
+  }
+  EXPECT_EQ(controller.admit(client, now, 0us), Decision::RETRY);
+}
+
+TEST(AdmissionControllerTest, PerPrefixLimit) {
+  auto config = makeConfig();
+  config.prefixRate = 2;
+  config.prefixBurst = 2;
+  TokenBucketAdmissionController controller(config);
+  auto now = Clock::now();
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("1.2.3.4"), now, 0us),
+      Decision::ACCEPT);
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("1.2.3.5"), now, 0us),
+      Decision::ACCEPT);
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("1.2.3.6"), now, 0us), Decision::DROP);
+  // Same prefix once mapped to IPv4.
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("::ffff:1.2.3.7"), now, 0us),
+      Decision::DROP);
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("1.2.4.4"), now, 0us),
+      Decision::ACCEPT);
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("2001:db8:1:1::1"), now, 0us),
+      Decision::ACCEPT);
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("2001:db8:1:2::1"), now, 0us),
+      Decision::ACCEPT);
+  EXPECT_EQ(
+      controller.admit(folly::IPAddress("2001:db8:1:3::1"), now, 0us),
+      Decision::DROP);
+  EXPECT_EQ(controller.numTrackedPrefixes(), 3);
+}
+
+TEST(AdmissionControllerTest, TrackedPrefixesBounded) {
+  auto config = makeConfig();
+  config.rate = 1000;
+  config.burst = 1000;
+  config.prefixRate = 1;
+  config.prefixBurst = 1;
+  config.maxTrackedPrefixes = 4;
+  TokenBucketAdmissionController controller(config);
+  auto now = Clock::now();
+  for (int i = 0; i < 10; i++) {
+    folly::IPAddress client(folly::to<std::string>("10.0.", i, ".1"));
+    EXPECT_EQ(controller.admit(client, now, 0us), Decision::ACCEPT);
+  }
+  EXPECT_EQ(controller.numTrackedPrefixes(), 4);
+}
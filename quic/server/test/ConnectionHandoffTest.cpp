@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/server/state/ConnectionHandoff.h>
+
+#include <folly/portability/GTest.h>
+
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+namespace {
+
+// Keys of the sizes TLS_AES_128_GCM_SHA256 expects.
+TrafficKey makeKey(char fill) {
+  return TrafficKey{
+      folly::IOBuf::copyBuffer(std::string(16, fill)),
+      folly::IOBuf::copyBuffer(std::string(12, fill))};
+}
+
+Buf makeHeaderKey(char fill) {
+  return folly::IOBuf::copyBuffer(std::string(16, fill));
+}
+
+ConnectionHandoffState makeHandoffState() {
+  ConnectionHandoffState state;
+  state.version = QuicVersion::MVFST;
+  state.peerAddress = folly::SocketAddress("1.2.3.4", 1234);
+  state.originalPeerAddress = folly::SocketAddress("1.2.3.4", 1233);
+  state.serverAddr = folly::SocketAddress("::1", 443);
+  state.clientChosenDestConnectionId = getTestConnectionId(1);
+  state.clientConnectionId = getTestConnectionId(2);
+  state.serverConnectionId = getTestConnectionId(3);
+  StatelessResetToken token;
+  token.fill(7);
+  state.selfConnectionIds.emplace_back(getTestConnectionId(3), 0, token);
+  state.selfConnectionIds.emplace_back(getTestConnectionId(4), 1, token);
+  state.peerConnectionIds.emplace_back(getTestConnectionId(2), 0);
+  state.nextSelfConnectionIdSequence = 2;
+  state.cipherSuite = fizz::CipherSuite::TLS_AES_128_GCM_SHA256;
+  state.alpn = "h3";
+  state.oneRttReadKey = makeKey('r');
+  state.oneRttWriteKey = makeKey('w');
+  state.oneRttReadHeaderKey = makeHeaderKey('R');
+  state.oneRttWriteHeaderKey = makeHeaderKey('W');
+  state.nextPacketNum = 100;
+  state.largestAckedByPeer = 99;
+  state.largestReceivedPacketNum = 50;
+  state.acks.insert(0, 20);
+  state.acks.insert(30, 50);
+  state.peerIdleTimeout = std::chrono::milliseconds(30000);
+  state.udpSendPacketLen = 1400;
+  state.peerMaxUdpPayloadSize = 1500;
+  state.peerAckDelayExponent = 3;
+  state.peerActiveConnectionIdLimit = 4;
+  state.flowControlState.windowSize = 1000;
+  state.flowControlState.sumCurReadOffset = 10;
+  state.flowControlState.largestMaxOffsetReceived = 5000;
+  state.streamIdState.nextAcceptablePeerBidirectionalStreamId = 4;
+  state.streamIdState.maxRemoteBidirectionalStreamId = 400;
+  state.streamIdState.openStreams.push_back(0);
+  StreamHandoffState stream;
+  stream.id = 0;
+  stream.currentReadOffset = 10;
+  stream.currentWriteOffset = 20;
+  stream.maxOffsetObserved = 10;
+  stream.windowSize = 100;
+  stream.advertisedMaxOffset = 110;
+  stream.peerAdvertisedMaxOffset = 120;
+  stream.priority = Priority(2, true);
+  stream.isControl = true;
+  state.streams.push_back(stream);
+  state.srtt = std::chrono::microseconds(1000);
+  state.lrtt = std::chrono::microseconds(1100);
+  state.rttvar = std::chrono::microseconds(100);
+  state.mrtt = std::chrono::microseconds(900);
+  return state;
+}
+
+} // namespace
+
+TEST(ConnectionHandoffTest, EncodeDecode) {
+  auto buf = encodeConnectionHandoffState(makeHandoffState());
+  auto state = decodeConnectionHandoffState(*buf);
+  ASSERT_TRUE(state.has_value());
+  EXPECT_EQ(state->version, QuicVersion::MVFST);
+  EXPECT_EQ(state->peerAddress, folly::SocketAddress("1.2.3.4", 1234));
+  EXPECT_EQ(state->originalPeerAddress, folly::SocketAddress("1.2.3.4", 1233));
+  EXPECT_EQ(state->serverAddr, folly::SocketAddress("::1", 443));
+  EXPECT_EQ(state->clientChosenDestConnectionId, getTestConnectionId(1));
+  EXPECT_EQ(state->clientConnectionId, getTestConnectionId(2));
+  EXPECT_EQ(state->serverConnectionId, getTestConnectionId(3));
+  ASSERT_EQ(state->selfConnectionIds.size(), 2);
+  EXPECT_EQ(state->selfConnectionIds[1].connId, getTestConnectionId(4));
+  EXPECT_EQ(state->selfConnectionIds[1].sequenceNumber, 1);
+  ASSERT_TRUE(state->selfConnectionIds[1].token.has_value());
+  EXPECT_EQ((*state->selfConnectionIds[1].token)[0], 7);
+  ASSERT_EQ(state->peerConnectionIds.size(), 1);
+  EXPECT_FALSE(state->peerConnectionIds[0].token.has_value());
+  EXPECT_EQ(state->nextSelfConnectionIdSequence, 2);
+  EXPECT_EQ(state->cipherSuite, fizz::CipherSuite::TLS_AES_128_GCM_SHA256);
+  EXPECT_EQ(state->alpn, std::string("h3"));
+  folly::IOBufEqualTo eq;
+  EXPECT_TRUE(eq(state->oneRttReadKey.key, makeKey('r').key));
+  EXPECT_TRUE(eq(state->oneRttWriteKey.iv, makeKey('w').iv));
+  EXPECT_TRUE(eq(state->oneRttWriteHeaderKey, makeHeaderKey('W')));
+  EXPECT_EQ(state->nextPacketNum, 100);
+  EXPECT_EQ(state->largestAckedByPeer, 99);
+  EXPECT_EQ(state->largestReceivedPacketNum, 50);
+  EXPECT_EQ(state->acks.size(), 2);
+  EXPECT_EQ(state->acks.back().end, 50);
+  EXPECT_EQ(state->peerIdleTimeout, std::chrono::milliseconds(30000));
+  EXPECT_EQ(state->udpSendPacketLen, 1400);
+  EXPECT_EQ(state->peerActiveConnectionIdLimit, 4);
+  EXPECT_EQ(state->flowControlState.windowSize, 1000);
+  EXPECT_EQ(state->flowControlState.sumCurReadOffset, 10);
+  EXPECT_EQ(state->flowControlState.largestMaxOffsetReceived, 5000);
+  EXPECT_EQ(state->streamIdState.nextAcceptablePeerBidirectionalStreamId, 4);
+  EXPECT_EQ(state->streamIdState.maxRemoteBidirectionalStreamId, 400);
+  EXPECT_EQ(state->streamIdState.openStreams, std::vector<StreamId>{0});
+  ASSERT_EQ(state->streams.size(), 1);
+  const auto& stream = state->streams[0];
+  EXPECT_EQ(stream.id, 0);
+  EXPECT_EQ(stream.currentReadOffset, 10);
+  EXPECT_EQ(stream.currentWriteOffset, 20);
+  EXPECT_EQ(stream.maxOffsetObserved, 10);
+  EXPECT_EQ(stream.windowSize, 100);
+  EXPECT_EQ(stream.advertisedMaxOffset, 110);
+  EXPECT_EQ(stream.peerAdvertisedMaxOffset, 120);
+  EXPECT_EQ(stream.priority, Priority(2, true));
+  EXPECT_TRUE(stream.isControl);
+  EXPECT_EQ(state->srtt, std::chrono::microseconds(1000));
+  EXPECT_EQ(state->mrtt, std::chrono::microseconds(900));
+}
+
+TEST(ConnectionHandoffTest, DecodeTruncated) {
+  auto buf = encodeConnectionHandoffState(makeHandoffState());
+  buf->coalesce();
+  buf->trimEnd(1);
+  EXPECT_FALSE(decodeConnectionHandoffState(*buf).has_value());
+}
+
+TEST(ConnectionHandoffTest, DecodeWrongVersion) {
+  auto buf = encodeConnectionHandoffState(makeHandoffState());
+  buf->coalesce();
+  buf->writableData()[0]++;
+  EXPECT_FALSE(decodeConnectionHandoffState(*buf).has_value());
+}
+
+TEST(ConnectionHandoffTest, HandshakeNotDone) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  EXPECT_FALSE(getConnectionHandoffState(conn).has_value());
+}
+
+TEST(ConnectionHandoffTest, Restore) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  ASSERT_TRUE(restoreConnectionHandoffState(conn, makeHandoffState()));
+  EXPECT_TRUE(conn.serverHandshakeLayer->isHandshakeDone());
+  EXPECT_EQ(
+      conn.serverHandshakeLayer->getApplicationProtocol(), std::string("h3"));
+  ASSERT_NE(conn.readCodec, nullptr);
+  EXPECT_NE(conn.readCodec->getOneRttReadCipher(), nullptr);
+  EXPECT_NE(conn.readCodec->getOneRttHeaderCipher(), nullptr);
+  EXPECT_NE(conn.oneRttWriteCipher, nullptr);
+  EXPECT_NE(conn.oneRttWriteHeaderCipher, nullptr);
+  EXPECT_EQ(conn.initialWriteCipher, nullptr);
+  EXPECT_EQ(conn.handshakeWriteCipher, nullptr);
+  EXPECT_TRUE(conn.sentHandshakeDone);
+  EXPECT_EQ(conn.version, QuicVersion::MVFST);
+  EXPECT_EQ(conn.serverConnectionId, getTestConnectionId(3));
+  EXPECT_EQ(conn.selfConnectionIds.size(), 2);
+  const auto& ackState = conn.ackStates.appDataAckState;
+  EXPECT_EQ(ackState.nextPacketNum, 100);
+  EXPECT_EQ(ackState.largestAckedByPeer, 99);
+  EXPECT_EQ(ackState.largestReceivedPacketNum, 50);
+  EXPECT_EQ(ackState.acks.size(), 2);
+  EXPECT_EQ(conn.flowControlState.windowSize, 1000);
+  EXPECT_EQ(conn.flowControlState.largestMaxOffsetReceived, 5000);
+  EXPECT_EQ(conn.lossState.srtt, std::chrono::microseconds(1000));
+
+  EXPECT_EQ(conn.streamManager->streamCount(), 1);
+  auto stream = conn.streamManager->getStream(0);
+  ASSERT_NE(stream, nullptr);
+  EXPECT_EQ(stream->currentReadOffset, 10);
+  EXPECT_EQ(stream->currentReceiveOffset, 10);
+  EXPECT_EQ(stream->currentWriteOffset, 20);
+  EXPECT_EQ(stream->maxOffsetObserved, 10);
+  ASSERT_EQ(stream->ackedIntervals.size(), 1);
+  EXPECT_EQ(stream->ackedIntervals.front().end, 19);
+  EXPECT_EQ(stream->flowControlState.windowSize, 100);
+  EXPECT_EQ(stream->flowControlState.advertisedMaxOffset, 110);
+  EXPECT_EQ(stream->flowControlState.peerAdvertisedMaxOffset, 120);
+  EXPECT_EQ(stream->priority, Priority(2, true));
+  EXPECT_TRUE(stream->isControl);
+  EXPECT_EQ(conn.streamManager->numControlStreams(), 1);
+  EXPECT_FALSE(conn.streamManager->hasWritable());
+}
+
+TEST(ConnectionHandoffTest, RestoreStreamNotOpen) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  auto state = makeHandoffState();
+  state.streamIdState.openStreams.clear();
+  EXPECT_FALSE(restoreConnectionHandoffState(conn, std::move(state)));
+  EXPECT_EQ(conn.readCodec, nullptr);
+  EXPECT_EQ(conn.streamManager->streamCount(), 0);
+}
+
+TEST(ConnectionHandoffTest, RestoreInvalidKey) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  auto state = makeHandoffState();
+  state.oneRttReadKey.key = folly::IOBuf::copyBuffer("short");
+  EXPECT_FALSE(restoreConnectionHandoffState(conn, std::move(state)));
+  EXPECT_EQ(conn.readCodec, nullptr);
+  EXPECT_EQ(conn.oneRttWriteCipher, nullptr);
+  EXPECT_FALSE(conn.serverConnectionId.has_value());
+  EXPECT_FALSE(conn.serverHandshakeLayer->isHandshakeDone());
+}
+
+TEST(ConnectionHandoffTest, RestoreInvalidHeaderKey) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  auto state = makeHandoffState();
+  state.oneRttWriteHeaderKey = folly::IOBuf::copyBuffer("short");
+  EXPECT_FALSE(restoreConnectionHandoffState(conn, std::move(state)));
+  EXPECT_EQ(conn.readCodec, nullptr);
+}
+
+TEST(ConnectionHandoffTest, RestoreUnknownCipherSuite) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  auto state = makeHandoffState();
+  state.cipherSuite = static_cast<fizz::CipherSuite>(0xffff);
+  EXPECT_FALSE(restoreConnectionHandoffState(conn, std::move(state)));
+  EXPECT_EQ(conn.readCodec, nullptr);
+}
+
+TEST(ConnectionHandoffTest, RestoreNoConnectionIds) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  auto state = makeHandoffState();
+  state.selfConnectionIds.clear();
+  EXPECT_FALSE(restoreConnectionHandoffState(conn, std::move(state)));
+  EXPECT_EQ(conn.readCodec, nullptr);
+}
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <quic/common/test/TestUtils.h>
+#include <quic/server/ConnectionIdRoutingTable.h>
+
+namespace quic {
+namespace test {
+
+TEST(ConnectionIdRoutingTableTest, InsertAndFind) {
+  ConnectionIdRoutingTable table;
+  auto cid1 = getTestConnectionId(0);
+  auto cid2 = getTestConnectionId(1);
+  EXPECT_EQ(table.find(cid1), folly::none);
+  EXPECT_TRUE(table.insert(cid1, 2));
+  EXPECT_TRUE(table.insert(cid2, 5));
+  EXPECT_EQ(table.find(cid1), 2);
+  EXPECT_EQ(table.find(cid2), 5);
+  EXPECT_EQ(table.size(), 2);
+}
+
+TEST(ConnectionIdRoutingTableTest, InsertConflict) {
+  ConnectionIdRoutingTable table;
+  auto cid = getTestConnectionId(0);
+  EXPECT_TRUE(table.insert(cid, 2));
+  EXPECT_FALSE(table.insert(cid, 3));
+  EXPECT_EQ(table.find(cid), 2);
+}
+
+TEST(ConnectionIdRoutingTableTest, EraseOnlyByOwner) {
+  ConnectionIdRoutingTable table;
+  auto cid = getTestConnectionId(0);
+  table.insert(cid, 2);
+  table.erase(cid, 3);
+  EXPECT_EQ(table.find(cid), 2);
+  table.erase(cid, 2);
+  EXPECT_EQ(table.find(cid), folly::none);
+  EXPECT_EQ(table.size(), 0);
+  // Erasing an unknown id is a no-op.
+  table.erase(cid, 2);
+}
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+#include <quic/congestion_control/QuicCubic.h>
+#include <quic/server/PathStateCache.h>
+
+using namespace quic;
+using namespace std::chrono_literals;
+
+namespace {
+
+CachedPathState makeState(TimePoint now) {
+  CachedPathState state;
+  state.srtt = 40ms;
+  state.minRtt = 30ms;
+  // 10 MB/s, a 300KB bandwidth-delay product.
+  state.bandwidth = 10 * 1000 * 1000;
+  state.updateTime = now;
+  return state;
+}
+
+} // namespace
+
+TEST(PathStateCacheTest, SharedWithinPrefix) {
+  PathStateCache cache;
+  auto now = Clock::now();
+  cache.update(folly::IPAddress("1.2.3.4"), makeState(now));
+  auto state = cache.get(folly::IPAddress("1.2.3.200"), now);
+  ASSERT_TRUE(state.has_value());
+  EXPECT_EQ(state->srtt, 40ms);
+  EXPECT_EQ(state->minRtt, 30ms);
+  EXPECT_EQ(state->bandwidth, 10 * 1000 * 1000);
+  EXPECT_FALSE(cache.get(folly::IPAddress("1.2.4.4"), now).has_value());
+
+  // A v4 mapped address is the same client as the v4 one.
+  EXPECT_TRUE(cache.get(folly::IPAddress("::ffff:1.2.3.5"), now).has_value());
+
+  cache.update(folly::IPAddress("2001:db8:1::1"), makeState(now));
+  EXPECT_TRUE(cache.get(folly::IPAddress("2001:db8:1:2::1"), now).has_value());
+  EXPECT_FALSE(cache.get(folly::IPAddress("2001:db8:2::1"), now).has_value());
+}
+
+TEST(PathStateCacheTest, LastUpdateWins) {
+  PathStateCache cache;
+  auto now = Clock::now();
+  folly::IPAddress client("1.2.3.4");
+  cache.update(client, makeState(now));
+  auto newer = makeState(now);
+  newer.srtt = 80ms;
+  cache.update(client, newer);
+  EXPECT_EQ(cache.get(client, now)->srtt, 80ms);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(PathStateCacheTest, Expires) {
+  PathStateCacheConfig config;
+  config.maxAge = 10s;
+  PathStateCache cache(config);
+  auto now = Clock::now();
+  folly::IPAddress client("1.2.3.4");
+  cache.update(client, makeState(now));
+  EXPECT_TRUE(cache.get(client, now + 10s).has_value());
+  EXPECT_FALSE(cache.get(client, now + 11s).has_value());
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(PathStateCacheTest, Bounded) {
+  PathStateCacheConfig config;
+  config.capacity = 32;
+  PathStateCache cache(config);
+  auto now = Clock::now();
+  for (int i = 0; i < 1000; i++) {
+    auto client = folly::to<std::string>("10.", i / 256, ".", i % 256, ".1");
+    cache.update(folly::IPAddress(client), makeState(now));
+  }
+  EXPECT_LE(cache.size(), 32);
+  EXPECT_TRUE(cache.get(folly::IPAddress("10.3.231.1"), now).has_value());
+}
+
+TEST(PathStateCacheTest, ApplyTo) {
+  PathStateCache cache;
+  auto state = makeState(Clock::now());
+  TransportSettings settings;
+  settings.initCwndInMss = 10;
+  cache.applyTo(state, settings);
+  EXPECT_EQ(settings.initialRtt, 40ms);
+  // Half of the 300KB bandwidth-delay product.
+  EXPECT_EQ(settings.initCwndInMss, 150 * 1000 / kDefaultUDPSendPacketLen);
+}
+
+TEST(PathStateCacheTest, ApplyToCaps) {
+  PathStateCacheConfig config;
+  config.maxInitCwndInMss = 50;
+  config.maxInitialRtt = 200ms;
+  PathStateCache cache(config);
+  auto state = makeState(Clock::now());
+  state.srtt = 1s;
+  state.bandwidth = 1000 * 1000 * 1000;
+  TransportSettings settings;
+  cache.applyTo(state, settings);
+  EXPECT_EQ(settings.initialRtt, 200ms);
+  EXPECT_EQ(settings.initCwndInMss, 50);
+
+  // Never below what the connection would start with anyway.
+  state.srtt = 1us;
+  state.bandwidth = 1000;
+  settings = TransportSettings();
+  cache.applyTo(state, settings);
+  EXPECT_EQ(settings.initialRtt, kGranularity);
+  EXPECT_EQ(settings.initCwndInMss, TransportSettings().initCwndInMss);
+}
+
+TEST(PathStateCacheTest, ApplyToWithoutBandwidth) {
+  PathStateCache cache;
+  auto state = makeState(Clock::now());
+  state.bandwidth = 0;
+  TransportSettings settings;
+  cache.applyTo(state, settings);
+  EXPECT_EQ(settings.initialRtt, 40ms);
+  EXPECT_EQ(settings.initCwndInMss, TransportSettings().initCwndInMss);
+}
+
+TEST(PathStateCacheTest, EstimateBandwidthFromCwnd) {
+  QuicConnectionStateBase conn(QuicNodeType::Server);
+  Cubic cubic(conn);
+  EXPECT_EQ(estimateBandwidth(cubic, 0us), 0);
+  EXPECT_EQ(estimateBandwidth(cubic, 100ms), cubic.getCongestionWindow() * 10);
+}
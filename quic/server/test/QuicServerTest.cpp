@@ -24,6 +24,7 @@
 #include <quic/server/SlidingWindowRateLimiter.h>
 #include <quic/server/handshake/RetryTokenGenerator.h>
 #include <quic/server/handshake/StatelessResetGenerator.h>
+#include <quic/server/state/ConnectionHandoff.h>
 #include <quic/server/test/Mocks.h>
 #include <quic/state/test/MockQuicStats.h>
 #include "quic/codec/QuicConnectionId.h"
@@ -97,6 +98,37 @@ TEST_F(SimpleQuicServerWorkerTest, RejectCid) {
   EXPECT_FALSE(worker_->rejectConnectionId(excludeCid));
 }
 
+TEST_F(SimpleQuicServerWorkerTest, RoutingTable) {
+  folly::SocketAddress addr("::1", 0);
+  auto mockSock =
+      std::make_unique<folly::test::MockAsyncUDPSocket>(&eventbase_);
+  EXPECT_CALL(*mockSock, address()).WillRepeatedly(ReturnRef(addr));
+  MockConnectionCallback mockConnectionCallback;
+  MockQuicTransport::Ptr transportPtr = std::make_shared<MockQuicTransport>(
+      &eventbase_, std::move(mockSock), mockConnectionCallback, nullptr);
+  workerCb_ = std::make_shared<NiceMock<MockWorkerCallback>>();
+  worker_ = std::make_unique<QuicServerWorker>(workerCb_);
+  auto routingTable = std::make_shared<ConnectionIdRoutingTable>();
+  worker_->setWorkerId(3);
+  worker_->setConnectionIdRoutingTable(routingTable);
+  auto cid = getTestConnectionId(0);
+  auto otherCid = getTestConnectionId(1);
+  // Owned by another worker, which this one must not unpublish.
+  routingTable->insert(otherCid, 1);
+
+  worker_->onConnectionIdAvailable(transportPtr, cid);
+  EXPECT_EQ(routingTable->find(cid), 3);
+
+  QuicServerTransport::SourceIdentity sourceId(addr, cid);
+  std::vector<ConnectionIdData> cidDataVec;
+  cidDataVec.emplace_back(cid, 0);
+  cidDataVec.emplace_back(otherCid, 1);
+  EXPECT_CALL(*transportPtr, setRoutingCallback(nullptr)).Times(1);
+  worker_->onConnectionUnbound(transportPtr.get(), sourceId, cidDataVec);
+  EXPECT_EQ(routingTable->find(cid), folly::none);
+  EXPECT_EQ(routingTable->find(otherCid), 1);
+}
+
 TEST_F(SimpleQuicServerWorkerTest, TurnOffPMTU) {
   auto sock =
       std::make_unique<NiceMock<folly::test::MockAsyncUDPSocket>>(&eventbase_);
@@ -473,6 +505,44 @@ TEST_F(QuicServerWorkerTest, NoConnFoundTestReset) {
       QuicTransportStatsCallback::PacketDropReason::CONNECTION_NOT_FOUND);
 }
 
+TEST_F(QuicServerWorkerTest, HandedOffConnectionNoReset) {
+  EXPECT_CALL(*socketPtr_, address()).WillRepeatedly(ReturnRef(fakeAddress_));
+  auto connId = getTestConnectionId(hostId_);
+  createQuicConnection(kClientAddr, connId);
+  EXPECT_CALL(*transportInfoCb_, onNewConnection());
+  transport_->QuicServerTransport::setRoutingCallback(worker_.get());
+  worker_->onConnectionIdAvailable(transport_, connId);
+
+  EXPECT_CALL(*transport_, handoff())
+      .WillOnce(Return(ByMove(folly::IOBuf::copyBuffer("state"))));
+  EXPECT_EQ(worker_->handoffConnections().size(), 1);
+  // A real transport unbinds itself as it closes on handoff.
+  EXPECT_CALL(*transport_, setRoutingCallback(nullptr));
+  worker_->onConnectionUnbound(
+      transport_.get(),
+      std::make_pair(kClientAddr, connId),
+      std::vector<ConnectionIdData>{ConnectionIdData{connId, 0}});
+  transport_->QuicServerTransport::setRoutingCallback(nullptr);
+
+  // Its packets, e.g. forwarded by the process which took it over before
+  // resuming it, must not reset it.
+  EXPECT_CALL(
+      *transportInfoCb_,
+      onPacketDropped(PacketDropReason::CONNECTION_NOT_FOUND));
+  EXPECT_CALL(*transportInfoCb_, onStatelessReset()).Times(0);
+  EXPECT_CALL(*socketPtr_, write(_, _)).Times(0);
+  EXPECT_CALL(*transport_, onNetworkData(_, _)).Times(0);
+  RoutingData routingData(
+      HeaderForm::Short, false, false, false, connId, folly::none);
+  auto data = folly::IOBuf::copyBuffer("data");
+  worker_->dispatchPacketData(
+      kClientAddr,
+      std::move(routingData),
+      NetworkData(data->clone(), Clock::now()),
+      true /* isForwardedData */);
+  eventbase_.loop();
+}
+
 TEST_F(QuicServerWorkerTest, RateLimit) {
   worker_->setRateLimiter(std::make_unique<SlidingWindowRateLimiter>(2, 60s));
   EXPECT_CALL(*transportInfoCb_, onConnectionRateLimited()).Times(1);
@@ -556,6 +626,81 @@ TEST_F(QuicServerWorkerTest, RateLimit) {
   eventbase_.loop();
 }
 
+TEST_F(QuicServerWorkerTest, AdmissionControlRetryWhenBucketEmpty) {
+  AdmissionControlConfig config;
+  // One connection, then no token for the rest of the test.
+  config.rate = 0.001;
+  config.burst = 1;
+  config.prefixRate = 0;
+  config.retryLoopTime = std::chrono::hours(1);
+  config.dropLoopTime = std::chrono::hours(1);
+  worker_->setAdmissionController(
+      std::make_unique<TokenBucketAdmissionController>(config));
+
+  EXPECT_CALL(
+      *transportInfoCb_,
+      onConnectionAdmission(AdmissionController::Decision::ACCEPT));
+  createQuicConnection(kClientAddr, getTestConnectionId(hostId_));
+
+  auto connId = getTestConnectionId(0);
+  EXPECT_CALL(
+      *transportInfoCb_,
+      onConnectionAdmission(AdmissionController::Decision::RETRY));
+  EXPECT_CALL(*factory_, _make(_, _, _, _)).Times(0);
+  EXPECT_CALL(*transportInfoCb_, onPacketSent()).Times(1);
+  EXPECT_CALL(*socketPtr_, write(kClientAddr2, _))
+      .WillOnce(Invoke([&](const folly::SocketAddress&,
+                           const std::unique_ptr<folly::IOBuf>& buf) {
+        QuicReadCodec codec(QuicNodeType::Client);
+        auto packetQueue = bufToQueue(buf->clone());
+        AckStates ackStates;
+        auto parsedPacket = codec.parsePacket(packetQueue, ackStates);
+        EXPECT_NE(parsedPacket.retryPacket(), nullptr);
+        return buf->computeChainDataLength();
+      }));
+  RoutingData routingData(HeaderForm::Long, true, false, true, connId, connId);
+  auto data = createData(kMinInitialPacketSize + 10);
+  worker_->dispatchPacketData(
+      kClientAddr2,
+      std::move(routingData),
+      NetworkData(data->clone(), Clock::now()));
+  eventbase_.loop();
+  const auto& addrMap = worker_->getSrcToTransportMap();
+  EXPECT_EQ(addrMap.count(std::make_pair(kClientAddr2, connId)), 0);
+}
+
+TEST_F(QuicServerWorkerTest, AdmissionControlDropWhenPrefixBucketEmpty) {
+  AdmissionControlConfig config;
+  // kClientAddr and kClientAddr2 share a /24.
+  config.prefixRate = 0.001;
+  config.prefixBurst = 1;
+  config.retryLoopTime = std::chrono::hours(1);
+  config.dropLoopTime = std::chrono::hours(1);
+  worker_->setAdmissionController(
+      std::make_unique<TokenBucketAdmissionController>(config));
+
+  EXPECT_CALL(
+      *transportInfoCb_,
+      onConnectionAdmission(AdmissionController::Decision::ACCEPT));
+  createQuicConnection(kClientAddr, getTestConnectionId(hostId_));
+
+  auto connId = getTestConnectionId(0);
+  EXPECT_CALL(
+      *transportInfoCb_,
+      onConnectionAdmission(AdmissionController::Decision::DROP));
+  EXPECT_CALL(*factory_, _make(_, _, _, _)).Times(0);
+  EXPECT_CALL(*socketPtr_, write(_, _)).Times(0);
+  RoutingData routingData(HeaderForm::Long, true, false, true, connId, connId);
+  auto data = createData(kMinInitialPacketSize + 10);
+  worker_->dispatchPacketData(
+      kClientAddr2,
+      std::move(routingData),
+      NetworkData(data->clone(), Clock::now()));
+  eventbase_.loop();
+  const auto& addrMap = worker_->getSrcToTransportMap();
+  EXPECT_EQ(addrMap.count(std::make_pair(kClientAddr2, connId)), 0);
+}
+
 TEST_F(QuicServerWorkerTest, TestRetryValidInitial) {
   // The second client initial packet with the retry token is valid
   // as the client IP is the same as the one stored in the retry token
@@ -976,6 +1121,53 @@ TEST_F(QuicServerWorkerTest, FailToParseConnectionId) {
   eventbase_.loop();
 }
 
+TEST_F(QuicServerWorkerTest, RoutingTableBeforeConnectionIdAlgo) {
+  auto routingTable = std::make_shared<ConnectionIdRoutingTable>();
+  worker_->setConnectionIdRoutingTable(routingTable);
+  auto mockConnIdAlgo = std::make_unique<MockConnectionIdAlgo>();
+  auto rawConnIdAlgo = mockConnIdAlgo.get();
+  worker_->setConnectionIdAlgo(std::move(mockConnIdAlgo));
+  auto connId = getTestConnectionId(hostId_);
+  auto otherConnId = getTestConnectionId(hostId_ + 1);
+  routingTable->insert(connId, 7);
+
+  auto makePacket = [](const ConnectionId& dstConnId) {
+    ShortHeader header(ProtectionType::KeyPhaseZero, dstConnId, 1);
+    RegularQuicPacketBuilder builder(
+        kDefaultUDPSendPacketLen, std::move(header), 0 /* largestAcked */);
+    builder.encodePacketHeader();
+    while (builder.remainingSpaceInPkt() > 0) {
+      writeFrame(PaddingFrame(), builder);
+    }
+    return packetToBuf(std::move(builder).buildPacket());
+  };
+
+  // A connection id in the table is routed to its owner, even though the
+  // algo cannot parse it.
+  EXPECT_CALL(*rawConnIdAlgo, canParseNonConst(_)).Times(0);
+  EXPECT_CALL(*transportInfoCb_, onRoutingTableLookup(true, _));
+  EXPECT_CALL(*transportInfoCb_, onPacketDropped(_)).Times(0);
+  EXPECT_CALL(*transportInfoCb_, onPacketForwarded()).Times(0);
+  EXPECT_CALL(*workerCb_, routeDataToWorkerShort(kClientAddr, _, _, false))
+      .WillOnce(Invoke([&](auto&, auto& routingData, auto&, auto) {
+        EXPECT_EQ(routingData->destinationConnId, connId);
+        EXPECT_EQ(routingData->workerIndex, 7);
+      }));
+  worker_->handleNetworkData(kClientAddr, makePacket(connId), Clock::now());
+  eventbase_.loop();
+
+  // A miss falls back to the algo.
+  EXPECT_CALL(*rawConnIdAlgo, canParseNonConst(_)).WillOnce(Return(false));
+  EXPECT_CALL(*transportInfoCb_, onRoutingTableLookup(false, _));
+  EXPECT_CALL(
+      *transportInfoCb_,
+      onPacketDropped(PacketDropReason::CONNECTION_NOT_FOUND));
+  EXPECT_CALL(*workerCb_, routeDataToWorkerShort(_, _, _, _)).Times(0);
+  worker_->handleNetworkData(
+      kClientAddr, makePacket(otherConnId), Clock::now());
+  eventbase_.loop();
+}
+
 TEST_F(QuicServerWorkerTest, ConnectionIdTooShortDispatch) {
   auto data = createData(kDefaultUDPSendPacketLen);
   auto dstConnId = ConnectionId::createWithoutChecks({3});
@@ -1674,6 +1866,187 @@ TEST_F(QuicServerWorkerTakeoverTest, QuicServerTakeoverProcessForwardedPkt) {
   writeSock.release();
 }
 
+TEST_F(QuicServerWorkerTakeoverTest, QuicServerTakeoverBatchedForwarding) {
+  TransportSettings settings;
+  settings.maxForwardedPacketBatchSize = 4;
+  takeoverWorker_->setTransportSettings(settings);
+  // packets belong to different server
+  ConnectionId connId = createConnIdForServer(ProcessId::ZERO),
+               clientConnId = getTestConnectionId(clientHostId_);
+  takeoverWorker_->setProcessId(ProcessId::ONE);
+  takeoverWorker_->startPacketForwarding(folly::SocketAddress("0", 0));
+
+  auto writeSock =
+      std::make_unique<NiceMock<folly::test::MockAsyncUDPSocket>>(&evb_);
+  EXPECT_CALL(*takeoverSocketFactory_, _make(_, _))
+      .WillOnce(Return(writeSock.get()));
+  EXPECT_CALL(*writeSock, bind(_, _));
+  EXPECT_CALL(*writeSock, write(_, _)).Times(0);
+  auto workerCb = [&](const folly::SocketAddress& client,
+                      std::unique_ptr<RoutingData>& routingData,
+                      std::unique_ptr<NetworkData>& networkData,
+                      bool isForwardedData) {
+    takeoverWorker_->dispatchPacketData(
+        client,
+        std::move(*routingData.get()),
+        std::move(*networkData.get()),
+        isForwardedData);
+  };
+  EXPECT_CALL(*takeoverWorkerCb_, routeDataToWorkerLong(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(workerCb));
+  EXPECT_CALL(*transportInfoCb_, onPacketForwarded()).Times(2);
+  for (int i = 0; i < 2; i++) {
+    size_t len{0};
+    writeTestDataOnWorkersBuf(
+        clientConnId,
+        connId,
+        len,
+        takeoverWorker_.get(),
+        LongHeader::Types::Handshake);
+    takeoverWorker_->onDataAvailable(
+        clientAddr, len, false, OnDataAvailableParams());
+  }
+
+  // Both packets go out together at the end of the loop.
+  EXPECT_CALL(*writeSock, writem(_, _, 2)).WillOnce(Return(2));
+  EXPECT_CALL(*transportInfoCb_, onForwardedPacketBatchSent(2));
+  evb_.loopOnce(EVLOOP_NONBLOCK);
+  takeoverWorker_->stopPacketForwarding();
+  // release this resource since MockQuicUDPSocketFactory::_make() hands its
+  // ownership to it's caller (i.e. QuicServerWorker)
+  writeSock.release();
+}
+
+TEST_F(QuicServerWorkerTakeoverTest, QuicServerTakeoverRecvmmsg) {
+  TransportSettings settings;
+  settings.maxForwardedPacketBatchSize = 4;
+  takeoverWorker_->setTransportSettings(settings);
+  takeoverWorker_->setProcessId(ProcessId::ZERO);
+  folly::AsyncUDPSocket::ReadCallback* takeoverCb =
+      takeoverWorker_->getTakeoverHandlerCallback();
+  EXPECT_TRUE(takeoverCb->shouldOnlyNotify());
+  folly::SocketAddress takeoverAddr("127.0.0.1", 4433);
+  EXPECT_CALL(*takeoverSocket_, address())
+      .WillRepeatedly(ReturnRef(takeoverAddr));
+
+  ConnectionId connId = createConnIdForServer(ProcessId::ZERO);
+  ShortHeader header(ProtectionType::KeyPhaseZero, connId, 1);
+  RegularQuicPacketBuilder builder(
+      kDefaultUDPSendPacketLen, std::move(header), 0 /* largestAcked */);
+  builder.encodePacketHeader();
+  writeFrame(PaddingFrame(), builder);
+  auto packet = packetToBuf(std::move(builder).buildPacket());
+  packet->coalesce();
+
+  // Encapsulated the way the server being taken over forwards packets.
+  auto forwarded = [&](const folly::SocketAddress& client) {
+    auto buf = folly::IOBuf::create(64);
+    folly::io::Appender appender(buf.get(), 64);
+    appender.writeBE<uint32_t>(
+        static_cast<uint32_t>(TakeoverProtocolVersion::V0));
+    sockaddr_storage addrStorage;
+    uint16_t socklen = client.getAddress(&addrStorage);
+    appender.writeBE<uint16_t>(socklen);
+    appender.push((uint8_t*)&addrStorage, socklen);
+    appender.writeBE<uint64_t>(Clock::now().time_since_epoch().count());
+    buf->prependChain(packet->clone());
+    buf->coalesce();
+    return buf;
+  };
+  // Fills a message per client with a packet forwarded from it, flagging the
+  // ones set in truncated as truncated.
+  auto fill = [&](std::vector<folly::SocketAddress> clients,
+                  std::vector<bool> truncated = {}) {
+    return [forwarded, clients, truncated, takeoverAddr](
+               struct mmsghdr* msgs,
+               unsigned int vlen,
+               unsigned int,
+               struct timespec*) {
+      EXPECT_EQ(vlen, 4);
+      for (size_t i = 0; i < clients.size(); ++i) {
+        auto buf = forwarded(clients[i]);
+        auto& msg = msgs[i].msg_hdr;
+        EXPECT_GE(msg.msg_iov[0].iov_len, buf->length());
+        memcpy(msg.msg_iov[0].iov_base, buf->data(), buf->length());
+        msgs[i].msg_len = buf->length();
+        msg.msg_namelen = takeoverAddr.getAddress(
+            reinterpret_cast<sockaddr_storage*>(msg.msg_name));
+        if (i < truncated.size() && truncated[i]) {
+          msg.msg_flags |= MSG_TRUNC;
+        }
+      }
+      return static_cast<int>(clients.size());
+    };
+  };
+
+  std::vector<folly::SocketAddress> received;
+  EXPECT_CALL(*takeoverWorkerCb_, routeDataToWorkerShort(_, _, _, _))
+      .WillRepeatedly(Invoke([&](const folly::SocketAddress& client,
+                                 std::unique_ptr<RoutingData>& routingData,
+                                 std::unique_ptr<NetworkData>& networkData,
+                                 bool isForwardedData) {
+        EXPECT_TRUE(isForwardedData);
+        EXPECT_EQ(routingData->destinationConnId, connId);
+        ASSERT_EQ(networkData->packets.size(), 1);
+        EXPECT_TRUE(eq(*packet, *networkData->packets[0]));
+        received.push_back(client);
+      }));
+
+  // A partial batch, the last buffer is not handed out.
+  folly::SocketAddress client1("1.2.3.4", 1001);
+  folly::SocketAddress client2("1.2.3.5", 1002);
+  folly::SocketAddress client3("::1", 1003);
+  void* unusedBuf = nullptr;
+  EXPECT_CALL(*takeoverSocket_, recvmmsg(_, 4, 0, nullptr))
+      .WillOnce(Invoke([&](struct mmsghdr* msgs,
+                           unsigned int vlen,
+                           unsigned int flags,
+                           struct timespec* timeout) {
+        unusedBuf = msgs[3].msg_hdr.msg_iov[0].iov_base;
+        return fill({client1, client2, client3})(msgs, vlen, flags, timeout);
+      }));
+  EXPECT_CALL(*transportInfoCb_, onForwardedPacketBatchReceived(3));
+  EXPECT_CALL(*transportInfoCb_, onForwardedPacketReceived()).Times(3);
+  EXPECT_CALL(*transportInfoCb_, onForwardedPacketProcessed()).Times(3);
+  takeoverCb->onNotifyDataAvailable(*takeoverSocket_);
+  EXPECT_EQ(
+      received,
+      std::vector<folly::SocketAddress>({client1, client2, client3}));
+
+  // The unused buffer is reused, and so is the one of a truncated packet.
+  received.clear();
+  void* truncatedBuf = nullptr;
+  EXPECT_CALL(*takeoverSocket_, recvmmsg(_, 4, 0, nullptr))
+      .WillOnce(Invoke([&](struct mmsghdr* msgs,
+                           unsigned int vlen,
+                           unsigned int flags,
+                           struct timespec* timeout) {
+        EXPECT_EQ(msgs[3].msg_hdr.msg_iov[0].iov_base, unusedBuf);
+        truncatedBuf = msgs[0].msg_hdr.msg_iov[0].iov_base;
+        return fill({client3, client1}, {true, false})(
+            msgs, vlen, flags, timeout);
+      }));
+  EXPECT_CALL(*transportInfoCb_, onForwardedPacketBatchReceived(2));
+  EXPECT_CALL(*transportInfoCb_, onForwardedPacketReceived()).Times(2);
+  EXPECT_CALL(*transportInfoCb_, onForwardedPacketProcessed()).Times(1);
+  takeoverCb->onNotifyDataAvailable(*takeoverSocket_);
+  EXPECT_EQ(received, std::vector<folly::SocketAddress>({client1}));
+
+  // Nothing left to read, nothing is delivered.
+  received.clear();
+  EXPECT_CALL(*takeoverSocket_, recvmmsg(_, 4, 0, nullptr))
+      .WillOnce(Invoke(
+          [&](struct mmsghdr* msgs, unsigned int, unsigned int, timespec*) {
+            EXPECT_EQ(msgs[0].msg_hdr.msg_iov[0].iov_base, truncatedBuf);
+            EXPECT_EQ(msgs[3].msg_hdr.msg_iov[0].iov_base, unusedBuf);
+            errno = EAGAIN;
+            return -1;
+          }));
+  takeoverCb->onNotifyDataAvailable(*takeoverSocket_);
+  EXPECT_TRUE(received.empty());
+}
+
 TEST_F(QuicServerWorkerTakeoverTest, QuicServerTakeoverCbReadClose) {
   folly::AsyncUDPSocket::ReadCallback* takeoverCb =
       takeoverWorker_->getTakeoverHandlerCallback();
@@ -2013,6 +2386,69 @@ TEST_F(QuicServerTest, OverrideTakeoverAddressTest) {
   t.join();
 }
 
+TEST_F(QuicServerTest, ResumeConnections) {
+  initializeServer({});
+  NiceMock<MockConnectionCallback> connCb;
+  EXPECT_CALL(*factory_, _make(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(
+          [&](folly::EventBase* evb,
+              std::unique_ptr<folly::AsyncUDPSocket>& socket,
+              const folly::SocketAddress&,
+              std::shared_ptr<const fizz::server::FizzServerContext> ctx) {
+            return QuicServerTransport::make(
+                evb, std::move(socket), connCb, std::move(ctx));
+          }));
+
+  auto serverConnId =
+      getTestConnectionId(serverHostId_, quic::ConnectionIdVersion::V2);
+  auto makeHandoffState = [&] {
+    ConnectionHandoffState state;
+    state.version = QuicVersion::MVFST;
+    state.peerAddress = kClientAddr;
+    state.originalPeerAddress = kClientAddr;
+    state.serverAddr = server_->getAddress();
+    state.clientChosenDestConnectionId = getTestConnectionId(1);
+    state.clientConnectionId = getTestConnectionId(clientHostId_);
+    state.serverConnectionId = serverConnId;
+    state.selfConnectionIds.emplace_back(serverConnId, 0);
+    state.peerConnectionIds.emplace_back(*state.clientConnectionId, 0);
+    state.nextSelfConnectionIdSequence = 1;
+    state.cipherSuite = fizz::CipherSuite::TLS_AES_128_GCM_SHA256;
+    for (auto* key : {&state.oneRttReadKey, &state.oneRttWriteKey}) {
+      key->key = folly::IOBuf::copyBuffer(std::string(16, 'k'));
+      key->iv = folly::IOBuf::copyBuffer(std::string(12, 'i'));
+    }
+    state.oneRttReadHeaderKey = folly::IOBuf::copyBuffer(std::string(16, 'h'));
+    state.oneRttWriteHeaderKey =
+        folly::IOBuf::copyBuffer(std::string(16, 'h'));
+    state.peerIdleTimeout = kDefaultIdleTimeout;
+    state.udpSendPacketLen = kDefaultUDPSendPacketLen;
+    state.peerAckDelayExponent = kDefaultAckDelayExponent;
+    return state;
+  };
+  auto resume = [&](ConnectionHandoffState state) {
+    std::vector<Buf> handoffStates;
+    handoffStates.push_back(encodeConnectionHandoffState(state));
+    return server_->resumeConnections(std::move(handoffStates));
+  };
+
+  EXPECT_EQ(resume(makeHandoffState()), 1);
+  // Its connection id is taken now.
+  EXPECT_EQ(resume(makeHandoffState()), 0);
+
+  auto invalidState = makeHandoffState();
+  invalidState.serverConnectionId =
+      getTestConnectionId(serverHostId_ + 1, quic::ConnectionIdVersion::V2);
+  invalidState.selfConnectionIds[0].connId = invalidState.serverConnectionId;
+  invalidState.oneRttReadKey.key = folly::IOBuf::copyBuffer("short");
+  EXPECT_EQ(resume(std::move(invalidState)), 0);
+
+  std::vector<Buf> garbage;
+  garbage.push_back(folly::IOBuf::copyBuffer("garbage"));
+  EXPECT_EQ(server_->resumeConnections(std::move(garbage)), 0);
+}
+
 class QuicServerTakeoverTest : public Test {
  public:
   void SetUp() override {
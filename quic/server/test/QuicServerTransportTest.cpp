@@ -20,6 +20,7 @@
 #include <quic/congestion_control/ServerCongestionControllerFactory.h>
 #include <quic/dsr/Types.h>
 #include <quic/dsr/test/Mocks.h>
+#include <quic/fizz/handshake/FizzBridge.h>
 #include <quic/fizz/handshake/FizzCryptoFactory.h>
 #include <quic/fizz/server/handshake/FizzServerHandshake.h>
 #include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
@@ -4339,5 +4340,200 @@ TEST_F(QuicServerTransportTest, WriteDSR) {
   server->resetStream(streamId, GenericApplicationErrorCode::NO_ERROR);
 }
 
+class QuicServerTransportHandoffTest : public Test {
+ public:
+  void SetUp() override {
+    auto sock =
+        std::make_unique<NiceMock<folly::test::MockAsyncUDPSocket>>(&evb);
+    EXPECT_CALL(*sock, write(_, _))
+        .WillRepeatedly(Invoke([&](const SocketAddress&,
+                                   const std::unique_ptr<folly::IOBuf>& buf) {
+          serverWrites.push_back(buf->clone());
+          return buf->computeChainDataLength();
+        }));
+    EXPECT_CALL(*sock, address()).WillRepeatedly(ReturnRef(serverAddr));
+    server = std::make_shared<TestingQuicServerTransport>(
+        &evb, std::move(sock), connCallback, createServerCtx());
+    server->setCongestionControllerFactory(
+        std::make_shared<ServerCongestionControllerFactory>());
+    server->setCongestionControl(CongestionControlType::Cubic);
+    server->setConnectionIdAlgo(&connIdAlgo);
+    server->setRoutingCallback(&routingCallback);
+  }
+
+  // Keys of the sizes TLS_AES_128_GCM_SHA256 expects.
+  static TrafficKey makeKey(char fill) {
+    return TrafficKey{
+        folly::IOBuf::copyBuffer(std::string(16, fill)),
+        folly::IOBuf::copyBuffer(std::string(12, fill))};
+  }
+
+  static Buf makeHeaderKey(char fill) {
+    return folly::IOBuf::copyBuffer(std::string(16, fill));
+  }
+
+  static std::unique_ptr<Aead> makeAead(char fill) {
+    FizzCryptoFactory cryptoFactory;
+    auto aead = cryptoFactory.getFizzFactory()->makeAead(
+        fizz::CipherSuite::TLS_AES_128_GCM_SHA256);
+    auto key = makeKey(fill);
+    fizz::TrafficKey trafficKey;
+    trafficKey.key = std::move(key.key);
+    trafficKey.iv = std::move(key.iv);
+    aead->setKey(std::move(trafficKey));
+    return FizzAead::wrap(std::move(aead));
+  }
+
+  static std::unique_ptr<PacketNumberCipher> makeHeaderCipher(char fill) {
+    FizzCryptoFactory cryptoFactory;
+    auto headerCipher = cryptoFactory.makePacketNumberCipher(
+        fizz::CipherSuite::TLS_AES_128_GCM_SHA256);
+    headerCipher->setKey(makeHeaderKey(fill)->coalesce());
+    return headerCipher;
+  }
+
+  // The state of a connection the client keeps writing to with 'c' keys and
+  // reading from with 's' keys.
+  ConnectionHandoffState makeHandoffState() {
+    ConnectionHandoffState state;
+    state.version = QuicVersion::MVFST;
+    state.peerAddress = clientAddr;
+    state.originalPeerAddress = clientAddr;
+    state.serverAddr = serverAddr;
+    state.clientChosenDestConnectionId = getTestConnectionId(1);
+    state.clientConnectionId = clientConnectionId;
+    state.serverConnectionId = serverConnectionId;
+    state.selfConnectionIds.emplace_back(serverConnectionId, 0);
+    state.peerConnectionIds.emplace_back(clientConnectionId, 0);
+    state.nextSelfConnectionIdSequence = 1;
+    state.cipherSuite = fizz::CipherSuite::TLS_AES_128_GCM_SHA256;
+    state.alpn = "h3";
+    state.oneRttReadKey = makeKey('c');
+    state.oneRttWriteKey = makeKey('s');
+    state.oneRttReadHeaderKey = makeHeaderKey('c');
+    state.oneRttWriteHeaderKey = makeHeaderKey('s');
+    state.nextPacketNum = 10;
+    state.largestAckedByPeer = 9;
+    state.largestReceivedPacketNum = 5;
+    state.acks.insert(0, 5);
+    state.peerIdleTimeout = kDefaultIdleTimeout;
+    state.udpSendPacketLen = kDefaultUDPSendPacketLen;
+    state.peerMaxUdpPayloadSize = kDefaultMaxUDPPayload;
+    state.peerAckDelayExponent = kDefaultAckDelayExponent;
+    state.peerActiveConnectionIdLimit = kDefaultActiveConnectionIdLimit;
+    auto& flowControl = state.flowControlState;
+    flowControl.windowSize = kDefaultConnectionWindowSize;
+    flowControl.advertisedMaxOffset = kDefaultConnectionWindowSize;
+    flowControl.peerAdvertisedMaxOffset = kDefaultConnectionWindowSize;
+    flowControl.peerAdvertisedInitialMaxStreamOffsetBidiLocal =
+        kDefaultStreamWindowSize;
+    flowControl.peerAdvertisedInitialMaxStreamOffsetBidiRemote =
+        kDefaultStreamWindowSize;
+    flowControl.peerAdvertisedInitialMaxStreamOffsetUni =
+        kDefaultStreamWindowSize;
+    state.streamIdState = server->getConn().streamManager->getStreamIdState();
+    state.srtt = std::chrono::milliseconds(10);
+    state.lrtt = std::chrono::milliseconds(10);
+    state.rttvar = std::chrono::milliseconds(1);
+    state.mrtt = std::chrono::milliseconds(10);
+    return state;
+  }
+
+  EventBase evb;
+  SocketAddress serverAddr{"1.2.3.4", 8080};
+  SocketAddress clientAddr{"127.0.0.1", 1000};
+  ConnectionId clientConnectionId{getTestConnectionId(2)};
+  ConnectionId serverConnectionId{getTestConnectionId(3)};
+  std::vector<Buf> serverWrites;
+  NiceMock<MockConnectionCallback> connCallback;
+  NiceMock<MockRoutingCallback> routingCallback;
+  DefaultConnectionIdAlgo connIdAlgo;
+  std::shared_ptr<TestingQuicServerTransport> server;
+};
+
+TEST_F(QuicServerTransportHandoffTest, ResumeFromHandoff) {
+  EXPECT_CALL(routingCallback, onConnectionIdAvailable(_, serverConnectionId));
+  EXPECT_CALL(connCallback, onTransportReady());
+  ASSERT_TRUE(server->resumeFromHandoff(makeHandoffState()));
+  EXPECT_TRUE(server->idleTimeout().isScheduled());
+
+  // The peer keeps using the keys it negotiated with the old process.
+  StreamId streamId = 0;
+  PacketNum packetNum = 6;
+  auto clientAead = makeAead('c');
+  auto packet = createStreamPacket(
+      clientConnectionId,
+      serverConnectionId,
+      packetNum,
+      streamId,
+      *IOBuf::copyBuffer("hello"),
+      clientAead->getCipherOverhead(),
+      0 /* largestAcked */,
+      folly::none /* longHeaderOverride */,
+      false /* eof */);
+  EXPECT_CALL(connCallback, onNewBidirectionalStream(streamId));
+  server->onNetworkData(
+      clientAddr,
+      NetworkData(
+          packetToBufCleartext(
+              packet, *clientAead, *makeHeaderCipher('c'), packetNum),
+          Clock::now()));
+  EXPECT_FALSE(server->getConn().localConnectionError.has_value());
+  EXPECT_EQ(
+      server->getConn().ackStates.appDataAckState.largestReceivedPacketNum,
+      packetNum);
+
+  server->writeChain(streamId, IOBuf::copyBuffer("world"), true);
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_FALSE(serverWrites.empty());
+  QuicReadCodec clientCodec(QuicNodeType::Client);
+  clientCodec.setClientConnectionId(clientConnectionId);
+  clientCodec.setOneRttReadCipher(makeAead('s'));
+  clientCodec.setOneRttHeaderCipher(makeHeaderCipher('s'));
+  clientCodec.setCodecParameters(
+      CodecParameters(kDefaultAckDelayExponent, QuicVersion::MVFST));
+  EXPECT_TRUE(verifyFramePresent(
+      serverWrites, clientCodec, QuicFrame::Type::ReadStreamFrame));
+}
+
+TEST_F(QuicServerTransportHandoffTest, ResumeFromHandoffNoTicket) {
+  server->getNonConstConn().transportSettings.carefulResume.enabled = true;
+  server->getNonConstConn().transportSettings.carefulResume.ticketRefreshBytes =
+      0;
+  ASSERT_TRUE(server->resumeFromHandoff(makeHandoffState()));
+  // The handshake ran in the old process, no ticket can be written here.
+  StreamId streamId = 0;
+  PacketNum packetNum = 6;
+  auto clientAead = makeAead('c');
+  auto packet = createStreamPacket(
+      clientConnectionId,
+      serverConnectionId,
+      packetNum,
+      streamId,
+      *IOBuf::copyBuffer("hello"),
+      clientAead->getCipherOverhead(),
+      0 /* largestAcked */);
+  server->onNetworkData(
+      clientAddr,
+      NetworkData(
+          packetToBufCleartext(
+              packet, *clientAead, *makeHeaderCipher('c'), packetNum),
+          Clock::now()));
+  EXPECT_FALSE(server->getConn().localConnectionError.has_value());
+  EXPECT_FALSE(server->isClosed());
+}
+
+TEST_F(QuicServerTransportHandoffTest, ResumeFromHandoffInvalidState) {
+  auto state = makeHandoffState();
+  state.oneRttReadKey.key = IOBuf::copyBuffer("short");
+  EXPECT_CALL(routingCallback, onConnectionIdAvailable(_, _)).Times(0);
+  EXPECT_CALL(routingCallback, onConnectionUnbound(_, _, _)).Times(0);
+  EXPECT_CALL(connCallback, onTransportReady()).Times(0);
+  EXPECT_FALSE(server->resumeFromHandoff(std::move(state)));
+  EXPECT_FALSE(server->hasWriteCipher());
+  // Dropped the way the worker drops it.
+  server = nullptr;
+}
+
 } // namespace test
 } // namespace quic
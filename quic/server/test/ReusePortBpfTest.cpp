@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <folly/portability/Sockets.h>
+#include <folly/portability/Unistd.h>
+
+#include <quic/codec/DefaultConnectionIdAlgo.h>
+#include <quic/server/ReusePortBpf.h>
+
+#include <poll.h>
+
+namespace quic {
+namespace test {
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+namespace {
+constexpr int kNumWorkers = 5;
+}
+
+class ReusePortBpfTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < kNumWorkers; ++i) {
+      int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+      ASSERT_GE(fd, 0);
+      int one = 1;
+      ASSERT_EQ(
+          ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)), 0);
+      ASSERT_EQ(
+          ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+      if (i == 0) {
+        socklen_t len = sizeof(addr);
+        ASSERT_EQ(
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+      }
+      fds_.push_back(fd);
+    }
+    addr_ = addr;
+    client_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(client_, 0);
+    ASSERT_TRUE(attachReusePortBpfProgram(
+        folly::NetworkSocket::fromFd(fds_[0]), kNumWorkers));
+  }
+
+  void TearDown() override {
+    for (auto fd : fds_) {
+      ::close(fd);
+    }
+    if (client_ >= 0) {
+      ::close(client_);
+    }
+  }
+
+  // Returns the index of the socket which received the packet.
+  int sendAndReceive(const std::vector<uint8_t>& packet) {
+    ::sendto(
+        client_,
+        packet.data(),
+        packet.size(),
+        0,
+        reinterpret_cast<const sockaddr*>(&addr_),
+        sizeof(addr_));
+    std::vector<pollfd> pollFds(fds_.size());
+    for (size_t i = 0; i < fds_.size(); ++i) {
+      pollFds[i].fd = fds_[i];
+      pollFds[i].events = POLLIN;
+    }
+    if (::poll(pollFds.data(), pollFds.size(), 1000) <= 0) {
+      return -1;
+    }
+    for (size_t i = 0; i < pollFds.size(); ++i) {
+      if (pollFds[i].revents & POLLIN) {
+        uint8_t buf[64];
+        ::recv(fds_[i], buf, sizeof(buf), 0);
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  std::vector<uint8_t> makeShortHeaderPacket(
+      ConnectionIdVersion version,
+      uint8_t workerId) {
+    DefaultConnectionIdAlgo algo;
+    ServerConnectionIdParams params(version, 0x1234, 1, workerId);
+    auto connId = algo.encodeConnectionId(params).value();
+    std::vector<uint8_t> packet{0x40};
+    packet.insert(packet.end(), connId.data(), connId.data() + connId.size());
+    // Some payload after the connection id.
+    packet.resize(packet.size() + 16, 0xab);
+    return packet;
+  }
+
+ protected:
+  std::vector<int> fds_;
+  sockaddr_in addr_;
+  int client_{-1};
+};
+
+TEST_F(ReusePortBpfTest, RoutesShortHeaderV1) {
+  for (int workerId = 0; workerId < 256; ++workerId) {
+    auto packet = makeShortHeaderPacket(ConnectionIdVersion::V1, workerId);
+    EXPECT_EQ(sendAndReceive(packet), workerId % kNumWorkers);
+  }
+}
+
+TEST_F(ReusePortBpfTest, RoutesShortHeaderV2) {
+  for (int workerId = 0; workerId < 256; ++workerId) {
+    auto packet = makeShortHeaderPacket(ConnectionIdVersion::V2, workerId);
+    EXPECT_EQ(sendAndReceive(packet), workerId % kNumWorkers);
+  }
+}
+
+TEST_F(ReusePortBpfTest, FallsBackToHash) {
+  // Long header, truncated short header and unknown connection id version
+  // are still delivered, to whichever socket the kernel hashes them to.
+  std::vector<uint8_t> longHeader(32, 0xc0);
+  EXPECT_GE(sendAndReceive(longHeader), 0);
+  std::vector<uint8_t> truncated{0x40, 0x40, 0x00};
+  EXPECT_GE(sendAndReceive(truncated), 0);
+  std::vector<uint8_t> unknownVersion(32, 0x00);
+  unknownVersion[0] = 0x40;
+  unknownVersion[1] = 0xc0;
+  EXPECT_GE(sendAndReceive(unknownVersion), 0);
+}
+
+#endif
+
+} // namespace test
+} // namespace quic
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <quic/codec/QuicPacketBuilder.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/handshake/FizzRetryIntegrityTagGenerator.h>
+#include <quic/server/StatelessResponseWriter.h>
+#include <quic/server/handshake/RetryTokenGenerator.h>
+#include <quic/server/handshake/StatelessResetGenerator.h>
+
+/**
+ * Measures how many stateless responses (Stateless Reset, Retry and Version
+ * Negotiation) one core can build and send, comparing generators keyed per
+ * response with pre-keyed ones, and single writes with batched sendmmsg to a
+ * loopback sink.
+ */
+
+using namespace quic;
+
+namespace {
+
+const folly::SocketAddress kClient("127.0.0.1", 4433);
+const std::string kServerAddress = "127.0.0.1:443";
+
+StatelessResetSecret makeResetSecret() {
+  StatelessResetSecret secret;
+  secret.fill(0x42);
+  return secret;
+}
+
+RetryTokenSecret makeRetrySecret() {
+  RetryTokenSecret secret;
+  secret.fill(0x24);
+  return secret;
+}
+
+Buf buildReset(StatelessResetGenerator& generator, const ConnectionId& connId) {
+  StatelessResetPacketBuilder builder(
+      kMinStatelessPacketSize, generator.generateToken(connId));
+  return std::move(builder).buildPacket();
+}
+
+Buf buildRetry(
+    RetryTokenGenerator& tokenGenerator,
+    FizzRetryIntegrityTagGenerator& tagGenerator,
+    const ConnectionId& dstConnId,
+    const ConnectionId& srcConnId) {
+  auto encryptedToken = tokenGenerator.encryptToken(
+      dstConnId, kClient.getIPAddress(), kClient.getPort());
+  auto tokenStr = encryptedToken.value()->moveToFbString().toStdString();
+  uint8_t initialByte = kHeaderFormMask | LongHeader::kFixedBitMask |
+      (static_cast<uint8_t>(LongHeader::Types::Retry)
+       << LongHeader::kTypeShift);
+  PseudoRetryPacketBuilder pseudoBuilder(
+      initialByte,
+      dstConnId,
+      srcConnId,
+      dstConnId,
+      QuicVersion::MVFST_INVALID,
+      folly::IOBuf::copyBuffer(tokenStr));
+  auto pseudoPacket = std::move(pseudoBuilder).buildPacket();
+  auto integrityTag = tagGenerator.getRetryIntegrityTag(pseudoPacket.get());
+  RetryPacketBuilder builder(
+      dstConnId,
+      srcConnId,
+      QuicVersion::MVFST_INVALID,
+      std::move(tokenStr),
+      std::move(integrityTag));
+  return std::move(builder).buildPacket();
+}
+
+Buf buildVersionNegotiation(
+    const ConnectionId& dstConnId,
+    const ConnectionId& srcConnId) {
+  VersionNegotiationPacketBuilder builder(
+      dstConnId,
+      srcConnId,
+      std::vector<QuicVersion>{QuicVersion::MVFST, QuicVersion::QUIC_DRAFT});
+  return std::move(builder).buildPacket().second;
+}
+
+void sendResets(size_t iters, size_t batchSize) {
+  folly::BenchmarkSuspender suspender;
+  folly::EventBase evb;
+  folly::AsyncUDPSocket sink(&evb);
+  sink.bind(folly::SocketAddress("127.0.0.1", 0));
+  folly::AsyncUDPSocket sock(&evb);
+  sock.bind(folly::SocketAddress("127.0.0.1", 0));
+  auto sinkAddress = sink.address();
+  StatelessResetGenerator generator(makeResetSecret(), kServerAddress);
+  StatelessResponseWriter writer(batchSize);
+  auto connId = test::getTestConnectionId();
+  suspender.dismiss();
+  while (iters--) {
+    writer.write(sock, sinkAddress, buildReset(generator, connId));
+  }
+  writer.flush();
+}
+
+} // namespace
+
+BENCHMARK(stateless_reset_keyed_per_response, iters) {
+  auto connId = test::getTestConnectionId();
+  while (iters--) {
+    StatelessResetGenerator generator(makeResetSecret(), kServerAddress);
+    folly::doNotOptimizeAway(buildReset(generator, connId));
+  }
+}
+
+BENCHMARK_RELATIVE(stateless_reset_prekeyed, iters) {
+  folly::BenchmarkSuspender suspender;
+  StatelessResetGenerator generator(makeResetSecret(), kServerAddress);
+  auto connId = test::getTestConnectionId();
+  suspender.dismiss();
+  while (iters--) {
+    folly::doNotOptimizeAway(buildReset(generator, connId));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(retry_keyed_per_response, iters) {
+  auto dstConnId = test::getTestConnectionId(0);
+  auto srcConnId = test::getTestConnectionId(1);
+  while (iters--) {
+    RetryTokenGenerator tokenGenerator(makeRetrySecret());
+    FizzRetryIntegrityTagGenerator tagGenerator;
+    folly::doNotOptimizeAway(
+        buildRetry(tokenGenerator, tagGenerator, dstConnId, srcConnId));
+  }
+}
+
+BENCHMARK_RELATIVE(retry_prekeyed, iters) {
+  folly::BenchmarkSuspender suspender;
+  RetryTokenGenerator tokenGenerator(makeRetrySecret());
+  FizzRetryIntegrityTagGenerator tagGenerator;
+  auto dstConnId = test::getTestConnectionId(0);
+  auto srcConnId = test::getTestConnectionId(1);
+  suspender.dismiss();
+  while (iters--) {
+    folly::doNotOptimizeAway(
+        buildRetry(tokenGenerator, tagGenerator, dstConnId, srcConnId));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(version_negotiation_build, iters) {
+  auto dstConnId = test::getTestConnectionId(0);
+  auto srcConnId = test::getTestConnectionId(1);
+  while (iters--) {
+    folly::doNotOptimizeAway(buildVersionNegotiation(dstConnId, srcConnId));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(stateless_reset_send_single, iters) {
+  sendResets(iters, 1);
+}
+
+BENCHMARK_RELATIVE(stateless_reset_send_batch_16, iters) {
+  sendResets(iters, 16);
+}
+
+BENCHMARK_RELATIVE(stateless_reset_send_batch_64, iters) {
+  sendResets(iters, 64);
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/io/async/test/MockAsyncUDPSocket.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+#include <quic/server/StatelessResponseWriter.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+class StatelessResponseWriterTest : public Test {
+ protected:
+  Buf makeResponse(size_t len) {
+    auto buf = folly::IOBuf::create(len);
+    buf->append(len);
+    return buf;
+  }
+
+  folly::EventBase evb_;
+  NiceMock<folly::test::MockAsyncUDPSocket> sock_{&evb_};
+  folly::SocketAddress client1_{"1.2.3.4", 1234};
+  folly::SocketAddress client2_{"5.6.7.8", 5678};
+};
+
+TEST_F(StatelessResponseWriterTest, WritesImmediatelyByDefault) {
+  StatelessResponseWriter writer;
+  EXPECT_CALL(sock_, write(client1_, _)).WillOnce(Return(10));
+  writer.write(sock_, client1_, makeResponse(10));
+  EXPECT_EQ(writer.pending(), 0);
+  EXPECT_FALSE(writer.isLoopCallbackScheduled());
+}
+
+TEST_F(StatelessResponseWriterTest, FlushesAtEndOfLoop) {
+  StatelessResponseWriter writer(8);
+  EXPECT_CALL(sock_, write(_, _)).Times(0);
+  EXPECT_CALL(sock_, writem(_, _, _)).Times(0);
+  writer.write(sock_, client1_, makeResponse(10));
+  writer.write(sock_, client2_, makeResponse(20));
+  EXPECT_EQ(writer.pending(), 2);
+  EXPECT_TRUE(writer.isLoopCallbackScheduled());
+  Mock::VerifyAndClearExpectations(&sock_);
+
+  EXPECT_CALL(sock_, writem(_, _, 2))
+      .WillOnce(Invoke([&](folly::Range<folly::SocketAddress const*> addrs,
+                           const std::unique_ptr<folly::IOBuf>* bufs,
+                           size_t count) {
+        EXPECT_EQ(addrs.size(), count);
+        EXPECT_EQ(addrs[0], client1_);
+        EXPECT_EQ(addrs[1], client2_);
+        EXPECT_EQ(bufs[0]->computeChainDataLength(), 10);
+        EXPECT_EQ(bufs[1]->computeChainDataLength(), 20);
+        return count;
+      }));
+  evb_.loopOnce();
+  EXPECT_EQ(writer.pending(), 0);
+}
+
+TEST_F(StatelessResponseWriterTest, FlushesFullBatch) {
+  StatelessResponseWriter writer(2);
+  EXPECT_CALL(sock_, writem(_, _, 2)).WillOnce(Return(2));
+  writer.write(sock_, client1_, makeResponse(10));
+  writer.write(sock_, client2_, makeResponse(10));
+  EXPECT_EQ(writer.pending(), 0);
+  EXPECT_FALSE(writer.isLoopCallbackScheduled());
+}
+
+TEST_F(StatelessResponseWriterTest, SingleResponseUsesWrite) {
+  StatelessResponseWriter writer(8);
+  writer.write(sock_, client1_, makeResponse(10));
+  EXPECT_CALL(sock_, write(client1_, _)).WillOnce(Return(10));
+  EXPECT_CALL(sock_, writem(_, _, _)).Times(0);
+  writer.flush();
+  EXPECT_EQ(writer.pending(), 0);
+}
+
+TEST_F(StatelessResponseWriterTest, ResetDropsPending) {
+  StatelessResponseWriter writer(8);
+  writer.write(sock_, client1_, makeResponse(10));
+  writer.reset();
+  EXPECT_FALSE(writer.isLoopCallbackScheduled());
+  EXPECT_CALL(sock_, write(_, _)).Times(0);
+  EXPECT_CALL(sock_, writem(_, _, _)).Times(0);
+  evb_.loopOnce(EVLOOP_NONBLOCK);
+  writer.flush();
+}
+
+} // namespace test
+} // namespace quic
@@ -13,6 +13,74 @@
 
 namespace quic {
 
+namespace {
+
+/**
+ * Empties the ack event, keeping the storage of its ackedPackets.
+ */
+void resetAckEvent(CongestionController::AckEvent& ack) {
+  auto ackedPackets = std::move(ack.ackedPackets);
+  ackedPackets.clear();
+  ack = CongestionController::AckEvent();
+  ack.ackedPackets = std::move(ackedPackets);
+}
+
+/**
+ * Adds the acks of an ACK frame, but its ackedPackets, to the pending ack
+ * event.
+ */
+void mergeAckEvent(
+    CongestionController::AckEvent& pending,
+    const CongestionController::AckEvent& ack) {
+  if (!ack.largestAckedPacket) {
+    return;
+  }
+  bool first = !pending.largestAckedPacket.has_value();
+  // The two events can be from different packet number spaces, whose packet
+  // numbers can't be compared, so the largest acked is the latest sent.
+  if (first ||
+      pending.largestAckedPacketSentTime < ack.largestAckedPacketSentTime ||
+      (pending.largestAckedPacketSentTime == ack.largestAckedPacketSentTime &&
+       *pending.largestAckedPacket < *ack.largestAckedPacket)) {
+    pending.largestAckedPacket = ack.largestAckedPacket;
+    pending.largestAckedPacketSentTime = ack.largestAckedPacketSentTime;
+    pending.largestAckedPacketAppLimited = ack.largestAckedPacketAppLimited;
+  }
+  if (first || pending.ackTime < ack.ackTime) {
+    pending.ackTime = ack.ackTime;
+    pending.adjustedAckTime = ack.adjustedAckTime;
+  }
+  pending.ackedBytes += ack.ackedBytes;
+  if (ack.mrttSample) {
+    pending.mrttSample =
+        std::min(pending.mrttSample.value_or(*ack.mrttSample), *ack.mrttSample);
+  }
+}
+
+void mergeLossEvent(
+    folly::Optional<CongestionController::LossEvent>& pending,
+    const CongestionController::LossEvent& loss) {
+  if (!pending) {
+    pending.emplace(loss);
+    return;
+  }
+  CongestionController::LossEvent merged(
+      std::max(pending->lossTime, loss.lossTime));
+  merged.largestLostPacketNum = std::max(
+      pending->largestLostPacketNum, loss.largestLostPacketNum);
+  merged.lostBytes = pending->lostBytes + loss.lostBytes;
+  merged.lostPackets = pending->lostPackets + loss.lostPackets;
+  merged.largestLostSentTime =
+      std::max(pending->largestLostSentTime, loss.largestLostSentTime);
+  merged.smallestLostSentTime = std::min(
+      *pending->smallestLostSentTime, *loss.smallestLostSentTime);
+  merged.persistentCongestion =
+      pending->persistentCongestion || loss.persistentCongestion;
+  pending.emplace(std::move(merged));
+}
+
+} // namespace
+
 /**
  * Process ack frame and acked outstanding packets.
  *
@@ -36,8 +104,14 @@ void processAckFrame(
     const AckVisitor& ackVisitor,
     const LossVisitor& lossVisitor,
     const TimePoint& ackReceiveTime) {
+  QUIC_TRACE_SCOPE(ACK_PROCESSING);
   // TODO: send error if we get an ack for a packet we've not sent t18721184
-  CongestionController::AckEvent ack;
+  folly::Optional<TimePoint> processingStartTime;
+  if (conn.statsCallback && conn.statsCallback->wantsLatencySamples()) {
+    processingStartTime = Clock::now();
+  }
+  auto& ack = conn.ackEventBuffer;
+  resetAckEvent(ack);
   ack.ackTime = ackReceiveTime;
   ack.implicit = frame.implicit;
   ack.adjustedAckTime = ackReceiveTime - frame.ackDelay;
@@ -46,6 +120,11 @@ void processAckFrame(
   // different acking policy. It's also possibly that all acked packets are pure
   // acks which leads to different number of packets being acked usually.
   ack.ackedPackets.reserve(kDefaultRxPacketsBeforeAckAfterInit);
+  // When batching, the acked packets go straight to the pending ack event.
+  bool batchAckEvent = conn.congestionController &&
+      conn.transportSettings.batchAckEvents && !frame.implicit;
+  auto& ackedPackets =
+      batchAckEvent ? conn.pendingAckEvent.ackedPackets : ack.ackedPackets;
   auto currentPacketIt = getLastOutstandingPacketIncludingLost(conn, pnSpace);
   uint64_t dsrPacketsAcked = 0;
   folly::Optional<decltype(conn.lossState.lastAckedPacketSentTime)>
@@ -208,7 +287,7 @@ void processAckFrame(
         conn.lossState.lastAckedTime = ackReceiveTime;
         conn.lossState.adjustedLastAckedTime = ackReceiveTime - frame.ackDelay;
       }
-      ack.ackedPackets.push_back(
+      ackedPackets.push_back(
           CongestionController::AckEvent::AckPacket::Builder()
               .setSentTime(rPacketIt->metadata.time)
               .setEncodedSize(rPacketIt->metadata.encodedSize)
@@ -275,10 +354,30 @@ void processAckFrame(
         QUIC_STATS(conn.statsCallback, onPersistentCongestion);
       }
     }
-    conn.congestionController->onPacketAckOrLoss(
-        std::move(ack), std::move(lossEvent));
+    if (batchAckEvent) {
+      mergeAckEvent(conn.pendingAckEvent, ack);
+      if (lossEvent) {
+        mergeLossEvent(conn.pendingLossEvent, *lossEvent);
+      }
+    } else {
+      // Keep the updates in the order of the ACK frames.
+      processPendingAckEvents(conn);
+      conn.congestionController->onPacketAckOrLossInPlace(
+          &ack, lossEvent.get_pointer());
+      QUIC_STATS(
+          conn.statsCallback,
+          onCwndSample,
+          conn.congestionController->getCongestionWindow());
+    }
   }
   clearOldOutstandingPackets(conn, ackReceiveTime, pnSpace);
+  if (processingStartTime) {
+    QUIC_STATS(
+        conn.statsCallback,
+        onAckProcessed,
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - *processingStartTime));
+  }
   if (spuriousLossEvent && spuriousLossEvent->hasPackets()) {
     for (const auto& observer : *(conn.observers)) {
       conn.pendingCallbacks.emplace_back(
@@ -291,6 +390,23 @@ void processAckFrame(
   }
 }
 
+void processPendingAckEvents(QuicConnectionStateBase& conn) {
+  auto& ack = conn.pendingAckEvent;
+  if (!ack.largestAckedPacket && !conn.pendingLossEvent) {
+    return;
+  }
+  if (conn.congestionController) {
+    conn.congestionController->onPacketAckOrLossInPlace(
+        &ack, conn.pendingLossEvent.get_pointer());
+    QUIC_STATS(
+        conn.statsCallback,
+        onCwndSample,
+        conn.congestionController->getCongestionWindow());
+  }
+  resetAckEvent(ack);
+  conn.pendingLossEvent.reset();
+}
+
 void clearOldOutstandingPackets(
     QuicConnectionStateBase& conn,
     TimePoint time,
@@ -33,6 +33,12 @@ void processAckFrame(
     const LossVisitor& lossVisitor,
     const TimePoint& ackReceiveTime);
 
+/**
+ * Gives the acks and losses of the ACK frames processed since the last call
+ * to the congestion controller, when transportSettings.batchAckEvents is set.
+ */
+void processPendingAckEvents(QuicConnectionStateBase& conn);
+
 /**
  * Clears outstanding packets marked as lost that are not likely to be ACKed
  * (have been lost for >= 1 PTO).
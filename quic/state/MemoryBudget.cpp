@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/MemoryBudget.h>
+
+#include <quic/state/StateData.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace quic {
+
+namespace {
+constexpr uint64_t kMinWindowDivisor = 8;
+} // namespace
+
+MemoryBudget::MemoryBudget(uint64_t budgetBytes, double pressureThreshold) {
+  setBudget(budgetBytes, pressureThreshold);
+}
+
+void MemoryBudget::setBudget(uint64_t budgetBytes, double pressureThreshold) {
+  CHECK_GT(budgetBytes, 0);
+  CHECK(pressureThreshold > 0 && pressureThreshold <= 1)
+      << "Invalid pressure threshold=" << pressureThreshold;
+  budget_ = budgetBytes;
+  pressureBytes_ = static_cast<uint64_t>(budgetBytes * pressureThreshold);
+}
+
+void MemoryBudget::add(uint64_t bytes) {
+  usage_ += bytes;
+}
+
+void MemoryBudget::remove(uint64_t bytes) {
+  DCHECK_GE(usage_, bytes);
+  usage_ -= std::min(usage_, bytes);
+}
+
+uint64_t MemoryBudget::scaleWindow(uint64_t windowSize) const {
+  if (!underPressure()) {
+    return windowSize;
+  }
+  auto minWindow = windowSize / kMinWindowDivisor;
+  if (usage_ >= budget_) {
+    return minWindow;
+  }
+  // Use floating point, windowSize * (budget_ - usage_) can overflow.
+  auto fraction = static_cast<double>(budget_ - usage_) /
+      static_cast<double>(budget_ - pressureBytes_);
+  return std::max(minWindow, static_cast<uint64_t>(windowSize * fraction));
+}
+
+uint64_t estimateBufferedBytes(
+    const QuicConnectionStateBase& conn,
+    uint64_t extraBytes) {
+  const auto& flowControlState = conn.flowControlState;
+  // Received and not read yet by the app, including holes.
+  uint64_t readBuffered = flowControlState.sumMaxObservedOffset -
+      std::min(
+          flowControlState.sumMaxObservedOffset,
+          flowControlState.sumCurReadOffset);
+  // Written by the app and not sent yet, and sent and not acked yet.
+  uint64_t writeBuffered =
+      flowControlState.sumCurStreamBufferLen + conn.lossState.inflightBytes;
+  return readBuffered + writeBuffered + extraBytes;
+}
+
+void updateMemoryUsage(QuicConnectionStateBase& conn, uint64_t extraBytes) {
+  if (!conn.memoryBudget) {
+    return;
+  }
+  auto usage = estimateBufferedBytes(conn, extraBytes);
+  if (usage > conn.memoryBudgetUsage) {
+    conn.memoryBudget->add(usage - conn.memoryBudgetUsage);
+  } else {
+    conn.memoryBudget->remove(conn.memoryBudgetUsage - usage);
+  }
+  conn.memoryBudgetUsage = usage;
+}
+
+void releaseMemoryUsage(QuicConnectionStateBase& conn) {
+  if (!conn.memoryBudget) {
+    return;
+  }
+  conn.memoryBudget->remove(conn.memoryBudgetUsage);
+  conn.memoryBudgetUsage = 0;
+  conn.memoryBudget = nullptr;
+}
+
+} // namespace quic
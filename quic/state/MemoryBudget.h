@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace quic {
+
+struct QuicConnectionStateBase;
+
+/**
+ * Budget for the bytes buffered by a group of connections, typically all the
+ * connections of a server worker: stream read and write buffers, data
+ * waiting to be acked and packets waiting for their keys.
+ *
+ * Each connection reports an estimate of its own usage with
+ * updateMemoryUsage(). Once the total goes above the pressure threshold the
+ * connections start advertising smaller flow control windows and stop
+ * raising the peer's stream limits, which slows down the peers before the
+ * budget is exhausted rather than failing any connection.
+ *
+ * Not thread safe, all the connections sharing a budget must run on the same
+ * event base.
+ */
+class MemoryBudget {
+ public:
+  /**
+   * pressureThreshold is the fraction of budgetBytes above which connections
+   * are slowed down.
+   */
+  MemoryBudget(uint64_t budgetBytes, double pressureThreshold);
+
+  void setBudget(uint64_t budgetBytes, double pressureThreshold);
+
+  void add(uint64_t bytes);
+
+  void remove(uint64_t bytes);
+
+  uint64_t usage() const {
+    return usage_;
+  }
+
+  uint64_t budget() const {
+    return budget_;
+  }
+
+  bool underPressure() const {
+    return usage_ >= pressureBytes_;
+  }
+
+  /**
+   * Returns the flow control window to advertise instead of windowSize. It
+   * shrinks linearly from the pressure threshold to the budget, down to an
+   * eighth of windowSize so that no connection stalls completely.
+   */
+  uint64_t scaleWindow(uint64_t windowSize) const;
+
+ private:
+  uint64_t budget_;
+  uint64_t pressureBytes_;
+  uint64_t usage_{0};
+};
+
+/**
+ * Estimate of the bytes buffered by conn, extraBytes accounts for buffers
+ * the transport keeps outside of the connection state.
+ */
+uint64_t estimateBufferedBytes(
+    const QuicConnectionStateBase& conn,
+    uint64_t extraBytes = 0);
+
+/**
+ * Updates the usage of conn in its memory budget, if it has one.
+ */
+void updateMemoryUsage(QuicConnectionStateBase& conn, uint64_t extraBytes = 0);
+
+/**
+ * Returns the usage of conn to its memory budget and detaches it from it.
+ */
+void releaseMemoryUsage(QuicConnectionStateBase& conn);
+
+} // namespace quic
@@ -18,6 +18,18 @@ namespace quic {
 
 struct BbrStats {
   uint8_t state;
+  // Bandwidth estimate in bytes per second.
+  uint64_t bandwidth;
+};
+
+struct Bbr2Stats {
+  // A Bbr2CongestionController::State.
+  uint8_t state;
+  // Bandwidth estimate in bytes per second.
+  uint64_t bandwidth;
+  // The inflight bounds in bytes, 0 when not set.
+  uint64_t inflightHi;
+  uint64_t inflightLo;
 };
 
 struct CopaStats {
@@ -32,6 +44,7 @@ struct CubicStats {
 
 union CongestionControllerStats {
   struct BbrStats bbrStats;
+  struct Bbr2Stats bbr2Stats;
   struct CopaStats copaStats;
   struct CubicStats cubicStats;
 };
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/QuicHistogramStats.h>
+
+namespace quic {
+
+void QuicHistogramStatsRegistry::Snapshot::merge(
+    const Snapshot& other) noexcept {
+  for (auto key : counters.keys()) {
+    counters[key] += other.counters[key];
+  }
+  for (auto key : packetDrops.keys()) {
+    packetDrops[key] += other.packetDrops[key];
+  }
+  for (auto key : admissions.keys()) {
+    admissions[key] += other.admissions[key];
+  }
+  for (auto key : histograms.keys()) {
+    histograms[key].merge(other.histograms[key]);
+  }
+  for (auto key : hotPath.keys()) {
+    hotPath[key].merge(other.hotPath[key]);
+  }
+}
+
+QuicHistogramStatsRegistry::Snapshot
+QuicHistogramStatsRegistry::Shard::snapshot() const noexcept {
+  Snapshot snap;
+  for (auto key : counters.keys()) {
+    snap.counters[key] = counters[key].load(std::memory_order_relaxed);
+  }
+  for (auto key : packetDrops.keys()) {
+    snap.packetDrops[key] = packetDrops[key].load(std::memory_order_relaxed);
+  }
+  for (auto key : admissions.keys()) {
+    snap.admissions[key] = admissions[key].load(std::memory_order_relaxed);
+  }
+  for (auto key : histograms.keys()) {
+    snap.histograms[key] = histograms[key].snapshot();
+  }
+  for (auto key : hotPath.keys()) {
+    snap.hotPath[key] = hotPath[key].snapshot();
+  }
+  return snap;
+}
+
+QuicHistogramStatsRegistry::QuicHistogramStatsRegistry(size_t maxShards) {
+  shards_.reserve(maxShards);
+  for (size_t i = 0; i < maxShards; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+QuicHistogramStatsRegistry::Shard*
+QuicHistogramStatsRegistry::allocateShard() noexcept {
+  auto index = numShards_.load(std::memory_order_relaxed);
+  do {
+    if (index >= shards_.size()) {
+      return nullptr;
+    }
+  } while (!numShards_.compare_exchange_weak(
+      index, index + 1, std::memory_order_acq_rel));
+  return shards_[index].get();
+}
+
+size_t QuicHistogramStatsRegistry::numShards() const noexcept {
+  return numShards_.load(std::memory_order_acquire);
+}
+
+QuicHistogramStatsRegistry::Snapshot QuicHistogramStatsRegistry::snapshot(
+    size_t shardIndex) const noexcept {
+  if (shardIndex >= numShards()) {
+    return Snapshot();
+  }
+  return shards_[shardIndex]->snapshot();
+}
+
+QuicHistogramStatsRegistry::Snapshot QuicHistogramStatsRegistry::snapshot()
+    const noexcept {
+  Snapshot merged;
+  auto numShards = this->numShards();
+  for (size_t i = 0; i < numShards; ++i) {
+    merged.merge(shards_[i]->snapshot());
+  }
+  return merged;
+}
+
+void QuicHistogramStatsRegistry::setExportCallback(ExportCallback cb) {
+  exportCallback_ = std::move(cb);
+}
+
+void QuicHistogramStatsRegistry::exportStats() const {
+  if (exportCallback_) {
+    exportCallback_(snapshot());
+  }
+}
+
+QuicHistogramStats::QuicHistogramStats(
+    std::shared_ptr<QuicHistogramStatsRegistry> registry,
+    QuicHistogramStatsRegistry::Shard* shard)
+    : registry_(std::move(registry)), shard_(CHECK_NOTNULL(shard)) {}
+
+QuicHistogramStatsFactory::QuicHistogramStatsFactory(
+    std::shared_ptr<QuicHistogramStatsRegistry> registry)
+    : registry_(std::move(registry)) {
+  CHECK(registry_);
+}
+
+std::unique_ptr<QuicTransportStatsCallback> QuicHistogramStatsFactory::make() {
+  auto shard = registry_->allocateShard();
+  CHECK(shard) << "QuicHistogramStatsRegistry ran out of shards";
+  return std::make_unique<QuicHistogramStats>(registry_, shard);
+}
+
+} // namespace quic
@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <folly/lang/Align.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <quic/common/EnumArray.h>
+#include <quic/common/LogLinearHistogram.h>
+#include <quic/state/QuicTransportStatsCallback.h>
+
+namespace quic {
+
+/**
+ * Built-in QuicTransportStatsCallback sink.
+ *
+ * Every worker gets its own shard, allocated by QuicHistogramStatsFactory and
+ * aligned to a cache line so two workers never write to the same line. A
+ * shard has a single writer (the worker thread), so updating a counter or a
+ * histogram is a couple of relaxed loads and stores with no atomic RMW.
+ *
+ * Any thread can call QuicHistogramStatsRegistry::snapshot() at any time to
+ * merge all the shards without taking a lock.
+ */
+class QuicHistogramStatsRegistry {
+ public:
+  enum class Counter : uint8_t {
+    PACKET_RECEIVED,
+    DUPLICATED_PACKET_RECEIVED,
+    OUT_OF_ORDER_PACKET_RECEIVED,
+    PACKET_PROCESSED,
+    PACKET_SENT,
+    PACKET_RETRANSMISSION,
+    PACKET_LOSS,
+    PACKET_SPURIOUS_LOSS,
+    PERSISTENT_CONGESTION,
+    PACKET_FORWARDED,
+    FORWARDED_PACKET_RECEIVED,
+    FORWARDED_PACKET_PROCESSED,
+    CLIENT_INITIAL_RECEIVED,
+    CONNECTION_RATE_LIMITED,
+    NEW_CONNECTION,
+    CONNECTION_CLOSE,
+    NEW_QUIC_STREAM,
+    QUIC_STREAM_CLOSED,
+    QUIC_STREAM_RESET,
+    CONN_FLOW_CONTROL_UPDATE,
+    CONN_FLOW_CONTROL_BLOCKED,
+    STATELESS_RESET,
+    STREAM_FLOW_CONTROL_UPDATE,
+    STREAM_FLOW_CONTROL_BLOCKED,
+    CWND_BLOCKED,
+    NEW_CONGESTION_CONTROLLER,
+    PTO,
+    BYTES_READ,
+    BYTES_WRITTEN,
+    UDP_SOCKET_WRITE_ERROR,
+    D6D_STARTED,
+    PMTU_RAISED,
+    PMTU_BLACKHOLE_DETECTED,
+    PMTU_UPPER_BOUND_DETECTED,
+    TRANSPORT_KNOB_APPLIED,
+    TRANSPORT_KNOB_ERROR,
+    SERVER_UNFINISHED_HANDSHAKE,
+    ZERO_RTT_BUFFERED,
+    ZERO_RTT_BUFFERED_PRUNED,
+    HANDSHAKE_OFFLOAD_REJECTED,
+    ROUTING_TABLE_HIT,
+    ROUTING_TABLE_MISS,
+    PATH_STATE_CACHE_HIT,
+    PATH_STATE_CACHE_MISS,
+    // NOTE: MAX should always be at the end
+    MAX
+  };
+
+  enum class Histogram : uint8_t {
+    RTT_US,
+    CWND_BYTES,
+    PACKET_SIZE,
+    WRITE_BURST_PACKETS,
+    ACK_PROCESSING_US,
+    HANDSHAKE_US,
+    HANDSHAKE_QUEUE_DELAY_US,
+    ROUTING_LOOKUP_NS,
+    FORWARDED_SEND_BATCH_PACKETS,
+    FORWARDED_RECV_BATCH_PACKETS,
+    COLD_COMPLETION_US,
+    WARM_COMPLETION_US,
+    // NOTE: MAX should always be at the end
+    MAX
+  };
+
+  using PacketDropReason = QuicTransportStatsCallback::PacketDropReason;
+  using AdmissionDecision = QuicTransportStatsCallback::AdmissionDecision;
+
+  struct Snapshot {
+    EnumArray<Counter, uint64_t> counters{};
+    EnumArray<PacketDropReason, uint64_t> packetDrops{};
+    EnumArray<AdmissionDecision, uint64_t> admissions{};
+    EnumArray<Histogram, LogLinearHistogram::Snapshot> histograms{};
+    // Nanoseconds per loop iteration, see HotPathTrace.h.
+    EnumArray<HotPathPhase, LogLinearHistogram::Snapshot> hotPath{};
+
+    void merge(const Snapshot& other) noexcept;
+  };
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    EnumArray<Counter, std::atomic<uint64_t>> counters{};
+    EnumArray<PacketDropReason, std::atomic<uint64_t>> packetDrops{};
+    EnumArray<AdmissionDecision, std::atomic<uint64_t>> admissions{};
+    EnumArray<Histogram, LogLinearHistogram> histograms{};
+    EnumArray<HotPathPhase, LogLinearHistogram> hotPath{};
+
+    void add(Counter counter, uint64_t delta = 1) noexcept {
+      auto& val = counters[counter];
+      val.store(
+          val.load(std::memory_order_relaxed) + delta,
+          std::memory_order_relaxed);
+    }
+
+    void addDrop(PacketDropReason reason) noexcept {
+      auto& val = packetDrops[reason];
+      val.store(
+          val.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void addAdmission(AdmissionDecision decision) noexcept {
+      auto& val = admissions[decision];
+      val.store(
+          val.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void addValue(Histogram histogram, uint64_t value) noexcept {
+      histograms[histogram].addValue(value);
+    }
+
+    Snapshot snapshot() const noexcept;
+  };
+
+  using ExportCallback = std::function<void(const Snapshot&)>;
+
+  /**
+   * maxShards bounds the number of workers that can report into this
+   * registry. All shards are allocated upfront so that readers never race
+   * with an allocation.
+   */
+  explicit QuicHistogramStatsRegistry(size_t maxShards);
+
+  /**
+   * Hands out the next unused shard. Returns nullptr once maxShards shards
+   * have been handed out.
+   */
+  Shard* allocateShard() noexcept;
+
+  size_t numShards() const noexcept;
+
+  /**
+   * Snapshot of a single shard, e.g. to look at per worker stats.
+   */
+  Snapshot snapshot(size_t shardIndex) const noexcept;
+
+  /**
+   * Merged snapshot of all the shards handed out so far.
+   */
+  Snapshot snapshot() const noexcept;
+
+  /**
+   * Set the hook invoked by exportStats(). The application decides how often
+   * to export, e.g. from a timer on one of its own EventBases.
+   */
+  void setExportCallback(ExportCallback cb);
+
+  /**
+   * Take a merged snapshot and hand it to the export callback, if any.
+   */
+  void exportStats() const;
+
+ private:
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> numShards_{0};
+  ExportCallback exportCallback_;
+};
+
+/**
+ * Per worker QuicTransportStatsCallback writing into one registry shard.
+ */
+class QuicHistogramStats : public QuicTransportStatsCallback {
+ public:
+  using Counter = QuicHistogramStatsRegistry::Counter;
+  using Histogram = QuicHistogramStatsRegistry::Histogram;
+
+  QuicHistogramStats(
+      std::shared_ptr<QuicHistogramStatsRegistry> registry,
+      QuicHistogramStatsRegistry::Shard* shard);
+
+  ~QuicHistogramStats() override = default;
+
+  void onPacketReceived() override {
+    shard_->add(Counter::PACKET_RECEIVED);
+  }
+
+  void onDuplicatedPacketReceived() override {
+    shard_->add(Counter::DUPLICATED_PACKET_RECEIVED);
+  }
+
+  void onOutOfOrderPacketReceived() override {
+    shard_->add(Counter::OUT_OF_ORDER_PACKET_RECEIVED);
+  }
+
+  void onPacketProcessed() override {
+    shard_->add(Counter::PACKET_PROCESSED);
+  }
+
+  void onPacketSent() override {
+    shard_->add(Counter::PACKET_SENT);
+  }
+
+  void onPacketRetransmission() override {
+    shard_->add(Counter::PACKET_RETRANSMISSION);
+  }
+
+  void onPacketLoss() override {
+    shard_->add(Counter::PACKET_LOSS);
+  }
+
+  void onPacketSpuriousLoss() override {
+    shard_->add(Counter::PACKET_SPURIOUS_LOSS);
+  }
+
+  void onPersistentCongestion() override {
+    shard_->add(Counter::PERSISTENT_CONGESTION);
+  }
+
+  void onPacketDropped(PacketDropReason reason) override {
+    shard_->addDrop(reason);
+  }
+
+  void onPacketForwarded() override {
+    shard_->add(Counter::PACKET_FORWARDED);
+  }
+
+  void onForwardedPacketReceived() override {
+    shard_->add(Counter::FORWARDED_PACKET_RECEIVED);
+  }
+
+  void onForwardedPacketProcessed() override {
+    shard_->add(Counter::FORWARDED_PACKET_PROCESSED);
+  }
+
+  void onForwardedPacketBatchSent(uint32_t numPackets) override {
+    shard_->addValue(Histogram::FORWARDED_SEND_BATCH_PACKETS, numPackets);
+  }
+
+  void onForwardedPacketBatchReceived(uint32_t numPackets) override {
+    shard_->addValue(Histogram::FORWARDED_RECV_BATCH_PACKETS, numPackets);
+  }
+
+  void onClientInitialReceived(QuicVersion) override {
+    shard_->add(Counter::CLIENT_INITIAL_RECEIVED);
+  }
+
+  void onConnectionRateLimited() override {
+    shard_->add(Counter::CONNECTION_RATE_LIMITED);
+  }
+
+  void onConnectionAdmission(AdmissionDecision decision) override {
+    shard_->addAdmission(decision);
+  }
+
+  void onRoutingTableLookup(bool found, std::chrono::nanoseconds duration)
+      override {
+    shard_->add(
+        found ? Counter::ROUTING_TABLE_HIT : Counter::ROUTING_TABLE_MISS);
+    shard_->addValue(Histogram::ROUTING_LOOKUP_NS, duration.count());
+  }
+
+  void onNewConnection() override {
+    shard_->add(Counter::NEW_CONNECTION);
+  }
+
+  void onConnectionClose(folly::Optional<ConnectionCloseReason>) override {
+    shard_->add(Counter::CONNECTION_CLOSE);
+  }
+
+  void onNewQuicStream() override {
+    shard_->add(Counter::NEW_QUIC_STREAM);
+  }
+
+  void onQuicStreamClosed() override {
+    shard_->add(Counter::QUIC_STREAM_CLOSED);
+  }
+
+  void onQuicStreamReset() override {
+    shard_->add(Counter::QUIC_STREAM_RESET);
+  }
+
+  void onConnFlowControlUpdate() override {
+    shard_->add(Counter::CONN_FLOW_CONTROL_UPDATE);
+  }
+
+  void onConnFlowControlBlocked() override {
+    shard_->add(Counter::CONN_FLOW_CONTROL_BLOCKED);
+  }
+
+  void onStatelessReset() override {
+    shard_->add(Counter::STATELESS_RESET);
+  }
+
+  void onStreamFlowControlUpdate() override {
+    shard_->add(Counter::STREAM_FLOW_CONTROL_UPDATE);
+  }
+
+  void onStreamFlowControlBlocked() override {
+    shard_->add(Counter::STREAM_FLOW_CONTROL_BLOCKED);
+  }
+
+  void onCwndBlocked() override {
+    shard_->add(Counter::CWND_BLOCKED);
+  }
+
+  void onNewCongestionController(CongestionControlType) override {
+    shard_->add(Counter::NEW_CONGESTION_CONTROLLER);
+  }
+
+  void onPTO() override {
+    shard_->add(Counter::PTO);
+  }
+
+  void onRead(size_t bufSize) override {
+    shard_->add(Counter::BYTES_READ, bufSize);
+  }
+
+  void onWrite(size_t bufSize) override {
+    shard_->add(Counter::BYTES_WRITTEN, bufSize);
+    shard_->addValue(Histogram::PACKET_SIZE, bufSize);
+  }
+
+  void onUDPSocketWriteError(SocketErrorType) override {
+    shard_->add(Counter::UDP_SOCKET_WRITE_ERROR);
+  }
+
+  void onConnectionD6DStarted() override {
+    shard_->add(Counter::D6D_STARTED);
+  }
+
+  void onConnectionPMTURaised() override {
+    shard_->add(Counter::PMTU_RAISED);
+  }
+
+  void onConnectionPMTUBlackholeDetected() override {
+    shard_->add(Counter::PMTU_BLACKHOLE_DETECTED);
+  }
+
+  void onConnectionPMTUUpperBoundDetected() override {
+    shard_->add(Counter::PMTU_UPPER_BOUND_DETECTED);
+  }
+
+  void onTransportKnobApplied(TransportKnobType) override {
+    shard_->add(Counter::TRANSPORT_KNOB_APPLIED);
+  }
+
+  void onTransportKnobError(TransportKnobType) override {
+    shard_->add(Counter::TRANSPORT_KNOB_ERROR);
+  }
+
+  void onServerUnfinishedHandshake() override {
+    shard_->add(Counter::SERVER_UNFINISHED_HANDSHAKE);
+  }
+
+  void onZeroRttBuffered() override {
+    shard_->add(Counter::ZERO_RTT_BUFFERED);
+  }
+
+  void onZeroRttBufferedPruned() override {
+    shard_->add(Counter::ZERO_RTT_BUFFERED_PRUNED);
+  }
+
+  void onRttSample(std::chrono::microseconds rtt) override {
+    shard_->addValue(Histogram::RTT_US, rtt.count());
+  }
+
+  void onCwndSample(uint64_t cwndBytes) override {
+    shard_->addValue(Histogram::CWND_BYTES, cwndBytes);
+  }
+
+  void onWriteBurst(uint64_t numPackets) override {
+    shard_->addValue(Histogram::WRITE_BURST_PACKETS, numPackets);
+  }
+
+  void onAckProcessed(std::chrono::microseconds duration) override {
+    shard_->addValue(Histogram::ACK_PROCESSING_US, duration.count());
+  }
+
+  void onHandshakeDone(std::chrono::microseconds duration) override {
+    shard_->addValue(Histogram::HANDSHAKE_US, duration.count());
+  }
+
+  bool wantsLatencySamples() const override {
+    return true;
+  }
+
+  void onHandshakeQueueDelay(std::chrono::microseconds delay) override {
+    shard_->addValue(Histogram::HANDSHAKE_QUEUE_DELAY_US, delay.count());
+  }
+
+  void onHandshakeOffloadRejected() override {
+    shard_->add(Counter::HANDSHAKE_OFFLOAD_REJECTED);
+  }
+
+  void onPathStateCacheLookup(bool hit) override {
+    shard_->add(
+        hit ? Counter::PATH_STATE_CACHE_HIT : Counter::PATH_STATE_CACHE_MISS);
+  }
+
+  void onConnectionCompletion(
+      bool warmStarted,
+      std::chrono::microseconds duration) override {
+    shard_->addValue(
+        warmStarted ? Histogram::WARM_COMPLETION_US
+                    : Histogram::COLD_COMPLETION_US,
+        duration.count());
+  }
+
+  void onHotPathLatency(HotPathPhase phase, std::chrono::nanoseconds duration)
+      override {
+    shard_->hotPath[phase].addValue(duration.count());
+  }
+
+ private:
+  // Keeps the shard alive even if the factory goes away first.
+  std::shared_ptr<QuicHistogramStatsRegistry> registry_;
+  QuicHistogramStatsRegistry::Shard* shard_;
+};
+
+class QuicHistogramStatsFactory : public QuicTransportStatsCallbackFactory {
+ public:
+  explicit QuicHistogramStatsFactory(
+      std::shared_ptr<QuicHistogramStatsRegistry> registry);
+
+  ~QuicHistogramStatsFactory() override = default;
+
+  /**
+   * Called once per worker. The registry must have been created with at
+   * least as many shards as there are workers.
+   */
+  std::unique_ptr<QuicTransportStatsCallback> make() override;
+
+  const std::shared_ptr<QuicHistogramStatsRegistry>& getRegistry() const {
+    return registry_;
+  }
+
+ private:
+  std::shared_ptr<QuicHistogramStatsRegistry> registry_;
+};
+
+} // namespace quic
@@ -56,6 +56,7 @@ void updateRtt(
   // explicitly. We might want to change this by including ackDelay
   // as well.
   conn.lossState.lrtt = rttSample;
+  QUIC_STATS(conn.statsCallback, onRttSample, rttSample);
   if (conn.lossState.srtt == 0us) {
     conn.lossState.srtt = rttSample;
     conn.lossState.rttvar = rttSample / 2;
@@ -167,6 +168,22 @@ bool isConnectionPaced(const QuicConnectionStateBase& conn) noexcept {
       conn.transportSettings.pacingEnabled && conn.canBePaced && conn.pacer);
 }
 
+uint64_t getWriteDataPacketsLimit(QuicConnectionStateBase& conn) {
+  uint64_t packetLimit = conn.transportSettings.writeConnectionDataPacketsLimit;
+  if (isConnectionPaced(conn)) {
+    // Within a budget this is a turn of a burst written by the fair pacing
+    // scheduler. Updating the pacer there would restart its interval in the
+    // middle of the burst.
+    packetLimit = conn.writePacketsBudget
+        ? conn.pacer->getCachedWriteBatchSize()
+        : conn.pacer->updateAndGetWriteBatchSize(Clock::now());
+  }
+  if (conn.writePacketsBudget) {
+    packetLimit = std::min(packetLimit, *conn.writePacketsBudget);
+  }
+  return packetLimit;
+}
+
 AckState& getAckState(
     QuicConnectionStateBase& conn,
     PacketNumberSpace pnSpace) noexcept {
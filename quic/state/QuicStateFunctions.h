@@ -35,6 +35,14 @@ void updateRtt(
 
 bool isConnectionPaced(const QuicConnectionStateBase& conn) noexcept;
 
+/**
+ * How many packets the transport can write in this write loop: the pacer's
+ * batch size or writeConnectionDataPacketsLimit, within writePacketsBudget.
+ * Within a budget, i.e. in a fair pacing turn, the pacer's cached batch size
+ * is used: the pacer is updated once per burst, when the burst is queued.
+ */
+uint64_t getWriteDataPacketsLimit(QuicConnectionStateBase& conn);
+
 AckState& getAckState(
     QuicConnectionStateBase& conn,
     PacketNumberSpace pnSpace) noexcept;
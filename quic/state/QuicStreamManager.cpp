@@ -563,6 +563,61 @@ void QuicStreamManager::setStreamAsControl(QuicStreamState& stream) {
   updateAppIdleState();
 }
 
+QuicStreamManager::StreamIdState QuicStreamManager::getStreamIdState() const {
+  StreamIdState state;
+  state.nextAcceptablePeerBidirectionalStreamId =
+      nextAcceptablePeerBidirectionalStreamId_;
+  state.nextAcceptablePeerUnidirectionalStreamId =
+      nextAcceptablePeerUnidirectionalStreamId_;
+  state.nextAcceptableLocalBidirectionalStreamId =
+      nextAcceptableLocalBidirectionalStreamId_;
+  state.nextAcceptableLocalUnidirectionalStreamId =
+      nextAcceptableLocalUnidirectionalStreamId_;
+  state.nextBidirectionalStreamId = nextBidirectionalStreamId_;
+  state.nextUnidirectionalStreamId = nextUnidirectionalStreamId_;
+  state.maxLocalBidirectionalStreamId = maxLocalBidirectionalStreamId_;
+  state.maxLocalUnidirectionalStreamId = maxLocalUnidirectionalStreamId_;
+  state.maxRemoteBidirectionalStreamId = maxRemoteBidirectionalStreamId_;
+  state.maxRemoteUnidirectionalStreamId = maxRemoteUnidirectionalStreamId_;
+  for (const auto& openStreams :
+       {&openBidirectionalPeerStreams_,
+        &openUnidirectionalPeerStreams_,
+        &openBidirectionalLocalStreams_,
+        &openUnidirectionalLocalStreams_}) {
+    state.openStreams.insert(
+        state.openStreams.end(), openStreams->begin(), openStreams->end());
+  }
+  return state;
+}
+
+void QuicStreamManager::setStreamIdState(const StreamIdState& state) {
+  DCHECK(!hasOpenStreams());
+  nextAcceptablePeerBidirectionalStreamId_ =
+      state.nextAcceptablePeerBidirectionalStreamId;
+  nextAcceptablePeerUnidirectionalStreamId_ =
+      state.nextAcceptablePeerUnidirectionalStreamId;
+  nextAcceptableLocalBidirectionalStreamId_ =
+      state.nextAcceptableLocalBidirectionalStreamId;
+  nextAcceptableLocalUnidirectionalStreamId_ =
+      state.nextAcceptableLocalUnidirectionalStreamId;
+  nextBidirectionalStreamId_ = state.nextBidirectionalStreamId;
+  nextUnidirectionalStreamId_ = state.nextUnidirectionalStreamId;
+  maxLocalBidirectionalStreamId_ = state.maxLocalBidirectionalStreamId;
+  maxLocalUnidirectionalStreamId_ = state.maxLocalUnidirectionalStreamId;
+  maxRemoteBidirectionalStreamId_ = state.maxRemoteBidirectionalStreamId;
+  maxRemoteUnidirectionalStreamId_ = state.maxRemoteUnidirectionalStreamId;
+  for (auto streamId : state.openStreams) {
+    bool isUni = isUnidirectionalStream(streamId);
+    if (isLocalStream(nodeType_, streamId)) {
+      (isUni ? openUnidirectionalLocalStreams_ : openBidirectionalLocalStreams_)
+          .insert(streamId);
+    } else {
+      (isUni ? openUnidirectionalPeerStreams_ : openBidirectionalPeerStreams_)
+          .insert(streamId);
+    }
+  }
+}
+
 bool QuicStreamManager::isAppIdle() const {
   return isAppIdle_;
 }
@@ -689,6 +689,17 @@ class QuicStreamManager {
     return streams_.size();
   }
 
+  /*
+   * Returns whether any stream is open, whether or not its state has been
+   * created yet.
+   */
+  bool hasOpenStreams() const {
+    return !streams_.empty() || !openBidirectionalPeerStreams_.empty() ||
+        !openUnidirectionalPeerStreams_.empty() ||
+        !openBidirectionalLocalStreams_.empty() ||
+        !openUnidirectionalLocalStreams_.empty();
+  }
+
   /*
    * Returns a const reference to the container of streams with pending
    * StopSending events.
@@ -754,6 +765,33 @@ class QuicStreamManager {
 
   bool isAppIdle() const;
 
+  /*
+   * The stream id bookkeeping of the connection, used to hand it off to
+   * another process. It doesn't include the state of the streams themselves.
+   */
+  struct StreamIdState {
+    StreamId nextAcceptablePeerBidirectionalStreamId{0};
+    StreamId nextAcceptablePeerUnidirectionalStreamId{0};
+    StreamId nextAcceptableLocalBidirectionalStreamId{0};
+    StreamId nextAcceptableLocalUnidirectionalStreamId{0};
+    StreamId nextBidirectionalStreamId{0};
+    StreamId nextUnidirectionalStreamId{0};
+    StreamId maxLocalBidirectionalStreamId{0};
+    StreamId maxLocalUnidirectionalStreamId{0};
+    StreamId maxRemoteBidirectionalStreamId{0};
+    StreamId maxRemoteUnidirectionalStreamId{0};
+    // Open streams, whether or not their state has been created yet.
+    std::vector<StreamId> openStreams;
+  };
+
+  StreamIdState getStreamIdState() const;
+
+  /*
+   * Replace the stream id bookkeeping. Must be called before any stream is
+   * opened, the state of the open streams is then created lazily.
+   */
+  void setStreamIdState(const StreamIdState& state);
+
  private:
   // Updates the congestion controller app-idle state, after a change in the
   // number of streams.
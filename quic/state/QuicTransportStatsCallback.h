@@ -11,9 +11,11 @@
 #include <folly/Optional.h>
 #include <folly/functional/Invoke.h>
 #include <folly/io/async/EventBase.h>
+#include <chrono>
 #include <string>
 
 #include <quic/QuicConstants.h>
+#include <quic/common/HotPathTrace.h>
 
 namespace quic {
 
@@ -74,6 +76,15 @@ class QuicTransportStatsCallback {
     MAX
   };
 
+  // Outcome of new connection admission control on the server.
+  enum class AdmissionDecision : uint8_t {
+    ACCEPT,
+    RETRY,
+    DROP,
+    // NOTE: MAX should always be at the end
+    MAX
+  };
+
   virtual ~QuicTransportStatsCallback() = default;
 
   // packet level metrics
@@ -103,10 +114,23 @@ class QuicTransportStatsCallback {
 
   virtual void onForwardedPacketProcessed() = 0;
 
+  // number of packets written to the server being taken over by one syscall
+  virtual void onForwardedPacketBatchSent(uint32_t /* numPackets */) {}
+
+  // number of forwarded packets read by one syscall
+  virtual void onForwardedPacketBatchReceived(uint32_t /* numPackets */) {}
+
   virtual void onClientInitialReceived(QuicVersion version) = 0;
 
   virtual void onConnectionRateLimited() = 0;
 
+  virtual void onConnectionAdmission(AdmissionDecision /* decision */) {}
+
+  // lookup of a packet's worker in the shared connection id routing table
+  virtual void onRoutingTableLookup(
+      bool /* found */,
+      std::chrono::nanoseconds /* duration */) {}
+
   // connection level metrics:
   virtual void onNewConnection() = 0;
 
@@ -163,6 +187,45 @@ class QuicTransportStatsCallback {
 
   virtual void onZeroRttBufferedPruned() = 0;
 
+  // distribution metrics, each call is a single sample
+  virtual void onRttSample(std::chrono::microseconds /* rtt */) {}
+
+  virtual void onCwndSample(uint64_t /* cwndBytes */) {}
+
+  virtual void onWriteBurst(uint64_t /* numPackets */) {}
+
+  // only reported when wantsLatencySamples() returns true
+  virtual void onAckProcessed(std::chrono::microseconds /* duration */) {}
+
+  virtual void onHandshakeDone(std::chrono::microseconds /* duration */) {}
+
+  // whether the transport should take the extra timestamps needed to report
+  // the latency of its own processing, e.g. onAckProcessed.
+  virtual bool wantsLatencySamples() const {
+    return false;
+  }
+
+  // time a handshake waited for a HandshakeOffloadExecutor thread.
+  virtual void onHandshakeQueueDelay(std::chrono::microseconds /* delay */) {}
+
+  // a handshake was refused because the offload queue was full.
+  virtual void onHandshakeOffloadRejected() {}
+
+  // lookup of a new connection's client prefix in the PathStateCache.
+  virtual void onPathStateCacheLookup(bool /* hit */) {}
+
+  // time from the start of a connection to its last acked packet, reported
+  // when it closes and a PathStateCache is in use.
+  virtual void onConnectionCompletion(
+      bool /* warmStarted */,
+      std::chrono::microseconds /* duration */) {}
+
+  // time spent in a phase of the read or write loop during one iteration,
+  // only reported when built with QUIC_ENABLE_HOT_PATH_TRACING
+  virtual void onHotPathLatency(
+      HotPathPhase /* phase */,
+      std::chrono::nanoseconds /* duration */) {}
+
   static const char* toString(ConnectionCloseReason reason) {
     switch (reason) {
       case ConnectionCloseReason::NONE:
@@ -272,6 +335,21 @@ class QuicTransportStatsCallback {
     }
   }
 
+  static const char* toString(AdmissionDecision decision) {
+    switch (decision) {
+      case AdmissionDecision::ACCEPT:
+        return "ACCEPT";
+      case AdmissionDecision::RETRY:
+        return "RETRY";
+      case AdmissionDecision::DROP:
+        return "DROP";
+      case AdmissionDecision::MAX:
+        return "MAX";
+      default:
+        throw std::runtime_error("Undefined AdmissionDecision passed");
+    }
+  }
+
   static TransportKnobType paramIdToTransportKnobType(uint64_t paramId) {
     switch (paramId) {
       case static_cast<uint64_t>(
@@ -21,6 +21,7 @@
 #include <quic/logging/QLogger.h>
 #include <quic/state/AckStates.h>
 #include <quic/state/LossState.h>
+#include <quic/state/MemoryBudget.h>
 #include <quic/state/OutstandingPacket.h>
 #include <quic/state/PacketEvent.h>
 #include <quic/state/PendingPathRateLimiter.h>
@@ -177,7 +178,8 @@ struct Pacer {
   /**
    * API for Trnasport to query the interval before next write
    */
-  virtual std::chrono::microseconds getTimeUntilNextWrite() const = 0;
+  virtual std::chrono::microseconds getTimeUntilNextWrite(
+      TimePoint currentTime) const = 0;
 
   /**
    * API for Transport to query a recalculated batch size based on currentTime
@@ -342,6 +344,24 @@ struct CongestionController {
       folly::Optional<AckEvent>,
       folly::Optional<LossEvent>) = 0;
 
+  /**
+   * Same as onPacketAckOrLoss, but leaves the events with the caller, which
+   * can then reuse the storage of their ackedPackets. The default copies them.
+   */
+  virtual void onPacketAckOrLossInPlace(
+      const AckEvent* FOLLY_NULLABLE ack,
+      const LossEvent* FOLLY_NULLABLE loss) {
+    folly::Optional<AckEvent> ackCopy;
+    if (ack) {
+      ackCopy = *ack;
+    }
+    folly::Optional<LossEvent> lossCopy;
+    if (loss) {
+      lossCopy.emplace(*loss);
+    }
+    onPacketAckOrLoss(std::move(ackCopy), std::move(lossCopy));
+  }
+
   /**
    * Return the number of bytes that the congestion controller
    * will allow you to write.
@@ -439,6 +459,21 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   // Pacer
   std::unique_ptr<Pacer> pacer;
 
+  // When set, the most packets a write may send, e.g. during the turn the
+  // worker's fair pacing gives the connection.
+  folly::Optional<uint64_t> writePacketsBudget;
+
+  // Filled in by processAckFrame for each ACK frame. Kept so that its
+  // ackedPackets don't need to be allocated again for each one.
+  CongestionController::AckEvent ackEventBuffer;
+
+  // The acks and losses of the ACK frames read in the same batch, when
+  // transportSettings.batchAckEvents is set. processPendingAckEvents gives
+  // them to the congestion controller at once. The ack event is pending when
+  // it has a largestAckedPacket.
+  CongestionController::AckEvent pendingAckEvent;
+  folly::Optional<CongestionController::LossEvent> pendingLossEvent;
+
   // Congestion Controller factory to create specific impl of cc algorithm
   std::shared_ptr<CongestionControllerFactory> congestionControllerFactory;
 
@@ -687,6 +722,11 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
   // Track stats for various server events
   QuicTransportStatsCallback* statsCallback{nullptr};
 
+  // Budget shared with other connections for the bytes they buffer, and
+  // this connection's share of it as of the last updateMemoryUsage().
+  MemoryBudget* memoryBudget{nullptr};
+  uint64_t memoryBudgetUsage{0};
+
   struct HappyEyeballsState {
     // Delay timer
     folly::HHWheelTimer::Callback* connAttemptDelayTimeout{nullptr};
@@ -43,6 +43,34 @@ struct BbrConfig {
 struct CcpConfig {
   std::string alg_name = "";
   std::string alg_args = "";
+  // How often connections report to an in-process CCP agent, 0 means once per
+  // smoothed rtt.
+  std::chrono::microseconds reportInterval{0};
+  // How long a report can go unanswered by an in-process CCP agent before the
+  // connection falls back to its own congestion control.
+  std::chrono::microseconds fallbackTimeout{
+      kDefaultInProcessCcpFallbackTimeout};
+};
+
+struct CarefulResumeConfig {
+  /**
+   * Whether the server stores the bandwidth and min rtt it measured in its
+   * session tickets, and uses them to jump the congestion window of 0-RTT
+   * resumptions from the same client address, as in the Careful Resume
+   * draft: the jump only happens once an RTT sample of the new connection
+   * is consistent with the saved min rtt, and the window falls back to
+   * half of what got delivered if anything sent after the jump is lost.
+   */
+  bool enabled{false};
+  // The jump window is this fraction of the saved bandwidth-delay product,
+  // capped at maxJumpCwndInMss.
+  double cwndGain{0.5};
+  uint64_t maxJumpCwndInMss{1000};
+  // Path characteristics from older tickets are not used.
+  std::chrono::seconds maxTicketAge{std::chrono::hours(1)};
+  // The ticket sent at the end of the handshake knows little about the path,
+  // a second one is sent once that many bytes have been acked.
+  uint64_t ticketRefreshBytes{128 * 1024};
 };
 
 struct D6DConfig {
@@ -148,6 +176,12 @@ struct TransportSettings {
   folly::Optional<double> copaDeltaParam;
   // Whether to use Copa's RTT standing feature. Only used by Copa.
   bool copaUseRttStanding{false};
+  // Whether Cubic and NewReno leave slow start with HyStart++ (RFC 9406),
+  // instead of Cubic's Hystart and NewReno's plain slow start.
+  bool hystartPlusPlus{false};
+  // Whether the ACK frames read together, e.g. in one GRO or recvmmsg batch,
+  // update the congestion controller once, instead of once per ACK frame.
+  bool batchAckEvents{false};
   // The max UDP packet size we are willing to receive.
   uint64_t maxRecvPacketSize{kDefaultUDPReadBufferSize};
   // Number of buffers to allocate for GRO
@@ -170,6 +204,15 @@ struct TransportSettings {
   // Pacing timer tick interval
   std::chrono::microseconds pacingTimerTickInterval{
       kDefaultPacingTimerTickInterval};
+  // Whether the server paces the connections of a worker through a wheel
+  // they share, run in one pass per pacing tick, instead of a timeout each.
+  bool usePacingWheel{false};
+  // Whether the server writes the paced bursts of the connections of a
+  // worker in deficit round robin, a quantum of packets per turn, instead of
+  // each connection writing its whole burst on its own.
+  bool useFairPacing{false};
+  uint64_t fairPacingQuantumInPackets{kDefaultFairPacingQuantumInPackets};
+  uint64_t fairPacingPacketsPerPass{kDefaultFairPacingPacketsPerPass};
   ZeroRttSourceTokenMatchingPolicy zeroRttSourceTokenMatchingPolicy{
       ZeroRttSourceTokenMatchingPolicy::REJECT_IF_NO_EXACT_MATCH};
   // Scale pacing rate for CC, non-empty indicates override via transport knobs
@@ -231,6 +274,23 @@ struct TransportSettings {
   // retry token secret used for encryption/decryption
   folly::Optional<std::array<uint8_t, kRetryTokenSecretLength>>
       retryTokenSecret;
+  // Max number of stateless responses (Version Negotiation, Retry and
+  // Stateless Reset) a server worker queues before writing them out with one
+  // sendmmsg. Pending responses are also written at the end of every loop.
+  // 1 writes each response as soon as it is built.
+  uint32_t maxStatelessResponseBatchSize{1};
+  // Max number of packets forwarded to the server being taken over that are
+  // queued before being written out with one sendmmsg, pending ones are also
+  // written at the end of every loop. Above 1, the server being taken over
+  // also reads forwarded packets with recvmmsg, up to this many at a time.
+  // 1 forwards and reads each packet on its own.
+  uint32_t maxForwardedPacketBatchSize{1};
+  // Bytes all the connections of a server worker can buffer together, see
+  // MemoryBudget. 0 means no budget.
+  uint64_t workerMemoryBudget{0};
+  // Fraction of workerMemoryBudget above which connections shrink the flow
+  // control windows they advertise and stop raising the peer's stream limits.
+  double workerMemoryPressureThreshold{0.8};
   // Default initial RTT
   std::chrono::microseconds initialRtt{kDefaultInitialRtt};
   // The active_connection_id_limit that is sent to the peer.
@@ -246,6 +306,7 @@ struct TransportSettings {
   BbrConfig bbrConfig;
   // Config struct for CCP
   CcpConfig ccpConfig;
+  CarefulResumeConfig carefulResume;
   // A packet is considered loss when a packet that's sent later by at least
   // timeReorderingThreshold * RTT is acked by peer.
   DurationRep timeReorderingThreshDividend{
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <folly/Benchmark.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/congestion_control/QuicCubic.h>
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/server/state/ServerStateMachine.h>
+#include <quic/state/AckHandlers.h>
+
+/**
+ * Measures processing the ACK frames read in one batch, a few packets acked
+ * by each, with Cubic updated once per ACK frame or once for the batch.
+ */
+
+using namespace quic;
+
+namespace {
+
+constexpr size_t kPacketsPerAck = 2;
+constexpr size_t kPacketSize = 1200;
+
+void processAckBatches(size_t iters, size_t acksPerBatch, bool batchAcks) {
+  folly::BenchmarkSuspender suspender;
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.transportSettings.batchAckEvents = batchAcks;
+  conn.congestionController = std::make_unique<Cubic>(conn);
+  PacketNum nextPacketNum = 0;
+  uint64_t totalBytesSent = 0;
+  suspender.dismiss();
+
+  while (iters--) {
+    std::vector<ReadAckFrame> ackFrames;
+    {
+      folly::BenchmarkSuspender sendSuspender;
+      auto sentTime = Clock::now();
+      for (size_t i = 0; i < acksPerBatch; i++) {
+        ReadAckFrame ackFrame;
+        auto firstPacketNum = nextPacketNum;
+        for (size_t j = 0; j < kPacketsPerAck; j++) {
+          totalBytesSent += kPacketSize;
+          auto packet = test::makeTestingWritePacket(
+              nextPacketNum++, kPacketSize, totalBytesSent, sentTime);
+          conn.congestionController->onPacketSent(packet);
+          conn.outstandings.packetCount[PacketNumberSpace::AppData]++;
+          conn.outstandings.packets.push_back(std::move(packet));
+        }
+        ackFrame.largestAcked = nextPacketNum - 1;
+        ackFrame.ackBlocks.emplace_back(firstPacketNum, ackFrame.largestAcked);
+        ackFrames.push_back(std::move(ackFrame));
+      }
+    }
+    auto ackTime = Clock::now();
+    for (const auto& ackFrame : ackFrames) {
+      processAckFrame(
+          conn,
+          PacketNumberSpace::AppData,
+          ackFrame,
+          [](const auto&, const auto&, const auto&) {},
+          [](auto&, auto&, bool) {},
+          ackTime);
+    }
+    processPendingAckEvents(conn);
+  }
+}
+
+} // namespace
+
+BENCHMARK(ack_batch_1, iters) {
+  processAckBatches(iters, 1, false);
+}
+
+BENCHMARK_RELATIVE(ack_batch_1_batched, iters) {
+  processAckBatches(iters, 1, true);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ack_batch_16, iters) {
+  processAckBatches(iters, 16, false);
+}
+
+BENCHMARK_RELATIVE(ack_batch_16_batched, iters) {
+  processAckBatches(iters, 16, true);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ack_batch_64, iters) {
+  processAckBatches(iters, 64, false);
+}
+
+BENCHMARK_RELATIVE(ack_batch_64_batched, iters) {
+  processAckBatches(iters, 64, true);
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -18,6 +18,7 @@
 #include <quic/server/state/ServerStateMachine.h>
 #include <quic/state/AckHandlers.h>
 #include <quic/state/StateData.h>
+#include <quic/state/test/MockQuicStats.h>
 #include <quic/state/test/Mocks.h>
 
 #include <numeric>
@@ -1372,6 +1373,258 @@ TEST_P(AckHandlersTest, ImplictAckEventCreation) {
       ackTime);
 }
 
+std::vector<TimePoint> emplaceAckEventPackets(
+    QuicServerConnectionState& conn,
+    PacketNum numPackets,
+    PacketNumberSpace pnSpace,
+    TimePoint startTime = Clock::now() - 100ms) {
+  std::vector<TimePoint> sentTimes;
+  for (PacketNum packetNum = 0; packetNum < numPackets; packetNum++) {
+    auto regularPacket = createNewPacket(packetNum, pnSpace);
+    WriteStreamFrame frame(packetNum, 0, 0, true);
+    regularPacket.frames.emplace_back(std::move(frame));
+    sentTimes.push_back(startTime + std::chrono::milliseconds(packetNum));
+    conn.outstandings
+        .packetCount[regularPacket.header.getPacketNumberSpace()]++;
+    OutstandingPacket sentPacket(
+        std::move(regularPacket),
+        sentTimes.back(),
+        1,
+        0,
+        false /* handshake */,
+        packetNum,
+        0,
+        packetNum + 1,
+        0,
+        LossState(),
+        0);
+    conn.outstandings.packets.emplace_back(sentPacket);
+  }
+  return sentTimes;
+}
+
+TEST_P(AckHandlersTest, BatchAckEvents) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.transportSettings.batchAckEvents = true;
+  auto mockCongestionController = std::make_unique<MockCongestionController>();
+  auto rawCongestionController = mockCongestionController.get();
+  conn.congestionController = std::move(mockCongestionController);
+  auto sentTimes = emplaceAckEventPackets(conn, 10, GetParam());
+
+  ReadAckFrame firstFrame;
+  firstFrame.largestAcked = 4;
+  firstFrame.ackBlocks.emplace_back(0, 4);
+  ReadAckFrame secondFrame;
+  secondFrame.largestAcked = 9;
+  secondFrame.ackBlocks.emplace_back(5, 9);
+  auto firstAckTime = Clock::now() + 10ms;
+  auto secondAckTime = firstAckTime + 1ms;
+  EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _)).Times(0);
+  processAckFrame(
+      conn,
+      GetParam(),
+      firstFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      firstAckTime);
+  processAckFrame(
+      conn,
+      GetParam(),
+      secondFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      secondAckTime);
+  Mock::VerifyAndClearExpectations(rawCongestionController);
+
+  EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _))
+      .Times(1)
+      .WillOnce(Invoke([&](auto ack, auto loss) {
+        EXPECT_EQ(secondAckTime, ack->ackTime);
+        EXPECT_EQ(9, ack->largestAckedPacket.value());
+        EXPECT_EQ(sentTimes[9], ack->largestAckedPacketSentTime);
+        EXPECT_EQ(10, ack->ackedBytes);
+        EXPECT_EQ(10, ack->ackedPackets.size());
+        EXPECT_EQ(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                secondAckTime - sentTimes[9]),
+            ack->mrttSample.value());
+        EXPECT_FALSE(loss.has_value());
+      }));
+  processPendingAckEvents(conn);
+  // Nothing left to give to the congestion controller.
+  processPendingAckEvents(conn);
+  EXPECT_TRUE(conn.pendingAckEvent.ackedPackets.empty());
+}
+
+TEST_P(AckHandlersTest, BatchAckEventsAcrossPacketNumberSpaces) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.transportSettings.batchAckEvents = true;
+  auto mockCongestionController = std::make_unique<MockCongestionController>();
+  auto rawCongestionController = mockCongestionController.get();
+  conn.congestionController = std::move(mockCongestionController);
+  auto otherPnSpace = GetParam() == PacketNumberSpace::AppData
+      ? PacketNumberSpace::Handshake
+      : PacketNumberSpace::AppData;
+  auto sentTimes = emplaceAckEventPackets(conn, 10, GetParam());
+  // Sent after the others, with smaller packet numbers.
+  auto otherSentTimes = emplaceAckEventPackets(
+      conn, 2, otherPnSpace, sentTimes.back() + 1ms);
+
+  ReadAckFrame firstFrame;
+  firstFrame.largestAcked = 9;
+  firstFrame.ackBlocks.emplace_back(0, 9);
+  ReadAckFrame secondFrame;
+  secondFrame.largestAcked = 1;
+  secondFrame.ackBlocks.emplace_back(0, 1);
+  auto ackTime = Clock::now() + 10ms;
+  processAckFrame(
+      conn,
+      GetParam(),
+      firstFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      ackTime);
+  processAckFrame(
+      conn,
+      otherPnSpace,
+      secondFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      ackTime);
+
+  EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _))
+      .WillOnce(Invoke([&](auto ack, auto /* loss */) {
+        EXPECT_EQ(1, ack->largestAckedPacket.value());
+        EXPECT_EQ(otherSentTimes[1], ack->largestAckedPacketSentTime);
+        EXPECT_EQ(12, ack->ackedBytes);
+        EXPECT_EQ(12, ack->ackedPackets.size());
+      }));
+  processPendingAckEvents(conn);
+}
+
+TEST_P(AckHandlersTest, BatchAckEventsImplicitAck) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.transportSettings.batchAckEvents = true;
+  auto mockCongestionController = std::make_unique<MockCongestionController>();
+  auto rawCongestionController = mockCongestionController.get();
+  conn.congestionController = std::move(mockCongestionController);
+  emplaceAckEventPackets(conn, 10, GetParam());
+
+  ReadAckFrame ackFrame;
+  ackFrame.largestAcked = 4;
+  ackFrame.ackBlocks.emplace_back(0, 4);
+  ReadAckFrame implicitFrame;
+  implicitFrame.largestAcked = 9;
+  implicitFrame.ackBlocks.emplace_back(5, 9);
+  implicitFrame.implicit = true;
+  auto ackTime = Clock::now() + 10ms;
+  {
+    // The implicit ack isn't batched, and goes after the pending one.
+    InSequence s;
+    EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _))
+        .WillOnce(Invoke([&](auto ack, auto /* loss */) {
+          EXPECT_EQ(4, ack->largestAckedPacket.value());
+          EXPECT_EQ(5, ack->ackedPackets.size());
+          EXPECT_FALSE(ack->implicit);
+        }));
+    EXPECT_CALL(*rawCongestionController, onPacketAckOrLoss(_, _))
+        .WillOnce(Invoke([&](auto ack, auto /* loss */) {
+          EXPECT_EQ(9, ack->largestAckedPacket.value());
+          EXPECT_EQ(5, ack->ackedPackets.size());
+          EXPECT_TRUE(ack->implicit);
+        }));
+  }
+  processAckFrame(
+      conn,
+      GetParam(),
+      ackFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      ackTime);
+  processAckFrame(
+      conn,
+      GetParam(),
+      implicitFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      ackTime);
+  processPendingAckEvents(conn);
+}
+
+TEST_P(AckHandlersTest, AckEventBufferReused) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.congestionController =
+      std::make_unique<NiceMock<MockCongestionController>>();
+  emplaceAckEventPackets(conn, 10, GetParam());
+
+  ReadAckFrame firstFrame;
+  firstFrame.largestAcked = 4;
+  firstFrame.ackBlocks.emplace_back(0, 4);
+  processAckFrame(
+      conn,
+      GetParam(),
+      firstFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      Clock::now());
+  auto& ackedPackets = conn.ackEventBuffer.ackedPackets;
+  EXPECT_EQ(5, ackedPackets.size());
+  auto storage = ackedPackets.data();
+
+  ReadAckFrame secondFrame;
+  secondFrame.largestAcked = 9;
+  secondFrame.ackBlocks.emplace_back(5, 9);
+  processAckFrame(
+      conn,
+      GetParam(),
+      secondFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      Clock::now());
+  EXPECT_EQ(5, ackedPackets.size());
+  EXPECT_EQ(storage, ackedPackets.data());
+  EXPECT_EQ(9, conn.ackEventBuffer.largestAckedPacket.value());
+}
+
+TEST_P(AckHandlersTest, AckProcessingLatencyOnlyWhenWanted) {
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  auto mockStats = std::make_unique<NiceMock<MockQuicStats>>();
+  conn.statsCallback = mockStats.get();
+  emplaceAckEventPackets(conn, 10, GetParam());
+
+  ReadAckFrame firstFrame;
+  firstFrame.largestAcked = 4;
+  firstFrame.ackBlocks.emplace_back(0, 4);
+  EXPECT_CALL(*mockStats, wantsLatencySamples()).WillOnce(Return(false));
+  EXPECT_CALL(*mockStats, onAckProcessed(_)).Times(0);
+  processAckFrame(
+      conn,
+      GetParam(),
+      firstFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      Clock::now());
+  Mock::VerifyAndClearExpectations(mockStats.get());
+
+  ReadAckFrame secondFrame;
+  secondFrame.largestAcked = 9;
+  secondFrame.ackBlocks.emplace_back(5, 9);
+  EXPECT_CALL(*mockStats, wantsLatencySamples()).WillOnce(Return(true));
+  EXPECT_CALL(*mockStats, onAckProcessed(_)).Times(1);
+  processAckFrame(
+      conn,
+      GetParam(),
+      secondFrame,
+      [](const auto&, const auto&, const auto&) {},
+      [](auto&, auto&, bool) {},
+      Clock::now());
+}
+
 TEST_P(AckHandlersTest, TestRTTPacketObserverCallback) {
   QuicServerConnectionState conn(
       FizzServerQuicHandshakeContext::Builder().build());
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <quic/fizz/server/handshake/FizzServerQuicHandshakeContext.h>
+#include <quic/flowcontrol/QuicFlowController.h>
+#include <quic/server/state/ServerStateMachine.h>
+#include <quic/state/MemoryBudget.h>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+TEST(MemoryBudgetTest, ScaleWindow) {
+  MemoryBudget budget(1000, 0.8);
+  EXPECT_FALSE(budget.underPressure());
+  EXPECT_EQ(budget.scaleWindow(800), 800);
+
+  budget.add(800);
+  EXPECT_TRUE(budget.underPressure());
+  EXPECT_EQ(budget.scaleWindow(800), 800);
+  budget.add(100);
+  EXPECT_EQ(budget.scaleWindow(800), 400);
+  budget.add(100);
+  EXPECT_EQ(budget.scaleWindow(800), 100);
+  budget.add(500);
+  EXPECT_EQ(budget.scaleWindow(800), 100);
+
+  budget.remove(1000);
+  EXPECT_FALSE(budget.underPressure());
+  EXPECT_EQ(budget.usage(), 500);
+  EXPECT_EQ(budget.scaleWindow(800), 800);
+}
+
+TEST(MemoryBudgetTest, ConnectionUsage) {
+  MemoryBudget budget(1000, 0.5);
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  updateMemoryUsage(conn);
+  EXPECT_EQ(budget.usage(), 0);
+
+  conn.memoryBudget = &budget;
+  conn.flowControlState.sumMaxObservedOffset = 300;
+  conn.flowControlState.sumCurReadOffset = 100;
+  conn.flowControlState.sumCurStreamBufferLen = 50;
+  conn.lossState.inflightBytes = 150;
+  updateMemoryUsage(conn, 10);
+  EXPECT_EQ(conn.memoryBudgetUsage, 410);
+  EXPECT_EQ(budget.usage(), 410);
+
+  conn.flowControlState.sumCurReadOffset = 300;
+  updateMemoryUsage(conn);
+  EXPECT_EQ(budget.usage(), 200);
+
+  releaseMemoryUsage(conn);
+  EXPECT_EQ(budget.usage(), 0);
+  EXPECT_EQ(conn.memoryBudget, nullptr);
+}
+
+TEST(MemoryBudgetTest, ShrinkAdvertisedWindow) {
+  MemoryBudget budget(1000, 0.5);
+  QuicServerConnectionState conn(
+      FizzServerQuicHandshakeContext::Builder().build());
+  conn.memoryBudget = &budget;
+  conn.flowControlState.windowSize = 800;
+  conn.flowControlState.advertisedMaxOffset = 800;
+  conn.flowControlState.sumCurReadOffset = 500;
+  EXPECT_EQ(generateMaxDataFrame(conn).maximumData, 1300);
+
+  budget.add(750);
+  EXPECT_EQ(generateMaxDataFrame(conn).maximumData, 900);
+
+  // The advertised offset never goes back.
+  budget.add(250);
+  EXPECT_EQ(generateMaxDataFrame(conn).maximumData, 800);
+  EXPECT_FALSE(maybeSendConnWindowUpdate(conn, Clock::now()));
+  budget.remove(1000);
+}
+
+} // namespace test
+} // namespace quic
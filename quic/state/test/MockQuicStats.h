@@ -30,8 +30,12 @@ class MockQuicStats : public QuicTransportStatsCallback {
   MOCK_METHOD0(onPacketForwarded, void());
   MOCK_METHOD0(onForwardedPacketReceived, void());
   MOCK_METHOD0(onForwardedPacketProcessed, void());
+  MOCK_METHOD1(onForwardedPacketBatchSent, void(uint32_t));
+  MOCK_METHOD1(onForwardedPacketBatchReceived, void(uint32_t));
   MOCK_METHOD1(onClientInitialReceived, void(QuicVersion));
   MOCK_METHOD0(onConnectionRateLimited, void());
+  MOCK_METHOD1(onConnectionAdmission, void(AdmissionDecision));
+  MOCK_METHOD2(onRoutingTableLookup, void(bool, std::chrono::nanoseconds));
   MOCK_METHOD0(onNewConnection, void());
   MOCK_METHOD1(onConnectionClose, void(folly::Optional<ConnectionCloseReason>));
   MOCK_METHOD0(onNewQuicStream, void());
@@ -57,6 +61,17 @@ class MockQuicStats : public QuicTransportStatsCallback {
   MOCK_METHOD0(onServerUnfinishedHandshake, void());
   MOCK_METHOD0(onZeroRttBuffered, void());
   MOCK_METHOD0(onZeroRttBufferedPruned, void());
+  MOCK_METHOD1(onRttSample, void(std::chrono::microseconds));
+  MOCK_METHOD1(onCwndSample, void(uint64_t));
+  MOCK_METHOD1(onWriteBurst, void(uint64_t));
+  MOCK_METHOD1(onAckProcessed, void(std::chrono::microseconds));
+  MOCK_METHOD1(onHandshakeDone, void(std::chrono::microseconds));
+  MOCK_CONST_METHOD0(wantsLatencySamples, bool());
+  MOCK_METHOD1(onHandshakeQueueDelay, void(std::chrono::microseconds));
+  MOCK_METHOD0(onHandshakeOffloadRejected, void());
+  MOCK_METHOD1(onPathStateCacheLookup, void(bool));
+  MOCK_METHOD2(onConnectionCompletion, void(bool, std::chrono::microseconds));
+  MOCK_METHOD2(onHotPathLatency, void(HotPathPhase, std::chrono::nanoseconds));
 };
 
 class MockQuicStatsFactory : public QuicTransportStatsCallbackFactory {
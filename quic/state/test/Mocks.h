@@ -40,7 +40,9 @@ class MockPacer : public Pacer {
   MOCK_METHOD2(setPacingRate, void(QuicConnectionStateBase&, uint64_t));
   MOCK_METHOD0(reset, void());
   MOCK_METHOD2(setRttFactor, void(uint8_t, uint8_t));
-  MOCK_CONST_METHOD0(getTimeUntilNextWrite, std::chrono::microseconds());
+  MOCK_CONST_METHOD1(
+      getTimeUntilNextWrite,
+      std::chrono::microseconds(TimePoint));
   MOCK_METHOD1(updateAndGetWriteBatchSize, uint64_t(TimePoint));
   MOCK_CONST_METHOD0(getCachedWriteBatchSize, uint64_t());
   MOCK_METHOD1(setAppLimited, void(bool));
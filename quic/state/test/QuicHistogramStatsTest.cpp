@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/state/QuicHistogramStats.h>
+
+#include <folly/portability/GTest.h>
+#include <thread>
+
+using namespace testing;
+
+namespace quic {
+namespace test {
+
+using Counter = QuicHistogramStatsRegistry::Counter;
+using Histogram = QuicHistogramStatsRegistry::Histogram;
+
+TEST(QuicHistogramStatsTest, PerWorkerShardsAreMerged) {
+  auto registry = std::make_shared<QuicHistogramStatsRegistry>(2);
+  QuicHistogramStatsFactory factory(registry);
+  auto stats1 = factory.make();
+  auto stats2 = factory.make();
+  EXPECT_EQ(2, registry->numShards());
+
+  stats1->onPacketReceived();
+  stats1->onWrite(1200);
+  stats1->onRttSample(std::chrono::microseconds(100));
+  stats1->onPacketDropped(
+      QuicTransportStatsCallback::PacketDropReason::PARSE_ERROR);
+  stats2->onPacketReceived();
+  stats2->onWrite(800);
+  stats2->onRttSample(std::chrono::microseconds(300));
+  stats2->onWriteBurst(4);
+
+  auto perWorker = registry->snapshot(0);
+  EXPECT_EQ(1, perWorker.counters[Counter::PACKET_RECEIVED]);
+  EXPECT_EQ(1200, perWorker.counters[Counter::BYTES_WRITTEN]);
+
+  auto merged = registry->snapshot();
+  EXPECT_EQ(2, merged.counters[Counter::PACKET_RECEIVED]);
+  EXPECT_EQ(2000, merged.counters[Counter::BYTES_WRITTEN]);
+  EXPECT_EQ(
+      1,
+      merged.packetDrops
+          [QuicTransportStatsCallback::PacketDropReason::PARSE_ERROR]);
+  EXPECT_EQ(2, merged.histograms[Histogram::PACKET_SIZE].count);
+  EXPECT_EQ(2, merged.histograms[Histogram::RTT_US].count);
+  EXPECT_EQ(300, merged.histograms[Histogram::RTT_US].max);
+  EXPECT_EQ(1, merged.histograms[Histogram::WRITE_BURST_PACKETS].count);
+}
+
+TEST(QuicHistogramStatsTest, OutOfShards) {
+  QuicHistogramStatsRegistry registry(1);
+  EXPECT_NE(nullptr, registry.allocateShard());
+  EXPECT_EQ(nullptr, registry.allocateShard());
+  EXPECT_EQ(1, registry.numShards());
+  // Snapshot of an unallocated shard is empty.
+  EXPECT_EQ(0, registry.snapshot(5).counters[Counter::PACKET_SENT]);
+}
+
+TEST(QuicHistogramStatsTest, ExportHook) {
+  auto registry = std::make_shared<QuicHistogramStatsRegistry>(1);
+  QuicHistogramStatsFactory factory(registry);
+  auto stats = factory.make();
+  stats->onNewConnection();
+  stats->onHandshakeDone(std::chrono::microseconds(5000));
+
+  registry->exportStats();
+  size_t exported = 0;
+  registry->setExportCallback(
+      [&](const QuicHistogramStatsRegistry::Snapshot& snap) {
+        exported++;
+        EXPECT_EQ(1, snap.counters[Counter::NEW_CONNECTION]);
+        EXPECT_EQ(5000, snap.histograms[Histogram::HANDSHAKE_US].max);
+      });
+  registry->exportStats();
+  EXPECT_EQ(1, exported);
+}
+
+TEST(QuicHistogramStatsTest, ConcurrentSnapshot) {
+  auto registry = std::make_shared<QuicHistogramStatsRegistry>(2);
+  QuicHistogramStatsFactory factory(registry);
+  std::vector<std::thread> workers;
+  constexpr uint64_t kIterations = 10000;
+  for (size_t i = 0; i < 2; ++i) {
+    workers.emplace_back([stats = factory.make()] {
+      for (uint64_t j = 0; j < kIterations; ++j) {
+        stats->onPacketSent();
+        stats->onCwndSample(j);
+      }
+    });
+  }
+  // Readers may run while the workers are writing.
+  auto during = registry->snapshot();
+  EXPECT_LE(during.counters[Counter::PACKET_SENT], 2 * kIterations);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  auto after = registry->snapshot();
+  EXPECT_EQ(2 * kIterations, after.counters[Counter::PACKET_SENT]);
+  EXPECT_EQ(2 * kIterations, after.histograms[Histogram::CWND_BYTES].count);
+}
+
+} // namespace test
+} // namespace quic
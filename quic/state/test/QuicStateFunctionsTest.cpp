@@ -671,6 +671,26 @@ TEST_F(QuicStateFunctionsTest, IsConnectionPaced) {
   EXPECT_FALSE(isConnectionPaced(state));
 }
 
+TEST_F(QuicStateFunctionsTest, GetWriteDataPacketsLimit) {
+  QuicConnectionStateBase conn(QuicNodeType::Client);
+  conn.transportSettings.writeConnectionDataPacketsLimit = 10;
+  EXPECT_EQ(10, getWriteDataPacketsLimit(conn));
+
+  conn.writePacketsBudget = 3;
+  EXPECT_EQ(3, getWriteDataPacketsLimit(conn));
+
+  auto mockPacer = std::make_unique<NiceMock<MockPacer>>();
+  auto rawPacer = mockPacer.get();
+  conn.pacer = std::move(mockPacer);
+  conn.canBePaced = true;
+  conn.transportSettings.pacingEnabled = true;
+  EXPECT_CALL(*rawPacer, updateAndGetWriteBatchSize(_))
+      .WillRepeatedly(Return(2));
+  EXPECT_EQ(2, getWriteDataPacketsLimit(conn));
+  conn.writePacketsBudget = folly::none;
+  EXPECT_EQ(2, getWriteDataPacketsLimit(conn));
+}
+
 TEST_F(QuicStateFunctionsTest, GetOutstandingPackets) {
   QuicConnectionStateBase conn(QuicNodeType::Client);
   conn.outstandings.packets.emplace_back(
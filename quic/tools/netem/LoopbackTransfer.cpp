@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/tools/netem/LoopbackTransfer.h>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <glog/logging.h>
+#include <quic/client/QuicClientTransport.h>
+#include <quic/common/BufUtil.h>
+#include <quic/common/test/TestUtils.h>
+#include <quic/fizz/client/handshake/FizzClientQuicHandshakeContext.h>
+#include <quic/server/QuicServer.h>
+#include <quic/server/QuicServerTransport.h>
+
+#include <time.h>
+
+namespace {
+// Large enough to never be what limits the transfer.
+constexpr uint64_t kLoopbackFlowControlWindow = 64 * 1024 * 1024;
+
+uint64_t cpuTimeNs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+} // namespace
+
+namespace quic {
+namespace netem {
+
+namespace {
+
+/**
+ * Server side of a transfer: reads the number of bytes asked for on each
+ * stream the client opens, and sends them back with a FIN.
+ */
+class TransferServerHandler : public QuicSocket::ConnectionCallback,
+                              public QuicSocket::ReadCallback {
+ public:
+  void setQuicSocket(std::shared_ptr<QuicSocket> socket) {
+    sock_ = std::move(socket);
+  }
+
+  void onNewBidirectionalStream(StreamId id) noexcept override {
+    sock_->setReadCallback(id, this);
+  }
+
+  void onNewUnidirectionalStream(StreamId id) noexcept override {
+    VLOG(4) << "TransferServerHandler ignoring uni stream=" << id;
+  }
+
+  void onStopSending(StreamId id, ApplicationErrorCode error) noexcept
+      override {
+    VLOG(4) << "TransferServerHandler got StopSending stream=" << id
+            << " error=" << error;
+  }
+
+  void onConnectionEnd() noexcept override {}
+
+  void onConnectionError(
+      std::pair<QuicErrorCode, std::string> error) noexcept override {
+    LOG(ERROR) << "TransferServerHandler error=" << toString(error.first)
+               << " " << error.second;
+  }
+
+  void readAvailable(StreamId id) noexcept override {
+    auto res = sock_->read(id, 0);
+    if (res.hasError()) {
+      LOG(ERROR) << "TransferServerHandler read error="
+                 << toString(res.error());
+      return;
+    }
+    auto& request = requests_[id];
+    request.append(std::move(res.value().first));
+    if (request.chainLength() < sizeof(uint64_t)) {
+      return;
+    }
+    folly::io::Cursor cursor(request.front());
+    auto transferBytes = cursor.readBE<uint64_t>();
+    requests_.erase(id);
+    sock_->setReadCallback(id, nullptr);
+
+    auto data = folly::IOBuf::create(transferBytes);
+    memset(data->writableData(), 'a', transferBytes);
+    data->append(transferBytes);
+    auto writeRes = sock_->writeChain(id, std::move(data), true);
+    if (writeRes.hasError()) {
+      LOG(ERROR) << "TransferServerHandler write error="
+                 << toString(writeRes.error());
+    }
+  }
+
+  void readError(
+      StreamId id,
+      std::pair<QuicErrorCode, folly::Optional<folly::StringPiece>>
+          error) noexcept override {
+    LOG(ERROR) << "TransferServerHandler read error on stream=" << id
+               << " error=" << toString(error);
+  }
+
+ private:
+  std::shared_ptr<QuicSocket> sock_;
+  std::map<StreamId, BufQueue> requests_;
+};
+
+class TransferServerTransportFactory : public QuicServerTransportFactory {
+ public:
+  ~TransferServerTransportFactory() override {
+    // Each handler holds on to its transport, which has to go away in the
+    // thread of its EventBase.
+    while (!handlers_.empty()) {
+      handlers_.back().first->runImmediatelyOrRunInEventBaseThreadAndWait(
+          [this] { handlers_.pop_back(); });
+    }
+  }
+
+  QuicServerTransport::Ptr make(
+      folly::EventBase* evb,
+      std::unique_ptr<folly::AsyncUDPSocket> sock,
+      const folly::SocketAddress&,
+      std::shared_ptr<const fizz::server::FizzServerContext> ctx) noexcept
+      override {
+    auto handler = std::make_unique<TransferServerHandler>();
+    auto transport =
+        QuicServerTransport::make(evb, std::move(sock), *handler, ctx);
+    handler->setQuicSocket(transport);
+    handlers_.emplace_back(evb, std::move(handler));
+    return transport;
+  }
+
+ private:
+  // Only ever used from the thread of the single server worker.
+  std::vector<
+      std::pair<folly::EventBase*, std::unique_ptr<TransferServerHandler>>>
+      handlers_;
+};
+
+/**
+ * Client side of a transfer, has to be used from the thread of the
+ * EventBase it is started on.
+ */
+class TransferClient : public QuicSocket::ConnectionCallback,
+                       public QuicSocket::ReadCallback {
+ public:
+  explicit TransferClient(uint64_t transferBytes)
+      : transferBytes_(transferBytes) {}
+
+  void start(folly::EventBase* evb, const folly::SocketAddress& address) {
+    auto fizzClientContext =
+        FizzClientQuicHandshakeContext::Builder()
+            .setCertificateVerifier(test::createTestCertificateVerifier())
+            .build();
+    transport_ = std::make_shared<QuicClientTransport>(
+        evb,
+        std::make_unique<folly::AsyncUDPSocket>(evb),
+        std::move(fizzClientContext));
+    transport_->setHostname("netem.test");
+    transport_->addNewPeerAddress(address);
+    TransportSettings settings;
+    settings.advertisedInitialConnectionWindowSize = kLoopbackFlowControlWindow;
+    settings.advertisedInitialBidiLocalStreamWindowSize =
+        kLoopbackFlowControlWindow;
+    transport_->setTransportSettings(settings);
+    transport_->start(this);
+  }
+
+  void stop() {
+    if (transport_) {
+      transport_->setConnectionCallback(nullptr);
+      transport_->close(folly::none);
+      transport_.reset();
+    }
+  }
+
+  void onTransportReady() noexcept override {
+    auto id = transport_->createBidirectionalStream().value();
+    transport_->setReadCallback(id, this);
+    auto request = folly::IOBuf::create(sizeof(uint64_t));
+    folly::io::Appender appender(request.get(), 0);
+    appender.writeBE<uint64_t>(transferBytes_);
+    requestTime_ = Clock::now();
+    transport_->writeChain(id, std::move(request), true);
+  }
+
+  void onNewBidirectionalStream(StreamId) noexcept override {}
+
+  void onNewUnidirectionalStream(StreamId) noexcept override {}
+
+  void onStopSending(StreamId, ApplicationErrorCode) noexcept override {}
+
+  void onConnectionEnd() noexcept override {
+    finish();
+  }
+
+  void onConnectionError(
+      std::pair<QuicErrorCode, std::string> error) noexcept override {
+    LOG(ERROR) << "TransferClient error=" << toString(error.first) << " "
+               << error.second;
+    finish();
+  }
+
+  void readAvailable(StreamId id) noexcept override {
+    auto res = transport_->read(id, 0);
+    if (res.hasError()) {
+      LOG(ERROR) << "TransferClient read error=" << toString(res.error());
+      return;
+    }
+    if (res.value().first) {
+      receivedBytes_ += res.value().first->computeChainDataLength();
+    }
+    if (res.value().second) {
+      completionTime_ = std::chrono::duration_cast<std::chrono::microseconds>(
+          Clock::now() - requestTime_);
+      completed_ = true;
+      finish();
+    }
+  }
+
+  void readError(
+      StreamId id,
+      std::pair<QuicErrorCode, folly::Optional<folly::StringPiece>>
+          error) noexcept override {
+    LOG(ERROR) << "TransferClient read error on stream=" << id
+               << " error=" << toString(error);
+    finish();
+  }
+
+  bool completed() const {
+    return completed_;
+  }
+
+  uint64_t receivedBytes() const {
+    return receivedBytes_;
+  }
+
+  std::chrono::microseconds completionTime() const {
+    return completionTime_;
+  }
+
+  folly::Baton<> done;
+
+ private:
+  void finish() {
+    if (!finished_) {
+      finished_ = true;
+      done.post();
+    }
+  }
+
+  uint64_t transferBytes_;
+  std::shared_ptr<QuicClientTransport> transport_;
+  TimePoint requestTime_;
+  bool completed_{false};
+  bool finished_{false};
+  uint64_t receivedBytes_{0};
+  std::chrono::microseconds completionTime_{0};
+};
+
+} // namespace
+
+std::ostream& operator<<(
+    std::ostream& os,
+    const LoopbackTransferResult& result) {
+  os << "completed=" << result.completed
+     << " received=" << result.receivedBytes
+     << " completionTime=" << result.completionTime.count() << "us"
+     << " goodput=" << result.goodput << "B/s"
+     << " cpu=" << result.cpuNsPerByte << "ns/B"
+     << " toServer delivered=" << result.toServer.deliveredPackets
+     << " lost=" << result.toServer.lostPackets
+     << " queueDropped=" << result.toServer.queueDroppedPackets
+     << " toClient delivered=" << result.toClient.deliveredPackets
+     << " lost=" << result.toClient.lostPackets
+     << " queueDropped=" << result.toClient.queueDroppedPackets;
+  return os;
+}
+
+LoopbackTransferResult runLoopbackTransfer(
+    const LoopbackTransferConfig& config) {
+  TransportSettings serverSettings;
+  serverSettings.defaultCongestionController = config.congestionControlType;
+  serverSettings.batchingMode = config.batchingMode;
+  serverSettings.pacingEnabled = config.pacingEnabled;
+  auto server = QuicServer::createQuicServer();
+  server->setQuicServerTransportFactory(
+      std::make_unique<TransferServerTransportFactory>());
+  server->setFizzContext(test::createServerCtx());
+  server->setTransportSettings(serverSettings);
+  server->start(folly::SocketAddress("::1", 0), 1);
+  server->waitUntilInitialized();
+
+  folly::ScopedEventBaseThread emulatorThread("NetworkEmulator");
+  auto emulatorEvb = emulatorThread.getEventBase();
+  std::unique_ptr<UdpNetworkEmulator> emulator;
+  folly::SocketAddress emulatorAddress;
+  uint64_t emulatorCpuStartNs = 0;
+  emulatorEvb->runInEventBaseThreadAndWait([&] {
+    emulator = std::make_unique<UdpNetworkEmulator>(
+        emulatorEvb,
+        server->getAddress(),
+        config.toServer,
+        config.toClient,
+        config.seed);
+    emulator->start(folly::SocketAddress("::1", 0));
+    emulatorAddress = emulator->getAddress();
+    emulatorCpuStartNs = cpuTimeNs(CLOCK_THREAD_CPUTIME_ID);
+  });
+
+  folly::ScopedEventBaseThread clientThread("LoopbackClient");
+  auto clientEvb = clientThread.getEventBase();
+  TransferClient client(config.transferBytes);
+  auto processCpuStartNs = cpuTimeNs(CLOCK_PROCESS_CPUTIME_ID);
+  clientEvb->runInEventBaseThreadAndWait(
+      [&] { client.start(clientEvb, emulatorAddress); });
+  if (!client.done.try_wait_for(config.timeout)) {
+    LOG(ERROR) << "Loopback transfer timed out";
+  }
+
+  LoopbackTransferResult result;
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    result.completed = client.completed();
+    result.receivedBytes = client.receivedBytes();
+    result.completionTime = client.completionTime();
+    client.stop();
+  });
+  auto processCpuNs = cpuTimeNs(CLOCK_PROCESS_CPUTIME_ID) - processCpuStartNs;
+  uint64_t emulatorCpuNs = 0;
+  emulatorEvb->runInEventBaseThreadAndWait([&] {
+    emulatorCpuNs = cpuTimeNs(CLOCK_THREAD_CPUTIME_ID) - emulatorCpuStartNs;
+    result.toServer = emulator->toServerStats();
+    result.toClient = emulator->toClientStats();
+    emulator.reset();
+  });
+  server->shutdown();
+
+  if (result.completionTime.count() > 0) {
+    result.goodput = result.receivedBytes * 1000 * 1000 /
+        result.completionTime.count();
+  }
+  if (result.receivedBytes > 0) {
+    result.cpuNsPerByte =
+        static_cast<double>(
+            processCpuNs - std::min(processCpuNs, emulatorCpuNs)) /
+        result.receivedBytes;
+  }
+  return result;
+}
+
+} // namespace netem
+} // namespace quic
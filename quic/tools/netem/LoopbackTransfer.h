@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/state/TransportSettings.h>
+#include <quic/tools/netem/UdpNetworkEmulator.h>
+
+#include <ostream>
+
+namespace quic {
+namespace netem {
+
+struct LoopbackTransferConfig {
+  // Used by the server, which does all the sending.
+  CongestionControlType congestionControlType{CongestionControlType::Cubic};
+  QuicBatchingMode batchingMode{QuicBatchingMode::BATCHING_MODE_NONE};
+  bool pacingEnabled{false};
+  uint64_t transferBytes{1000 * 1000};
+  LinkImpairment toServer;
+  LinkImpairment toClient;
+  uint64_t seed{0};
+  // The transfer is given up on past that.
+  std::chrono::milliseconds timeout{30000};
+};
+
+struct LoopbackTransferResult {
+  bool completed{false};
+  uint64_t receivedBytes{0};
+  // From the client asking for the data to it getting the FIN.
+  std::chrono::microseconds completionTime{0};
+  // Bytes received per second over completionTime.
+  uint64_t goodput{0};
+  // CPU time of the whole process over the transfer, handshake included,
+  // less the time spent in the emulator, per byte received.
+  double cpuNsPerByte{0};
+  LinkStats toServer;
+  LinkStats toClient;
+};
+
+std::ostream& operator<<(
+    std::ostream& os,
+    const LoopbackTransferResult& result);
+
+/**
+ * Runs a QuicServer and a QuicClientTransport in this process, talking through
+ * a UdpNetworkEmulator on the loopback interface. The client opens a stream
+ * asking for transferBytes and the server sends them back with a FIN. Each
+ * of the server, the client and the emulator runs on its own thread, and
+ * everything is torn down before returning.
+ */
+LoopbackTransferResult runLoopbackTransfer(
+    const LoopbackTransferConfig& config);
+
+} // namespace netem
+} // namespace quic
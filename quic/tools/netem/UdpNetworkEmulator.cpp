@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/tools/netem/UdpNetworkEmulator.h>
+
+#include <folly/Function.h>
+#include <glog/logging.h>
+
+namespace {
+// Large enough for whatever the kernel hands us, GSO batches included.
+constexpr size_t kMaxDatagramSize = 64 * 1024;
+} // namespace
+
+namespace quic {
+namespace netem {
+
+EmulatedLink::EmulatedLink(
+    folly::EventBase* evb,
+    LinkImpairment impairment,
+    std::mt19937_64& rng)
+    : folly::AsyncTimeout(evb),
+      evb_(evb),
+      impairment_(impairment),
+      rng_(rng) {}
+
+void EmulatedLink::send(
+    folly::AsyncUDPSocket& socket,
+    const folly::SocketAddress& dest,
+    std::unique_ptr<folly::IOBuf> data) {
+  if (draw(impairment_.lossRate)) {
+    stats_.lostPackets++;
+    return;
+  }
+  auto now = Clock::now();
+  auto departureTime = now;
+  if (impairment_.bytesPerSecond) {
+    while (!queue_.empty() && queue_.front().first <= now) {
+      queuedBytes_ -= queue_.front().second;
+      queue_.pop_front();
+    }
+    auto size = data->computeChainDataLength();
+    if (queuedBytes_ + size > impairment_.queueBytes) {
+      stats_.queueDroppedPackets++;
+      return;
+    }
+    std::chrono::nanoseconds serviceTime(
+        size * 1000 * 1000 * 1000 / impairment_.bytesPerSecond);
+    linkFreeTime_ = std::max(linkFreeTime_, now) +
+        std::chrono::duration_cast<std::chrono::microseconds>(serviceTime);
+    queue_.emplace_back(linkFreeTime_, size);
+    queuedBytes_ += size;
+    departureTime = linkFreeTime_;
+  }
+
+  auto deliveryTime = departureTime + impairment_.delay;
+  if (impairment_.jitter.count() > 0) {
+    std::uniform_int_distribution<int64_t> jitter(
+        0, impairment_.jitter.count());
+    deliveryTime += std::chrono::microseconds(jitter(rng_));
+  }
+  if (draw(impairment_.reorderRate)) {
+    stats_.reorderedPackets++;
+    deliveryTime += impairment_.reorderDelay;
+  } else {
+    deliveryTime = std::max(deliveryTime, lastDeliveryTime_);
+    lastDeliveryTime_ = deliveryTime;
+  }
+  inflight_.emplace(
+      std::make_pair(deliveryTime, nextSeq_++),
+      Datagram{&socket, dest, std::move(data)});
+  scheduleDelivery();
+}
+
+void EmulatedLink::clear() {
+  cancelTimeout();
+  inflight_.clear();
+  queue_.clear();
+  queuedBytes_ = 0;
+}
+
+const LinkStats& EmulatedLink::stats() const noexcept {
+  return stats_;
+}
+
+void EmulatedLink::timeoutExpired() noexcept {
+  auto now = Clock::now();
+  while (!inflight_.empty() && inflight_.begin()->first.first <= now) {
+    auto datagram = std::move(inflight_.begin()->second);
+    inflight_.erase(inflight_.begin());
+    auto size = datagram.data->computeChainDataLength();
+    if (datagram.socket->write(datagram.dest, datagram.data) < 0) {
+      VLOG(4) << "EmulatedLink failed to write to "
+              << datagram.dest.describe();
+      continue;
+    }
+    stats_.deliveredPackets++;
+    stats_.deliveredBytes += size;
+  }
+  scheduleDelivery();
+}
+
+void EmulatedLink::scheduleDelivery() {
+  if (inflight_.empty()) {
+    cancelTimeout();
+    return;
+  }
+  auto delay = std::chrono::duration_cast<std::chrono::microseconds>(
+      inflight_.begin()->first.first - Clock::now());
+  evb_->scheduleTimeoutHighRes(
+      this, std::max(delay, std::chrono::microseconds::zero()));
+}
+
+bool EmulatedLink::draw(double probability) {
+  if (probability <= 0) {
+    return false;
+  }
+  return std::uniform_real_distribution<double>(0, 1)(rng_) < probability;
+}
+
+class UdpNetworkEmulator::Reader : public folly::AsyncUDPSocket::ReadCallback {
+ public:
+  using OnData = folly::Function<void(
+      const folly::SocketAddress&,
+      std::unique_ptr<folly::IOBuf>)>;
+
+  explicit Reader(OnData onData) : onData_(std::move(onData)) {}
+
+  void getReadBuffer(void** buf, size_t* len) noexcept override {
+    readBuffer_ = folly::IOBuf::create(kMaxDatagramSize);
+    *buf = readBuffer_->writableData();
+    *len = kMaxDatagramSize;
+  }
+
+  void onDataAvailable(
+      const folly::SocketAddress& peer,
+      size_t len,
+      bool truncated,
+      OnDataAvailableParams /* params */) noexcept override {
+    if (truncated) {
+      VLOG(4) << "UdpNetworkEmulator dropping truncated datagram from "
+              << peer.describe();
+      readBuffer_.reset();
+      return;
+    }
+    readBuffer_->append(len);
+    onData_(peer, std::move(readBuffer_));
+  }
+
+  void onReadError(const folly::AsyncSocketException& ex) noexcept override {
+    LOG(ERROR) << "UdpNetworkEmulator read error=" << ex.what();
+  }
+
+  void onReadClosed() noexcept override {}
+
+ private:
+  OnData onData_;
+  std::unique_ptr<folly::IOBuf> readBuffer_;
+};
+
+UdpNetworkEmulator::UdpNetworkEmulator(
+    folly::EventBase* evb,
+    folly::SocketAddress serverAddress,
+    LinkImpairment toServer,
+    LinkImpairment toClient,
+    uint64_t seed)
+    : evb_(evb),
+      serverAddress_(std::move(serverAddress)),
+      rng_(seed),
+      toServer_(evb, toServer, rng_),
+      toClient_(evb, toClient, rng_) {}
+
+UdpNetworkEmulator::~UdpNetworkEmulator() {
+  stop();
+}
+
+void UdpNetworkEmulator::start(const folly::SocketAddress& bindAddress) {
+  DCHECK(evb_->isInEventBaseThread());
+  CHECK(!clientFacingSocket_);
+  clientFacingSocket_ = std::make_unique<folly::AsyncUDPSocket>(evb_);
+  clientFacingSocket_->bind(bindAddress);
+  clientFacingReader_ = std::make_unique<Reader>(
+      [this](
+          const folly::SocketAddress& client,
+          std::unique_ptr<folly::IOBuf> data) {
+        onClientData(client, std::move(data));
+      });
+  clientFacingSocket_->resumeRead(clientFacingReader_.get());
+}
+
+void UdpNetworkEmulator::stop() {
+  toServer_.clear();
+  toClient_.clear();
+  for (auto& path : clientPaths_) {
+    path.second.serverFacingSocket->close();
+  }
+  clientPaths_.clear();
+  if (clientFacingSocket_) {
+    clientFacingSocket_->close();
+    clientFacingSocket_.reset();
+  }
+}
+
+const folly::SocketAddress& UdpNetworkEmulator::getAddress() const {
+  CHECK(clientFacingSocket_);
+  return clientFacingSocket_->address();
+}
+
+const LinkStats& UdpNetworkEmulator::toServerStats() const noexcept {
+  return toServer_.stats();
+}
+
+const LinkStats& UdpNetworkEmulator::toClientStats() const noexcept {
+  return toClient_.stats();
+}
+
+void UdpNetworkEmulator::onClientData(
+    const folly::SocketAddress& client,
+    std::unique_ptr<folly::IOBuf> data) {
+  auto it = clientPaths_.find(client);
+  if (it == clientPaths_.end()) {
+    it = clientPaths_.emplace(client, ClientPath()).first;
+    auto& path = it->second;
+    path.clientAddress = client;
+    path.serverFacingSocket = std::make_unique<folly::AsyncUDPSocket>(evb_);
+    path.serverFacingSocket->bind(
+        folly::SocketAddress(clientFacingSocket_->address().getIPAddress(), 0));
+    path.reader = std::make_unique<Reader>(
+        [this, &path](
+            const folly::SocketAddress& /* server */,
+            std::unique_ptr<folly::IOBuf> data) {
+          onServerData(path, std::move(data));
+        });
+    path.serverFacingSocket->resumeRead(path.reader.get());
+    VLOG(4) << "UdpNetworkEmulator new path for client=" << client.describe()
+            << " via " << path.serverFacingSocket->address().describe();
+  }
+  auto& serverFacingSocket = *it->second.serverFacingSocket;
+  toServer_.send(serverFacingSocket, serverAddress_, std::move(data));
+}
+
+void UdpNetworkEmulator::onServerData(
+    ClientPath& path,
+    std::unique_ptr<folly::IOBuf> data) {
+  toClient_.send(*clientFacingSocket_, path.clientAddress, std::move(data));
+}
+
+} // namespace netem
+} // namespace quic
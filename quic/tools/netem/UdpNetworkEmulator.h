@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#pragma once
+
+#include <quic/QuicConstants.h>
+
+#include <folly/SocketAddress.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+#include <folly/io/async/EventBase.h>
+
+#include <deque>
+#include <map>
+#include <random>
+
+namespace quic {
+namespace netem {
+
+/**
+ * Impairments applied to the datagrams going in one direction. Datagrams are
+ * dropped with lossRate before anything else, then served in arrival order at
+ * bytesPerSecond out of a drop-tail queue of queueBytes, then held for delay
+ * plus a uniformly drawn jitter. Jitter alone never reorders datagrams, only
+ * the ones picked with reorderRate are held for reorderDelay on top of it and
+ * let the ones behind them overtake.
+ */
+struct LinkImpairment {
+  std::chrono::microseconds delay{0};
+  std::chrono::microseconds jitter{0};
+  // 0 means the rate isn't limited, and there is no queue.
+  uint64_t bytesPerSecond{0};
+  uint64_t queueBytes{100 * kDefaultUDPSendPacketLen};
+  double lossRate{0};
+  double reorderRate{0};
+  std::chrono::microseconds reorderDelay{0};
+};
+
+struct LinkStats {
+  uint64_t deliveredPackets{0};
+  uint64_t deliveredBytes{0};
+  uint64_t lostPackets{0};
+  uint64_t queueDroppedPackets{0};
+  uint64_t reorderedPackets{0};
+};
+
+/**
+ * One direction of an emulated path: takes datagrams read off a socket,
+ * applies a LinkImpairment to them, and writes the ones that make it through
+ * to their destination once they are due. Has to be used from the thread of
+ * its EventBase.
+ */
+class EmulatedLink : private folly::AsyncTimeout {
+ public:
+  EmulatedLink(
+      folly::EventBase* evb,
+      LinkImpairment impairment,
+      std::mt19937_64& rng);
+
+  ~EmulatedLink() override = default;
+
+  /**
+   * Sends data to dest through the link, it will be written with socket if
+   * it doesn't get dropped.
+   */
+  void send(
+      folly::AsyncUDPSocket& socket,
+      const folly::SocketAddress& dest,
+      std::unique_ptr<folly::IOBuf> data);
+
+  /**
+   * Drops every datagram not delivered yet.
+   */
+  void clear();
+
+  const LinkStats& stats() const noexcept;
+
+ private:
+  struct Datagram {
+    folly::AsyncUDPSocket* socket;
+    folly::SocketAddress dest;
+    std::unique_ptr<folly::IOBuf> data;
+  };
+
+  void timeoutExpired() noexcept override;
+  void scheduleDelivery();
+  bool draw(double probability);
+
+  folly::EventBase* evb_;
+  LinkImpairment impairment_;
+  std::mt19937_64& rng_;
+  LinkStats stats_;
+
+  // When the link is done serving the datagrams already queued.
+  TimePoint linkFreeTime_;
+  // Departure time and size of each datagram in the queue.
+  std::deque<std::pair<TimePoint, uint64_t>> queue_;
+  uint64_t queuedBytes_{0};
+
+  // Delivery time of the latest datagram that wasn't picked for reordering.
+  TimePoint lastDeliveryTime_;
+  uint64_t nextSeq_{0};
+  // Keyed by delivery time then arrival order.
+  std::map<std::pair<TimePoint, uint64_t>, Datagram> inflight_;
+};
+
+/**
+ * A UDP relay standing in for the network between QUIC clients and a server
+ * in the same process. Clients send to getAddress() instead of the server
+ * address, the emulator relays their datagrams to the server from a socket
+ * dedicated to each client, so the server sees one peer address per client
+ * and its replies can be relayed back. Each direction goes through its own
+ * EmulatedLink, both drawing from an RNG seeded with seed so the same seed
+ * always picks the same datagrams to drop and reorder.
+ *
+ * Everything but the constructor has to be called from the thread of evb,
+ * including the destructor.
+ */
+class UdpNetworkEmulator {
+ public:
+  UdpNetworkEmulator(
+      folly::EventBase* evb,
+      folly::SocketAddress serverAddress,
+      LinkImpairment toServer,
+      LinkImpairment toClient,
+      uint64_t seed = 0);
+
+  ~UdpNetworkEmulator();
+
+  /**
+   * Binds the socket clients send to and starts relaying.
+   */
+  void start(const folly::SocketAddress& bindAddress);
+
+  /**
+   * Closes every socket and drops the datagrams not delivered yet.
+   */
+  void stop();
+
+  const folly::SocketAddress& getAddress() const;
+
+  const LinkStats& toServerStats() const noexcept;
+  const LinkStats& toClientStats() const noexcept;
+
+ private:
+  class Reader;
+
+  struct ClientPath {
+    folly::SocketAddress clientAddress;
+    std::unique_ptr<folly::AsyncUDPSocket> serverFacingSocket;
+    std::unique_ptr<Reader> reader;
+  };
+
+  void onClientData(
+      const folly::SocketAddress& client,
+      std::unique_ptr<folly::IOBuf> data);
+  void onServerData(ClientPath& path, std::unique_ptr<folly::IOBuf> data);
+
+  folly::EventBase* evb_;
+  folly::SocketAddress serverAddress_;
+  std::mt19937_64 rng_;
+  EmulatedLink toServer_;
+  EmulatedLink toClient_;
+
+  std::unique_ptr<folly::AsyncUDPSocket> clientFacingSocket_;
+  std::unique_ptr<Reader> clientFacingReader_;
+  folly::F14NodeMap<folly::SocketAddress, ClientPath> clientPaths_;
+};
+
+} // namespace netem
+} // namespace quic
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/tools/netem/LoopbackTransfer.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace testing;
+
+namespace quic {
+namespace netem {
+namespace test {
+
+namespace {
+
+// 40Mbps, 20ms rtt, with a buffer of a couple of BDPs.
+LinkImpairment makeDownlink() {
+  LinkImpairment link;
+  link.delay = 10ms;
+  link.jitter = 1ms;
+  link.bytesPerSecond = 5 * 1000 * 1000;
+  link.queueBytes = 200 * 1000;
+  return link;
+}
+
+LinkImpairment makeUplink() {
+  LinkImpairment link;
+  link.delay = 10ms;
+  return link;
+}
+
+} // namespace
+
+using TransferParams = std::tuple<CongestionControlType, QuicBatchingMode>;
+
+class LoopbackTransferTest : public TestWithParam<TransferParams> {};
+
+TEST_P(LoopbackTransferTest, Transfer) {
+  LoopbackTransferConfig config;
+  config.congestionControlType = std::get<0>(GetParam());
+  config.batchingMode = std::get<1>(GetParam());
+  config.pacingEnabled = true;
+  config.transferBytes = 2 * 1000 * 1000;
+  config.toServer = makeUplink();
+  config.toClient = makeDownlink();
+  auto result = runLoopbackTransfer(config);
+  LOG(INFO) << congestionControlTypeToString(config.congestionControlType)
+            << " batching=" << static_cast<int>(config.batchingMode) << ": "
+            << result;
+  EXPECT_TRUE(result.completed);
+  EXPECT_EQ(config.transferBytes, result.receivedBytes);
+  EXPECT_LE(result.goodput, config.toClient.bytesPerSecond);
+  EXPECT_GT(result.cpuNsPerByte, 0);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    LoopbackTransferTests,
+    LoopbackTransferTest,
+    Combine(
+        Values(
+            CongestionControlType::Cubic,
+            CongestionControlType::NewReno,
+            CongestionControlType::Copa,
+            CongestionControlType::BBR,
+            CongestionControlType::BBR2),
+        Values(
+            QuicBatchingMode::BATCHING_MODE_NONE,
+            QuicBatchingMode::BATCHING_MODE_GSO,
+            QuicBatchingMode::BATCHING_MODE_SENDMMSG)));
+
+TEST(LoopbackTransferLossTest, RecoversFromLossAndReordering) {
+  LoopbackTransferConfig config;
+  config.transferBytes = 1000 * 1000;
+  config.toServer = makeUplink();
+  config.toServer.lossRate = 0.01;
+  config.toClient = makeDownlink();
+  config.toClient.lossRate = 0.02;
+  config.toClient.reorderRate = 0.01;
+  config.toClient.reorderDelay = 5ms;
+  config.seed = 1;
+  auto result = runLoopbackTransfer(config);
+  LOG(INFO) << result;
+  EXPECT_TRUE(result.completed);
+  EXPECT_EQ(config.transferBytes, result.receivedBytes);
+  EXPECT_GT(result.toClient.lostPackets, 0);
+}
+
+} // namespace test
+} // namespace netem
+} // namespace quic
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ *
+ */
+
+#include <quic/tools/netem/UdpNetworkEmulator.h>
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+#include <array>
+
+using namespace testing;
+
+namespace quic {
+namespace netem {
+namespace test {
+
+namespace {
+
+class TestReceiver : public folly::AsyncUDPSocket::ReadCallback {
+ public:
+  explicit TestReceiver(folly::EventBase* evb) : socket(evb) {
+    socket.bind(folly::SocketAddress("::1", 0));
+    socket.resumeRead(this);
+  }
+
+  ~TestReceiver() override {
+    socket.close();
+  }
+
+  void getReadBuffer(void** buf, size_t* len) noexcept override {
+    *buf = buffer_.data();
+    *len = buffer_.size();
+  }
+
+  void onDataAvailable(
+      const folly::SocketAddress& peer,
+      size_t len,
+      bool /* truncated */,
+      OnDataAvailableParams /* params */) noexcept override {
+    lastPeer = peer;
+    received.emplace_back(
+        Clock::now(), std::string(buffer_.data(), buffer_.data() + len));
+  }
+
+  void onReadError(const folly::AsyncSocketException&) noexcept override {}
+
+  void onReadClosed() noexcept override {}
+
+  void send(const folly::SocketAddress& dest, const std::string& data) {
+    socket.write(dest, folly::IOBuf::copyBuffer(data));
+  }
+
+  folly::AsyncUDPSocket socket;
+  folly::SocketAddress lastPeer;
+  std::vector<std::pair<TimePoint, std::string>> received;
+
+ private:
+  std::array<char, 2048> buffer_;
+};
+
+} // namespace
+
+class UdpNetworkEmulatorTest : public Test {
+ public:
+  void SetUp() override {
+    client_ = std::make_unique<TestReceiver>(&evb_);
+    server_ = std::make_unique<TestReceiver>(&evb_);
+  }
+
+  void makeEmulator(LinkImpairment toServer, LinkImpairment toClient) {
+    emulator_ = std::make_unique<UdpNetworkEmulator>(
+        &evb_, server_->socket.address(), toServer, toClient);
+    emulator_->start(folly::SocketAddress("::1", 0));
+  }
+
+  void loopFor(std::chrono::milliseconds duration) {
+    evb_.runAfterDelay([&] { evb_.terminateLoopSoon(); }, duration.count());
+    evb_.loop();
+  }
+
+  void TearDown() override {
+    emulator_.reset();
+    client_.reset();
+    server_.reset();
+  }
+
+ protected:
+  folly::EventBase evb_;
+  std::unique_ptr<TestReceiver> client_;
+  std::unique_ptr<TestReceiver> server_;
+  std::unique_ptr<UdpNetworkEmulator> emulator_;
+};
+
+TEST_F(UdpNetworkEmulatorTest, RelaysBothWays) {
+  LinkImpairment toServer;
+  toServer.delay = 20ms;
+  makeEmulator(toServer, LinkImpairment());
+  auto sendTime = Clock::now();
+  client_->send(emulator_->getAddress(), "hello");
+  loopFor(100ms);
+  ASSERT_EQ(1, server_->received.size());
+  EXPECT_EQ("hello", server_->received[0].second);
+  EXPECT_GE(server_->received[0].first - sendTime, 20ms);
+  EXPECT_NE(client_->socket.address(), server_->lastPeer);
+
+  server_->send(server_->lastPeer, "world");
+  loopFor(50ms);
+  ASSERT_EQ(1, client_->received.size());
+  EXPECT_EQ("world", client_->received[0].second);
+  EXPECT_EQ(emulator_->getAddress(), client_->lastPeer);
+  EXPECT_EQ(1, emulator_->toServerStats().deliveredPackets);
+  EXPECT_EQ(1, emulator_->toClientStats().deliveredPackets);
+}
+
+TEST_F(UdpNetworkEmulatorTest, Loss) {
+  LinkImpairment toServer;
+  toServer.lossRate = 1;
+  makeEmulator(toServer, LinkImpairment());
+  for (int i = 0; i < 10; i++) {
+    client_->send(emulator_->getAddress(), "lost");
+  }
+  loopFor(50ms);
+  EXPECT_TRUE(server_->received.empty());
+  EXPECT_EQ(10, emulator_->toServerStats().lostPackets);
+  EXPECT_EQ(0, emulator_->toServerStats().deliveredPackets);
+}
+
+TEST_F(UdpNetworkEmulatorTest, RateLimitDropsPastQueue) {
+  LinkImpairment toServer;
+  toServer.bytesPerSecond = 1000;
+  toServer.queueBytes = 30;
+  makeEmulator(toServer, LinkImpairment());
+  for (int i = 0; i < 10; i++) {
+    client_->send(emulator_->getAddress(), "0123456789");
+  }
+  // Each datagram takes 10ms to go through.
+  loopFor(100ms);
+  EXPECT_EQ(3, server_->received.size());
+  EXPECT_EQ(7, emulator_->toServerStats().queueDroppedPackets);
+  for (size_t i = 1; i < server_->received.size(); i++) {
+    EXPECT_GE(
+        server_->received[i].first - server_->received[i - 1].first, 9ms);
+  }
+}
+
+TEST_F(UdpNetworkEmulatorTest, JitterKeepsOrder) {
+  LinkImpairment toServer;
+  toServer.delay = 5ms;
+  toServer.jitter = 10ms;
+  makeEmulator(toServer, LinkImpairment());
+  for (int i = 0; i < 20; i++) {
+    client_->send(emulator_->getAddress(), folly::to<std::string>(i));
+  }
+  loopFor(100ms);
+  ASSERT_EQ(20, server_->received.size());
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(folly::to<std::string>(i), server_->received[i].second);
+  }
+}
+
+TEST_F(UdpNetworkEmulatorTest, Reordering) {
+  LinkImpairment toServer;
+  toServer.reorderRate = 0.5;
+  toServer.reorderDelay = 10ms;
+  makeEmulator(toServer, LinkImpairment());
+  std::vector<std::string> sent;
+  for (int i = 0; i < 20; i++) {
+    sent.push_back(folly::to<std::string>(i));
+    client_->send(emulator_->getAddress(), sent.back());
+  }
+  loopFor(100ms);
+  ASSERT_EQ(20, server_->received.size());
+  std::vector<std::string> received;
+  for (const auto& datagram : server_->received) {
+    received.push_back(datagram.second);
+  }
+  EXPECT_NE(sent, received);
+  EXPECT_GT(emulator_->toServerStats().reorderedPackets, 0);
+}
+
+} // namespace test
+} // namespace netem
+} // namespace quic
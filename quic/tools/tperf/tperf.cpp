@@ -9,21 +9,34 @@
 #include <glog/logging.h>
 
 #include <fizz/crypto/Utils.h>
+#include <fizz/server/AeadTicketCipher.h>
+#include <folly/Function.h>
+#include <folly/Random.h>
 #include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <folly/portability/GFlags.h>
+#include <folly/portability/SysResource.h>
 #include <folly/stats/Histogram.h>
 
+#include <thread>
+
 #include <quic/QuicConstants.h>
 #include <quic/client/QuicClientTransport.h>
+#include <quic/common/LogLinearHistogram.h>
 #include <quic/common/test/TestUtils.h>
 #include <quic/congestion_control/ServerCongestionControllerFactory.h>
 #include <quic/fizz/client/handshake/FizzClientQuicHandshakeContext.h>
+#include <quic/fizz/client/handshake/QuicPskCache.h>
+#include <quic/fizz/server/handshake/FizzReplayCache.h>
 #include <quic/server/AcceptObserver.h>
 #include <quic/server/QuicCcpThreadLauncher.h>
 #include <quic/server/QuicServer.h>
 #include <quic/server/QuicServerTransport.h>
 #include <quic/server/QuicSharedUDPSocketFactory.h>
+#include <quic/server/handshake/RetryTokenGenerator.h>
 #include <quic/tools/tperf/PacingObserver.h>
 #include <quic/tools/tperf/TperfDSRSender.h>
 #include <quic/tools/tperf/TperfQLogger.h>
@@ -117,12 +130,69 @@ DEFINE_string(
     "",
     "JSON-serialized dictionary of transport knob params");
 DEFINE_bool(dsr, false, "if you want to debug perf");
+DEFINE_uint32(
+    connections,
+    1,
+    "Client only. Number of concurrent connections to open");
+DEFINE_uint32(
+    client_threads,
+    1,
+    "Client only. Number of EventBase threads the connections are spread over");
+DEFINE_bool(
+    rpc,
+    false,
+    "Run request/response on a stream per request instead of a bulk transfer. "
+    "Must be set on both client and server");
+DEFINE_uint64(
+    request_size,
+    64,
+    "Client only. RPC request size in bytes, at least 8");
+DEFINE_uint64(response_size, 1024, "Client only. RPC response size in bytes");
+DEFINE_uint64(
+    max_response_size,
+    64 * 1024 * 1024,
+    "Server only. Largest RPC response in bytes, larger requests are clamped");
+DEFINE_uint32(
+    rpc_concurrency,
+    1,
+    "Client only. Number of outstanding RPC requests per connection");
+DEFINE_bool(
+    churn,
+    false,
+    "Open and close connections back to back to measure handshake rate, "
+    "keeping --connections of them in flight. Must be set on both client "
+    "and server");
+DEFINE_bool(
+    zero_rtt,
+    false,
+    "Resume with 0-RTT via a PSK cache. Must be set on both client and server");
+DEFINE_bool(
+    retry,
+    false,
+    "Server only. Answer every new connection with a Retry");
 
 namespace quic {
 namespace tperf {
 
 namespace {
 
+/**
+ * What the server does once a connection is up. Bulk pushes data on
+ * num_streams streams for the whole connection, Rpc answers requests on
+ * client opened streams and Churn sends a single block so the client can
+ * time its first byte and reconnect.
+ */
+enum class TrafficMode : uint8_t { Bulk, Rpc, Churn };
+
+constexpr std::chrono::seconds kChurnReportInterval{5};
+
+uint64_t processCpuTimeUs() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+      usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
 ProbeSizeRaiserType parseRaiserType(uint32_t type) {
   auto maybeRaiserType = static_cast<ProbeSizeRaiserType>(type);
   switch (maybeRaiserType) {
@@ -204,9 +274,14 @@ class TPerfAcceptObserver : public AcceptObserver {
   }
 
   void accept(QuicTransportBase* transport) noexcept override {
+    numAccepted_.fetch_add(1, std::memory_order_relaxed);
     transport->addObserver(tperfObserver_.get());
   }
 
+  uint64_t getNumAccepted() const {
+    return numAccepted_.load(std::memory_order_relaxed);
+  }
+
   void acceptorDestroy(QuicServerWorker* /* worker */) noexcept override {
     LOG(INFO) << "quic server worker destroyed";
   }
@@ -221,6 +296,7 @@ class TPerfAcceptObserver : public AcceptObserver {
 
  private:
   std::unique_ptr<TPerfObserver> tperfObserver_;
+  std::atomic<uint64_t> numAccepted_{0};
 };
 
 } // namespace
@@ -235,20 +311,22 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
       uint32_t numStreams,
       uint64_t maxBytesPerStream,
       folly::AsyncUDPSocket& sock,
-      bool dsrEnabled)
+      bool dsrEnabled,
+      TrafficMode mode)
       : evb_(evbIn),
         blockSize_(blockSize),
         numStreams_(numStreams),
         maxBytesPerStream_(maxBytesPerStream),
         udpSock_(sock),
-        dsrEnabled_(dsrEnabled) {}
+        dsrEnabled_(dsrEnabled),
+        mode_(mode) {}
 
   void setQuicSocket(std::shared_ptr<quic::QuicSocket> socket) {
     sock_ = socket;
   }
 
   void onNewBidirectionalStream(quic::StreamId id) noexcept override {
-    LOG(INFO) << "Got bidirectional stream id=" << id;
+    VLOG(4) << "Got bidirectional stream id=" << id;
     sock_->setReadCallback(id, this);
   }
 
@@ -275,6 +353,14 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
   }
 
   void onTransportReady() noexcept override {
+    if (mode_ == TrafficMode::Rpc) {
+      VLOG(2) << "Waiting for requests from client.";
+      return;
+    }
+    if (mode_ == TrafficMode::Churn) {
+      sendSingleBlock();
+      return;
+    }
     LOG(INFO) << "Starting sends to client.";
     for (uint32_t i = 0; i < numStreams_; i++) {
       createNewStream();
@@ -307,7 +393,23 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
   }
 
   void readAvailable(quic::StreamId id) noexcept override {
-    LOG(INFO) << "read available for stream id=" << id;
+    if (mode_ != TrafficMode::Rpc) {
+      LOG(INFO) << "read available for stream id=" << id;
+      return;
+    }
+    auto res = sock_->read(id, 0);
+    if (res.hasError()) {
+      LOG(ERROR) << "Got error on read: " << quic::toString(res.error());
+      return;
+    }
+    auto& request = pendingRequests_[id];
+    request.append(std::move(res->first));
+    if (!res->second) {
+      return;
+    }
+    auto requestBuf = request.move();
+    pendingRequests_.erase(id);
+    respond(id, std::move(requestBuf));
   }
 
   void readError(
@@ -359,6 +461,17 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
   }
 
  private:
+  void sendSingleBlock() {
+    auto stream = sock_->createUnidirectionalStream();
+    CHECK(stream.hasValue());
+    auto block = folly::IOBuf::create(blockSize_);
+    block->append(blockSize_);
+    auto res = sock_->writeChain(*stream, std::move(block), true, nullptr);
+    if (res.hasError()) {
+      LOG(ERROR) << "Got error on write: " << quic::toString(res.error());
+    }
+  }
+
   void dsrSend(quic::StreamId id, uint64_t toSend, bool eof) {
     if (streamsHavingDSRSender_.find(id) == streamsHavingDSRSender_.end()) {
       auto dsrSender = std::make_unique<TperfDSRSender>(blockSize_, udpSock_);
@@ -383,6 +496,31 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
     }
   }
 
+  /**
+   * The first 8 bytes of an RPC request carry the size of the response the
+   * client wants back, the rest is padding.
+   */
+  void respond(quic::StreamId id, Buf request) {
+    uint64_t responseSize = 0;
+    if (request && request->computeChainDataLength() >= sizeof(uint64_t)) {
+      folly::io::Cursor cursor(request.get());
+      responseSize = cursor.readBE<uint64_t>();
+    } else {
+      LOG(ERROR) << "Malformed request on stream=" << id;
+    }
+    if (responseSize > FLAGS_max_response_size) {
+      VLOG(2) << "Clamping response size=" << responseSize
+              << " on stream=" << id;
+      responseSize = FLAGS_max_response_size;
+    }
+    auto response = folly::IOBuf::create(responseSize);
+    response->append(responseSize);
+    auto res = sock_->writeChain(id, std::move(response), true, nullptr);
+    if (res.hasError()) {
+      LOG(ERROR) << "Got error on write: " << quic::toString(res.error());
+    }
+  }
+
   void regularSend(quic::StreamId id, uint64_t toSend, bool eof) {
     auto buf = folly::IOBuf::createChain(toSend, blockSize_);
     auto curBuf = buf.get();
@@ -404,8 +542,10 @@ class ServerStreamHandler : public quic::QuicSocket::ConnectionCallback,
   uint64_t maxBytesPerStream_;
   std::unordered_map<quic::StreamId, uint64_t> bytesPerStream_;
   std::set<quic::StreamId> streamsHavingDSRSender_;
+  std::unordered_map<quic::StreamId, folly::IOBufQueue> pendingRequests_;
   folly::AsyncUDPSocket& udpSock_;
   bool dsrEnabled_;
+  TrafficMode mode_;
 };
 
 class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
@@ -416,11 +556,13 @@ class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
       uint64_t blockSize,
       uint32_t numStreams,
       uint64_t maxBytesPerStream,
-      bool dsrEnabled)
+      bool dsrEnabled,
+      TrafficMode mode)
       : blockSize_(blockSize),
         numStreams_(numStreams),
         maxBytesPerStream_(maxBytesPerStream),
-        dsrEnabled_(dsrEnabled) {}
+        dsrEnabled_(dsrEnabled),
+        mode_(mode) {}
 
   quic::QuicServerTransport::Ptr make(
       folly::EventBase* evb,
@@ -430,7 +572,13 @@ class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
       override {
     CHECK_EQ(evb, sock->getEventBase());
     auto serverHandler = std::make_unique<ServerStreamHandler>(
-        evb, blockSize_, numStreams_, maxBytesPerStream_, *sock, dsrEnabled_);
+        evb,
+        blockSize_,
+        numStreams_,
+        maxBytesPerStream_,
+        *sock,
+        dsrEnabled_,
+        mode_);
     auto transport = quic::QuicServerTransport::make(
         evb, std::move(sock), *serverHandler, ctx);
     if (!FLAGS_server_qlogger_path.empty()) {
@@ -465,6 +613,7 @@ class TPerfServerTransportFactory : public quic::QuicServerTransportFactory {
   uint32_t numStreams_;
   uint64_t maxBytesPerStream_;
   bool dsrEnabled_;
+  TrafficMode mode_;
 };
 
 class TPerfServer {
@@ -482,17 +631,34 @@ class TPerfServer {
       uint64_t maxBytesPerStream,
       uint32_t maxReceivePacketSize,
       bool useInplaceWrite,
-      bool dsrEnabled)
+      bool dsrEnabled,
+      TrafficMode mode,
+      bool zeroRtt,
+      bool retry)
       : host_(host),
         port_(port),
+        mode_(mode),
         acceptObserver_(std::make_unique<TPerfAcceptObserver>()),
         server_(QuicServer::createQuicServer()) {
     eventBase_.setName("tperf_server");
     server_->setQuicServerTransportFactory(
         std::make_unique<TPerfServerTransportFactory>(
-            blockSize, numStreams, maxBytesPerStream, dsrEnabled));
+            blockSize, numStreams, maxBytesPerStream, dsrEnabled, mode));
     auto serverCtx = quic::test::createServerCtx();
     serverCtx->setClock(std::make_shared<fizz::SystemClock>());
+    if (zeroRtt) {
+      std::array<uint8_t, 32> ticketSecret;
+      folly::Random::secureRandom(ticketSecret.data(), ticketSecret.size());
+      auto ticketCipher = std::make_shared<fizz::server::AES128TicketCipher>();
+      ticketCipher->setTicketSecrets({folly::range(ticketSecret)});
+      serverCtx->setTicketCipher(std::move(ticketCipher));
+      serverCtx->setEarlyDataSettings(
+          true,
+          fizz::server::ClockSkewTolerance{-5s, 5s},
+          std::make_shared<FizzReplayCache>(
+              std::make_shared<ShardedReplayCache>(
+                  ShardedReplayCache::Options())));
+    }
     server_->setFizzContext(serverCtx);
     quic::TransportSettings settings;
     if (useInplaceWrite) {
@@ -524,6 +690,15 @@ class TPerfServer {
     settings.d6dConfig.blackholeDetectionThreshold =
         FLAGS_d6d_blackhole_detection_threshold;
     settings.dsrEnabled = dsrEnabled;
+    if (retry) {
+      // A limit of zero makes every new connection without a token get a
+      // Retry.
+      RetryTokenSecret retryTokenSecret;
+      folly::Random::secureRandom(
+          retryTokenSecret.data(), retryTokenSecret.size());
+      settings.retryTokenSecret = retryTokenSecret;
+      server_->setRateLimit(0, 1s);
+    }
     server_->setCongestionControllerFactory(
         std::make_shared<ServerCongestionControllerFactory>());
     server_->setTransportSettings(settings);
@@ -549,57 +724,176 @@ class TPerfServer {
       server_->addAcceptObserver(evb, acceptObserver_.get());
     }
     LOG(INFO) << "tperf server started at: " << addr1.describe();
+    if (mode_ == TrafficMode::Churn) {
+      lastReportAccepted_ = acceptObserver_->getNumAccepted();
+      lastReportCpuUs_ = processCpuTimeUs();
+      churnReportTimeout_ = folly::AsyncTimeout::make(
+          eventBase_, [this]() noexcept { reportChurn(); });
+      churnReportTimeout_->scheduleTimeout(kChurnReportInterval);
+    }
     eventBase_.loopForever();
   }
 
  private:
+  /**
+   * Logs the accept rate and the CPU time the whole server process spent per
+   * accepted connection since the last report.
+   */
+  void reportChurn() {
+    auto accepted = acceptObserver_->getNumAccepted();
+    auto cpuUs = processCpuTimeUs();
+    auto newConnections = accepted - lastReportAccepted_;
+    if (newConnections > 0) {
+      LOG(INFO) << "Accepted " << newConnections << " connections at "
+                << newConnections / kChurnReportInterval.count()
+                << " conn/s, server CPU per handshake: "
+                << (cpuUs - lastReportCpuUs_) / newConnections << "us";
+    }
+    lastReportAccepted_ = accepted;
+    lastReportCpuUs_ = cpuUs;
+    churnReportTimeout_->scheduleTimeout(kChurnReportInterval);
+  }
+
   std::string host_;
   uint16_t port_;
+  TrafficMode mode_;
   folly::EventBase eventBase_;
+  std::unique_ptr<folly::AsyncTimeout> churnReportTimeout_;
+  uint64_t lastReportAccepted_{0};
+  uint64_t lastReportCpuUs_{0};
   std::unique_ptr<TPerfAcceptObserver> acceptObserver_;
   std::shared_ptr<quic::QuicServer> server_;
   quic::QuicCcpThreadLauncher quicCcpThreadLauncher_;
 };
 
+/**
+ * Per connection results, filled in by TPerfClient on its EventBase thread and
+ * read by TPerfLoadClient once that thread has been joined.
+ */
+struct TPerfConnectionStats {
+  uint64_t receivedBytes{0};
+  uint64_t receivedStreams{0};
+  uint64_t completedRequests{0};
+  // Request latency in microseconds, only filled in RPC mode.
+  LogLinearHistogram::Snapshot requestLatency;
+  TimePoint connectTime;
+  folly::Optional<TimePoint> transportReadyTime;
+  folly::Optional<TimePoint> replaySafeTime;
+  folly::Optional<TimePoint> firstByteTime;
+  bool tlsResumed{false};
+  bool error{false};
+};
+
+/**
+ * Churn mode results of one client thread, covering every connection that
+ * thread opened.
+ */
+struct TPerfChurnStats {
+  uint64_t attempts{0};
+  uint64_t handshakes{0};
+  uint64_t resumed{0};
+  uint64_t errors{0};
+  // Both in microseconds from the start of the connection.
+  LogLinearHistogram handshakeLatency;
+  LogLinearHistogram timeToFirstByte;
+};
+
+/**
+ * In RPC mode each request is sent on a fresh bidirectional stream and the
+ * server answers with responseSize bytes on the same stream. Up to
+ * concurrency requests are kept outstanding on each connection.
+ */
+struct TPerfRpcConfig {
+  uint64_t requestSize;
+  uint64_t responseSize;
+  uint32_t concurrency;
+};
+
+/**
+ * Forwards to the PSK cache shared by a churn thread and tells the owning
+ * connection when it has been handed a ticket, so it can hold off closing
+ * until the next connection is able to resume.
+ */
+class TPerfPskCache : public QuicPskCache {
+ public:
+  TPerfPskCache(
+      std::shared_ptr<QuicPskCache> cache,
+      folly::Function<void()> onPutPsk)
+      : cache_(std::move(cache)), onPutPsk_(std::move(onPutPsk)) {}
+
+  folly::Optional<QuicCachedPsk> getPsk(const std::string& identity) override {
+    return cache_->getPsk(identity);
+  }
+
+  void putPsk(const std::string& identity, QuicCachedPsk psk) override {
+    cache_->putPsk(identity, std::move(psk));
+    onPutPsk_();
+  }
+
+  void removePsk(const std::string& identity) override {
+    cache_->removePsk(identity);
+  }
+
+ private:
+  std::shared_ptr<QuicPskCache> cache_;
+  folly::Function<void()> onPutPsk_;
+};
+
 class TPerfClient : public quic::QuicSocket::ConnectionCallback,
                     public quic::QuicSocket::ReadCallback,
                     public quic::QuicSocket::WriteCallback,
-                    public folly::HHWheelTimer::Callback {
+                    public folly::HHWheelTimer::Callback,
+                    public folly::EventBase::LoopCallback {
  public:
   TPerfClient(
+      folly::EventBase* evb,
       const std::string& host,
       uint16_t port,
-      std::chrono::milliseconds transportTimerResolution,
       int32_t duration,
       uint64_t window,
       bool gso,
       quic::CongestionControlType congestionControlType,
-      uint32_t maxReceivePacketSize)
+      uint32_t maxReceivePacketSize,
+      folly::Optional<TPerfRpcConfig> rpcConfig,
+      bool churn,
+      std::shared_ptr<QuicPskCache> pskCache,
+      folly::Function<void()> doneCallback)
       : host_(host),
         port_(port),
-        eventBase_(transportTimerResolution),
+        eventBase_(evb),
         duration_(duration),
         window_(window),
         gso_(gso),
         congestionControlType_(congestionControlType),
-        maxReceivePacketSize_(maxReceivePacketSize) {
-    eventBase_.setName("tperf_client");
-  }
+        maxReceivePacketSize_(maxReceivePacketSize),
+        rpcConfig_(std::move(rpcConfig)),
+        churn_(churn),
+        pskCache_(std::move(pskCache)),
+        doneCallback_(std::move(doneCallback)) {}
 
   void timeoutExpired() noexcept override {
     quicClient_->closeNow(folly::none);
+    finish();
+  }
+
+  void logStats() {
     constexpr double bytesPerMegabit = 131072;
-    LOG(INFO) << "Received " << receivedBytes_ << " bytes in "
+    auto receivedBytes = stats_.receivedBytes;
+    auto receivedStreams = stats_.receivedStreams;
+    LOG(INFO) << "Received " << receivedBytes << " bytes in "
               << duration_.count() << " seconds.";
     LOG(INFO) << "Overall throughput: "
-              << (receivedBytes_ / bytesPerMegabit) / duration_.count()
+              << (receivedBytes / bytesPerMegabit) / duration_.count()
               << "Mb/s";
+    if (receivedStreams == 0) {
+      return;
+    }
     // Per Stream Stats
     LOG(INFO) << "Average per Stream throughput: "
-              << ((receivedBytes_ / receivedStreams_) / bytesPerMegabit) /
+              << ((receivedBytes / receivedStreams) / bytesPerMegabit) /
             duration_.count()
-              << "Mb/s over " << receivedStreams_ << " streams";
-    if (receivedStreams_ != 1) {
+              << "Mb/s over " << receivedStreams << " streams";
+    if (receivedStreams != 1) {
       LOG(INFO) << "Histogram per Stream bytes: " << std::endl;
       LOG(INFO) << "Lo\tHi\tNum\tSum";
       for (const auto bytes : bytesPerStream_) {
@@ -624,8 +918,22 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
                  << ", error=" << (uint32_t)readData.error();
     }
 
-    auto readBytes = readData->first->computeChainDataLength();
-    receivedBytes_ += readBytes;
+    auto readBytes =
+        readData->first ? readData->first->computeChainDataLength() : 0;
+    stats_.receivedBytes += readBytes;
+    if (churn_) {
+      if (readBytes > 0 && !stats_.firstByteTime) {
+        stats_.firstByteTime = Clock::now();
+        maybeCloseChurn();
+      }
+      return;
+    }
+    if (rpcConfig_) {
+      if (readData.value().second) {
+        onResponse(streamId);
+      }
+      return;
+    }
     bytesPerStream_[streamId] += readBytes;
     if (readData.value().second) {
       bytesPerStreamHistogram_.addValue(bytesPerStream_[streamId]);
@@ -649,16 +957,41 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
 
   void onNewUnidirectionalStream(quic::StreamId id) noexcept override {
     VLOG(5) << "TPerfClient: new unidirectional stream=" << id;
-    if (!timerScheduled_) {
+    if (!timerScheduled_ && !churn_) {
       timerScheduled_ = true;
-      eventBase_.timer().scheduleTimeout(this, duration_);
+      eventBase_->timer().scheduleTimeout(this, duration_);
     }
     quicClient_->setReadCallback(id, this);
-    receivedStreams_++;
+    stats_.receivedStreams++;
   }
 
   void onTransportReady() noexcept override {
-    LOG(INFO) << "TPerfClient: onTransportReady";
+    VLOG(2) << "TPerfClient: onTransportReady";
+    stats_.transportReadyTime = Clock::now();
+    if (rpcConfig_) {
+      timerScheduled_ = true;
+      eventBase_->timer().scheduleTimeout(this, duration_);
+      sendRequests();
+    }
+  }
+
+  void onReplaySafe() noexcept override {
+    stats_.replaySafeTime = Clock::now();
+    stats_.tlsResumed = quicClient_->isTLSResumed();
+    maybeCloseChurn();
+  }
+
+  // Closes a churn connection outside of the transport's callbacks.
+  void runLoopCallback() noexcept override {
+    quicClient_->closeNow(folly::none);
+    finish();
+  }
+
+  void onBidirectionalStreamsAvailable(
+      uint64_t /*numStreamsAvailable*/) noexcept override {
+    if (rpcConfig_ && stats_.transportReadyTime) {
+      sendRequests();
+    }
   }
 
   void onStopSending(
@@ -668,15 +1001,15 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
   }
 
   void onConnectionEnd() noexcept override {
-    LOG(INFO) << "TPerfClient connection end";
-
-    eventBase_.terminateLoopSoon();
+    VLOG(2) << "TPerfClient connection end";
+    finish();
   }
 
   void onConnectionError(
       std::pair<quic::QuicErrorCode, std::string> error) noexcept override {
     LOG(ERROR) << "TPerfClient error: " << toString(error.first);
-    eventBase_.terminateLoopSoon();
+    stats_.error = true;
+    finish();
   }
 
   void onStreamWriteReady(quic::StreamId id, uint64_t maxToSend) noexcept
@@ -693,22 +1026,38 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
                << " error=" << toString(error);
   }
 
-  void start() {
+  /**
+   * Starts the handshake. This does not run the EventBase, doneCallback is
+   * invoked on it once the connection has ended or errored out.
+   */
+  void connect() {
     folly::SocketAddress addr(host_.c_str(), port_);
 
-    auto sock = std::make_unique<folly::AsyncUDPSocket>(&eventBase_);
-    auto fizzClientContext =
-        FizzClientQuicHandshakeContext::Builder()
-            .setCertificateVerifier(test::createTestCertificateVerifier())
-            .build();
+    auto sock = std::make_unique<folly::AsyncUDPSocket>(eventBase_);
+    auto fizzClientContextBuilder =
+        FizzClientQuicHandshakeContext::Builder().setCertificateVerifier(
+            test::createTestCertificateVerifier());
+    if (pskCache_) {
+      auto context = std::make_shared<fizz::client::FizzClientContext>();
+      context->setSendEarlyData(true);
+      auto pskCache = std::make_shared<TPerfPskCache>(pskCache_, [this]() {
+        pskReceived_ = true;
+        maybeCloseChurn();
+      });
+      std::move(fizzClientContextBuilder)
+          .setFizzClientContext(std::move(context))
+          .setPskCache(std::move(pskCache));
+    }
+    auto fizzClientContext = std::move(fizzClientContextBuilder).build();
     quicClient_ = std::make_shared<quic::QuicClientTransport>(
-        &eventBase_, std::move(sock), std::move(fizzClientContext));
+        eventBase_, std::move(sock), std::move(fizzClientContext));
     quicClient_->setHostname("tperf");
     quicClient_->addNewPeerAddress(addr);
     quicClient_->setCongestionControllerFactory(
         std::make_shared<DefaultCongestionControllerFactory>());
     auto settings = quicClient_->getTransportSettings();
     settings.advertisedInitialUniStreamWindowSize = window_;
+    settings.advertisedInitialBidiLocalStreamWindowSize = window_;
     // TODO figure out what actually to do with conn flow control and not sent
     // limit.
     settings.advertisedInitialConnectionWindowSize =
@@ -716,7 +1065,8 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
     settings.connectUDP = true;
     settings.shouldRecvBatch = true;
     settings.defaultCongestionController = congestionControlType_;
-    if (congestionControlType_ == quic::CongestionControlType::BBR) {
+    if (congestionControlType_ == quic::CongestionControlType::BBR ||
+        congestionControlType_ == quic::CongestionControlType::BBR2) {
       settings.pacingEnabled = true;
       settings.pacingTimerTickInterval = 200us;
     }
@@ -725,6 +1075,7 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
       settings.maxBatchSize = 16;
     }
     settings.maxRecvPacketSize = maxReceivePacketSize_;
+    settings.attemptEarlyData = pskCache_ != nullptr;
     settings.canIgnorePathMTU = !FLAGS_d6d_enabled;
     settings.d6dConfig.enabled = FLAGS_d6d_enabled;
     settings.d6dConfig.advertisedBasePMTU = FLAGS_d6d_base_pmtu;
@@ -740,21 +1091,97 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
     }
     quicClient_->setTransportSettings(settings);
 
-    LOG(INFO) << "TPerfClient connecting to " << addr.describe();
+    VLOG(2) << "TPerfClient connecting to " << addr.describe();
+    stats_.connectTime = Clock::now();
+    if (churn_) {
+      // Bounds how long a connection that never gets its first byte can
+      // hold up its slot.
+      timerScheduled_ = true;
+      eventBase_->timer().scheduleTimeout(this, duration_);
+    }
     quicClient_->start(this);
-    eventBase_.loopForever();
+  }
+
+  const TPerfConnectionStats& getStats() const {
+    return stats_;
   }
 
   ~TPerfClient() override = default;
 
  private:
+  /**
+   * A churn connection is done once it has its first byte, the handshake is
+   * confirmed and, when resuming, the ticket for the next connection is in.
+   */
+  void maybeCloseChurn() {
+    if (churn_ && !done_ && stats_.firstByteTime && stats_.replaySafeTime &&
+        (!pskCache_ || pskReceived_) && !isLoopCallbackScheduled()) {
+      eventBase_->runInLoop(this);
+    }
+  }
+
+  /**
+   * Tops the connection back up to the configured number of outstanding
+   * requests. Stops early when out of stream credit, the next
+   * onBidirectionalStreamsAvailable resumes.
+   */
+  void sendRequests() {
+    while (!done_ && requestStartTimes_.size() < rpcConfig_->concurrency) {
+      auto stream = quicClient_->createBidirectionalStream();
+      if (stream.hasError()) {
+        VLOG(5) << "TPerfClient out of bidirectional streams";
+        return;
+      }
+      auto request = folly::IOBuf::create(rpcConfig_->requestSize);
+      request->append(rpcConfig_->requestSize);
+      folly::io::RWPrivateCursor cursor(request.get());
+      cursor.writeBE<uint64_t>(rpcConfig_->responseSize);
+      quicClient_->setReadCallback(*stream, this);
+      requestStartTimes_.emplace(*stream, Clock::now());
+      auto res = quicClient_->writeChain(*stream, std::move(request), true);
+      if (res.hasError()) {
+        LOG(ERROR) << "TPerfClient failed to send request on stream="
+                   << *stream << ", error=" << toString(res.error());
+        requestStartTimes_.erase(*stream);
+        return;
+      }
+    }
+  }
+
+  void onResponse(quic::StreamId streamId) {
+    auto it = requestStartTimes_.find(streamId);
+    if (it == requestStartTimes_.end()) {
+      return;
+    }
+    requestLatency_.addValue(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - it->second)
+            .count());
+    requestStartTimes_.erase(it);
+    stats_.completedRequests++;
+    sendRequests();
+  }
+
+  void finish() {
+    if (done_) {
+      return;
+    }
+    done_ = true;
+    if (rpcConfig_) {
+      stats_.requestLatency = requestLatency_.snapshot();
+    }
+    if (doneCallback_) {
+      doneCallback_();
+    }
+  }
+
   bool timerScheduled_{false};
+  bool done_{false};
   std::string host_;
   uint16_t port_;
   std::shared_ptr<quic::QuicClientTransport> quicClient_;
-  folly::EventBase eventBase_;
-  uint64_t receivedBytes_{0};
-  uint64_t receivedStreams_{0};
+  folly::EventBase* eventBase_;
+  TPerfConnectionStats stats_;
   std::map<quic::StreamId, uint64_t> bytesPerStream_;
   folly::Histogram<uint64_t> bytesPerStreamHistogram_{
       1024,
@@ -765,6 +1192,357 @@ class TPerfClient : public quic::QuicSocket::ConnectionCallback,
   bool gso_;
   quic::CongestionControlType congestionControlType_;
   uint32_t maxReceivePacketSize_;
+  folly::Optional<TPerfRpcConfig> rpcConfig_;
+  bool churn_;
+  std::shared_ptr<QuicPskCache> pskCache_;
+  bool pskReceived_{false};
+  std::unordered_map<quic::StreamId, TimePoint> requestStartTimes_;
+  LogLinearHistogram requestLatency_;
+  folly::Function<void()> doneCallback_;
+};
+
+/**
+ * Spreads numConnections TPerfClient connections round robin over
+ * numThreads EventBase threads and reports aggregate and per connection
+ * results once they are all done. With a single connection this reports the
+ * same per stream details the single client mode always did.
+ */
+class TPerfLoadClient {
+ public:
+  TPerfLoadClient(
+      const std::string& host,
+      uint16_t port,
+      std::chrono::milliseconds transportTimerResolution,
+      int32_t duration,
+      uint64_t window,
+      bool gso,
+      quic::CongestionControlType congestionControlType,
+      uint32_t maxReceivePacketSize,
+      uint32_t numConnections,
+      uint32_t numThreads,
+      folly::Optional<TPerfRpcConfig> rpcConfig,
+      bool churn,
+      bool zeroRtt)
+      : host_(host),
+        port_(port),
+        transportTimerResolution_(transportTimerResolution),
+        duration_(duration),
+        window_(window),
+        gso_(gso),
+        congestionControlType_(congestionControlType),
+        maxReceivePacketSize_(maxReceivePacketSize),
+        numConnections_(numConnections),
+        numThreads_(std::min(numThreads, numConnections)),
+        rpcConfig_(std::move(rpcConfig)),
+        churn_(churn),
+        zeroRtt_(zeroRtt),
+        stats_(numConnections),
+        churnStats_(numThreads_) {
+    CHECK_GT(numConnections_, 0);
+    CHECK_GT(numThreads_, 0);
+  }
+
+  void start() {
+    LOG(INFO) << "TPerfClient connecting " << numConnections_
+              << " connection(s) to " << host_ << ":" << port_ << " from "
+              << numThreads_ << " thread(s)";
+    auto startTime = Clock::now();
+    auto startCpuUs = processCpuTimeUs();
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads_);
+    for (uint32_t i = 0; i < numThreads_; ++i) {
+      threads.emplace_back([this, i]() {
+        if (churn_) {
+          runChurnThread(i);
+        } else {
+          runThread(i);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (churn_) {
+      logChurnStats(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              Clock::now() - startTime),
+          processCpuTimeUs() - startCpuUs);
+      return;
+    }
+    logStats();
+  }
+
+ private:
+  void runThread(uint32_t threadIndex) {
+    // Clients are declared after the EventBase so they are destroyed first,
+    // while their transports can still detach from it.
+    folly::EventBase evb(transportTimerResolution_);
+    evb.setName(folly::to<std::string>("tperf_client_", threadIndex));
+    std::vector<std::pair<size_t, std::unique_ptr<TPerfClient>>> clients;
+    size_t remaining = 0;
+    for (size_t conn = threadIndex; conn < numConnections_;
+         conn += numThreads_) {
+      ++remaining;
+      clients.emplace_back(
+          conn,
+          std::make_unique<TPerfClient>(
+              &evb,
+              host_,
+              port_,
+              duration_.count(),
+              window_,
+              gso_,
+              congestionControlType_,
+              maxReceivePacketSize_,
+              rpcConfig_,
+              false /* churn */,
+              nullptr /* pskCache */,
+              [&evb, &remaining]() {
+                if (--remaining == 0) {
+                  evb.terminateLoopSoon();
+                }
+              }));
+    }
+    for (auto& client : clients) {
+      client.second->connect();
+    }
+    evb.loopForever();
+    for (auto& client : clients) {
+      stats_[client.first] = client.second->getStats();
+      if (numConnections_ == 1 && !rpcConfig_) {
+        client.second->logStats();
+      }
+    }
+  }
+
+  /**
+   * Keeps this thread's share of --connections handshaking back to back until
+   * the duration is over. Each connection is closed as soon as its first
+   * byte arrives, and with zeroRtt every connection after the first one on
+   * the thread resumes from the PSK the previous one cached.
+   */
+  void runChurnThread(uint32_t threadIndex) {
+    folly::EventBase evb(transportTimerResolution_);
+    evb.setName(folly::to<std::string>("tperf_churn_", threadIndex));
+    std::shared_ptr<QuicPskCache> pskCache;
+    if (zeroRtt_) {
+      pskCache = std::make_shared<BasicQuicPskCache>();
+    }
+    auto& churnStats = churnStats_[threadIndex];
+    auto deadline = Clock::now() + duration_;
+    size_t numSlots = 0;
+    for (size_t conn = threadIndex; conn < numConnections_;
+         conn += numThreads_) {
+      ++numSlots;
+    }
+    std::vector<std::unique_ptr<TPerfClient>> slots(numSlots);
+    size_t active = numSlots;
+    folly::Function<void(size_t)> connectSlot;
+    auto onSlotDone = [&](size_t slot) {
+      recordChurnStats(churnStats, slots[slot]->getStats());
+      slots[slot].reset();
+      if (Clock::now() < deadline) {
+        connectSlot(slot);
+      } else if (--active == 0) {
+        evb.terminateLoopSoon();
+      }
+    };
+    connectSlot = [&](size_t slot) {
+      slots[slot] = std::make_unique<TPerfClient>(
+          &evb,
+          host_,
+          port_,
+          duration_.count(),
+          window_,
+          gso_,
+          congestionControlType_,
+          maxReceivePacketSize_,
+          folly::none,
+          true /* churn */,
+          pskCache,
+          [&evb, &onSlotDone, slot]() {
+            // Called from the transport's own callbacks, so replace the
+            // client once they have unwound.
+            evb.runInLoop([&onSlotDone, slot]() { onSlotDone(slot); });
+          });
+      slots[slot]->connect();
+    };
+    for (size_t slot = 0; slot < numSlots; ++slot) {
+      connectSlot(slot);
+    }
+    evb.loopForever();
+  }
+
+  static void recordChurnStats(
+      TPerfChurnStats& churnStats,
+      const TPerfConnectionStats& stats) {
+    churnStats.attempts++;
+    if (stats.error) {
+      churnStats.errors++;
+    }
+    if (stats.replaySafeTime) {
+      churnStats.handshakes++;
+      churnStats.handshakeLatency.addValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              *stats.replaySafeTime - stats.connectTime)
+              .count());
+    }
+    if (stats.tlsResumed) {
+      churnStats.resumed++;
+    }
+    if (stats.firstByteTime) {
+      churnStats.timeToFirstByte.addValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              *stats.firstByteTime - stats.connectTime)
+              .count());
+    }
+  }
+
+  void logChurnStats(std::chrono::microseconds elapsed, uint64_t cpuUs) {
+    uint64_t attempts = 0;
+    uint64_t handshakes = 0;
+    uint64_t resumed = 0;
+    uint64_t errors = 0;
+    LogLinearHistogram::Snapshot handshakeLatency;
+    LogLinearHistogram::Snapshot timeToFirstByte;
+    for (const auto& churnStats : churnStats_) {
+      attempts += churnStats.attempts;
+      handshakes += churnStats.handshakes;
+      resumed += churnStats.resumed;
+      errors += churnStats.errors;
+      handshakeLatency.merge(churnStats.handshakeLatency.snapshot());
+      timeToFirstByte.merge(churnStats.timeToFirstByte.snapshot());
+    }
+    LOG(INFO) << "Opened " << attempts << " connections with "
+              << numConnections_ << " in flight: " << handshakes
+              << " handshakes completed, " << resumed << " resumed, "
+              << errors << " errors";
+    if (handshakes == 0) {
+      return;
+    }
+    LOG(INFO) << "Handshakes/s: "
+              << handshakes * 1e6 / std::max<int64_t>(elapsed.count(), 1)
+              << ", client CPU per handshake: " << cpuUs / handshakes << "us";
+    LOG(INFO) << "Handshake latency us: p50=" << handshakeLatency.percentile(50)
+              << " p99=" << handshakeLatency.percentile(99)
+              << " max=" << handshakeLatency.max;
+    LOG(INFO) << "Time to first byte us: p50="
+              << timeToFirstByte.percentile(50)
+              << " p99=" << timeToFirstByte.percentile(99)
+              << " max=" << timeToFirstByte.max;
+  }
+
+  void logStats() {
+    if (rpcConfig_) {
+      logRpcStats();
+      return;
+    }
+    if (numConnections_ == 1) {
+      return;
+    }
+    constexpr double bytesPerMegabit = 131072;
+    uint64_t totalBytes = 0;
+    uint64_t totalStreams = 0;
+    uint64_t numErrors = 0;
+    uint64_t numHandshakes = 0;
+    folly::Optional<TimePoint> firstConnect;
+    folly::Optional<TimePoint> lastReady;
+    // Handshake latency in microseconds, throughput in kb/s.
+    LogLinearHistogram handshakeLatency;
+    LogLinearHistogram connThroughput;
+    for (const auto& stats : stats_) {
+      totalBytes += stats.receivedBytes;
+      totalStreams += stats.receivedStreams;
+      numErrors += stats.error ? 1 : 0;
+      connThroughput.addValue(
+          (stats.receivedBytes * 8 / 1000) / duration_.count());
+      if (!firstConnect || stats.connectTime < *firstConnect) {
+        firstConnect = stats.connectTime;
+      }
+      if (!stats.transportReadyTime) {
+        continue;
+      }
+      ++numHandshakes;
+      handshakeLatency.addValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              *stats.transportReadyTime - stats.connectTime)
+              .count());
+      if (!lastReady || *stats.transportReadyTime > *lastReady) {
+        lastReady = stats.transportReadyTime;
+      }
+    }
+    LOG(INFO) << "Received " << totalBytes << " bytes on " << totalStreams
+              << " streams over " << numConnections_ << " connections in "
+              << duration_.count() << " seconds, " << numErrors
+              << " connection errors";
+    LOG(INFO) << "Aggregate throughput: "
+              << (totalBytes / bytesPerMegabit) / duration_.count() << "Mb/s";
+    LOG(INFO) << "Average per connection throughput: "
+              << ((totalBytes / numConnections_) / bytesPerMegabit) /
+            duration_.count()
+              << "Mb/s";
+    auto throughput = connThroughput.snapshot();
+    LOG(INFO) << "Per connection throughput kb/s: p50="
+              << throughput.percentile(50)
+              << " p99=" << throughput.percentile(99)
+              << " max=" << throughput.max;
+    if (numHandshakes == 0) {
+      LOG(INFO) << "No handshakes completed";
+      return;
+    }
+    auto handshakeWindow =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            *lastReady - *firstConnect);
+    LOG(INFO) << "Completed " << numHandshakes << " handshakes at "
+              << numHandshakes * 1e6 /
+            std::max<int64_t>(handshakeWindow.count(), 1)
+              << " handshakes/s";
+    auto latency = handshakeLatency.snapshot();
+    LOG(INFO) << "Handshake latency us: p50=" << latency.percentile(50)
+              << " p99=" << latency.percentile(99)
+              << " max=" << latency.max;
+  }
+
+  void logRpcStats() {
+    uint64_t totalRequests = 0;
+    uint64_t numErrors = 0;
+    LogLinearHistogram::Snapshot latency;
+    for (const auto& stats : stats_) {
+      totalRequests += stats.completedRequests;
+      numErrors += stats.error ? 1 : 0;
+      latency.merge(stats.requestLatency);
+    }
+    LOG(INFO) << "Completed " << totalRequests << " requests of "
+              << rpcConfig_->requestSize << " bytes with "
+              << rpcConfig_->responseSize << " byte responses over "
+              << numConnections_ << " connections in " << duration_.count()
+              << " seconds, " << numErrors << " connection errors";
+    LOG(INFO) << "Requests/s: "
+              << static_cast<double>(totalRequests) / duration_.count()
+              << " with " << rpcConfig_->concurrency
+              << " outstanding per connection";
+    LOG(INFO) << "Request latency us: p50=" << latency.percentile(50)
+              << " p90=" << latency.percentile(90)
+              << " p99=" << latency.percentile(99)
+              << " p99.9=" << latency.percentile(99.9)
+              << " max=" << latency.max << " mean=" << latency.mean();
+  }
+
+  std::string host_;
+  uint16_t port_;
+  std::chrono::milliseconds transportTimerResolution_;
+  std::chrono::seconds duration_;
+  uint64_t window_;
+  bool gso_;
+  quic::CongestionControlType congestionControlType_;
+  uint32_t maxReceivePacketSize_;
+  uint32_t numConnections_;
+  uint32_t numThreads_;
+  folly::Optional<TPerfRpcConfig> rpcConfig_;
+  bool churn_;
+  bool zeroRtt_;
+  std::vector<TPerfConnectionStats> stats_;
+  std::vector<TPerfChurnStats> churnStats_;
 };
 
 } // namespace tperf
@@ -782,6 +1560,16 @@ quic::CongestionControlType flagsToCongestionControlType(
   return *ccType;
 }
 
+TrafficMode flagsToTrafficMode() {
+  if (FLAGS_rpc) {
+    return TrafficMode::Rpc;
+  }
+  if (FLAGS_churn) {
+    return TrafficMode::Churn;
+  }
+  return TrafficMode::Bulk;
+}
+
 int main(int argc, char* argv[]) {
 #if FOLLY_HAVE_LIBGFLAGS
   // Enable glog logging to stderr by default.
@@ -792,6 +1580,10 @@ int main(int argc, char* argv[]) {
   folly::Init init(&argc, &argv);
   fizz::CryptoUtils::init();
 
+  if (FLAGS_rpc && FLAGS_churn) {
+    LOG(ERROR) << "rpc and churn options are mutually exclusive";
+    return 1;
+  }
   if (FLAGS_mode == "server") {
     TPerfServer server(
         FLAGS_host,
@@ -806,7 +1598,10 @@ int main(int argc, char* argv[]) {
         FLAGS_bytes_per_stream,
         FLAGS_max_receive_packet_size,
         FLAGS_use_inplace_write,
-        FLAGS_dsr);
+        FLAGS_dsr,
+        flagsToTrafficMode(),
+        FLAGS_zero_rtt,
+        FLAGS_retry);
     server.start();
   } else if (FLAGS_mode == "client") {
     if (FLAGS_num_streams != 1) {
@@ -817,7 +1612,29 @@ int main(int argc, char* argv[]) {
       LOG(ERROR) << "bytes_per_stream option is server only";
       return 1;
     }
-    TPerfClient client(
+    if (FLAGS_connections == 0 || FLAGS_client_threads == 0) {
+      LOG(ERROR) << "connections and client_threads must be positive";
+      return 1;
+    }
+    if (FLAGS_retry) {
+      LOG(ERROR) << "retry option is server only";
+      return 1;
+    }
+    auto trafficMode = flagsToTrafficMode();
+    folly::Optional<TPerfRpcConfig> rpcConfig;
+    if (trafficMode == TrafficMode::Rpc) {
+      if (FLAGS_request_size < sizeof(uint64_t)) {
+        LOG(ERROR) << "request_size must be at least " << sizeof(uint64_t);
+        return 1;
+      }
+      if (FLAGS_rpc_concurrency == 0) {
+        LOG(ERROR) << "rpc_concurrency must be positive";
+        return 1;
+      }
+      rpcConfig = TPerfRpcConfig{
+          FLAGS_request_size, FLAGS_response_size, FLAGS_rpc_concurrency};
+    }
+    TPerfLoadClient client(
         FLAGS_host,
         FLAGS_port,
         std::chrono::milliseconds(FLAGS_client_transport_timer_resolution_ms),
@@ -825,7 +1642,12 @@ int main(int argc, char* argv[]) {
         FLAGS_window,
         FLAGS_gso,
         flagsToCongestionControlType(FLAGS_congestion),
-        FLAGS_max_receive_packet_size);
+        FLAGS_max_receive_packet_size,
+        FLAGS_connections,
+        FLAGS_client_threads,
+        std::move(rpcConfig),
+        trafficMode == TrafficMode::Churn,
+        FLAGS_zero_rtt);
     client.start();
   }
   return 0;